@@ -0,0 +1,24 @@
+set(MALIIT_KEYBOARD_LM_MAX_SIZE "8M" CACHE STRING "Size budget of each compiled language model (accepts K and M suffixes)")
+
+# Compiles a plain text corpus into a binary n-gram model with maliit-lmcompile.
+# The model is written to the current binary directory. OPTIONS are passed on
+# to maliit-lmcompile.
+function(add_language_model)
+    # Parse arguments
+    set(oneValueArgs TEXT MODEL)
+    set(multiValueArgs OPTIONS)
+    cmake_parse_arguments(ARGS "" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+
+    if(ARGS_UNPARSED_ARGUMENTS)
+        message(FATAL_ERROR "Unknown keywords given to add_language_model(): \"${ARGS_UNPARSED_ARGUMENTS}\"")
+    endif()
+
+    get_filename_component(_infile ${ARGS_TEXT} ABSOLUTE)
+    set(_model "${CMAKE_CURRENT_BINARY_DIR}/${ARGS_MODEL}")
+
+    set_source_files_properties(${_model} GENERATED)
+
+    add_custom_command(OUTPUT "${_model}"
+            COMMAND maliit-lmcompile --max-size ${MALIIT_KEYBOARD_LM_MAX_SIZE} ${ARGS_OPTIONS} -o ${_model} ${_infile}
+            DEPENDS maliit-lmcompile ${_infile} VERBATIM)
+endfunction()
@@ -15,6 +15,7 @@
  */
 
 #include "chewingadapter.h"
+#include "latencystats.h"
 
 #include <iostream>
 
@@ -42,8 +43,20 @@ ChewingAdapter::~ChewingAdapter()
     chewing_delete(m_chewingContext);
 }
 
-void ChewingAdapter::parse(const QString& string)
+void ChewingAdapter::request(quint64 generation)
 {
+    m_requests.request(generation);
+}
+
+void ChewingAdapter::parse(quint64 generation, const QString& string)
+{
+    if (m_requests.isSuperseded(generation)) {
+        return;
+    }
+
+    MALIIT_LATENCY_SINCE_KEYSTROKE(WorkerQueued);
+    MALIIT_LATENCY_SCOPE(WorkerProcessing);
+
     m_candidates.clear();
     clearChewingPreedit();
 
@@ -83,7 +96,7 @@ void ChewingAdapter::parse(const QString& string)
 
     chewing_cand_close(m_chewingContext);
 
-    Q_EMIT newPredictionSuggestions(string, m_candidates);
+    Q_EMIT newPredictionSuggestions(generation, string, m_candidates);
 }
 
 void ChewingAdapter::clearChewingPreedit()
@@ -21,6 +21,7 @@
 #include <QStringList>
 
 #include "chewing.h"
+#include "requestgeneration.h"
 
 class ChewingAdapter : public QObject
 {
@@ -29,16 +30,20 @@ class ChewingAdapter : public QObject
     QStringList m_candidates;
     bool m_processingWords;
     ChewingContext *m_chewingContext;
+    RequestGeneration m_requests;
 
 public:
     explicit ChewingAdapter(QObject *parent = nullptr);
     ~ChewingAdapter() override;
 
+    //! Thread-safe; marks generation as the newest queued request.
+    void request(quint64 generation);
+
 signals:
-    void newPredictionSuggestions(QString, QStringList);
+    void newPredictionSuggestions(quint64 generation, QString, QStringList);
 
 public slots:
-    void parse(const QString& string);
+    void parse(quint64 generation, const QString& string);
     void clearChewingPreedit();
     void wordCandidateSelected(const QString& word);
     void reset();
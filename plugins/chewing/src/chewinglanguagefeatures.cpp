@@ -16,9 +16,13 @@
 
 #include "chewinglanguagefeatures.h"
 
+using MaliitKeyboard::Logic::CharacterClassTable;
+
 ChewingLanguageFeatures::ChewingLanguageFeatures(QObject *parent) :
     QObject(parent)
 {
+    addCharacters(CharacterClassTable::Separator, QStringLiteral("。、!?:…\r\n"));
+    addCharacters(CharacterClassTable::Symbol, QStringLiteral(R"(*#+=()@~\€£$¥₹%<>[]`^|_—–•§{}¡¿«»"“”„&)"));
 }
 
 ChewingLanguageFeatures::~ChewingLanguageFeatures() = default;
@@ -51,36 +55,6 @@ QString ChewingLanguageFeatures::appendixForReplacedPreedit(const QString &preed
     return QStringLiteral(" ");
 }
 
-bool ChewingLanguageFeatures::isSeparator(const QString &text) const
-{
-    static const QString separators = QStringLiteral("。、!?:…\r\n");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (separators.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
-bool ChewingLanguageFeatures::isSymbol(const QString &text) const
-{
-    static const QString symbols = QStringLiteral(R"(*#+=()@~\€£$¥₹%<>[]`^|_—–•§{}¡¿«»"“”„&)");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (symbols.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
 bool ChewingLanguageFeatures::ignoreSimilarity() const
 {
     return true;
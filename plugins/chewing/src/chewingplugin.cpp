@@ -3,54 +3,42 @@
 
 #include <QDebug>
 
+using MaliitKeyboard::Logic::TaskExecutor;
+
 ChewingPlugin::ChewingPlugin(QObject *parent) :
     AbstractLanguagePlugin(parent)
   , m_chewingLanguageFeatures(new ChewingLanguageFeatures)
-  , m_processingWord(false)
 {
-    m_chewingThread = new QThread();
     m_chewingAdapter = new ChewingAdapter();
-    m_chewingAdapter->moveToThread(m_chewingThread);
 
-    connect(m_chewingAdapter, &ChewingAdapter::newPredictionSuggestions, this, &ChewingPlugin::finishedProcessing);
-    connect(this, &ChewingPlugin::parsePredictionText, m_chewingAdapter, &ChewingAdapter::parse);
-    connect(this, &ChewingPlugin::candidateSelected, m_chewingAdapter, &ChewingAdapter::wordCandidateSelected);
-    m_chewingThread->start();
+    connect(m_chewingAdapter, &ChewingAdapter::newPredictionSuggestions, this, &ChewingPlugin::newPredictionSuggestions);
 }
 
 ChewingPlugin::~ChewingPlugin()
 {
-    m_chewingAdapter->deleteLater();
-    m_chewingThread->quit();
-    m_chewingThread->wait();
+    m_strand.clear();
+    delete m_chewingAdapter;
 }
 
-void ChewingPlugin::predict(const QString& surroundingLeft, const QString& preedit)
+void ChewingPlugin::predict(quint64 generation, const QStringList& context, const QString& preedit)
 {
-    Q_UNUSED(surroundingLeft);
-    m_nextWord = preedit;
-    if (!m_processingWord) {
-        m_processingWord = true;
-        Q_EMIT parsePredictionText(preedit);
-    }
+    Q_UNUSED(context);
+    m_chewingAdapter->request(generation);
+    ChewingAdapter *adapter = m_chewingAdapter;
+    m_strand.post(TaskExecutor::Interactive, [adapter, generation, preedit]() {
+        adapter->parse(generation, preedit);
+    });
 }
 
 void ChewingPlugin::wordCandidateSelected(QString word)
 {
-    Q_EMIT candidateSelected(word);
+    ChewingAdapter *adapter = m_chewingAdapter;
+    m_strand.post(TaskExecutor::Interactive, [adapter, word]() {
+        adapter->wordCandidateSelected(word);
+    });
 }
 
 AbstractLanguageFeatures* ChewingPlugin::languageFeature()
 {
     return m_chewingLanguageFeatures;
 }
-
-void ChewingPlugin::finishedProcessing(QString word, QStringList suggestions)
-{
-    Q_EMIT newPredictionSuggestions(word, suggestions);
-    if (word != m_nextWord) {
-        Q_EMIT parsePredictionText(word);
-    } else {
-        m_processingWord = false;
-    }
-}
@@ -3,9 +3,9 @@
 
 #include <QObject>
 #include <QStringList>
-#include <QThread>
 #include "languageplugininterface.h"
 #include "abstractlanguageplugin.h"
+#include "taskexecutor.h"
 
 #include "chewingadapter.h"
 #include <iostream>
@@ -22,29 +22,20 @@ public:
     explicit ChewingPlugin(QObject *parent = nullptr);
     ~ChewingPlugin() override;
     
-    void predict(const QString& surroundingLeft, const QString& preedit) override;
+    void predict(quint64 generation, const QStringList& context, const QString& preedit) override;
     void wordCandidateSelected(QString word) override;
 
     AbstractLanguageFeatures* languageFeature() override;
 
     //! spell checker
-    void spellCheckerSuggest(const QString& word, int limit) override { Q_UNUSED(word); Q_UNUSED(limit); }
+    void spellCheckerSuggest(quint64 generation, const QString& word, int limit) override { Q_UNUSED(generation); Q_UNUSED(word); Q_UNUSED(limit); }
     void addToSpellCheckerUserWordList(const QString& word) override { Q_UNUSED(word); }
     bool setLanguage(const QString& languageId, const QString& pluginPath) override { Q_UNUSED(languageId); Q_UNUSED(pluginPath); return false; }
 
-signals:
-    void parsePredictionText(QString preedit);
-    void candidateSelected(QString word);
-    
-public slots:
-    void finishedProcessing(QString word, QStringList suggestions);
-    
 private:
-    QThread *m_chewingThread;
     ChewingAdapter *m_chewingAdapter;
+    MaliitKeyboard::Logic::TaskStrand m_strand;
     ChewingLanguageFeatures* m_chewingLanguageFeatures;
-    QString m_nextWord;
-    bool m_processingWord;
 };
 
 #endif // CHEWINGPLUGIN_H
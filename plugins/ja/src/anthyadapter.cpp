@@ -15,6 +15,7 @@
  */
 
 #include "anthyadapter.h"
+#include "latencystats.h"
 
 #include <QDebug>
 
@@ -49,9 +50,21 @@ AnthyAdapter::~AnthyAdapter()
     anthy_quit();
 }
 
+void AnthyAdapter::request(quint64 generation)
+{
+    m_requests.request(generation);
+}
+
 #define CANDIDATE_SIZE 1024
-void AnthyAdapter::parse(const QString& string)
+void AnthyAdapter::parse(quint64 generation, const QString& string)
 {
+    if (m_requests.isSuperseded(generation)) {
+        return;
+    }
+
+    MALIIT_LATENCY_SINCE_KEYSTROKE(WorkerQueued);
+    MALIIT_LATENCY_SCOPE(WorkerProcessing);
+
     struct anthy_conv_stat cs;
     struct anthy_segment_stat ss;
     char buf[CANDIDATE_SIZE];
@@ -106,7 +119,7 @@ void AnthyAdapter::parse(const QString& string)
         candidates.append(candidate);
     }
 
-    Q_EMIT newPredictionSuggestions(string, candidates);
+    Q_EMIT newPredictionSuggestions(generation, string, candidates);
 }
 
 void AnthyAdapter::wordCandidateSelected(const QString& word)
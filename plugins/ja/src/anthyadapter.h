@@ -21,6 +21,7 @@
 #include <QStringList>
 
 #include "anthy/anthy.h"
+#include "requestgeneration.h"
 
 class AnthyAdapter : public QObject
 {
@@ -30,16 +31,20 @@ public:
     explicit AnthyAdapter(QObject *parent = nullptr);
     ~AnthyAdapter() override;
 
+    //! Thread-safe; marks generation as the newest queued request.
+    void request(quint64 generation);
+
     QStringList candidates;
 
 signals:
-    void newPredictionSuggestions(QString, QStringList);
+    void newPredictionSuggestions(quint64 generation, QString, QStringList);
 
 public slots:
-    void parse(const QString& string);
+    void parse(quint64 generation, const QString& string);
     void wordCandidateSelected(const QString& word);
 
 private:
     anthy_context_t  m_context;
+    RequestGeneration m_requests;
 };
 #endif // ANTHYADAPTER_H
@@ -16,9 +16,12 @@
 
 #include "japaneselanguagefeatures.h"
 
+using MaliitKeyboard::Logic::CharacterClassTable;
+
 JapaneseLanguageFeatures::JapaneseLanguageFeatures(QObject *parent) :
     QObject(parent)
 {
+    addCharacters(CharacterClassTable::Separator, QStringLiteral("。、,!?:;.\r\n"));
 }
 
 JapaneseLanguageFeatures::~JapaneseLanguageFeatures() = default;
@@ -47,28 +50,6 @@ QString JapaneseLanguageFeatures::appendixForReplacedPreedit(const QString &pree
     return QString();
 }
 
-bool JapaneseLanguageFeatures::isSeparator(const QString &text) const
-{
-    static const QString separators = QStringLiteral("。、,!?:;.\r\n");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (separators.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
-bool JapaneseLanguageFeatures::isSymbol(const QString &text) const
-{
-    Q_UNUSED(text)
-
-    return false;
-}
-
 bool JapaneseLanguageFeatures::ignoreSimilarity() const
 {
     return true;
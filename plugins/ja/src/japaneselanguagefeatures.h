@@ -31,8 +31,6 @@ public:
     bool autoCapsAvailable() const override;
     bool activateAutoCaps(const QString &preedit) const override;
     QString appendixForReplacedPreedit(const QString &preedit) const override;
-    bool isSeparator(const QString &text) const override;
-    bool isSymbol(const QString &text) const override;
     bool ignoreSimilarity() const override;
     bool wordEngineAvailable() const override;
     bool enablePreeditAtInsertion() const override;
@@ -3,27 +3,21 @@
 
 #include <QDebug>
 
+using MaliitKeyboard::Logic::TaskExecutor;
+
 JapanesePlugin::JapanesePlugin(QObject *parent) :
     AbstractLanguagePlugin(parent)
   , m_japaneseLanguageFeatures(new JapaneseLanguageFeatures)
-  , m_processingWord(false)
 {
-    m_anthyThread = new QThread();
     m_anthyAdapter = new AnthyAdapter();
-    m_anthyAdapter->moveToThread(m_anthyThread);
-
-    connect(m_anthyAdapter, &AnthyAdapter::newPredictionSuggestions, this, &JapanesePlugin::finishedProcessing);
-    connect(this, &JapanesePlugin::parsePredictionText, m_anthyAdapter, &AnthyAdapter::parse);
-    connect(this, &JapanesePlugin::candidateSelected, m_anthyAdapter, &AnthyAdapter::wordCandidateSelected);
 
-    m_anthyThread->start();
+    connect(m_anthyAdapter, &AnthyAdapter::newPredictionSuggestions, this, &JapanesePlugin::newPredictionSuggestions);
 }
 
 JapanesePlugin::~JapanesePlugin()
 {
-    m_anthyAdapter->deleteLater();
-    m_anthyThread->quit();
-    m_anthyThread->wait();
+    m_strand.clear();
+    delete m_anthyAdapter;
 }
 
 AbstractLanguageFeatures* JapanesePlugin::languageFeature()
@@ -31,29 +25,21 @@ AbstractLanguageFeatures* JapanesePlugin::languageFeature()
     return m_japaneseLanguageFeatures;
 }
 
-void JapanesePlugin::predict(const QString& surroundingLeft, const QString& preedit)
+void JapanesePlugin::predict(quint64 generation, const QStringList& context, const QString& preedit)
 {
-    Q_UNUSED(surroundingLeft)
+    Q_UNUSED(context)
 
-    m_nextWord = preedit;
-    if (!m_processingWord) {
-        m_processingWord = true;
-        Q_EMIT parsePredictionText(preedit);
-    }
+    m_anthyAdapter->request(generation);
+    AnthyAdapter *adapter = m_anthyAdapter;
+    m_strand.post(TaskExecutor::Interactive, [adapter, generation, preedit]() {
+        adapter->parse(generation, preedit);
+    });
 }
 
 void JapanesePlugin::wordCandidateSelected(QString word)
 {
-    Q_EMIT candidateSelected(word);
-}
-
-void JapanesePlugin::finishedProcessing(QString word, QStringList suggestions)
-{
-    Q_EMIT newPredictionSuggestions(word, suggestions);
-    if (word != m_nextWord) {
-        Q_EMIT parsePredictionText(m_nextWord);
-    } else {
-        m_processingWord = false;
-    }
+    AnthyAdapter *adapter = m_anthyAdapter;
+    m_strand.post(TaskExecutor::Interactive, [adapter, word]() {
+        adapter->wordCandidateSelected(word);
+    });
 }
-
@@ -2,9 +2,9 @@
 #define JAPANESEPLUGIN_H
 
 #include <QObject>
-#include <QThread>
 #include "languageplugininterface.h"
 #include "abstractlanguageplugin.h"
+#include "taskexecutor.h"
 
 #include "anthyadapter.h"
 
@@ -21,22 +21,13 @@ public:
     ~JapanesePlugin() override;
     AbstractLanguageFeatures* languageFeature() override;
 
-    void predict(const QString& surroundingLeft, const QString& preedit) override;
+    void predict(quint64 generation, const QStringList& context, const QString& preedit) override;
     void wordCandidateSelected(QString word) override;
 
-signals:
-    void parsePredictionText(QString preedit);
-    void candidateSelected(QString word);
-
-public slots:
-    void finishedProcessing(QString word, QStringList suggestions);
-
 private:
     JapaneseLanguageFeatures* m_japaneseLanguageFeatures;
-    QThread *m_anthyThread;
     AnthyAdapter *m_anthyAdapter;
-    QString m_nextWord;
-    bool m_processingWord;
+    MaliitKeyboard::Logic::TaskStrand m_strand;
 };
 
 #endif // JAPANESEPLUGIN_H
@@ -16,9 +16,14 @@
 
 #include "koreanlanguagefeatures.h"
 
+using MaliitKeyboard::Logic::CharacterClassTable;
+
 KoreanLanguageFeatures::KoreanLanguageFeatures(QObject *parent) :
     QObject(parent)
 {
+    addCharacters(CharacterClassTable::SentenceBreak, QStringLiteral("!.?\r\n"));
+    addCharacters(CharacterClassTable::Separator, QStringLiteral("。、,!?:;.\r\n"));
+    addCharacters(CharacterClassTable::Symbol, QStringLiteral(R"(*#+=()@~/\€£$¥₹%<>[]`^|_§{}¡¿«»"“”„&0123456789)"));
 }
 
 KoreanLanguageFeatures::~KoreanLanguageFeatures() = default;
@@ -47,36 +52,6 @@ QString KoreanLanguageFeatures::appendixForReplacedPreedit(const QString &preedi
     return QStringLiteral(" ");
 }
 
-bool KoreanLanguageFeatures::isSeparator(const QString &text) const
-{
-    static const QString separators = QStringLiteral("。、,!?:;.\r\n");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (separators.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
-bool KoreanLanguageFeatures::isSymbol(const QString &text) const
-{
-    static const QString symbols = QStringLiteral(R"(*#+=()@~/\€£$¥₹%<>[]`^|_§{}¡¿«»"“”„&0123456789)");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (symbols.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
 bool KoreanLanguageFeatures::ignoreSimilarity() const
 {
     return true;
@@ -4,33 +4,25 @@
 
 #include <QDebug>
 
+using MaliitKeyboard::Logic::TaskExecutor;
+
 KoreanPlugin::KoreanPlugin(QObject *parent) :
     AbstractLanguagePlugin(parent)
   , m_koreanLanguageFeatures(new KoreanLanguageFeatures)
+  , m_spellPredictWorker(new SpellPredictWorker)
   , m_spellCheckEnabled(false)
-  , m_processingSpelling(false)
+  , m_languageLoad(0)
 {
-    m_spellPredictThread = new QThread();
-    m_spellPredictWorker = new SpellPredictWorker();
-    m_spellPredictWorker->moveToThread(m_spellPredictThread);
-
-    connect(m_spellPredictWorker, &SpellPredictWorker::newSpellingSuggestions, this, &KoreanPlugin::spellCheckFinishedProcessing);
+    connect(m_spellPredictWorker, &SpellPredictWorker::newSpellingSuggestions, this, &KoreanPlugin::newSpellingSuggestions);
     connect(m_spellPredictWorker, &SpellPredictWorker::newPredictionSuggestions, this, &KoreanPlugin::newPredictionSuggestions);
-    connect(this, &KoreanPlugin::newSpellCheckWord, m_spellPredictWorker, &SpellPredictWorker::newSpellCheckWord);
-    connect(this, &KoreanPlugin::setSpellPredictLanguage, m_spellPredictWorker, &SpellPredictWorker::setLanguage);
-    connect(this, &KoreanPlugin::setSpellCheckLimit, m_spellPredictWorker, &SpellPredictWorker::setSpellCheckLimit);
-    connect(this, &KoreanPlugin::parsePredictionText, m_spellPredictWorker, &SpellPredictWorker::parsePredictionText);
-    connect(this, &KoreanPlugin::addToUserWordList, m_spellPredictWorker, &SpellPredictWorker::addToUserWordList);
-    connect(this, &KoreanPlugin::addOverride, m_spellPredictWorker, &SpellPredictWorker::addOverride);
-    m_spellPredictThread->start();
-
+    connect(m_spellPredictWorker, &SpellPredictWorker::languageLoaded, this, &KoreanPlugin::languageReady);
 }
 
 KoreanPlugin::~KoreanPlugin()
 {
-    m_spellPredictWorker->deleteLater();
-    m_spellPredictThread->quit();
-    m_spellPredictThread->wait();
+    m_predictionStrand.clear();
+    m_spellingStrand.clear();
+    delete m_spellPredictWorker;
 }
 
 AbstractLanguageFeatures* KoreanPlugin::languageFeature()
@@ -38,9 +30,13 @@ AbstractLanguageFeatures* KoreanPlugin::languageFeature()
     return m_koreanLanguageFeatures;
 }
 
-void KoreanPlugin::predict(const QString& surroundingLeft, const QString& preedit)
+void KoreanPlugin::predict(quint64 generation, const QStringList& context, const QString& preedit)
 {
-    Q_EMIT parsePredictionText(surroundingLeft, preedit);
+    SpellPredictWorker *worker = m_spellPredictWorker;
+    worker->requestPrediction(generation);
+    m_predictionStrand.post(TaskExecutor::Interactive, [worker, generation, context, preedit]() {
+        worker->parsePredictionText(generation, context, preedit);
+    });
 }
 
 void KoreanPlugin::wordCandidateSelected(QString word)
@@ -49,54 +45,41 @@ void KoreanPlugin::wordCandidateSelected(QString word)
 }
 
 
-void KoreanPlugin::spellCheckerSuggest(const QString& word, int limit)
+void KoreanPlugin::spellCheckerSuggest(quint64 generation, const QString& word, int limit)
 {
-    m_nextSpellWord = word;
-    // Don't accept new words whilst we're processing, so we only process the
-    // most recent input once the current processing has completed
-    if (!m_processingSpelling) {
-        m_processingSpelling = true;
-        Q_EMIT setSpellCheckLimit(limit);
-        Q_EMIT newSpellCheckWord(word);
-    }
+    // The worker drops this request if a newer one is queued by the time
+    // it gets to it, so only the most recent input reaches Hunspell.
+    SpellPredictWorker *worker = m_spellPredictWorker;
+    worker->requestSpellCheck(generation);
+    m_spellingStrand.post(TaskExecutor::Interactive, [worker, generation, word, limit]() {
+        worker->setSpellCheckLimit(limit);
+        worker->newSpellCheckWord(generation, word);
+    });
 }
 
 void KoreanPlugin::addToSpellCheckerUserWordList(const QString& word)
 {
-    Q_EMIT addToUserWordList(word);
+    SpellPredictWorker *worker = m_spellPredictWorker;
+    m_spellingStrand.post(TaskExecutor::Background, [worker, word]() {
+        worker->addToUserWordList(word);
+    });
+    m_predictionStrand.post(TaskExecutor::Background, [worker, word]() {
+        worker->addToPredictionWordList(word);
+    });
 }
 
 bool KoreanPlugin::setLanguage(const QString& languageId, const QString& pluginPath)
 {
-    Q_EMIT setSpellPredictLanguage(languageId, pluginPath);
-    loadOverrides(pluginPath);
+    // The worker emits languageLoaded() once the dictionaries, the language
+    // models and the overrides of both strands are in memory.
+    SpellPredictWorker *worker = m_spellPredictWorker;
+    const quint64 load = ++m_languageLoad;
+    worker->requestLanguage(load);
+    m_predictionStrand.post(TaskExecutor::Background, [worker, load, languageId, pluginPath]() {
+        worker->setPredictionLanguage(load, languageId, pluginPath);
+    });
+    m_spellingStrand.post(TaskExecutor::Background, [worker, load, languageId, pluginPath]() {
+        worker->setSpellingLanguage(load, languageId, pluginPath);
+    });
     return true;
 }
-
-void KoreanPlugin::addSpellingOverride(const QString& orig, const QString& overridden)
-{
-    Q_EMIT addOverride(orig, overridden);
-}
-
-void KoreanPlugin::loadOverrides(const QString& pluginPath) {
-    QFile overrideFile(pluginPath + QDir::separator() + "overrides.csv");
-    if (overrideFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QTextStream overrideStream(&overrideFile);
-        while (!overrideStream.atEnd()) {
-            QString line = overrideStream.readLine();
-            QStringList components = line.split(QStringLiteral(","));
-            if (components.length() == 2) {
-                addSpellingOverride(components.first(), components.last());
-            }
-        }
-    }
-}
-
-void KoreanPlugin::spellCheckFinishedProcessing(QString word, QStringList suggestions) {
-    Q_EMIT newSpellingSuggestions(word, suggestions);
-    if (word != m_nextSpellWord) {
-        Q_EMIT newSpellCheckWord(m_nextSpellWord);
-    } else {
-        m_processingSpelling = false;
-    }
-}
@@ -8,6 +8,7 @@
 #include "candidatescallback.h"
 #include "spellchecker.h"
 #include "spellpredictworker.h"
+#include "taskexecutor.h"
 
 #include <iostream>
 
@@ -24,36 +25,23 @@ public:
     explicit KoreanPlugin(QObject *parent = nullptr);
     ~KoreanPlugin() override;
 
-    void predict(const QString& surroundingLeft, const QString& preedit) override;
+    void predict(quint64 generation, const QStringList& context, const QString& preedit) override;
     void wordCandidateSelected(QString word) override;
     AbstractLanguageFeatures* languageFeature() override;
 
     //! spell checker
-    void spellCheckerSuggest(const QString& word, int limit) override;
+    void spellCheckerSuggest(quint64 generation, const QString& word, int limit) override;
     void addToSpellCheckerUserWordList(const QString& word) override;
     bool setLanguage(const QString& languageId, const QString& pluginPath) override;
-    virtual void addSpellingOverride(const QString& orig, const QString& overridden);
-    virtual void loadOverrides(const QString& pluginPath);
-
-signals:
-    void newSpellCheckWord(QString word);
-    void setSpellCheckLimit(int limit);
-    void setSpellPredictLanguage(QString language, QString pluginPath);
-    void parsePredictionText(QString surroundingLeft, QString preedit);
-    void setPredictionLanguage(QString language);
-    void addToUserWordList(const QString& word);
-    void addOverride(const QString& orig, const QString& overridden);
-
-public slots:
-    void spellCheckFinishedProcessing(QString word, QStringList suggestions);
 
 private:
     KoreanLanguageFeatures* m_koreanLanguageFeatures;
     SpellPredictWorker *m_spellPredictWorker;
-    QThread *m_spellPredictThread;
+    // Predictions never wait for a slow spelling suggestion.
+    MaliitKeyboard::Logic::TaskStrand m_predictionStrand;
+    MaliitKeyboard::Logic::TaskStrand m_spellingStrand;
     bool m_spellCheckEnabled;
-    QString m_nextSpellWord;
-    bool m_processingSpelling;
+    quint64 m_languageLoad;
 };
 
 #endif // KOREANPLUGIN_H
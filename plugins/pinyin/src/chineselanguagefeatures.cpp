@@ -16,9 +16,13 @@
 
 #include "chineselanguagefeatures.h"
 
+using MaliitKeyboard::Logic::CharacterClassTable;
+
 ChineseLanguageFeatures::ChineseLanguageFeatures(QObject *parent) :
     QObject(parent)
 {
+    addCharacters(CharacterClassTable::Separator, QStringLiteral("。、,!?:;.…\r\n"));
+    addCharacters(CharacterClassTable::Symbol, QStringLiteral(R"(*#+=()@~/\€£$¥₹%<>[]`^|_—–•§{}¡¿«»"“”„&0123456789)"));
 }
 
 ChineseLanguageFeatures::~ChineseLanguageFeatures() = default;
@@ -52,36 +56,6 @@ QString ChineseLanguageFeatures::appendixForReplacedPreedit(const QString &preed
     return QString();
 }
 
-bool ChineseLanguageFeatures::isSeparator(const QString &text) const
-{
-    static const QString separators = QStringLiteral("。、,!?:;.…\r\n");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (separators.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
-bool ChineseLanguageFeatures::isSymbol(const QString &text) const
-{
-    static const QString symbols = QStringLiteral(R"(*#+=()@~/\€£$¥₹%<>[]`^|_—–•§{}¡¿«»"“”„&0123456789)");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (symbols.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
 bool ChineseLanguageFeatures::ignoreSimilarity() const
 {
     return true;
@@ -16,6 +16,7 @@
  */
 
 #include "pinyinadapter.h"
+#include "latencystats.h"
 
 #include <iostream>
 #include <algorithm>
@@ -53,8 +54,23 @@ PinyinAdapter::~PinyinAdapter()
     pinyin_fini(m_context);
 }
 
-void PinyinAdapter::parse(const QString& string)
+void PinyinAdapter::request(quint64 generation)
 {
+    m_requests.request(generation);
+}
+
+void PinyinAdapter::parse(quint64 generation, const QString& string)
+{
+    // Every request re-parses the whole preedit, so a superseded one
+    // can be skipped without losing any state.
+    if (m_requests.isSuperseded(generation)) {
+        return;
+    }
+
+    MALIIT_LATENCY_SINCE_KEYSTROKE(WorkerQueued);
+    MALIIT_LATENCY_SCOPE(WorkerProcessing);
+
+    m_generation = generation;
     m_preedit = string;
 
     m_currentSequence = getCurrentPinyinSequence(string);
@@ -253,7 +269,7 @@ void PinyinAdapter::genCandidatesForCurrentSequence(const QString &string, Updat
 
     qCDebug(Pinyin) << "current string is" << string;
     qCDebug(Pinyin) << "candidates are" << candidates;
-    Q_EMIT newPredictionSuggestions(string, candidates, strategy);
+    Q_EMIT newPredictionSuggestions(m_generation, string, candidates, strategy);
 }
 
 QStringList PinyinAdapter::remainingSequence() const
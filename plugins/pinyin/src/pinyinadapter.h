@@ -22,6 +22,7 @@
 
 #include "pinyin.h"
 #include "abstractlanguageplugin.h"
+#include "requestgeneration.h"
 
 class PinyinAdapter : public QObject
 {
@@ -37,13 +38,18 @@ class PinyinAdapter : public QObject
     QString m_convertedChars;
     QString m_preedit;
     std::size_t m_offset{};
+    RequestGeneration m_requests;
+    quint64 m_generation{};
 
 public:
     explicit PinyinAdapter(QObject *parent = nullptr);
     ~PinyinAdapter() override;
 
+    //! Thread-safe; marks generation as the newest queued request.
+    void request(quint64 generation);
+
 signals:
-    void newPredictionSuggestions(QString, QStringList, int strategy = UpdateCandidateListStrategy::ClearWhenNeeded);
+    void newPredictionSuggestions(quint64 generation, QString, QStringList, int strategy = UpdateCandidateListStrategy::ClearWhenNeeded);
     /*!
      * \brief Signals that the whole Pinyin sequence is converted
      * to Chinese characters.
@@ -53,7 +59,7 @@ signals:
     void completed(const QString &text);
 
 public slots:
-    void parse(const QString& string);
+    void parse(quint64 generation, const QString& string);
     void wordCandidateSelected(const QString& word);
     void reset();
 
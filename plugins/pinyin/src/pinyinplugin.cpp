@@ -3,56 +3,44 @@
 
 #include <QDebug>
 
+using MaliitKeyboard::Logic::TaskExecutor;
+
 PinyinPlugin::PinyinPlugin(QObject *parent) :
     AbstractLanguagePlugin(parent)
   , m_chineseLanguageFeatures(new ChineseLanguageFeatures)
-  , m_processingWord(false)
 {
-    m_pinyinThread = new QThread();
     m_pinyinAdapter = new PinyinAdapter();
-    m_pinyinAdapter->moveToThread(m_pinyinThread);
 
-    connect(m_pinyinAdapter, &PinyinAdapter::newPredictionSuggestions, this, &PinyinPlugin::finishedProcessing);
-    connect(this, &PinyinPlugin::parsePredictionText, m_pinyinAdapter, &PinyinAdapter::parse);
-    connect(this, &PinyinPlugin::candidateSelected, m_pinyinAdapter, &PinyinAdapter::wordCandidateSelected);
+    connect(m_pinyinAdapter, &PinyinAdapter::newPredictionSuggestions, this, &PinyinPlugin::newPredictionSuggestions);
     connect(m_pinyinAdapter, &PinyinAdapter::completed, this, &AbstractLanguagePlugin::commitTextRequested);
-    m_pinyinThread->start();
 }
 
 PinyinPlugin::~PinyinPlugin()
 {
-    m_pinyinAdapter->deleteLater();
-    m_pinyinThread->quit();
-    m_pinyinThread->wait();
+    m_strand.clear();
+    delete m_pinyinAdapter;
 }
 
-void PinyinPlugin::predict(const QString& surroundingLeft, const QString& preedit)
+void PinyinPlugin::predict(quint64 generation, const QStringList& context, const QString& preedit)
 {
-    Q_UNUSED(surroundingLeft);
-    m_nextWord = preedit;
-    if (!m_processingWord) {
-        m_processingWord = true;
-        Q_EMIT parsePredictionText(preedit);
-    }
+    Q_UNUSED(context);
+    m_pinyinAdapter->request(generation);
+    PinyinAdapter *adapter = m_pinyinAdapter;
+    m_strand.post(TaskExecutor::Interactive, [adapter, generation, preedit]() {
+        adapter->parse(generation, preedit);
+    });
 }
 
 void PinyinPlugin::wordCandidateSelected(QString word)
 {
     qDebug() << "Pinyin plugin: selecting word " << word;
-    Q_EMIT candidateSelected(word);
+    PinyinAdapter *adapter = m_pinyinAdapter;
+    m_strand.post(TaskExecutor::Interactive, [adapter, word]() {
+        adapter->wordCandidateSelected(word);
+    });
 }
 
 AbstractLanguageFeatures* PinyinPlugin::languageFeature()
 {
     return m_chineseLanguageFeatures;
 }
-
-void PinyinPlugin::finishedProcessing(QString word, QStringList suggestions, int strategy)
-{
-    Q_EMIT newPredictionSuggestions(word, suggestions, strategy);
-    if (word != m_nextWord) {
-        Q_EMIT parsePredictionText(word);
-    } else {
-        m_processingWord = false;
-    }
-}
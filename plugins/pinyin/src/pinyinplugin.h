@@ -3,9 +3,9 @@
 
 #include <QObject>
 #include <QStringList>
-#include <QThread>
 #include "languageplugininterface.h"
 #include "abstractlanguageplugin.h"
+#include "taskexecutor.h"
 
 #include "pinyinadapter.h"
 #include <iostream>
@@ -22,29 +22,20 @@ public:
     explicit PinyinPlugin(QObject *parent = nullptr);
     ~PinyinPlugin() override;
 
-    void predict(const QString& surroundingLeft, const QString& preedit) override;
+    void predict(quint64 generation, const QStringList& context, const QString& preedit) override;
     void wordCandidateSelected(QString word) override;
 
     AbstractLanguageFeatures* languageFeature() override;
 
     //! spell checker
-    void spellCheckerSuggest(const QString& word, int limit) override { Q_UNUSED(word); Q_UNUSED(limit); }
+    void spellCheckerSuggest(quint64 generation, const QString& word, int limit) override { Q_UNUSED(generation); Q_UNUSED(word); Q_UNUSED(limit); }
     void addToSpellCheckerUserWordList(const QString& word) override { Q_UNUSED(word); }
     bool setLanguage(const QString& languageId, const QString& pluginPath) override { Q_UNUSED(languageId); Q_UNUSED(pluginPath); return false; }
 
-signals:
-    void parsePredictionText(QString preedit);
-    void candidateSelected(QString word);
-
-public slots:
-    void finishedProcessing(QString word, QStringList suggestions, int strategy = UpdateCandidateListStrategy::ClearWhenNeeded);
-
 private:
-    QThread *m_pinyinThread;
     PinyinAdapter *m_pinyinAdapter;
+    MaliitKeyboard::Logic::TaskStrand m_strand;
     ChineseLanguageFeatures* m_chineseLanguageFeatures;
-    QString m_nextWord;
-    bool m_processingWord;
 };
 
 #endif // PINYINPLUGIN_H
@@ -16,9 +16,13 @@
 
 #include "thailanguagefeatures.h"
 
+using MaliitKeyboard::Logic::CharacterClassTable;
+
 ThaiLanguageFeatures::ThaiLanguageFeatures(QObject *parent) :
     QObject(parent)
 {
+    addCharacters(CharacterClassTable::Separator, QString::fromUtf8("。、,!?:;.\r\n"));
+    addCharacters(CharacterClassTable::Symbol, QString::fromUtf8("*#+=()@~/\\€£$¥₹%<>[]`^|_§{}¡¿«»\"“”„&0123456789"));
 }
 
 ThaiLanguageFeatures::~ThaiLanguageFeatures()
@@ -46,33 +50,3 @@ QString ThaiLanguageFeatures::appendixForReplacedPreedit(const QString &preedit)
     Q_UNUSED(preedit)
     return QString("");
 }
-
-bool ThaiLanguageFeatures::isSeparator(const QString &text) const
-{
-    static const QString separators = QString::fromUtf8("。、,!?:;.\r\n");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (separators.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
-bool ThaiLanguageFeatures::isSymbol(const QString &text) const
-{
-    static const QString symbols = QString::fromUtf8("*#+=()@~/\\€£$¥₹%<>[]`^|_§{}¡¿«»\"“”„&0123456789");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (symbols.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "bloomfilter.h"
+
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const int MaxHashCount = 16;
+
+} // unnamed namespace
+
+//! Creates an empty filter, which contains nothing.
+BloomFilter::BloomFilter()
+    : m_bits()
+    , m_bit_count(0)
+    , m_hash_count(0)
+{}
+
+//! Sizes the filter for the given number of keys.
+//! \param expected_count How many keys are going to be inserted.
+//! \param false_positive_rate The wanted rate of false positives, in (0, 1).
+BloomFilter::BloomFilter(int expected_count, double false_positive_rate)
+    : m_bits()
+    , m_bit_count(0)
+    , m_hash_count(0)
+{
+    const double ln2 = std::log(2.0);
+    const double keys = qMax(expected_count, 1);
+    const double rate = qBound(1e-9, false_positive_rate, 0.5);
+
+    const double bits = std::ceil(-keys * std::log(rate) / (ln2 * ln2));
+    m_bit_count = quint32(qBound(64.0, bits, double(std::numeric_limits<qint32>::max())));
+    m_hash_count = qBound(1, int(std::lround(m_bit_count / keys * ln2)), MaxHashCount);
+    m_bits.fill(0, int((m_bit_count + 63) / 64));
+}
+
+//! Two independent hashes of the key, combined as first + i * second into
+//! the hashCount() bit positions (Kirsch and Mitzenmacher).
+void BloomFilter::hashes(const QString &key, quint32 *first, quint32 *second) const
+{
+    *first = qHash(key, 0x2545f491u);
+    *second = qHash(key, 0x9e3779b9u) | 1u;
+}
+
+void BloomFilter::insert(const QString &key)
+{
+    if (m_bit_count == 0) {
+        return;
+    }
+
+    quint32 first;
+    quint32 second;
+    hashes(key, &first, &second);
+
+    for (int i = 0; i < m_hash_count; ++i) {
+        const quint32 bit = (first + quint32(i) * second) % m_bit_count;
+        m_bits[bit / 64] |= quint64(1) << (bit % 64);
+    }
+}
+
+//! \return false if the key was certainly never inserted.
+bool BloomFilter::contains(const QString &key) const
+{
+    if (m_bit_count == 0) {
+        return false;
+    }
+
+    quint32 first;
+    quint32 second;
+    hashes(key, &first, &second);
+
+    for (int i = 0; i < m_hash_count; ++i) {
+        const quint32 bit = (first + quint32(i) * second) % m_bit_count;
+        if (not (m_bits.at(bit / 64) & (quint64(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! Releases the bits; the filter contains nothing afterwards.
+void BloomFilter::clear()
+{
+    m_bits.clear();
+    m_bit_count = 0;
+    m_hash_count = 0;
+}
+
+//! \return true for a filter that was never sized, or was cleared.
+bool BloomFilter::isNull() const
+{
+    return m_bit_count == 0;
+}
+
+int BloomFilter::bitCount() const
+{
+    return int(m_bit_count);
+}
+
+int BloomFilter::hashCount() const
+{
+    return m_hash_count;
+}
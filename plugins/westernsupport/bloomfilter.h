@@ -0,0 +1,62 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_BLOOMFILTER_H
+#define MALIIT_KEYBOARD_BLOOMFILTER_H
+
+#include <QtCore>
+
+//! \class BloomFilter
+//! Set of strings that can answer "definitely not in the set" without
+//! storing the strings.
+//!
+//! contains() never misses an inserted key; it wrongly reports a key that
+//! was never inserted with roughly the false positive rate given when the
+//! filter was sized. Each key costs about ten bits at a 1% rate.
+class BloomFilter
+{
+public:
+    BloomFilter();
+    BloomFilter(int expected_count, double false_positive_rate);
+
+    void insert(const QString &key);
+    bool contains(const QString &key) const;
+
+    void clear();
+    bool isNull() const;
+    int bitCount() const;
+    int hashCount() const;
+
+private:
+    void hashes(const QString &key, quint32 *first, quint32 *second) const;
+
+    QVector<quint64> m_bits;
+    quint32 m_bit_count;
+    int m_hash_count;
+};
+
+#endif // MALIIT_KEYBOARD_BLOOMFILTER_H
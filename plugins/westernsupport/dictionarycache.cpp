@@ -0,0 +1,1276 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "dictionarycache.h"
+#include "dictionarycacheformat.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QSaveFile>
+#include <QTextCodec>
+
+#include <algorithm>
+#include <cstring>
+
+//! \class DictionaryCache
+//! Compiled form of a Hunspell .aff/.dic pair. Building a Hunspell instance
+//! parses both text files and hashes every stem, which takes hundreds of
+//! milliseconds for large dictionaries. The cache does that work once,
+//! stores the stems and the prefix and suffix tables in a file under the
+//! XDG cache directory (see dictionarycacheformat.h) and maps it, so opening
+//! a language is a single mmap() and the pages are shared between processes.
+//!
+//! check() strips at most one prefix and one suffix, like Hunspell does for
+//! dictionaries without compounds or two-level affixes. For other
+//! dictionaries only positive answers are definite, and misses are reported
+//! as Unknown so that the caller can ask Hunspell.
+
+namespace {
+
+const quint16 NoFlag = 0;
+
+// Directives that only affect suggestions or metadata, never which words
+// are accepted. Anything not listed here, and not handled by the parser,
+// makes the cache inexact.
+const char *const NeutralDirectives[] = {
+    "TRY", "KEY", "WORDCHARS", "REP", "MAP", "PHONE", "NAME", "VERSION",
+    "HOME", "NOSUGGEST", "MAXNGRAMSUGS", "MAXCPDSUGS", "MAXDIFF",
+    "ONLYMAXDIFF", "NOSPLITSUGS", "SUGSWITHDOTS", "AM", "WARN",
+    "FORBIDWARN", "SUBSTANDARD"
+};
+
+enum FlagType {
+    CharFlags,
+    LongFlags,
+    NumericFlags,
+    UnicodeFlags
+};
+
+enum CaseType {
+    LowerCase,
+    InitialCase,
+    AllCaps,
+    MixedCase
+};
+
+typedef QVector<quint16> FlagList;
+
+struct AffixRule
+{
+    QString strip;
+    QString append;
+    QString condition;
+    FlagList continuation;
+    quint16 flag;
+    bool cross_product;
+};
+
+struct AffixBlock
+{
+    bool cross_product;
+    int remaining;
+};
+
+bool isNeutralDirective(const QString &directive)
+{
+    for (const char *neutral : NeutralDirectives) {
+        if (directive == QLatin1String(neutral)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+CaseType caseType(const QString &word)
+{
+    int upper = 0;
+    int letters = 0;
+    for (const QChar &c : word) {
+        if (c.isLetter()) {
+            ++letters;
+            if (c.isUpper()) {
+                ++upper;
+            }
+        }
+    }
+
+    if (upper == 0) {
+        return LowerCase;
+    }
+    if (upper == letters) {
+        return AllCaps;
+    }
+    if (upper == 1 && word.at(0).isUpper()) {
+        return InitialCase;
+    }
+    return MixedCase;
+}
+
+// Hunspell splits words at hyphens, trims dots and accepts numbers before
+// looking anything up. The cache only answers definitely for plain words.
+bool isPlainWord(const QString &word)
+{
+    for (const QChar &c : word) {
+        if (not c.isLetter() && c != QLatin1Char('\'')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! Compares text against the key; for suffixes both are read backwards.
+int compareText(const char16_t *text, int text_length,
+                const QChar *key, int key_length, bool backwards)
+{
+    const int common = qMin(text_length, key_length);
+
+    for (int i = 0; i < common; ++i) {
+        const ushort a = backwards ? text[text_length - 1 - i] : text[i];
+        const ushort b = backwards ? key[key_length - 1 - i].unicode() : key[i].unicode();
+        if (a != b) {
+            return a < b ? -1 : 1;
+        }
+    }
+
+    return text_length == key_length ? 0 : (text_length < key_length ? -1 : 1);
+}
+
+int compareReversed(const QString &a, const QString &b)
+{
+    return compareText(reinterpret_cast<const char16_t *>(a.constData()), a.length(),
+                       b.constData(), b.length(), true);
+}
+
+//! Number of characters a Hunspell condition ("[^aeiou]y", ".") spans.
+int conditionLength(const char16_t *condition, int length)
+{
+    int elements = 0;
+    for (int i = 0; i < length; ++i, ++elements) {
+        if (condition[i] == u'[') {
+            while (i < length && condition[i] != u']') {
+                ++i;
+            }
+        }
+    }
+    return elements;
+}
+
+//! Matches the condition against the beginning of text, or its end.
+bool matchCondition(const char16_t *condition, int length,
+                    const QChar *text, int text_length, bool at_end)
+{
+    if (length == 0 || (length == 1 && condition[0] == u'.')) {
+        return true;
+    }
+
+    const int elements = conditionLength(condition, length);
+    if (elements > text_length) {
+        return false;
+    }
+
+    int position = at_end ? text_length - elements : 0;
+    for (int i = 0; i < length; ++i, ++position) {
+        const ushort c = text[position].unicode();
+
+        if (condition[i] == u'[') {
+            ++i;
+            const bool negated = (i < length && condition[i] == u'^');
+            if (negated) {
+                ++i;
+            }
+
+            bool found = false;
+            for (; i < length && condition[i] != u']'; ++i) {
+                found = found || condition[i] == c;
+            }
+            if (found == negated) {
+                return false;
+            }
+        } else if (condition[i] != u'.' && condition[i] != c) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//! Parses a Hunspell dictionary into the tables stored by the cache.
+class DictionarySource
+{
+public:
+    DictionarySource();
+
+    bool parseAffixFile(const QString &file_name);
+    bool parseDictionaryFile(const QString &file_name);
+    QByteArray serialize(const QFileInfo &aff_info, const QFileInfo &dic_info) const;
+
+private:
+    bool readLines(const QString &file_name, QStringList *lines);
+    FlagList parseFlags(const QString &text, bool aliased) const;
+    quint16 parseFlag(const QString &text) const;
+    void parseAffix(const QStringList &tokens, bool prefix);
+    void parseCompoundRule(const QString &rule);
+    void addStem(const QString &word, const FlagList &flags);
+
+    QTextCodec *m_codec;
+    FlagType m_flag_type;
+    QVector<FlagList> m_aliases;
+    int m_aliases_expected;
+    int m_compound_rules_expected;
+    QSet<quint16> m_compound_rule_flags;
+    QHash<quint32, AffixBlock> m_blocks;
+    QVector<AffixRule> m_prefixes;
+    QVector<AffixRule> m_suffixes;
+    QHash<QString, FlagList> m_stems;
+    quint16 m_need_affix;
+    quint16 m_forbidden;
+    quint16 m_keep_case;
+    quint16 m_only_in_compound;
+    bool m_exact;
+};
+
+DictionarySource::DictionarySource()
+    : m_codec(QTextCodec::codecForName("ISO-8859-1"))
+    , m_flag_type(CharFlags)
+    , m_aliases()
+    , m_aliases_expected(-1)
+    , m_compound_rules_expected(-1)
+    , m_compound_rule_flags()
+    , m_blocks()
+    , m_prefixes()
+    , m_suffixes()
+    , m_stems()
+    , m_need_affix(NoFlag)
+    , m_forbidden(NoFlag)
+    , m_keep_case(NoFlag)
+    , m_only_in_compound(NoFlag)
+    , m_exact(true)
+{}
+
+bool DictionarySource::readLines(const QString &file_name, QStringList *lines)
+{
+    QFile file(file_name);
+    if (not file.open(QIODevice::ReadOnly)) {
+        qWarning() << __PRETTY_FUNCTION__ << "Cannot read" << file_name << file.errorString();
+        return false;
+    }
+
+    QString text = m_codec->toUnicode(file.readAll());
+    if (text.startsWith(QChar(0xfeff))) {
+        text.remove(0, 1);
+    }
+
+    *lines = text.split(QLatin1Char('\n'));
+    return true;
+}
+
+bool DictionarySource::parseAffixFile(const QString &file_name)
+{
+    // The encoding is declared inside the file, so find it before decoding.
+    QFile file(file_name);
+    if (not file.open(QIODevice::ReadOnly)) {
+        qWarning() << __PRETTY_FUNCTION__ << "Cannot read" << file_name << file.errorString();
+        return false;
+    }
+
+    while (not file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.startsWith("\xef\xbb\xbf")) {
+            line.remove(0, 3);
+        }
+        if (line.startsWith("SET ")) {
+            const QByteArray encoding = line.mid(4).trimmed();
+            m_codec = QTextCodec::codecForName(encoding);
+            if (not m_codec) {
+                qWarning() << __PRETTY_FUNCTION__ << "Unknown dictionary encoding" << encoding;
+                return false;
+            }
+            break;
+        }
+    }
+    file.close();
+
+    QStringList lines;
+    if (not readLines(file_name, &lines)) {
+        return false;
+    }
+
+    for (const QString &line : lines) {
+        const QStringList tokens = line.simplified().split(QLatin1Char(' '), QString::SkipEmptyParts);
+        if (tokens.isEmpty() || tokens.first().startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+
+        const QString &directive = tokens.first();
+        const QString argument = tokens.value(1);
+
+        if (directive == QLatin1String("SET")) {
+            continue;
+        } else if (directive == QLatin1String("FLAG")) {
+            if (argument == QLatin1String("long")) {
+                m_flag_type = LongFlags;
+            } else if (argument == QLatin1String("num")) {
+                m_flag_type = NumericFlags;
+            } else if (argument == QLatin1String("UTF-8")) {
+                m_flag_type = UnicodeFlags;
+            }
+        } else if (directive == QLatin1String("AF")) {
+            if (m_aliases_expected < 0) {
+                m_aliases_expected = argument.toInt();
+            } else {
+                m_aliases.append(parseFlags(argument, false));
+            }
+        } else if (directive == QLatin1String("NEEDAFFIX") || directive == QLatin1String("PSEUDOROOT")) {
+            m_need_affix = parseFlag(argument);
+        } else if (directive == QLatin1String("FORBIDDENWORD")) {
+            m_forbidden = parseFlag(argument);
+        } else if (directive == QLatin1String("KEEPCASE")) {
+            m_keep_case = parseFlag(argument);
+        } else if (directive == QLatin1String("ONLYINCOMPOUND")) {
+            m_only_in_compound = parseFlag(argument);
+        } else if (directive == QLatin1String("PFX") || directive == QLatin1String("SFX")) {
+            parseAffix(tokens, directive == QLatin1String("PFX"));
+        } else if (directive == QLatin1String("COMPOUNDRULE")) {
+            if (m_compound_rules_expected < 0) {
+                m_compound_rules_expected = argument.toInt();
+            } else {
+                parseCompoundRule(argument);
+            }
+        } else if (directive == QLatin1String("COMPOUNDMIN")) {
+            continue;
+        } else if (directive == QLatin1String("ICONV")) {
+            // Conversions of punctuation such as typographic apostrophes
+            // only touch words the cache leaves to Hunspell anyway.
+            if (tokens.size() > 2 && not isPlainWord(argument)) {
+                continue;
+            }
+            m_exact = m_exact && tokens.size() == 2;
+        } else if (directive == QLatin1String("LANG")) {
+            // Turkic languages fold i and I differently from QString.
+            m_exact = m_exact && not argument.startsWith(QLatin1String("tr"))
+                    && not argument.startsWith(QLatin1String("az"))
+                    && not argument.startsWith(QLatin1String("crh"));
+        } else if (directive == QLatin1String("BREAK")) {
+            m_exact = m_exact && argument == QLatin1String("0");
+        } else if (not isNeutralDirective(directive)) {
+            m_exact = false;
+        }
+    }
+
+    // Affixed forms that need a further affix, or only occur inside
+    // compounds, are not words on their own.
+    const auto incomplete = [this](const AffixRule &rule) {
+        return (m_need_affix != NoFlag && rule.continuation.contains(m_need_affix))
+            || (m_only_in_compound != NoFlag && rule.continuation.contains(m_only_in_compound));
+    };
+    m_prefixes.erase(std::remove_if(m_prefixes.begin(), m_prefixes.end(), incomplete), m_prefixes.end());
+    m_suffixes.erase(std::remove_if(m_suffixes.begin(), m_suffixes.end(), incomplete), m_suffixes.end());
+
+    return true;
+}
+
+//! Parses "PFX A Y 2" block headers and "PFX A strip append[/flags] condition"
+//! rules.
+void DictionarySource::parseAffix(const QStringList &tokens, bool prefix)
+{
+    if (tokens.size() < 4) {
+        return;
+    }
+
+    const quint16 flag = parseFlag(tokens.at(1));
+    const quint32 key = (prefix ? 0x10000 : 0) | flag;
+    auto block = m_blocks.find(key);
+
+    if (block == m_blocks.end() || block->remaining <= 0) {
+        m_blocks.insert(key, AffixBlock{ tokens.at(2) == QLatin1String("Y"), tokens.at(3).toInt() });
+        return;
+    }
+
+    --block->remaining;
+
+    AffixRule rule;
+    rule.flag = flag;
+    rule.cross_product = block->cross_product;
+    rule.strip = tokens.at(2) == QLatin1String("0") ? QString() : tokens.at(2);
+
+    QString append = tokens.at(3);
+    const int slash = append.indexOf(QLatin1Char('/'));
+    if (slash >= 0) {
+        rule.continuation = parseFlags(append.mid(slash + 1), true);
+        append.truncate(slash);
+        // Two-level affixes are not followed by the cache.
+        m_exact = m_exact && rule.continuation.isEmpty();
+    }
+    rule.append = append == QLatin1String("0") ? QString() : append;
+    rule.condition = tokens.value(4, QStringLiteral("."));
+
+    (prefix ? m_prefixes : m_suffixes).append(rule);
+}
+
+bool DictionarySource::parseDictionaryFile(const QString &file_name)
+{
+    QStringList lines;
+    if (not readLines(file_name, &lines)) {
+        return false;
+    }
+
+    // The first line holds the approximate number of entries.
+    m_stems.reserve(lines.value(0).trimmed().toInt());
+
+    for (int i = 1; i < lines.size(); ++i) {
+        const QString &line = lines.at(i);
+        if (line.isEmpty() || line.at(0) == QLatin1Char('\t') || line.at(0) == QLatin1Char('#')) {
+            continue;
+        }
+
+        // word[/flags][<whitespace>morphological fields], with "\/" for a
+        // slash inside the word.
+        QString word;
+        QString flags;
+        int position = 0;
+        for (; position < line.length(); ++position) {
+            const QChar c = line.at(position);
+            if (c == QLatin1Char('\\') && position + 1 < line.length()
+                    && line.at(position + 1) == QLatin1Char('/')) {
+                word.append(QLatin1Char('/'));
+                ++position;
+            } else if (c == QLatin1Char('/')) {
+                int end = position + 1;
+                while (end < line.length() && not line.at(end).isSpace()) {
+                    ++end;
+                }
+                flags = line.mid(position + 1, end - position - 1);
+                break;
+            } else if (c == QLatin1Char('\t') || c == QLatin1Char('\r')) {
+                break;
+            } else if (c == QLatin1Char(' ') && line.indexOf(QLatin1Char(':'), position) == position + 3) {
+                // Start of a morphological field such as " po:noun".
+                break;
+            } else {
+                word.append(c);
+            }
+        }
+
+        word = word.trimmed();
+        if (not word.isEmpty()) {
+            addStem(word, parseFlags(flags, true));
+        }
+    }
+
+    return true;
+}
+
+//! Merges homonyms. A word listed once without NEEDAFFIX stays a word on
+//! its own even if another entry for it needs an affix.
+void DictionarySource::addStem(const QString &word, const FlagList &flags)
+{
+    // Compound rules that only combine numbers and suffixes ("1st",
+    // "22nd") never apply to plain words, so they do not make the cache
+    // inexact unless a plain word takes part in one.
+    if (m_exact && isPlainWord(word)) {
+        for (quint16 flag : flags) {
+            if (m_compound_rule_flags.contains(flag)) {
+                m_exact = false;
+                break;
+            }
+        }
+    }
+
+    auto stem = m_stems.find(word);
+    if (stem == m_stems.end()) {
+        m_stems.insert(word, flags);
+        return;
+    }
+
+    const quint16 standalone[] = { m_need_affix, m_only_in_compound };
+    for (quint16 flag : standalone) {
+        if (flag != NoFlag && not (stem->contains(flag) && flags.contains(flag))) {
+            stem->removeAll(flag);
+        }
+    }
+
+    for (quint16 flag : flags) {
+        if (not stem->contains(flag) && flag != m_need_affix && flag != m_only_in_compound) {
+            stem->append(flag);
+        }
+    }
+}
+
+//! Collects the flags used in a rule such as "n*1t" or "(aa)(bb)*".
+void DictionarySource::parseCompoundRule(const QString &rule)
+{
+    if (m_flag_type == CharFlags || m_flag_type == UnicodeFlags) {
+        for (const QChar &c : rule) {
+            if (c != QLatin1Char('*') && c != QLatin1Char('?')
+                    && c != QLatin1Char('(') && c != QLatin1Char(')')) {
+                m_compound_rule_flags.insert(c.unicode());
+            }
+        }
+        return;
+    }
+
+    int open = rule.indexOf(QLatin1Char('('));
+    while (open >= 0) {
+        const int close = rule.indexOf(QLatin1Char(')'), open);
+        if (close < 0) {
+            break;
+        }
+        m_compound_rule_flags.insert(parseFlag(rule.mid(open + 1, close - open - 1)));
+        open = rule.indexOf(QLatin1Char('('), close);
+    }
+}
+
+quint16 DictionarySource::parseFlag(const QString &text) const
+{
+    const FlagList flags = parseFlags(text, false);
+    return flags.isEmpty() ? NoFlag : flags.first();
+}
+
+FlagList DictionarySource::parseFlags(const QString &text, bool aliased) const
+{
+    FlagList flags;
+
+    if (text.isEmpty()) {
+        return flags;
+    }
+
+    if (aliased && not m_aliases.isEmpty()) {
+        return m_aliases.value(text.toInt() - 1);
+    }
+
+    switch (m_flag_type) {
+    case CharFlags:
+    case UnicodeFlags:
+        for (const QChar &c : text) {
+            flags.append(c.unicode());
+        }
+        break;
+    case LongFlags:
+        for (int i = 0; i + 1 < text.length(); i += 2) {
+            flags.append(quint16((text.at(i).unicode() << 8) | (text.at(i + 1).unicode() & 0xff)));
+        }
+        break;
+    case NumericFlags:
+        for (const QStringRef &number : text.splitRef(QLatin1Char(','), QString::SkipEmptyParts)) {
+            flags.append(quint16(number.toUInt()));
+        }
+        break;
+    }
+
+    flags.removeAll(NoFlag);
+    return flags;
+}
+
+QByteArray DictionarySource::serialize(const QFileInfo &aff_info, const QFileInfo &dic_info) const
+{
+    QStringList words = m_stems.keys();
+    std::sort(words.begin(), words.end());
+
+    QString pool;
+    QVector<quint32> stem_offsets;
+    QVector<quint32> flag_offsets;
+    QVector<quint16> flag_pool;
+
+    stem_offsets.reserve(words.size() + 1);
+    flag_offsets.reserve(words.size() + 1);
+
+    for (const QString &word : words) {
+        stem_offsets.append(pool.length());
+        flag_offsets.append(flag_pool.size());
+        pool.append(word);
+
+        FlagList flags = m_stems.value(word);
+        std::sort(flags.begin(), flags.end());
+        flags.erase(std::unique(flags.begin(), flags.end()), flags.end());
+        flag_pool += flags;
+    }
+    stem_offsets.append(pool.length());
+    flag_offsets.append(flag_pool.size());
+
+    QVector<AffixRule> prefixes(m_prefixes);
+    QVector<AffixRule> suffixes(m_suffixes);
+    std::stable_sort(prefixes.begin(), prefixes.end(), [](const AffixRule &a, const AffixRule &b) {
+        return a.append < b.append;
+    });
+    std::stable_sort(suffixes.begin(), suffixes.end(), [](const AffixRule &a, const AffixRule &b) {
+        return compareReversed(a.append, b.append) < 0;
+    });
+
+    const auto toAffixes = [&pool](const QVector<AffixRule> &rules) {
+        QVector<DictionaryFormat::Affix> affixes;
+        for (const AffixRule &rule : rules) {
+            DictionaryFormat::Affix affix;
+            std::memset(&affix, 0, sizeof(affix));
+            affix.flag = rule.flag;
+            affix.crossProduct = rule.cross_product ? 1 : 0;
+            affix.stripOffset = pool.length();
+            affix.stripLength = rule.strip.length();
+            pool.append(rule.strip);
+            affix.appendOffset = pool.length();
+            affix.appendLength = rule.append.length();
+            pool.append(rule.append);
+            affix.conditionOffset = pool.length();
+            affix.conditionLength = rule.condition.length();
+            pool.append(rule.condition);
+            affixes.append(affix);
+        }
+        return affixes;
+    };
+    const QVector<DictionaryFormat::Affix> prefix_table = toAffixes(prefixes);
+    const QVector<DictionaryFormat::Affix> suffix_table = toAffixes(suffixes);
+
+    DictionaryFormat::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, DictionaryFormat::Magic, sizeof(header.magic));
+    header.version = DictionaryFormat::Version;
+    header.options = m_exact ? DictionaryFormat::Exact : 0;
+    header.stemCount = words.size();
+    header.prefixCount = prefix_table.size();
+    header.suffixCount = suffix_table.size();
+    header.needAffixFlag = m_need_affix;
+    header.forbiddenWordFlag = m_forbidden;
+    header.keepCaseFlag = m_keep_case;
+    header.onlyInCompoundFlag = m_only_in_compound;
+    header.stringPoolLength = pool.length();
+    header.affixFileSize = aff_info.size();
+    header.affixFileModified = aff_info.lastModified().toMSecsSinceEpoch();
+    header.dictionaryFileSize = dic_info.size();
+    header.dictionaryFileModified = dic_info.lastModified().toMSecsSinceEpoch();
+
+    quint64 offset = DictionaryFormat::align(sizeof(header));
+    header.stemOffsetsOffset = offset;
+    offset = DictionaryFormat::align(offset + stem_offsets.size() * sizeof(quint32));
+    header.flagOffsetsOffset = offset;
+    offset = DictionaryFormat::align(offset + flag_offsets.size() * sizeof(quint32));
+    header.flagPoolOffset = offset;
+    offset = DictionaryFormat::align(offset + flag_pool.size() * sizeof(quint16));
+    header.prefixesOffset = offset;
+    offset = DictionaryFormat::align(offset + prefix_table.size() * sizeof(DictionaryFormat::Affix));
+    header.suffixesOffset = offset;
+    offset = DictionaryFormat::align(offset + suffix_table.size() * sizeof(DictionaryFormat::Affix));
+    header.stringPoolOffset = offset;
+    offset = DictionaryFormat::align(offset + pool.length() * sizeof(char16_t));
+    header.fileSize = offset;
+
+    QByteArray data(int(offset), '\0');
+    char *out = data.data();
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + header.stemOffsetsOffset, stem_offsets.constData(), stem_offsets.size() * sizeof(quint32));
+    std::memcpy(out + header.flagOffsetsOffset, flag_offsets.constData(), flag_offsets.size() * sizeof(quint32));
+    std::memcpy(out + header.flagPoolOffset, flag_pool.constData(), flag_pool.size() * sizeof(quint16));
+    std::memcpy(out + header.prefixesOffset, prefix_table.constData(), prefix_table.size() * sizeof(DictionaryFormat::Affix));
+    std::memcpy(out + header.suffixesOffset, suffix_table.constData(), suffix_table.size() * sizeof(DictionaryFormat::Affix));
+    std::memcpy(out + header.stringPoolOffset, pool.constData(), pool.length() * sizeof(char16_t));
+
+    return data;
+}
+
+} // unnamed namespace
+
+class DictionaryCachePrivate
+{
+public:
+    QFile file;
+    const uchar *data;
+    const DictionaryFormat::Header *header;
+    const quint32 *stem_offsets;
+    const quint32 *flag_offsets;
+    const quint16 *flag_pool;
+    const DictionaryFormat::Affix *prefixes;
+    const DictionaryFormat::Affix *suffixes;
+    const char16_t *string_pool;
+
+    DictionaryCachePrivate();
+
+    void reset();
+    bool map(const QString &file_name, const QFileInfo &aff_info, const QFileInfo &dic_info);
+    bool validate(qint64 size, const QFileInfo &aff_info, const QFileInfo &dic_info) const;
+
+    int findStem(const QChar *text, int length) const;
+    bool hasFlag(int stem, quint16 flag) const;
+    bool checkRoot(const QChar *text, int length, quint16 flag, quint16 other_flag, bool keep_case) const;
+    bool checkPrefixes(const QChar *text, int length, quint16 suffix_flag, bool keep_case) const;
+    bool checkSuffixes(const QChar *text, int length, bool keep_case) const;
+    bool accepts(const QString &word, bool keep_case) const;
+    QString stem(quint32 index) const;
+    QString affixText(quint32 offset, int length) const;
+    bool applySuffix(const DictionaryFormat::Affix &affix, const QString &root, QString *form) const;
+    bool applyPrefix(const DictionaryFormat::Affix &affix, const QString &root, QString *form) const;
+};
+
+DictionaryCachePrivate::DictionaryCachePrivate()
+    : file()
+    , data(nullptr)
+    , header(nullptr)
+    , stem_offsets(nullptr)
+    , flag_offsets(nullptr)
+    , flag_pool(nullptr)
+    , prefixes(nullptr)
+    , suffixes(nullptr)
+    , string_pool(nullptr)
+{}
+
+void DictionaryCachePrivate::reset()
+{
+    data = nullptr;
+    header = nullptr;
+    stem_offsets = nullptr;
+    flag_offsets = nullptr;
+    flag_pool = nullptr;
+    prefixes = nullptr;
+    suffixes = nullptr;
+    string_pool = nullptr;
+}
+
+bool DictionaryCachePrivate::map(const QString &file_name, const QFileInfo &aff_info, const QFileInfo &dic_info)
+{
+    file.setFileName(file_name);
+    if (not file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 size = file.size();
+    if (size < qint64(sizeof(DictionaryFormat::Header))) {
+        return false;
+    }
+
+    data = file.map(0, size);
+    if (not data) {
+        qWarning() << "Cannot map dictionary cache" << file_name << file.errorString();
+        return false;
+    }
+
+    header = reinterpret_cast<const DictionaryFormat::Header *>(data);
+    if (not validate(size, aff_info, dic_info)) {
+        return false;
+    }
+
+    stem_offsets = reinterpret_cast<const quint32 *>(data + header->stemOffsetsOffset);
+    flag_offsets = reinterpret_cast<const quint32 *>(data + header->flagOffsetsOffset);
+    flag_pool = reinterpret_cast<const quint16 *>(data + header->flagPoolOffset);
+    prefixes = reinterpret_cast<const DictionaryFormat::Affix *>(data + header->prefixesOffset);
+    suffixes = reinterpret_cast<const DictionaryFormat::Affix *>(data + header->suffixesOffset);
+    string_pool = reinterpret_cast<const char16_t *>(data + header->stringPoolOffset);
+    return true;
+}
+
+//! Rejects foreign, truncated, damaged and stale files, which are simply
+//! compiled again.
+bool DictionaryCachePrivate::validate(qint64 size, const QFileInfo &aff_info, const QFileInfo &dic_info) const
+{
+    if (size < qint64(sizeof(DictionaryFormat::Header))
+        || memcmp(header->magic, DictionaryFormat::Magic, sizeof(header->magic)) != 0
+        || header->version != DictionaryFormat::Version
+        || header->fileSize != quint64(size)) {
+        return false;
+    }
+
+    if (header->affixFileSize != aff_info.size()
+        || header->affixFileModified != aff_info.lastModified().toMSecsSinceEpoch()
+        || header->dictionaryFileSize != dic_info.size()
+        || header->dictionaryFileModified != dic_info.lastModified().toMSecsSinceEpoch()) {
+        return false;
+    }
+
+    const auto fits = [size](quint64 offset, quint64 bytes) {
+        return offset <= quint64(size) && bytes <= quint64(size) - offset;
+    };
+
+    const quint64 stems = header->stemCount;
+    if (not fits(header->stemOffsetsOffset, (stems + 1) * sizeof(quint32))
+        || not fits(header->flagOffsetsOffset, (stems + 1) * sizeof(quint32))
+        || not fits(header->prefixesOffset, header->prefixCount * sizeof(DictionaryFormat::Affix))
+        || not fits(header->suffixesOffset, header->suffixCount * sizeof(DictionaryFormat::Affix))
+        || not fits(header->stringPoolOffset, header->stringPoolLength * sizeof(char16_t))) {
+        return false;
+    }
+
+    if (header->stemOffsetsOffset % sizeof(quint32) != 0
+        || header->flagOffsetsOffset % sizeof(quint32) != 0
+        || header->flagPoolOffset % sizeof(quint16) != 0
+        || header->prefixesOffset % alignof(DictionaryFormat::Affix) != 0
+        || header->suffixesOffset % alignof(DictionaryFormat::Affix) != 0
+        || header->stringPoolOffset % sizeof(char16_t) != 0) {
+        return false;
+    }
+
+    // Lookups take the extent of a stem and of its flags from two
+    // neighbouring offsets, so every one of them must be in order.
+    const quint32 *stem_ends = reinterpret_cast<const quint32 *>(data + header->stemOffsetsOffset);
+    const quint32 *flag_ends = reinterpret_cast<const quint32 *>(data + header->flagOffsetsOffset);
+    for (quint64 i = 0; i < stems; ++i) {
+        if (stem_ends[i] > stem_ends[i + 1] || flag_ends[i] > flag_ends[i + 1]) {
+            return false;
+        }
+    }
+
+    if (stem_ends[stems] > header->stringPoolLength
+        || not fits(header->flagPoolOffset, quint64(flag_ends[stems]) * sizeof(quint16))) {
+        return false;
+    }
+
+    const DictionaryFormat::Affix *affixes[] = {
+        reinterpret_cast<const DictionaryFormat::Affix *>(data + header->prefixesOffset),
+        reinterpret_cast<const DictionaryFormat::Affix *>(data + header->suffixesOffset)
+    };
+    const quint32 counts[] = { header->prefixCount, header->suffixCount };
+    const quint64 pool_length = header->stringPoolLength;
+
+    for (int kind = 0; kind < 2; ++kind) {
+        for (quint32 i = 0; i < counts[kind]; ++i) {
+            const DictionaryFormat::Affix &affix = affixes[kind][i];
+            if (quint64(affix.stripOffset) + affix.stripLength > pool_length
+                || quint64(affix.appendOffset) + affix.appendLength > pool_length
+                || quint64(affix.conditionOffset) + affix.conditionLength > pool_length) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int DictionaryCachePrivate::findStem(const QChar *text, int length) const
+{
+    quint32 begin = 0;
+    quint32 count = header->stemCount;
+
+    while (count > 0) {
+        const quint32 step = count / 2;
+        const quint32 middle = begin + step;
+        const quint32 offset = stem_offsets[middle];
+        if (compareText(string_pool + offset, stem_offsets[middle + 1] - offset, text, length, false) < 0) {
+            begin = middle + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    if (begin < header->stemCount) {
+        const quint32 offset = stem_offsets[begin];
+        if (compareText(string_pool + offset, stem_offsets[begin + 1] - offset, text, length, false) == 0) {
+            return int(begin);
+        }
+    }
+
+    return -1;
+}
+
+bool DictionaryCachePrivate::hasFlag(int stem, quint16 flag) const
+{
+    return std::binary_search(flag_pool + flag_offsets[stem], flag_pool + flag_offsets[stem + 1], flag);
+}
+
+//! Whether text is a stem carrying the flags of the affixes stripped from
+//! it (none, one, or a prefix and a suffix).
+bool DictionaryCachePrivate::checkRoot(const QChar *text, int length, quint16 flag, quint16 other_flag,
+                                       bool keep_case) const
+{
+    const int stem = findStem(text, length);
+    if (stem < 0) {
+        return false;
+    }
+
+    if ((flag != NoFlag && not hasFlag(stem, flag))
+        || (other_flag != NoFlag && not hasFlag(stem, other_flag))) {
+        return false;
+    }
+
+    const quint16 rejected[] = {
+        header->forbiddenWordFlag,
+        flag == NoFlag ? header->needAffixFlag : NoFlag,
+        header->onlyInCompoundFlag,
+        keep_case ? NoFlag : header->keepCaseFlag
+    };
+    for (quint16 r : rejected) {
+        if (r != NoFlag && hasFlag(stem, r)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DictionaryCachePrivate::checkPrefixes(const QChar *text, int length, quint16 suffix_flag,
+                                           bool keep_case) const
+{
+    const DictionaryFormat::Affix *end = prefixes + header->prefixCount;
+    QVarLengthArray<QChar, 64> root;
+
+    for (int appended = 0; appended < length; ++appended) {
+        const DictionaryFormat::Affix *rule = std::lower_bound(prefixes, end, appended,
+            [&](const DictionaryFormat::Affix &affix, int key_length) {
+                return compareText(string_pool + affix.appendOffset, affix.appendLength, text, key_length, false) < 0;
+            });
+
+        for (; rule != end && compareText(string_pool + rule->appendOffset, rule->appendLength,
+                                          text, appended, false) == 0; ++rule) {
+            if (suffix_flag != NoFlag && not rule->crossProduct) {
+                continue;
+            }
+
+            root.clear();
+            root.append(reinterpret_cast<const QChar *>(string_pool + rule->stripOffset), rule->stripLength);
+            root.append(text + appended, length - appended);
+
+            if (matchCondition(string_pool + rule->conditionOffset, rule->conditionLength,
+                               root.constData(), root.size(), false)
+                && checkRoot(root.constData(), root.size(), rule->flag, suffix_flag, keep_case)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool DictionaryCachePrivate::checkSuffixes(const QChar *text, int length, bool keep_case) const
+{
+    const DictionaryFormat::Affix *end = suffixes + header->suffixCount;
+    QVarLengthArray<QChar, 64> root;
+
+    for (int appended = 0; appended < length; ++appended) {
+        const QChar *key = text + length - appended;
+        const DictionaryFormat::Affix *rule = std::lower_bound(suffixes, end, appended,
+            [&](const DictionaryFormat::Affix &affix, int key_length) {
+                return compareText(string_pool + affix.appendOffset, affix.appendLength, key, key_length, true) < 0;
+            });
+
+        for (; rule != end && compareText(string_pool + rule->appendOffset, rule->appendLength,
+                                          key, appended, true) == 0; ++rule) {
+            root.clear();
+            root.append(text, length - appended);
+            root.append(reinterpret_cast<const QChar *>(string_pool + rule->stripOffset), rule->stripLength);
+
+            if (not matchCondition(string_pool + rule->conditionOffset, rule->conditionLength,
+                                   root.constData(), root.size(), true)) {
+                continue;
+            }
+
+            if (checkRoot(root.constData(), root.size(), rule->flag, NoFlag, keep_case)
+                || (rule->crossProduct && checkPrefixes(root.constData(), root.size(), rule->flag, keep_case))) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool DictionaryCachePrivate::accepts(const QString &word, bool keep_case) const
+{
+    const QChar *text = word.constData();
+    const int length = word.length();
+
+    return checkRoot(text, length, NoFlag, NoFlag, keep_case)
+        || checkSuffixes(text, length, keep_case)
+        || checkPrefixes(text, length, NoFlag, keep_case);
+}
+
+QString DictionaryCachePrivate::stem(quint32 index) const
+{
+    const quint32 begin = stem_offsets[index];
+    return QString(reinterpret_cast<const QChar *>(string_pool + begin), stem_offsets[index + 1] - begin);
+}
+
+QString DictionaryCachePrivate::affixText(quint32 offset, int length) const
+{
+    return QString(reinterpret_cast<const QChar *>(string_pool + offset), length);
+}
+
+//! The reverse of checkSuffixes(): derives a form from root.
+bool DictionaryCachePrivate::applySuffix(const DictionaryFormat::Affix &affix, const QString &root,
+                                         QString *form) const
+{
+    if (root.length() <= affix.stripLength
+        || not root.endsWith(affixText(affix.stripOffset, affix.stripLength))
+        || not matchCondition(string_pool + affix.conditionOffset, affix.conditionLength,
+                              root.constData(), root.length(), true)) {
+        return false;
+    }
+
+    *form = root.left(root.length() - affix.stripLength)
+            + affixText(affix.appendOffset, affix.appendLength);
+    return true;
+}
+
+bool DictionaryCachePrivate::applyPrefix(const DictionaryFormat::Affix &affix, const QString &root,
+                                         QString *form) const
+{
+    if (root.length() <= affix.stripLength
+        || not root.startsWith(affixText(affix.stripOffset, affix.stripLength))
+        || not matchCondition(string_pool + affix.conditionOffset, affix.conditionLength,
+                              root.constData(), root.length(), false)) {
+        return false;
+    }
+
+    *form = affixText(affix.appendOffset, affix.appendLength) + root.mid(affix.stripLength);
+    return true;
+}
+
+DictionaryCache::DictionaryCache()
+    : d_ptr(new DictionaryCachePrivate)
+{}
+
+DictionaryCache::~DictionaryCache()
+{
+    close();
+}
+
+//! Maps the compiled form of the given dictionary, compiling it first if
+//! there is no cache yet or the dictionary changed since. Returns false,
+//! leaving the cache closed, if the dictionary cannot be compiled.
+bool DictionaryCache::open(const QString &aff_file, const QString &dic_file)
+{
+    Q_D(DictionaryCache);
+
+    close();
+
+    const QFileInfo aff_info(aff_file);
+    const QFileInfo dic_info(dic_file);
+    const QString file_name = cacheFileName(aff_file, dic_file);
+
+    if (d->map(file_name, aff_info, dic_info)) {
+        return true;
+    }
+    close();
+
+    if (not compile(aff_file, dic_file, file_name) || not d->map(file_name, aff_info, dic_info)) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void DictionaryCache::close()
+{
+    Q_D(DictionaryCache);
+
+    if (d->data) {
+        d->file.unmap(const_cast<uchar *>(d->data));
+    }
+
+    d->file.close();
+    d->reset();
+}
+
+bool DictionaryCache::isOpen() const
+{
+    Q_D(const DictionaryCache);
+    return d->header != nullptr;
+}
+
+//! Whether misses are definite, see DictionaryFormat::Exact.
+bool DictionaryCache::isExact() const
+{
+    Q_D(const DictionaryCache);
+    return isOpen() && (d->header->options & DictionaryFormat::Exact);
+}
+
+QString DictionaryCache::fileName() const
+{
+    Q_D(const DictionaryCache);
+    return d->file.fileName();
+}
+
+//! Checks the spelling of word with Hunspell's case rules: a capitalized
+//! or upper case word is also correct if its lower case or capitalized
+//! form is, unless the stem is marked KEEPCASE.
+DictionaryCache::Verdict DictionaryCache::check(const QString &word) const
+{
+    Q_D(const DictionaryCache);
+
+    if (not isOpen() || word.isEmpty()) {
+        return Unknown;
+    }
+
+    const int stem = d->findStem(word.constData(), word.length());
+    if (stem >= 0 && d->header->forbiddenWordFlag != NoFlag
+        && d->hasFlag(stem, d->header->forbiddenWordFlag)) {
+        return Incorrect;
+    }
+
+    if (d->accepts(word, true)) {
+        return Correct;
+    }
+
+    const CaseType type = caseType(word);
+    if (type == InitialCase || type == AllCaps) {
+        const QString lower = word.toLower();
+        if (d->accepts(lower, false)) {
+            return Correct;
+        }
+
+        if (type == AllCaps) {
+            QString capitalized = lower;
+            capitalized[0] = capitalized.at(0).toUpper();
+            if (d->accepts(capitalized, false)) {
+                return Correct;
+            }
+        }
+    }
+
+    if (not isDecidable(word)) {
+        return Unknown;
+    }
+
+    return Incorrect;
+}
+
+//! \return true if check() never answers Unknown for the word. Such a word
+//! is only correct if it lower-cases to one of words() lower-cased.
+bool DictionaryCache::isDecidable(const QString &word) const
+{
+    return isExact() && caseType(word) != MixedCase && isPlainWord(word);
+}
+
+//! Returns every form check() accepts as correct, sorted and without
+//! duplicates, or an empty list once there are more than max_words. For an
+//! inexact dictionary the list lacks compounds and two-level affixes.
+QStringList DictionaryCache::words(int max_words) const
+{
+    Q_D(const DictionaryCache);
+
+    if (not isOpen()) {
+        return QStringList();
+    }
+
+    const DictionaryFormat::Header *header = d->header;
+    QMultiHash<quint16, const DictionaryFormat::Affix *> prefixes;
+    QMultiHash<quint16, const DictionaryFormat::Affix *> suffixes;
+    for (quint32 i = 0; i < header->prefixCount; ++i) {
+        prefixes.insert(d->prefixes[i].flag, &d->prefixes[i]);
+    }
+    for (quint32 i = 0; i < header->suffixCount; ++i) {
+        suffixes.insert(d->suffixes[i].flag, &d->suffixes[i]);
+    }
+
+    const quint16 skipped[] = { header->forbiddenWordFlag, header->onlyInCompoundFlag };
+    QStringList forms;
+    QString form;
+    QString cross_form;
+
+    for (quint32 index = 0; index < header->stemCount; ++index) {
+        if (forms.size() > max_words) {
+            return QStringList();
+        }
+
+        const quint16 *flags = d->flag_pool + d->flag_offsets[index];
+        const quint16 *flags_end = d->flag_pool + d->flag_offsets[index + 1];
+        const auto hasFlag = [flags, flags_end](quint16 flag) {
+            return flag != NoFlag && std::binary_search(flags, flags_end, flag);
+        };
+
+        if (hasFlag(skipped[0]) || hasFlag(skipped[1])) {
+            continue;
+        }
+
+        const QString root = d->stem(index);
+        if (not hasFlag(header->needAffixFlag)) {
+            forms.append(root);
+        }
+
+        for (const quint16 *flag = flags; flag != flags_end; ++flag) {
+            for (auto suffix = suffixes.constFind(*flag); suffix != suffixes.constEnd() && suffix.key() == *flag; ++suffix) {
+                if (not d->applySuffix(**suffix, root, &form)) {
+                    continue;
+                }
+                forms.append(form);
+
+                if (not (*suffix)->crossProduct) {
+                    continue;
+                }
+                for (const quint16 *other = flags; other != flags_end; ++other) {
+                    for (auto prefix = prefixes.constFind(*other); prefix != prefixes.constEnd() && prefix.key() == *other; ++prefix) {
+                        if ((*prefix)->crossProduct && d->applyPrefix(**prefix, form, &cross_form)) {
+                            forms.append(cross_form);
+                        }
+                    }
+                }
+            }
+
+            for (auto prefix = prefixes.constFind(*flag); prefix != prefixes.constEnd() && prefix.key() == *flag; ++prefix) {
+                if (d->applyPrefix(**prefix, root, &form)) {
+                    forms.append(form);
+                }
+            }
+        }
+    }
+
+    std::sort(forms.begin(), forms.end());
+    forms.erase(std::unique(forms.begin(), forms.end()), forms.end());
+    return forms.size() > max_words ? QStringList() : forms;
+}
+
+//! Directory of the compiled dictionaries, shared by all users of the
+//! keyboard under the XDG cache directory.
+QString DictionaryCache::cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + QDir::separator() + QStringLiteral("maliit-keyboard")
+            + QDir::separator() + QStringLiteral("dictionaries");
+}
+
+//! The cache file of a dictionary is named after the paths of its files;
+//! their sizes and modification times are checked when it is opened.
+QString DictionaryCache::cacheFileName(const QString &aff_file, const QString &dic_file)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QFileInfo(aff_file).absoluteFilePath().toUtf8());
+    hash.addData("\n", 1);
+    hash.addData(QFileInfo(dic_file).absoluteFilePath().toUtf8());
+
+    return cacheDirectory() + QDir::separator()
+            + QString::fromLatin1(hash.result().toHex()) + QStringLiteral(".dict");
+}
+
+//! Compiles the dictionary into output_file. The file is replaced
+//! atomically, so processes that have the previous version mapped are not
+//! affected.
+bool DictionaryCache::compile(const QString &aff_file, const QString &dic_file,
+                              const QString &output_file)
+{
+    DictionarySource source;
+    if (not source.parseAffixFile(aff_file) || not source.parseDictionaryFile(dic_file)) {
+        return false;
+    }
+
+    const QByteArray data = source.serialize(QFileInfo(aff_file), QFileInfo(dic_file));
+
+    QDir().mkpath(QFileInfo(output_file).absolutePath());
+    QSaveFile file(output_file);
+    if (not file.open(QIODevice::WriteOnly)
+        || file.write(data) != data.size()
+        || not file.commit()) {
+        qWarning() << __PRETTY_FUNCTION__ << "Cannot write dictionary cache" << output_file << file.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,69 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_DICTIONARYCACHE_H
+#define MALIIT_KEYBOARD_DICTIONARYCACHE_H
+
+#include <QtCore>
+
+class DictionaryCachePrivate;
+
+class DictionaryCache
+{
+    Q_DISABLE_COPY(DictionaryCache)
+    Q_DECLARE_PRIVATE(DictionaryCache)
+
+public:
+    enum Verdict {
+        Correct,
+        Incorrect,
+        Unknown //!< Only the full Hunspell dictionary can tell.
+    };
+
+    DictionaryCache();
+    ~DictionaryCache();
+
+    bool open(const QString &aff_file, const QString &dic_file);
+    void close();
+    bool isOpen() const;
+    bool isExact() const;
+    QString fileName() const;
+
+    Verdict check(const QString &word) const;
+    bool isDecidable(const QString &word) const;
+    QStringList words(int max_words) const;
+
+    static QString cacheDirectory();
+    static QString cacheFileName(const QString &aff_file, const QString &dic_file);
+    static bool compile(const QString &aff_file, const QString &dic_file,
+                        const QString &output_file);
+
+private:
+    const QScopedPointer<DictionaryCachePrivate> d_ptr;
+};
+
+#endif // MALIIT_KEYBOARD_DICTIONARYCACHE_H
@@ -0,0 +1,102 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_DICTIONARYCACHEFORMAT_H
+#define MALIIT_KEYBOARD_DICTIONARYCACHEFORMAT_H
+
+#include <cstdint>
+
+//! On-disk layout of a compiled Hunspell dictionary (see DictionaryCache).
+//!
+//! The file is written once per .aff/.dic pair and mapped read-only, so as
+//! in ngrammodelformat.h every section is a flat array aligned to 8 bytes
+//! and addressed through offsets stored in the header.
+//!
+//! Stems are stored as UTF-16 in a string pool, sorted by code unit, each
+//! with a sorted run of affix flags. Homonyms are merged into one stem.
+//! Prefixes are sorted by their appended text and suffixes by their
+//! appended text read backwards, so the rules that may have produced a
+//! word are found by binary search on its beginning and end.
+namespace DictionaryFormat {
+
+const char Magic[8] = { 'M', 'K', 'D', 'I', 'C', 'T', 'B', 'N' };
+const std::uint32_t Version = 1;
+
+enum Options {
+    //! Every word the dictionary accepts can be derived from the cache:
+    //! there are no compounds, no two-level affixes and no input
+    //! conversions, so a miss is a definite misspelling.
+    Exact = 0x1
+};
+
+struct Affix
+{
+    std::uint32_t stripOffset;      //!< Removed from the stem, in the string pool.
+    std::uint32_t appendOffset;     //!< Added to the stem, in the string pool.
+    std::uint32_t conditionOffset;  //!< Hunspell condition on the stem, in the string pool.
+    std::uint16_t stripLength;
+    std::uint16_t appendLength;
+    std::uint16_t conditionLength;
+    std::uint16_t flag;
+    std::uint8_t crossProduct;      //!< Combines with affixes of the other kind.
+    std::uint8_t reserved[3];
+};
+
+struct Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t options;
+    std::uint32_t stemCount;
+    std::uint32_t prefixCount;
+    std::uint32_t suffixCount;
+    std::uint16_t needAffixFlag;       //!< 0 when the dictionary does not use it.
+    std::uint16_t forbiddenWordFlag;
+    std::uint16_t keepCaseFlag;
+    std::uint16_t onlyInCompoundFlag;
+    std::uint32_t stringPoolLength;    //!< In UTF-16 units.
+    std::int64_t affixFileSize;        //!< Source files, to detect stale caches.
+    std::int64_t affixFileModified;    //!< Milliseconds since the epoch.
+    std::int64_t dictionaryFileSize;
+    std::int64_t dictionaryFileModified;
+    std::uint64_t fileSize;
+    std::uint64_t stemOffsetsOffset;   //!< uint32_t[stemCount + 1], in UTF-16 units.
+    std::uint64_t flagOffsetsOffset;   //!< uint32_t[stemCount + 1], into the flag pool.
+    std::uint64_t flagPoolOffset;      //!< uint16_t[], sorted per stem.
+    std::uint64_t prefixesOffset;      //!< Affix[prefixCount].
+    std::uint64_t suffixesOffset;      //!< Affix[suffixCount].
+    std::uint64_t stringPoolOffset;    //!< char16_t[], stems followed by affix texts.
+};
+
+inline std::uint64_t align(std::uint64_t offset)
+{
+    return (offset + 7) & ~std::uint64_t(7);
+}
+
+} // namespace DictionaryFormat
+
+#endif // MALIIT_KEYBOARD_DICTIONARYCACHEFORMAT_H
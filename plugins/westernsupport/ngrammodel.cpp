@@ -0,0 +1,657 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "ngrammodel.h"
+#include "ngrammodelformat.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cstring>
+
+//! \class NGramModel
+//! Read-only n-gram language model used for word prediction. The model is
+//! produced at build time (see ngrammodelformat.h) and mapped into memory,
+//! so opening it costs a single mmap() and the pages are shared between all
+//! processes using the same language. A prediction is a handful of binary
+//! searches over the trie levels followed by a bounded scan of the matching
+//! range, and does not allocate besides the returned list.
+
+namespace {
+
+// Ranges of unigrams larger than this are served from the probability-sorted
+// rank table instead of being scanned, which keeps short prefixes bounded.
+const quint32 MaxUnigramScan = 4096;
+
+// Every open() gets a new generation, so a cursor never outlives its model.
+QAtomicInteger<quint64> model_generations(0);
+
+struct ScoredWord
+{
+    float score;
+    quint32 word;
+};
+
+} // unnamed namespace
+
+class NGramModelPrivate
+{
+public:
+    QFile file;
+    const uchar *data;
+    const NGramFormat::Header *header;
+    const quint32 *string_offsets;
+    const char16_t *string_pool;
+    const quint32 *unigram_rank;
+    const quint32 *word_ids[NGramFormat::MaxOrder];
+    const quint8 *probs[NGramFormat::MaxOrder];
+    const quint32 *child_offsets[NGramFormat::MaxOrder];
+    const quint32 *successor_offsets[NGramFormat::MaxOrder];
+    const quint32 *successors[NGramFormat::MaxOrder];
+    quint64 generation;
+
+    NGramModelPrivate();
+
+    void reset();
+    bool validate(qint64 size) const;
+
+    int compare(quint32 word, const QChar *text, int length, bool prefix) const;
+    quint32 lowerBound(const QString &text, quint32 begin, quint32 end) const;
+    quint32 prefixEnd(quint32 begin, quint32 end, const QString &prefix) const;
+    bool findWord(const QString &word, quint32 *id) const;
+    bool findChild(int level, quint32 node, quint32 word, quint32 *child) const;
+    void childRange(int level, quint32 node, quint32 first_word, quint32 end_word,
+                    quint32 *begin, quint32 *end) const;
+    void resolveContext(NGramModel::Cursor *cursor) const;
+    void extendPrefix(NGramModel::Cursor *cursor, const QString &prefix) const;
+    QString word(quint32 id) const;
+};
+
+NGramModelPrivate::NGramModelPrivate()
+    : file()
+    , data(nullptr)
+    , header(nullptr)
+    , string_offsets(nullptr)
+    , string_pool(nullptr)
+    , unigram_rank(nullptr)
+    , generation(0)
+{
+    reset();
+}
+
+void NGramModelPrivate::reset()
+{
+    data = nullptr;
+    header = nullptr;
+    string_offsets = nullptr;
+    string_pool = nullptr;
+    unigram_rank = nullptr;
+
+    for (quint32 level = 0; level < NGramFormat::MaxOrder; ++level) {
+        word_ids[level] = nullptr;
+        probs[level] = nullptr;
+        child_offsets[level] = nullptr;
+        successor_offsets[level] = nullptr;
+        successors[level] = nullptr;
+    }
+}
+
+//! Checks that the file is a model of this version and that every offset
+//! and index in it stays within its array. They are used without further
+//! checks, so a damaged file must be rejected here.
+bool NGramModelPrivate::validate(qint64 size) const
+{
+    if (size < qint64(sizeof(NGramFormat::Header))
+        || memcmp(header->magic, NGramFormat::Magic, sizeof(header->magic)) != 0) {
+        qWarning() << "Not a language model file:" << file.fileName();
+        return false;
+    }
+
+    if (header->version != NGramFormat::Version
+        || header->order < 1 || header->order > NGramFormat::MaxOrder
+        || header->fileSize != quint64(size)) {
+        qWarning() << "Unsupported or truncated language model:" << file.fileName()
+                   << "version" << header->version;
+        return false;
+    }
+
+    const quint64 vocabulary = header->vocabularySize;
+    const auto fits = [size](quint64 offset, quint64 bytes) {
+        return offset <= quint64(size) && bytes <= quint64(size) - offset;
+    };
+    const auto fitsArray = [&fits](quint64 offset, quint64 count) {
+        return offset % sizeof(quint32) == 0 && fits(offset, count * sizeof(quint32));
+    };
+    const auto array = [this](quint64 offset) {
+        return reinterpret_cast<const quint32 *>(data + offset);
+    };
+    // values[0..count] never decrease.
+    const auto ascending = [](const quint32 *values, quint64 count) {
+        for (quint64 i = 0; i < count; ++i) {
+            if (values[i] > values[i + 1]) {
+                return false;
+            }
+        }
+        return true;
+    };
+    // values[0..count) are all below limit.
+    const auto below = [](const quint32 *values, quint64 count, quint64 limit) {
+        for (quint64 i = 0; i < count; ++i) {
+            if (values[i] >= limit) {
+                return false;
+            }
+        }
+        return true;
+    };
+    const auto damaged = [this]() {
+        qWarning() << "Damaged language model:" << file.fileName();
+        return false;
+    };
+
+    if (header->levels[0].nodeCount != vocabulary
+        || not fitsArray(header->stringOffsetsOffset, vocabulary + 1)
+        || not fitsArray(header->unigramRankOffset, vocabulary)
+        || not fits(header->levels[0].probsOffset, vocabulary)
+        || header->stringPoolOffset % sizeof(char16_t) != 0) {
+        return damaged();
+    }
+
+    const quint32 *offsets = array(header->stringOffsetsOffset);
+    if (not ascending(offsets, vocabulary)
+        || not fits(header->stringPoolOffset, quint64(offsets[vocabulary]) * sizeof(char16_t))
+        || not below(array(header->unigramRankOffset), vocabulary, vocabulary)) {
+        return damaged();
+    }
+
+    for (quint32 level = 0; level < header->order; ++level) {
+        const NGramFormat::Level &l = header->levels[level];
+
+        if (not fits(l.probsOffset, l.nodeCount)) {
+            return damaged();
+        }
+
+        if (level > 0
+            && (not fitsArray(l.wordIdsOffset, l.nodeCount)
+                || not below(array(l.wordIdsOffset), l.nodeCount, vocabulary))) {
+            return damaged();
+        }
+
+        if (level + 1 == header->order) {
+            continue;
+        }
+
+        const quint64 children = header->levels[level + 1].nodeCount;
+        if (not fitsArray(l.childOffsets, l.nodeCount + 1)
+            || not fitsArray(l.successorOffsets, l.nodeCount + 1)) {
+            return damaged();
+        }
+
+        const quint32 *child_offsets = array(l.childOffsets);
+        const quint32 *successor_offsets = array(l.successorOffsets);
+        if (not ascending(child_offsets, l.nodeCount)
+            || child_offsets[l.nodeCount] > children
+            || not ascending(successor_offsets, l.nodeCount)
+            || not fitsArray(l.successors, successor_offsets[l.nodeCount])
+            || not below(array(l.successors), successor_offsets[l.nodeCount], children)) {
+            return damaged();
+        }
+    }
+
+    return true;
+}
+
+QString NGramModelPrivate::word(quint32 id) const
+{
+    const quint32 begin = string_offsets[id];
+    const quint32 end = string_offsets[id + 1];
+    return QString(reinterpret_cast<const QChar *>(string_pool + begin), end - begin);
+}
+
+//! Compares the word with the given id against text. In prefix mode only
+//! the first length characters of the word take part in the comparison.
+int NGramModelPrivate::compare(quint32 word, const QChar *text, int length, bool prefix) const
+{
+    const char16_t *w = string_pool + string_offsets[word];
+    const int word_length = string_offsets[word + 1] - string_offsets[word];
+    const int common = qMin(word_length, length);
+
+    for (int i = 0; i < common; ++i) {
+        const ushort a = w[i];
+        const ushort b = text[i].unicode();
+        if (a != b) {
+            return a < b ? -1 : 1;
+        }
+    }
+
+    if (word_length < length) {
+        return -1;
+    }
+    return (prefix || word_length == length) ? 0 : 1;
+}
+
+//! Returns the first word id in [begin, end) not less than text.
+quint32 NGramModelPrivate::lowerBound(const QString &text, quint32 begin, quint32 end) const
+{
+    quint32 count = end - begin;
+
+    while (count > 0) {
+        const quint32 step = count / 2;
+        const quint32 middle = begin + step;
+        if (compare(middle, text.constData(), text.length(), false) < 0) {
+            begin = middle + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    return begin;
+}
+
+//! Returns the end of the run of words starting at begin that share prefix,
+//! which is at most end.
+quint32 NGramModelPrivate::prefixEnd(quint32 begin, quint32 end, const QString &prefix) const
+{
+    quint32 count = end - begin;
+
+    while (count > 0) {
+        const quint32 step = count / 2;
+        const quint32 middle = begin + step;
+        if (compare(middle, prefix.constData(), prefix.length(), true) == 0) {
+            begin = middle + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    return begin;
+}
+
+bool NGramModelPrivate::findWord(const QString &word, quint32 *id) const
+{
+    const quint32 candidate = lowerBound(word, 0, header->vocabularySize);
+    if (candidate < header->vocabularySize
+        && compare(candidate, word.constData(), word.length(), false) == 0) {
+        *id = candidate;
+        return true;
+    }
+
+    return false;
+}
+
+//! Finds the children of node (at the 0-based level) whose word ids lie in
+//! [first_word, end_word). Children are sorted by word id, so this is two
+//! binary searches.
+void NGramModelPrivate::childRange(int level, quint32 node, quint32 first_word, quint32 end_word,
+                                   quint32 *begin, quint32 *end) const
+{
+    const quint32 *children = child_offsets[level];
+    const quint32 *ids = word_ids[level + 1];
+
+    *begin = std::lower_bound(ids + children[node], ids + children[node + 1], first_word) - ids;
+    *end = std::lower_bound(ids + *begin, ids + children[node + 1], end_word) - ids;
+}
+
+bool NGramModelPrivate::findChild(int level, quint32 node, quint32 word, quint32 *child) const
+{
+    quint32 begin;
+    quint32 end;
+    childRange(level, node, word, word + 1, &begin, &end);
+
+    if (begin == end) {
+        return false;
+    }
+
+    *child = begin;
+    return true;
+}
+
+//! Resolves the context of the cursor into trie nodes, one per usable
+//! order, and starts its prefix stack with the children of those nodes.
+void NGramModelPrivate::resolveContext(NGramModel::Cursor *cursor) const
+{
+    const QStringList &context = cursor->context;
+    const int max_context = int(header->order) - 1;
+    const int available = qMin(max_context, context.size());
+
+    for (int length = available; length > 0 && cursor->known == 0; --length) {
+        quint32 node = 0;
+        int level = 0;
+        bool found = true;
+
+        for (int i = context.size() - length; i < context.size() && found; ++i) {
+            quint32 id;
+            if (not findWord(context.at(i).toLower(), &id)) {
+                found = false;
+            } else if (level == 0) {
+                node = id;
+                ++level;
+            } else {
+                found = findChild(level - 1, node, id, &node);
+                ++level;
+            }
+        }
+
+        if (found) {
+            cursor->known = length;
+            cursor->nodes[length - 1] = node;
+
+            // Shorter contexts are suffixes of this one.
+            for (int shorter = length - 1; shorter > 0; --shorter) {
+                quint32 suffix_node = 0;
+                findWord(context.at(context.size() - shorter).toLower(), &suffix_node);
+                for (int i = context.size() - shorter + 1; i < context.size(); ++i) {
+                    quint32 id = 0;
+                    findWord(context.at(i).toLower(), &id);
+                    findChild(i - (context.size() - shorter) - 1, suffix_node, id, &suffix_node);
+                }
+                cursor->nodes[shorter - 1] = suffix_node;
+            }
+        }
+    }
+
+    NGramModel::Cursor::Range range;
+    range.first = 0;
+    range.last = header->vocabularySize;
+    for (int length = cursor->known; length > 0; --length) {
+        childRange(length - 1, cursor->nodes[length - 1], range.first, range.last,
+                   &range.begin[length - 1], &range.end[length - 1]);
+    }
+    cursor->ranges.append(range);
+}
+
+//! Moves the cursor to prefix. The ranges of the prefix the cursor shares
+//! with the previous one are kept, and every further character narrows
+//! the range of the one before it, so typing or deleting a character costs
+//! a few binary searches within the already small range.
+void NGramModelPrivate::extendPrefix(NGramModel::Cursor *cursor, const QString &prefix) const
+{
+    const int shared_length = qMin(cursor->prefix.length(), prefix.length());
+    int common = 0;
+    while (common < shared_length && cursor->prefix.at(common) == prefix.at(common)) {
+        ++common;
+    }
+
+    cursor->ranges.resize(common + 1);
+
+    for (int length = common + 1; length <= prefix.length(); ++length) {
+        const NGramModel::Cursor::Range previous = cursor->ranges.last();
+        const QString current = prefix.left(length);
+
+        NGramModel::Cursor::Range range;
+        range.first = lowerBound(current, previous.first, previous.last);
+        range.last = prefixEnd(range.first, previous.last, current);
+
+        for (int level = 0; level < cursor->known; ++level) {
+            const quint32 *ids = word_ids[level + 1];
+            range.begin[level] = std::lower_bound(ids + previous.begin[level],
+                                                  ids + previous.end[level], range.first) - ids;
+            range.end[level] = std::lower_bound(ids + range.begin[level],
+                                                ids + previous.end[level], range.last) - ids;
+        }
+
+        cursor->ranges.append(range);
+    }
+
+    cursor->prefix = prefix;
+}
+
+NGramModel::Cursor::Cursor()
+    : model_generation(0)
+    , context()
+    , known(0)
+    , prefix()
+    , ranges()
+{}
+
+//! Forgets the cached search, e.g. when the user moved the cursor.
+void NGramModel::Cursor::reset()
+{
+    model_generation = 0;
+    context.clear();
+    known = 0;
+    prefix.clear();
+    ranges.clear();
+}
+
+NGramModel::NGramModel()
+    : d_ptr(new NGramModelPrivate)
+{}
+
+NGramModel::~NGramModel()
+{
+    close();
+}
+
+//! Maps the model stored in file_name. Returns false, leaving the model
+//! closed, if the file is missing or not a valid model of this version.
+bool NGramModel::open(const QString &file_name)
+{
+    Q_D(NGramModel);
+
+    close();
+    d->file.setFileName(file_name);
+
+    if (not d->file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 size = d->file.size();
+    d->data = d->file.map(0, size);
+
+    if (not d->data) {
+        qWarning() << "Cannot map language model" << file_name << d->file.errorString();
+        close();
+        return false;
+    }
+
+    d->header = reinterpret_cast<const NGramFormat::Header *>(d->data);
+    if (not d->validate(size)) {
+        close();
+        return false;
+    }
+
+    d->string_offsets = reinterpret_cast<const quint32 *>(d->data + d->header->stringOffsetsOffset);
+    d->string_pool = reinterpret_cast<const char16_t *>(d->data + d->header->stringPoolOffset);
+    d->unigram_rank = reinterpret_cast<const quint32 *>(d->data + d->header->unigramRankOffset);
+
+    for (quint32 level = 0; level < d->header->order; ++level) {
+        const NGramFormat::Level &l = d->header->levels[level];
+        d->word_ids[level] = reinterpret_cast<const quint32 *>(d->data + l.wordIdsOffset);
+        d->probs[level] = d->data + l.probsOffset;
+        d->child_offsets[level] = reinterpret_cast<const quint32 *>(d->data + l.childOffsets);
+        d->successor_offsets[level] = reinterpret_cast<const quint32 *>(d->data + l.successorOffsets);
+        d->successors[level] = reinterpret_cast<const quint32 *>(d->data + l.successors);
+    }
+
+    d->generation = ++model_generations;
+
+    return true;
+}
+
+void NGramModel::close()
+{
+    Q_D(NGramModel);
+
+    if (d->data) {
+        d->file.unmap(const_cast<uchar *>(d->data));
+    }
+
+    d->file.close();
+    d->reset();
+}
+
+bool NGramModel::isOpen() const
+{
+    Q_D(const NGramModel);
+    return d->header != nullptr;
+}
+
+QString NGramModel::fileName() const
+{
+    Q_D(const NGramModel);
+    return d->file.fileName();
+}
+
+//! Returns up to limit words starting with prefix, most likely first, given
+//! the preceding context words (oldest first, see Model::Text::contextWords()).
+//! The longest known context is used and shorter ones are backed off to with
+//! a fixed penalty per dropped order.
+//!
+//! An empty prefix predicts the next word from the successor tables of the
+//! context, which are exact up to NGramFormat::SuccessorCount results.
+QStringList NGramModel::predict(const QStringList &context,
+                                const QString &prefix,
+                                int limit) const
+{
+    Cursor cursor;
+    return predict(context, prefix, limit, &cursor);
+}
+
+//! Like predict() above, but reuses the search cached in cursor by the
+//! previous call when the context is the same, and leaves this search in
+//! it for the next one. Consecutive keystrokes in a word then only search
+//! the characters that changed.
+QStringList NGramModel::predict(const QStringList &context,
+                                const QString &prefix,
+                                int limit,
+                                Cursor *cursor) const
+{
+    Q_D(const NGramModel);
+
+    QStringList result;
+    if (not d->header || limit <= 0) {
+        return result;
+    }
+
+    if (cursor->model_generation != d->generation || cursor->context != context) {
+        cursor->reset();
+        cursor->model_generation = d->generation;
+        cursor->context = context;
+        d->resolveContext(cursor);
+    }
+
+    d->extendPrefix(cursor, prefix.toLower());
+
+    const Cursor::Range &range = cursor->ranges.last();
+    const quint32 first = range.first;
+    const quint32 last = range.last;
+
+    if (first == last) {
+        return result;
+    }
+
+    QVarLengthArray<ScoredWord, 16> best;
+    const auto offer = [&best, limit](quint32 word, float score) {
+        for (int i = 0; i < best.size(); ++i) {
+            if (best[i].word == word) {
+                return;
+            }
+        }
+
+        if (best.size() == limit && score <= best.last().score) {
+            return;
+        }
+
+        if (best.size() == limit) {
+            best.removeLast();
+        }
+
+        int position = best.size();
+        while (position > 0 && best[position - 1].score < score) {
+            --position;
+        }
+        best.insert(position, ScoredWord{score, word});
+    };
+
+    const float step = d->header->logProbStep;
+    const int max_context = int(d->header->order) - 1;
+
+    for (int length = cursor->known; length > 0; --length) {
+        const float penalty = d->header->backoffPenalty * (max_context - length);
+        const quint32 *ids = d->word_ids[length];
+        const quint8 *probs = d->probs[length];
+
+        if (prefix.isEmpty()) {
+            // Next word: only the precomputed most likely children can make
+            // it into the first SuccessorCount results of this order.
+            const quint32 node = cursor->nodes[length - 1];
+            const quint32 *offsets = d->successor_offsets[length - 1];
+            const quint32 *successors = d->successors[length - 1];
+            for (quint32 i = offsets[node]; i < offsets[node + 1]; ++i) {
+                offer(ids[successors[i]], -probs[successors[i]] * step - penalty);
+            }
+            continue;
+        }
+
+        for (quint32 i = range.begin[length - 1]; i < range.end[length - 1]; ++i) {
+            offer(ids[i], -probs[i] * step - penalty);
+        }
+    }
+
+    const float unigram_penalty = d->header->backoffPenalty * max_context;
+    const quint8 *unigram_probs = d->probs[0];
+
+    if (last - first <= MaxUnigramScan) {
+        for (quint32 id = first; id < last; ++id) {
+            offer(id, -unigram_probs[id] * step - unigram_penalty);
+        }
+    } else {
+        // Dense range: the most likely words are found early in rank order.
+        int found = 0;
+        for (quint32 rank = 0; rank < d->header->vocabularySize && found < limit; ++rank) {
+            const quint32 id = d->unigram_rank[rank];
+            if (id >= first && id < last) {
+                offer(id, -unigram_probs[id] * step - unigram_penalty);
+                ++found;
+            }
+        }
+    }
+
+    result.reserve(best.size());
+    for (int i = 0; i < best.size(); ++i) {
+        result.append(d->word(best[i].word));
+    }
+
+    return result;
+}
+
+//! Looks up the log10 probability of word on its own, without context.
+//! Returns false if the word is not in the model.
+bool NGramModel::unigram(const QString &word, float *log_probability) const
+{
+    Q_D(const NGramModel);
+
+    quint32 id;
+    if (not d->header || not d->findWord(word.toLower(), &id)) {
+        return false;
+    }
+
+    *log_probability = -d->probs[0][id] * d->header->logProbStep;
+    return true;
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_NGRAMMODEL_H
+#define MALIIT_KEYBOARD_NGRAMMODEL_H
+
+#include "ngrammodelformat.h"
+
+#include <QtCore>
+
+class NGramModelPrivate;
+
+class NGramModel
+{
+    Q_DISABLE_COPY(NGramModel)
+    Q_DECLARE_PRIVATE(NGramModel)
+
+public:
+    //! Search state of the previous prediction, so that the next one in the
+    //! same context narrows the cached word ranges when the prefix grew by a
+    //! keystroke, or pops back to them when it shrank, instead of searching
+    //! the whole model again.
+    class Cursor
+    {
+    public:
+        Cursor();
+        void reset();
+
+    private:
+        friend class NGramModel;
+        friend class NGramModelPrivate;
+
+        //! Word ids starting with the first length characters of prefix,
+        //! and the children of each context node among them.
+        struct Range
+        {
+            quint32 first;
+            quint32 last;
+            quint32 begin[NGramFormat::MaxOrder];
+            quint32 end[NGramFormat::MaxOrder];
+        };
+
+        quint64 model_generation;
+        QStringList context;
+        quint32 nodes[NGramFormat::MaxOrder];
+        int known;
+        QString prefix;
+        QVector<Range> ranges; //!< ranges[length] for every prefix length.
+    };
+
+    NGramModel();
+    ~NGramModel();
+
+    bool open(const QString &file_name);
+    void close();
+    bool isOpen() const;
+    QString fileName() const;
+
+    QStringList predict(const QStringList &context,
+                        const QString &prefix,
+                        int limit) const;
+    QStringList predict(const QStringList &context,
+                        const QString &prefix,
+                        int limit,
+                        Cursor *cursor) const;
+    bool unigram(const QString &word, float *log_probability) const;
+
+private:
+    const QScopedPointer<NGramModelPrivate> d_ptr;
+};
+
+#endif // MALIIT_KEYBOARD_NGRAMMODEL_H
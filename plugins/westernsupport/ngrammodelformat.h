@@ -0,0 +1,93 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_NGRAMMODELFORMAT_H
+#define MALIIT_KEYBOARD_NGRAMMODELFORMAT_H
+
+#include <cstdint>
+
+//! On-disk layout of the binary n-gram language model ("model_<lang>.lm").
+//!
+//! The file is written once at build time and mapped read-only at runtime,
+//! so every section is a flat little-endian array aligned to 8 bytes and
+//! addressed through offsets stored in the header. No pointer ever needs
+//! fixing up after mmap().
+//!
+//! Words are stored lowercased as UTF-16 in a single string pool and sorted
+//! by code unit, which makes all words sharing a prefix a contiguous range
+//! of word ids. The n-gram trie is kept as one array per order: level 1 is
+//! implicit (one node per word id), the nodes of level n+1 are sorted by
+//! parent node and then word id, and childOffsets[n] holds, for every node
+//! of level n, the first index of its children in level n+1.
+//!
+//! Probabilities are stored as quantized conditional log10 probabilities:
+//! logprob = -quantized * logProbStep, so 0 is the most likely value.
+//!
+//! For next-word prediction every node below the highest order also lists
+//! its SuccessorCount most likely children, best first, so predicting after
+//! a committed word is a lookup rather than a scan of all children.
+namespace NGramFormat {
+
+const char Magic[8] = { 'M', 'K', 'L', 'M', 'O', 'D', 'E', 'L' };
+const std::uint32_t Version = 2;
+const std::uint32_t MaxOrder = 3;
+const std::uint32_t SuccessorCount = 8;
+
+struct Level
+{
+    std::uint64_t nodeCount;      //!< Number of n-grams of this order.
+    std::uint64_t wordIdsOffset;  //!< uint32_t[nodeCount], unused for level 1.
+    std::uint64_t probsOffset;    //!< uint8_t[nodeCount], quantized log10 P(w | context).
+    std::uint64_t childOffsets;   //!< uint32_t[nodeCount + 1], 0 for the highest order.
+    std::uint64_t successorOffsets; //!< uint32_t[nodeCount + 1] into successors, 0 for the highest order.
+    std::uint64_t successors;     //!< uint32_t[], indices of the most likely children in level n+1.
+};
+
+struct Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t order;              //!< Highest n-gram order stored, 1..MaxOrder.
+    std::uint32_t vocabularySize;
+    std::uint32_t reserved;
+    float logProbStep;                //!< log10 step of one quantization level.
+    float backoffPenalty;             //!< log10 penalty per order backed off.
+    std::uint64_t fileSize;
+    std::uint64_t stringOffsetsOffset; //!< uint32_t[vocabularySize + 1], in UTF-16 units.
+    std::uint64_t stringPoolOffset;    //!< char16_t[], concatenated words.
+    std::uint64_t unigramRankOffset;   //!< uint32_t[vocabularySize], word ids by descending probability.
+    Level levels[MaxOrder];
+};
+
+inline std::uint64_t align(std::uint64_t offset)
+{
+    return (offset + 7) & ~std::uint64_t(7);
+}
+
+} // namespace NGramFormat
+
+#endif // MALIIT_KEYBOARD_NGRAMMODELFORMAT_H
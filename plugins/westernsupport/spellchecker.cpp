@@ -31,6 +31,12 @@
  */
 
 #include "spellchecker.h"
+#include "bloomfilter.h"
+#include "dictionarycache.h"
+#include "editdistance.h"
+#include "ngrammodel.h"
+#include "symspellindex.h"
+#include "userlexicon.h"
 
 #ifdef HAVE_HUNSPELL
 #include "hunspell/hunspell.hxx"
@@ -58,23 +64,172 @@ private:
 #include <QStringList>
 #include <QDebug>
 #include <QDir>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include <algorithm>
+
+namespace {
+
+// Beyond this many word forms the suggestion index gets too large to be
+// worth it (agglutinative languages), and Hunspell suggests on its own.
+const int MaxIndexedWords = 250000;
+
+// Ranks words the language model does not know after those it does.
+const float UnknownWordLogProbability = -99.0f;
+
+// Predictions get checked on every keystroke, mostly the same few words.
+const int VerdictCacheSize = 1024;
+
+const double FilterFalsePositiveRate = 0.01;
+
+} // unnamed namespace
+
+//! \class SharedDictionary
+//! The parts of a dictionary that do not change once loaded: the mapped
+//! DictionaryCache and the word filter. All spell checkers of a dictionary
+//! share them, e.g. the spelling and prediction halves of a
+//! SpellPredictWorker, which run on different threads. Hunspell is not
+//! thread-safe, so each spell checker still loads its own.
+class SharedDictionary
+{
+    Q_DISABLE_COPY(SharedDictionary)
+
+public:
+    ~SharedDictionary();
+
+    static QSharedPointer<SharedDictionary> acquire(const QString &aff_file, const QString &dic_file);
+
+    const DictionaryCache &cache() const;
+    const BloomFilter *filter() const;
+    void prepareFilter(const QStringList &words = QStringList());
+
+private:
+    SharedDictionary();
+
+    DictionaryCache m_cache;
+    QMutex m_filter_mutex; //!< Held while the filter gets built.
+    QAtomicPointer<const BloomFilter> m_filter; //!< Null until prepareFilter().
+};
+
+namespace {
+
+QMutex shared_dictionaries_mutex;
+QHash<QString, QWeakPointer<SharedDictionary> > shared_dictionaries;
+
+} // unnamed namespace
+
+SharedDictionary::SharedDictionary()
+    : m_cache()
+    , m_filter_mutex()
+    , m_filter(nullptr)
+{}
+
+SharedDictionary::~SharedDictionary()
+{
+    delete m_filter.loadAcquire();
+}
+
+//! \brief SharedDictionary::acquire opens the cache of a dictionary, or
+//! returns the one another spell checker has open already
+//! \return null if there is no cache and it cannot be compiled
+QSharedPointer<SharedDictionary> SharedDictionary::acquire(const QString &aff_file, const QString &dic_file)
+{
+    const QString key = DictionaryCache::cacheFileName(aff_file, dic_file);
+
+    // Held while opening, so that two halves loading the same language at
+    // once do not both compile it.
+    QMutexLocker locker(&shared_dictionaries_mutex);
+
+    QSharedPointer<SharedDictionary> dictionary = shared_dictionaries.value(key).toStrongRef();
+    if (dictionary) {
+        return dictionary;
+    }
+
+    dictionary = QSharedPointer<SharedDictionary>(new SharedDictionary);
+    if (not dictionary->m_cache.open(aff_file, dic_file)) {
+        return QSharedPointer<SharedDictionary>();
+    }
+
+    for (auto it = shared_dictionaries.begin(); it != shared_dictionaries.end();) {
+        if (it.value().isNull()) {
+            it = shared_dictionaries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    shared_dictionaries.insert(key, dictionary);
+
+    return dictionary;
+}
+
+const DictionaryCache &SharedDictionary::cache() const
+{
+    return m_cache;
+}
+
+//! \brief SharedDictionary::filter returns the word filter, or null if
+//! prepareFilter() has not built one
+const BloomFilter *SharedDictionary::filter() const
+{
+    return m_filter.loadAcquire();
+}
+
+//! \brief SharedDictionary::prepareFilter builds the word filter unless
+//! it exists already. Only an exact cache lists every word it accepts.
+//! \param words The cache's words, if the caller has them at hand
+void SharedDictionary::prepareFilter(const QStringList &words)
+{
+    QMutexLocker locker(&m_filter_mutex);
+
+    if (m_filter.loadAcquire() or not m_cache.isExact()) {
+        return;
+    }
+
+    const QStringList all_words = words.isEmpty() ? m_cache.words(MaxIndexedWords) : words;
+    if (all_words.isEmpty()) {
+        return;
+    }
+
+    BloomFilter *filter = new BloomFilter(all_words.size(), FilterFalsePositiveRate);
+    for (const QString &word : all_words) {
+        filter->insert(word.toLower());
+    }
+    m_filter.storeRelease(filter);
+}
 
 //! \class SpellChecker
 //! Checks spelling and suggest words. Currently Spellchecker is
-//! implemented by using Hunspell.
+//! implemented by using Hunspell. Most words are checked against the
+//! compiled DictionaryCache instead, and Hunspell itself is only loaded
+//! when the cache cannot decide or suggestions are needed.
 
 struct SpellCheckerPrivate
 {
-    Hunspell *hunspell; //!< The spellchecker backend, Hunspell.
+    Hunspell *hunspell; //!< The spellchecker backend, Hunspell, see backend().
     QTextCodec *codec; //!< Which codec to use.
+    QSharedPointer<SharedDictionary> dictionary; //!< Compiled dictionary, checked before Hunspell.
+    SymSpellIndex index; //!< Fast suggestions, asked before Hunspell.
+    QCache<QString, bool> verdicts; //!< Recent answers of checkWord().
+    SpellChecker::Statistics statistics;
+    const NGramModel *language_model; //!< Ranks suggestions, may be null.
+    bool enabled;
     QSet<QString> ignored_words; //!< The words to ignore.
-    QString user_dictionary_file;
+    UserLexicon user_lexicon; //!< The words from the user's dictionary.
+    QSet<QString> session_words; //!< Added by updateWord() alone.
+    QString user_dictionary_file; //!< Plain text word list of older versions.
     QString aff_file;
     QString dic_file;
 
     SpellCheckerPrivate(const QString &user_dictionary);
     ~SpellCheckerPrivate();
-    void addUserDictionary(const QString &user_dictionary);
+    void loadUserDictionary(const QString &user_dictionary);
+    bool isUserWord(const QString &word) const;
+    QStringList userWords() const;
+    Hunspell *backend();
+    bool checkWord(const QString &word);
+    QStringList indexSuggestions(const QString &word, int limit) const;
+    void unload();
     void clear();
 };
 
@@ -83,7 +238,15 @@ SpellCheckerPrivate::SpellCheckerPrivate(const QString &user_dictionary)
     // XXX: toUtf8? toLatin1? toAscii? toLocal8Bit?
     : hunspell(nullptr)
     , codec(nullptr)
+    , dictionary()
+    , index()
+    , verdicts(VerdictCacheSize)
+    , statistics()
+    , language_model(nullptr)
+    , enabled(false)
     , ignored_words()
+    , user_lexicon()
+    , session_words()
     , user_dictionary_file(user_dictionary)
     , aff_file()
     , dic_file()
@@ -95,30 +258,191 @@ SpellCheckerPrivate::~SpellCheckerPrivate()
     clear();
 }
 
-//! \brief SpellCheckerPrivate::addUserDictionary adds the users custom words to the dictionary
-//! \param user_dictionary filename of the user's dictionary
-void SpellCheckerPrivate::addUserDictionary(const QString &user_dictionary)
+//! \brief SpellCheckerPrivate::loadUserDictionary opens the user's lexicon,
+//! which is created from the plain text word list on first use
+//! \param user_dictionary filename of the user's plain text word list
+void SpellCheckerPrivate::loadUserDictionary(const QString &user_dictionary)
 {
-    if (not hunspell)
+    session_words.clear();
+
+    if (user_dictionary.isEmpty()) {
+        user_lexicon.close();
         return;
+    }
+
+    const QFileInfo info(user_dictionary);
+    user_lexicon.open(info.absolutePath() + QDir::separator() + info.completeBaseName() + QStringLiteral(".lex"),
+                      user_dictionary);
+}
+
+//! \brief SpellCheckerPrivate::isUserWord tells if the user added the
+//! word, also accepting it capitalized
+bool SpellCheckerPrivate::isUserWord(const QString &word) const
+{
+    const auto contains = [this](const QString &candidate) {
+        return session_words.contains(candidate) or user_lexicon.contains(candidate);
+    };
+
+    return contains(word)
+            or (not word.isEmpty() and word.at(0).isUpper() and contains(word.toLower()));
+}
+
+//! \brief SpellCheckerPrivate::userWords lists all words the user added
+QStringList SpellCheckerPrivate::userWords() const
+{
+    QStringList words = user_lexicon.words();
+    for (const QString &word : session_words) {
+        if (not user_lexicon.contains(word)) {
+            words.append(word);
+        }
+    }
+    return words;
+}
 
-    if (not user_dictionary.isEmpty() and QFile::exists(user_dictionary)) {
-        QFile file(user_dictionary);
-        if (file.open(QFile::ReadOnly)) {
-            QTextStream stream(&file);
-            while (!stream.atEnd()) {
-                hunspell->add(codec->fromUnicode(stream.readLine()).toStdString());
-            }
+//! \brief SpellCheckerPrivate::backend returns Hunspell, loading the
+//! dictionary and adding the user's words to it on first use
+//! \return nullptr if spellchecking is off or Hunspell cannot be used
+Hunspell *SpellCheckerPrivate::backend()
+{
+    if (hunspell or not enabled) {
+        return hunspell;
+    }
+
+    hunspell = new Hunspell(aff_file.toUtf8().constData(),
+                            dic_file.toUtf8().constData());
+
+    codec = QTextCodec::codecForName(hunspell->get_dic_encoding());
+    if (not codec) {
+        qWarning () << Q_FUNC_INFO << ":Could not find codec for" << hunspell->get_dic_encoding() << "- turning off spellchecking";
+        clear();
+        return nullptr;
+    }
+
+    for (const QString &word : userWords()) {
+        hunspell->add(codec->fromUnicode(word).toStdString());
+    }
+
+    return hunspell;
+}
+
+//! \brief SpellCheckerPrivate::checkWord checks a word against the
+//! dictionary, leaving out the ignored and user words
+bool SpellCheckerPrivate::checkWord(const QString &word)
+{
+    if (dictionary) {
+        const DictionaryCache &cache = dictionary->cache();
+        const BloomFilter *filter = dictionary->filter();
+
+        // Not even a case variant of the word is in the dictionary, so there
+        // is no need to search the cache's affixes.
+        if (filter and cache.isDecidable(word)
+                and not filter->contains(word.toLower())) {
+            ++statistics.filterRejections;
+            return false;
         }
+
+        switch (cache.check(word)) {
+        case DictionaryCache::Correct:
+            return true;
+        case DictionaryCache::Incorrect:
+            return false;
+        case DictionaryCache::Unknown:
+            break;
+        }
+    }
+
+    Hunspell *hunspell = backend();
+    if (not hunspell) {
+        return true;
     }
+
+    ++statistics.backendChecks;
+    return hunspell->spell(codec->fromUnicode(word).toStdString());
+}
+
+//! \brief SpellCheckerPrivate::indexSuggestions asks the suggestion index,
+//! ranking words of the same distance by the language model and the
+//! user's own words first
+QStringList SpellCheckerPrivate::indexSuggestions(const QString &word, int limit) const
+{
+    const NGramModel *model = language_model;
+    const auto frequency = [model](const QString &candidate) {
+        float log_probability;
+        return (model and model->unigram(candidate, &log_probability))
+                ? log_probability : UnknownWordLogProbability;
+    };
+
+    QVector<SymSpellIndex::Suggestion> suggestions = index.lookup(word, limit, frequency);
+
+    // The user's words come first among those of the same distance, the
+    // most used first. Their frequency is a use count, not a probability.
+    const QStringList user_words = userWords();
+    QStringList lowered;
+    for (const QString &user_word : user_words) {
+        lowered.append(user_word.toLower());
+    }
+
+    QVarLengthArray<int, 256> distances(user_words.size());
+    const MaliitKeyboard::Logic::EditDistance metric(word.toLower());
+    metric.distances(lowered, distances.data());
+
+    QVector<SymSpellIndex::Suggestion> user_suggestions;
+    for (int index = 0; index < user_words.size(); ++index) {
+        const int distance = distances[index];
+        if (distance == 0 or distance > SymSpellIndex::MaxDistance) {
+            continue;
+        }
+
+        const QString &user_word(user_words.at(index));
+        user_suggestions.append(SymSpellIndex::Suggestion{ user_word, distance, float(user_lexicon.count(user_word)) });
+    }
+
+    std::sort(user_suggestions.begin(), user_suggestions.end(),
+              [](const SymSpellIndex::Suggestion &a, const SymSpellIndex::Suggestion &b) {
+        if (a.distance != b.distance) {
+            return a.distance < b.distance;
+        }
+        return a.frequency > b.frequency;
+    });
+
+    int position = 0;
+    for (const SymSpellIndex::Suggestion &user_suggestion : user_suggestions) {
+        while (position < suggestions.size() and suggestions.at(position).distance < user_suggestion.distance) {
+            ++position;
+        }
+        suggestions.insert(position++, user_suggestion);
+    }
+
+    QStringList result;
+    for (const SymSpellIndex::Suggestion &suggestion : suggestions) {
+        if (result.size() == limit)
+            break;
+
+        if (not result.contains(suggestion.word)) {
+            result.append(suggestion.word);
+        }
+    }
+
+    return result;
+}
+
+//! \brief SpellCheckerPrivate::unload releases the dictionary
+void SpellCheckerPrivate::unload()
+{
+    delete(hunspell);
+    hunspell = nullptr;
+    index.close();
+    user_lexicon.close();
+    verdicts.clear();
+    dictionary.clear();
+    enabled = false;
 }
 
 //! \brief SpellCheckerPrivate::clear cleans up all memory and does reset
 //! everything for a new language
 void SpellCheckerPrivate::clear()
 {
-    delete(hunspell);
-    hunspell = nullptr;
+    unload();
     aff_file.clear();
     dic_file.clear();
 }
@@ -130,7 +454,7 @@ SpellChecker::~SpellChecker() = default;
 bool SpellChecker::enabled() const
 {
     Q_D(const SpellChecker);
-    return (d->hunspell != nullptr);
+    return d->enabled;
 }
 
 //! \brief SpellChecker::setEnabled
@@ -143,8 +467,7 @@ bool SpellChecker::setEnabled(bool on)
     if (enabled() == on)
         return true;
 
-    delete(d->hunspell);
-    d->hunspell = nullptr;
+    d->unload();
 
     if (not on) {
         return true;
@@ -155,20 +478,76 @@ bool SpellChecker::setEnabled(bool on)
         return false;
     }
 
-    d->hunspell = new Hunspell(d->aff_file.toUtf8().constData(),
-                               d->dic_file.toUtf8().constData());
+    d->enabled = true;
+    d->loadUserDictionary(d->user_dictionary_file);
 
-    d->codec = QTextCodec::codecForName(d->hunspell->get_dic_encoding());
-    if (not d->codec) {
-        qWarning () << Q_FUNC_INFO << ":Could not find codec for" << d->hunspell->get_dic_encoding() << "- turning off spellchecking";
-        d->clear();
-        return false;
+    // Without a cache every check goes to Hunspell, so load it right away.
+    d->dictionary = SharedDictionary::acquire(d->aff_file, d->dic_file);
+    if (not d->dictionary) {
+        qWarning() << "no dictionary cache for" << d->dic_file << "- using Hunspell only";
+        return d->backend() != nullptr;
     }
 
-    d->addUserDictionary(d->user_dictionary_file);
     return true;
 }
 
+//! \brief SpellChecker::prepareChecks fills the filter that lets spell()
+//! reject most misspellings right away, unless another spell checker of
+//! the same dictionary did already
+void SpellChecker::prepareChecks()
+{
+    Q_D(SpellChecker);
+
+    if (not enabled() or not d->dictionary) {
+        return;
+    }
+
+    d->dictionary->prepareFilter();
+}
+
+//! \brief SpellChecker::prepareSuggestions opens the suggestion index of
+//! the dictionary, building it the first time, so that the first suggest()
+//! does not have to. Without an index Hunspell is loaded instead. Also does
+//! prepareChecks().
+void SpellChecker::prepareSuggestions()
+{
+    Q_D(SpellChecker);
+
+    if (not enabled() or d->index.isOpen()) {
+        return;
+    }
+
+    if (d->dictionary) {
+        const DictionaryCache &cache = d->dictionary->cache();
+        const QString index_file = SymSpellIndex::indexFileName(cache.fileName());
+        if (d->index.open(index_file, cache.fileName())) {
+            d->dictionary->prepareFilter();
+            return;
+        }
+
+        // Building the index needs the words anyway; the filter gets them too.
+        const QStringList words = cache.words(MaxIndexedWords);
+        d->dictionary->prepareFilter(words);
+
+        if (not words.isEmpty()
+                and SymSpellIndex::build(words, cache.fileName(), index_file)
+                and d->index.open(index_file, cache.fileName())) {
+            return;
+        }
+    }
+
+    d->backend();
+}
+
+//! \brief SpellChecker::setLanguageModel sets the model whose word
+//! frequencies rank suggestions of the same edit distance
+//! \param model The model, which must outlive the spell checker, or null
+void SpellChecker::setLanguageModel(const NGramModel *model)
+{
+    Q_D(SpellChecker);
+    d->language_model = model;
+}
+
 //! \param user_dictionary The file path to the user's own dictionary.
 SpellChecker::SpellChecker(const QString &user_dictionary)
     : d_ptr(new SpellCheckerPrivate(user_dictionary))
@@ -178,6 +557,7 @@ SpellChecker::SpellChecker(const QString &user_dictionary)
 //! \brief Checks whether given word is spelled correctly.
 //!
 //! Ignored words are treated as having correct spelling. \sa ignoreWord.
+//! The answers for the most recently checked words are remembered.
 //! \param word word to check for spelling.
 //! \return \c true if the word has correct spelling (or is ignored),
 //!         otherwise \c false.
@@ -189,7 +569,20 @@ bool SpellChecker::spell(const QString &word)
         return true;
     }
 
-    return d->hunspell->spell(d->codec->fromUnicode(word).toStdString());
+    if (d->isUserWord(word)) {
+        return true;
+    }
+
+    ++d->statistics.checks;
+
+    if (const bool *verdict = d->verdicts.object(word)) {
+        ++d->statistics.cacheHits;
+        return *verdict;
+    }
+
+    const bool verdict = d->checkWord(word);
+    d->verdicts.insert(word, new bool(verdict));
+    return verdict;
 }
 
 
@@ -206,7 +599,20 @@ QStringList SpellChecker::suggest(const QString &word,
         return QStringList();
     }
 
-    auto suggestions = d->hunspell->suggest(
+    // Hunspell only gets asked when the index has nothing within reach.
+    if (d->index.isOpen()) {
+        const QStringList result = d->indexSuggestions(word, limit);
+        if (not result.isEmpty()) {
+            return result;
+        }
+    }
+
+    Hunspell *hunspell = d->backend();
+    if (not hunspell) {
+        return QStringList();
+    }
+
+    auto suggestions = hunspell->suggest(
                                 d->codec->fromUnicode(word).toStdString());
 
     QStringList result;
@@ -246,17 +652,23 @@ void SpellChecker::addToUserWordList(const QString &word)
         return;
     }
 
-    QFile user_dictionary(d->user_dictionary_file);
-    QDir::home().mkpath(QFileInfo(user_dictionary).absolutePath());
-    if (user_dictionary.open(QFile::Append)) {
-        QTextStream stream(&user_dictionary);
-        // Qt 5.15 replaces endl with Qt::endl, so do the equivalent here so
-        // this can still compile against 5.12
-        stream << word << '\n';
-        stream.flush();
+    // Written to disk in the background.
+    d->user_lexicon.add(word);
+    updateWord(word);
+}
+
+//! \brief Counts a use of a word from the user's dictionary, which ranks
+//! it higher among suggestions.
+//! \param word A word picked by the user; others are ignored.
+void SpellChecker::recordUse(const QString &word)
+{
+    Q_D(SpellChecker);
+
+    if (not enabled()) {
+        return;
     }
 
-    updateWord(word);
+    d->user_lexicon.recordUse(word);
 }
 
 //! \brief Adds a new word to the current hunspell instance
@@ -269,12 +681,36 @@ void SpellChecker::updateWord(const QString &word)
         return;
     }
 
+    if (not d->user_lexicon.contains(word)) {
+        d->session_words.insert(word);
+    }
+    // Hunspell accepts more than the word itself, e.g. in upper case.
+    d->verdicts.clear();
+
+    // Added to Hunspell when it gets loaded otherwise.
+    if (not d->hunspell) {
+        return;
+    }
+
     // Non-zero return value means some error.
     if (d->hunspell->add(d->codec->fromUnicode(word).toStdString())) {
         qWarning() << __PRETTY_FUNCTION__ << ": Failed to add '" << word << "' to user dictionary.";
     }
 }
 
+//! \brief SpellChecker::statistics tells how spell() answered so far
+SpellChecker::Statistics SpellChecker::statistics() const
+{
+    Q_D(const SpellChecker);
+    return d->statistics;
+}
+
+void SpellChecker::resetStatistics()
+{
+    Q_D(SpellChecker);
+    d->statistics = Statistics();
+}
+
 //! \brief SpellChecker::setLanguage switches to the given language if possible
 //! \param language The new language use "en" or "en_US". If more than one
 //! exists, the first one in the directory listing is used
@@ -34,6 +34,7 @@
 
 #include <QtCore>
 
+class NGramModel;
 class SpellCheckerPrivate;
 
 class SpellChecker
@@ -41,6 +42,15 @@ class SpellChecker
     Q_DISABLE_COPY(SpellChecker)
     Q_DECLARE_PRIVATE(SpellChecker)
 public:
+    //! Counts how spell() came to its answers, see statistics().
+    struct Statistics
+    {
+        quint64 checks;           //!< Words not settled by the ignored or user words.
+        quint64 cacheHits;        //!< Answered from recently checked words.
+        quint64 filterRejections; //!< Rejected by the dictionary's word filter.
+        quint64 backendChecks;    //!< Left to Hunspell.
+    };
+
     // FIXME: Find better way to discover default dictionaries.
     // FIXME: Allow changing languages in between.
     explicit SpellChecker(const QString &user_dictionary = QStringLiteral("%1/.config/maliit/userwords.txt").arg(QDir::homePath()));
@@ -49,6 +59,9 @@ public:
 
     bool enabled() const;
     bool setEnabled(bool on);
+    void prepareChecks();
+    void prepareSuggestions();
+    void setLanguageModel(const NGramModel *model);
 
     bool spell(const QString &word);
     QStringList suggest(const QString &word,
@@ -56,6 +69,10 @@ public:
     void ignoreWord(const QString &word);
     void addToUserWordList(const QString &word);
     void updateWord(const QString &word);
+    void recordUse(const QString &word);
+
+    Statistics statistics() const;
+    void resetStatistics();
 
     bool setLanguage(const QString& language);
 
@@ -26,24 +26,158 @@
  */
 
 #include "spellpredictworker.h"
+#include "latencystats.h"
+
+#ifdef HAVE_PRESAGE
+#include "candidatescallback.h"
+#include <presage.h>
+#endif
 
 #include <QDebug>
 
+namespace {
+// Trigram model: two words of context.
+const int MaxContextWords = 2;
+const int MaxPredictions = 6;
+
+//! Where the files of a language are.
+struct LanguagePaths
+{
+    QString baseLocale; //!< Without the layout, e.g. "fr" for "fr-ch".
+    QString modelFile;
+    QString databaseFile;
+};
+
+LanguagePaths languagePaths(const QString& locale, QString pluginPath)
+{
+    LanguagePaths paths;
+
+    // locale for secondary layouts I.E., dvorak will be formatted as locale@layout, swiss keyboard as "fr-ch"
+    // in this case we want to drop the layout portion
+    QStringList tmpLocales = locale.split(QRegExp("(@|\\-)"));
+    if (tmpLocales.size() > 1) {
+        paths.baseLocale = tmpLocales[0];
+        pluginPath = pluginPath.mid(0, pluginPath.size()-(locale.size()-paths.baseLocale.size()));
+    } else {
+        paths.baseLocale = locale;
+    }
+
+    const QString modelFileName = "model_"+paths.baseLocale+".lm";
+    const QString dbFileName = "database_"+paths.baseLocale+".db";
+
+    //fallback method when there is a difference between locale and the plugin path ( e.g locale=fr, pluginpath end with fr-ch )
+    QString dataPath = pluginPath;
+    if (!QFile::exists(dataPath + QDir::separator() + modelFileName)
+            && !QFile::exists(dataPath + QDir::separator() + dbFileName)) {
+        qDebug() << "language data not found, try alternative to main lang plugin directory";
+        dataPath.truncate(dataPath.lastIndexOf(QDir::separator()));
+        dataPath += QDir::separator() + locale;
+    }
+
+    paths.modelFile = dataPath + QDir::separator() + modelFileName;
+    paths.databaseFile = dataPath + QDir::separator() + dbFileName;
+    return paths;
+}
+}
+
+//! Fallback predictor for plugins that only ship a presage database.
+class PresagePredictor
+{
+public:
+#ifdef HAVE_PRESAGE
+    PresagePredictor()
+        : m_candidatesContext()
+        , m_presageCandidates(CandidatesCallback(m_candidatesContext))
+        , m_presage(&m_presageCandidates)
+    {
+        m_presage.config("Presage.Selector.SUGGESTIONS", "6");
+        m_presage.config("Presage.Selector.REPEAT_SUGGESTIONS", "yes");
+    }
+
+    void setDatabase(const QString& fullPath)
+    {
+        try {
+            m_presage.config("Presage.Predictors.DefaultSmoothedNgramPredictor.DBFILENAME", fullPath.toLatin1().data());
+        } catch (int error) {
+            qWarning() << "An exception was thrown in libpresage when changing language database, exception nr: " << error;
+        }
+    }
+
+    QStringList predict(const QStringList& context, const QString& preedit)
+    {
+        QStringList predictions;
+        m_candidatesContext.clear();
+        for (const QString &word : context) {
+            m_candidatesContext += word.toStdString() + ' ';
+        }
+        m_candidatesContext += preedit.toStdString();
+
+        try {
+            const std::vector<std::string> result = m_presage.predict();
+
+            std::vector<std::string>::const_iterator it;
+            for (it = result.begin(); it != result.end(); ++it) {
+                predictions << QString::fromStdString(*it);
+            }
+        } catch (int error) {
+            qWarning() << "An exception was thrown in libpresage when calling predict(), exception nr: " << error;
+        }
+
+        return predictions;
+    }
+
+private:
+    std::string m_candidatesContext;
+    CandidatesCallback m_presageCandidates;
+    Presage m_presage;
+#else
+    void setDatabase(const QString&) {}
+    QStringList predict(const QStringList&, const QString&) { return QStringList(); }
+#endif
+};
+
 SpellPredictWorker::SpellPredictWorker(QObject *parent)
     : QObject(parent)
-    , m_candidatesContext()
-    , m_presageCandidates(CandidatesCallback(m_candidatesContext))
-    , m_presage(&m_presageCandidates)
+    , m_model()
+    , m_predictionCursor()
+    , m_presage(new PresagePredictor)
+    , m_predictionChecker()
     , m_spellChecker()
+    , m_suggestionModel()
     , m_limit(5)
+    , m_predictionLoad(0)
+    , m_spellingLoad(0)
+{
+    m_spellChecker.setLanguageModel(&m_suggestionModel);
+}
+
+SpellPredictWorker::~SpellPredictWorker()
 {
-    m_presage.config("Presage.Selector.SUGGESTIONS", "6");
-    m_presage.config("Presage.Selector.REPEAT_SUGGESTIONS", "yes");
 }
 
-void SpellPredictWorker::parsePredictionText(const QString& surroundingLeft, const QString& origPreedit)
+void SpellPredictWorker::requestPrediction(quint64 generation)
 {
-    m_candidatesContext = (surroundingLeft.toStdString() + origPreedit.toStdString());
+    m_predictionRequests.request(generation);
+}
+
+void SpellPredictWorker::requestSpellCheck(quint64 generation)
+{
+    m_spellCheckRequests.request(generation);
+}
+
+void SpellPredictWorker::requestLanguage(quint64 load)
+{
+    m_languageRequests.request(load);
+}
+
+void SpellPredictWorker::parsePredictionText(quint64 generation, const QStringList& context, const QString& origPreedit)
+{
+    if (m_predictionRequests.isSuperseded(generation)) {
+        return;
+    }
+
+    MALIIT_LATENCY_SINCE_KEYSTROKE(WorkerQueued);
+    MALIIT_LATENCY_SCOPE(WorkerProcessing);
 
     QStringList list;
 
@@ -53,86 +187,136 @@ void SpellPredictWorker::parsePredictionText(const QString& surroundingLeft, con
     if(m_overrides.contains(preedit.toLower())) {
         preedit = m_overrides[preedit.toLower()];
         list << preedit;
-        // Emit the override corrections instantly so they're always up-to-date
-        // as they're often used for short words like 'I'
-        Q_EMIT newPredictionSuggestions(origPreedit, list);
-    } else if(m_spellChecker.spell(preedit)) {
+    } else if(not preedit.isEmpty() && m_predictionChecker.spell(preedit)) {
         // If the user input is spelt correctly add it to the start of the predictions
         list << preedit;
     }
 
-    try {
-        const std::vector<std::string> predictions = m_presage.predict();
-
-        std::vector<std::string>::const_iterator it;
-        for (it = predictions.begin(); it != predictions.end(); ++it) {
-            QString prediction = QString::fromStdString(*it);
-            // Presage will implicitly learn any words the user types as part
-            // of its prediction model, so we only provide predictions for 
-            // words that have been explicitly added to the spellcheck dictionary.
-            QString predictionTitleCase = prediction;
-            predictionTitleCase[0] = prediction.at(0).toUpper();
-            if (m_spellChecker.spell(prediction) || m_spellChecker.spell(predictionTitleCase) || m_spellChecker.spell(prediction.toUpper())) {
-                list << prediction;
-            }
-        }
+    // The native model is preferred; presage is only consulted for plugins
+    // that ship nothing but a presage database.
+    const QStringList predictions = m_model.isOpen()
+            ? m_model.predict(context.mid(qMax(0, context.size() - MaxContextWords)),
+                              origPreedit, MaxPredictions, &m_predictionCursor)
+            : m_presage->predict(context, origPreedit);
 
-    } catch (int error) {
-        qWarning() << "An exception was thrown in libpresage when calling predict(), exception nr: " << error;
+    for (const QString &prediction : predictions) {
+        // Presage will implicitly learn any words the user types as part
+        // of its prediction model, and the native model is built from free
+        // ebooks, so we only provide predictions for words that have been
+        // explicitly added to the spellcheck dictionary.
+        QString predictionTitleCase = prediction;
+        predictionTitleCase[0] = prediction.at(0).toUpper();
+        if (m_predictionChecker.spell(prediction) || m_predictionChecker.spell(predictionTitleCase) || m_predictionChecker.spell(prediction.toUpper())) {
+            list << prediction;
+        }
     }
 
-    Q_EMIT newPredictionSuggestions(origPreedit, list);
+    Q_EMIT newPredictionSuggestions(generation, origPreedit, list);
 }
 
-void SpellPredictWorker::setLanguage(QString locale, QString pluginPath)
+void SpellPredictWorker::setPredictionLanguage(quint64 load, QString locale, QString pluginPath)
 {
-    // locale for secondary layouts I.E., dvorak will be formatted as locale@layout, swiss keyboard as "fr-ch"
-    // in this case we want to drop the layout portion
-    QStringList tmpLocales = locale.split(QRegExp("(@|\\-)"));
-    QString baseLocale;
-    if (tmpLocales.size() > 1) {
-        baseLocale = tmpLocales[0];
-        pluginPath = pluginPath.mid(0, pluginPath.size()-(locale.size()-baseLocale.size()));
+    if (m_languageRequests.isSuperseded(load)) {
+        return;
+    }
+
+    loadOverrides(pluginPath);
+
+    const LanguagePaths paths = languagePaths(locale, pluginPath);
+
+    m_predictionChecker.setLanguage(paths.baseLocale);
+    m_predictionChecker.setEnabled(true);
+
+    if (m_model.open(paths.modelFile)) {
+        qDebug() << "Language model path:" << paths.modelFile.toLatin1().data();
     } else {
-        baseLocale = locale;
+        qDebug() << "DB path:" << paths.databaseFile.toLatin1().data();
+        m_presage->setDatabase(paths.databaseFile);
     }
 
-    QString dbFileName = "database_"+baseLocale+".db";
-    QString fullPath(pluginPath + QDir::separator() + dbFileName);
-    qDebug() << "DB path:" << fullPath.toLatin1().data();
+    markLoaded(&m_predictionLoad, load, locale);
 
-    //fallback method when there is a difference between locale and the plugin path ( e.g locale=fr, pluginpath end with fr-ch )
-    if (!QFile::exists(fullPath)) {
-        qDebug() << "db path not found, try alternative to main lang plugin directory";
-        pluginPath.truncate(pluginPath.lastIndexOf(QDir::separator()));
-        fullPath = pluginPath + QDir::separator() + locale  + QDir::separator() + dbFileName;
-        qDebug() << "New Database path:" << fullPath.toLatin1().data();
+    // Predictions are checked on every keystroke, suggestions are not.
+    m_predictionChecker.prepareChecks();
+}
+
+void SpellPredictWorker::setSpellingLanguage(quint64 load, QString locale, QString pluginPath)
+{
+    if (m_languageRequests.isSuperseded(load)) {
+        return;
     }
 
-    m_spellChecker.setLanguage(baseLocale);
+    const LanguagePaths paths = languagePaths(locale, pluginPath);
+
+    m_spellChecker.setLanguage(paths.baseLocale);
     m_spellChecker.setEnabled(true);
 
-    try {
-        m_presage.config("Presage.Predictors.DefaultSmoothedNgramPredictor.DBFILENAME", fullPath.toLatin1().data());
-    } catch (int error) {
-        qWarning() << "An exception was thrown in libpresage when changing language database, exception nr: " << error;
+    // Without a model suggestions of the same distance are ranked alphabetically.
+    m_suggestionModel.open(paths.modelFile);
+
+    markLoaded(&m_spellingLoad, load, locale);
+
+    // Open, or build, the suggestion index now rather than on the first typo.
+    m_spellChecker.prepareSuggestions();
+}
+
+//! \brief Records that one half has completed a load, and emits
+//! languageLoaded() once the other half has completed the same one.
+//!
+//! Loads are compared by generation, not by language: after switching
+//! from A to B and back, one half may be done with the second A while the
+//! other still has B and A ahead of it.
+void SpellPredictWorker::markLoaded(quint64 *half, quint64 load, const QString& language)
+{
+    QMutexLocker locker(&m_loadedMutex);
+
+    *half = load;
+    if (m_predictionLoad != m_spellingLoad || m_languageRequests.isSuperseded(load)) {
+        return;
+    }
+
+    locker.unlock();
+    Q_EMIT languageLoaded(language);
+}
+
+void SpellPredictWorker::loadOverrides(const QString& pluginPath)
+{
+    m_overrides.clear();
+
+    QFile overrideFile(pluginPath + QDir::separator() + "overrides.csv");
+    if (overrideFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream overrideStream(&overrideFile);
+        while (!overrideStream.atEnd()) {
+            QString line = overrideStream.readLine();
+            QStringList components = line.split(QStringLiteral(","));
+            if (components.length() == 2) {
+                addOverride(components.first(), components.last());
+            }
+        }
     }
 }
 
-void SpellPredictWorker::suggest(const QString& word, int limit)
+void SpellPredictWorker::suggest(quint64 generation, const QString& word, int limit)
 {
+    if (m_spellCheckRequests.isSuperseded(generation)) {
+        return;
+    }
+
+    MALIIT_LATENCY_SINCE_KEYSTROKE(WorkerQueued);
+    MALIIT_LATENCY_SCOPE(WorkerProcessing);
+
     QStringList suggestions;
     if(!m_spellChecker.spell(word)) {
         suggestions = m_spellChecker.suggest(word, limit);
     }
-    // If spelt correctly still send empty suggestions so the plugin knows we
-    // have finished processing.
-    Q_EMIT newSpellingSuggestions(word, suggestions);
+    // If spelt correctly still send empty suggestions so the word engine
+    // knows this generation has finished processing.
+    Q_EMIT newSpellingSuggestions(generation, word, suggestions);
 }
 
-void SpellPredictWorker::newSpellCheckWord(QString word)
+void SpellPredictWorker::newSpellCheckWord(quint64 generation, QString word)
 {
-    suggest(word, m_limit);
+    suggest(generation, word, m_limit);
 }
 
 void SpellPredictWorker::addToUserWordList(const QString& word)
@@ -140,6 +324,18 @@ void SpellPredictWorker::addToUserWordList(const QString& word)
     m_spellChecker.addToUserWordList(word);
 }
 
+//! \brief Counts a use of a word from the user's dictionary.
+void SpellPredictWorker::recordWordUse(const QString& word)
+{
+    m_spellChecker.recordUse(word);
+}
+
+//! \brief Lets predictions offer a word addToUserWordList() is adding.
+void SpellPredictWorker::addToPredictionWordList(const QString& word)
+{
+    m_predictionChecker.updateWord(word);
+}
+
 void SpellPredictWorker::setSpellCheckLimit(int limit)
 {
     m_limit = limit;
@@ -29,45 +29,86 @@
 #define SPELLPREDICTWORKER_H
 
 #include "spellchecker.h"
-#include "candidatescallback.h"
+#include "ngrammodel.h"
 #include "languageplugininterface.h"
-#include <presage.h>
+#include "requestgeneration.h"
 
 #include <QObject>
 #include <QStringList>
 #include <QMap>
+#include <QMutex>
 
-class CandidatesCallback;
+class PresagePredictor;
 
+//! \class SpellPredictWorker
+//! Spelling corrections and word predictions for one language.
+//!
+//! The worker has two independent halves, each with its own spell checker
+//! and language model. The spelling half (newSpellCheckWord(),
+//! addToUserWordList(), recordWordUse(), setSpellingLanguage()) and the
+//! prediction half (parsePredictionText(), addToPredictionWordList(),
+//! setPredictionLanguage()) are meant to run on two TaskStrands, so a slow
+//! Hunspell suggestion never holds up the predictions for a keystroke.
+//! Within a half calls must not overlap. The two spell checkers share the
+//! compiled dictionary and its word filter; each loads its own Hunspell.
 class SpellPredictWorker : public QObject
 {
     Q_OBJECT
 
 public:
     SpellPredictWorker(QObject *parent = 0);
-    void suggest(const QString& word, int limit);
+    ~SpellPredictWorker() override;
+    void suggest(quint64 generation, const QString& word, int limit);
+
+    //! Thread-safe; called when a request is queued so that older
+    //! requests still waiting in the queue get dropped.
+    void requestPrediction(quint64 generation);
+    void requestSpellCheck(quint64 generation);
+    //! Likewise for language switches; both halves skip a load that a
+    //! newer one supersedes.
+    void requestLanguage(quint64 load);
 
 public slots:
-    void parsePredictionText(const QString& surroundingLeft, const QString& preedit);
-    void newSpellCheckWord(QString word);
-    void setLanguage(QString language, QString pluginPath);
+    void parsePredictionText(quint64 generation, const QStringList& context, const QString& preedit);
+    void newSpellCheckWord(quint64 generation, QString word);
+    void setSpellingLanguage(quint64 load, QString language, QString pluginPath);
+    void setPredictionLanguage(quint64 load, QString language, QString pluginPath);
     void setSpellCheckLimit(int limit);
     void addToUserWordList(const QString& word);
+    void recordWordUse(const QString& word);
+    void addToPredictionWordList(const QString& word);
     void addOverride(const QString& orig, const QString& overridden);
 
 signals:
-    void newSpellingSuggestions(QString word, QStringList suggestions,
+    void newSpellingSuggestions(quint64 generation, QString word, QStringList suggestions,
                                 int strategy = UpdateCandidateListStrategy::ClearWhenNeeded);
-    void newPredictionSuggestions(QString word, QStringList suggestions,
+    void newPredictionSuggestions(quint64 generation, QString word, QStringList suggestions,
                                   int strategy = UpdateCandidateListStrategy::ClearWhenNeeded);
+    //! Emitted once both halves have loaded the newest requested language.
+    void languageLoaded(const QString& language);
 
 private:
-    std::string m_candidatesContext;
-    CandidatesCallback m_presageCandidates;
-    Presage m_presage;
+    void loadOverrides(const QString& pluginPath);
+    void markLoaded(quint64 *half, quint64 load, const QString& language);
+
+    // Prediction half.
+    NGramModel m_model;
+    NGramModel::Cursor m_predictionCursor;
+    QScopedPointer<PresagePredictor> m_presage;
+    SpellChecker m_predictionChecker;
+    RequestGeneration m_predictionRequests;
+    QMap<QString, QString> m_overrides;
+
+    // Spelling half; its model only ranks suggestions.
     SpellChecker m_spellChecker;
+    NGramModel m_suggestionModel;
     int m_limit;
-    QMap<QString, QString> m_overrides;
+    RequestGeneration m_spellCheckRequests;
+
+    RequestGeneration m_languageRequests;
+    QMutex m_loadedMutex;
+    quint64 m_predictionLoad;
+    quint64 m_spellingLoad;
 };
 
 #endif // SPELLPREDICTWORKER_H
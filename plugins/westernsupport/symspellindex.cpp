@@ -0,0 +1,464 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "symspellindex.h"
+#include "editdistance.h"
+
+#include <QDebug>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+
+//! \class SymSpellIndex
+//! Symmetric delete spelling suggestions (the SymSpell algorithm). Every
+//! dictionary word is indexed under all strings obtained by deleting up to
+//! MaxDistance characters from its first PrefixLength characters. Looking
+//! a word up generates the same deletes for it, so the candidates within
+//! MaxDistance edits are found with a few binary searches instead of
+//! Hunspell's search over the whole dictionary, and only those candidates
+//! are verified with a real edit distance.
+//!
+//! The index is built once per dictionary and stored next to its
+//! DictionaryCache file, which it is tied to by size and modification
+//! time. Like the dictionary cache it is mapped read-only and shared
+//! between processes.
+
+namespace {
+
+const char Magic[8] = { 'M', 'K', 'S', 'Y', 'M', 'S', 'P', 'L' };
+const quint32 Version = 1;
+
+//! File layout. Entries are (delete hash, word id) pairs sorted by hash
+//! and stored as two parallel arrays.
+struct Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 maxDistance;
+    quint32 prefixLength;
+    quint32 wordCount;
+    quint32 entryCount;
+    quint32 stringPoolLength;  //!< In UTF-16 units.
+    qint64 sourceSize;
+    qint64 sourceModified;     //!< Milliseconds since the epoch.
+    quint64 fileSize;
+    quint64 wordOffsetsOffset; //!< quint32[wordCount + 1], in UTF-16 units.
+    quint64 stringPoolOffset;  //!< char16_t[], concatenated words.
+    quint64 hashesOffset;      //!< quint32[entryCount], sorted.
+    quint64 wordIdsOffset;     //!< quint32[entryCount].
+};
+
+quint64 align(quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+
+//! FNV-1a, so that the stored hashes do not depend on the Qt version.
+quint32 hashText(const QChar *text, int length)
+{
+    quint32 hash = 2166136261u;
+    for (int i = 0; i < length; ++i) {
+        const ushort c = text[i].unicode();
+        hash = (hash ^ (c & 0xff)) * 16777619u;
+        hash = (hash ^ (c >> 8)) * 16777619u;
+    }
+    return hash;
+}
+
+//! Hashes of key and of every string obtained by deleting up to
+//! MaxDistance of its characters.
+void deleteHashes(const QString &key, QVector<quint32> *hashes)
+{
+    hashes->clear();
+    hashes->append(hashText(key.constData(), key.length()));
+
+    QVarLengthArray<QChar, SymSpellIndex::PrefixLength> buffer;
+    const int length = key.length();
+
+    for (int first = 0; first < length; ++first) {
+        buffer.clear();
+        buffer.append(key.constData(), first);
+        buffer.append(key.constData() + first + 1, length - first - 1);
+        hashes->append(hashText(buffer.constData(), buffer.size()));
+
+        for (int second = first; second < buffer.size(); ++second) {
+            QVarLengthArray<QChar, SymSpellIndex::PrefixLength> twice(buffer);
+            twice.remove(second);
+            hashes->append(hashText(twice.constData(), twice.size()));
+        }
+    }
+
+    std::sort(hashes->begin(), hashes->end());
+    hashes->erase(std::unique(hashes->begin(), hashes->end()), hashes->end());
+}
+
+//! Gives the suggestion the case of the misspelled word: "Teh" -> "The",
+//! "TEH" -> "THE". Proper nouns keep their own capitals.
+QString applyCase(const QString &suggestion, const QString &word)
+{
+    if (suggestion.isEmpty() || not word.at(0).isUpper()) {
+        return suggestion;
+    }
+
+    if (word.length() > 1 && word == word.toUpper()) {
+        return suggestion.toUpper();
+    }
+
+    QString result = suggestion;
+    result[0] = result.at(0).toUpper();
+    return result;
+}
+
+} // unnamed namespace
+
+class SymSpellIndexPrivate
+{
+public:
+    QFile file;
+    const uchar *data;
+    const Header *header;
+    const quint32 *word_offsets;
+    const char16_t *string_pool;
+    const quint32 *hashes;
+    const quint32 *word_ids;
+
+    SymSpellIndexPrivate();
+
+    void reset();
+    bool validate(qint64 size, const QFileInfo &source) const;
+    QString word(quint32 id) const;
+};
+
+SymSpellIndexPrivate::SymSpellIndexPrivate()
+    : file()
+    , data(nullptr)
+    , header(nullptr)
+    , word_offsets(nullptr)
+    , string_pool(nullptr)
+    , hashes(nullptr)
+    , word_ids(nullptr)
+{}
+
+void SymSpellIndexPrivate::reset()
+{
+    data = nullptr;
+    header = nullptr;
+    word_offsets = nullptr;
+    string_pool = nullptr;
+    hashes = nullptr;
+    word_ids = nullptr;
+}
+
+bool SymSpellIndexPrivate::validate(qint64 size, const QFileInfo &source) const
+{
+    if (size < qint64(sizeof(Header))
+        || memcmp(header->magic, Magic, sizeof(header->magic)) != 0
+        || header->version != Version
+        || header->maxDistance != quint32(SymSpellIndex::MaxDistance)
+        || header->prefixLength != quint32(SymSpellIndex::PrefixLength)
+        || header->fileSize != quint64(size)
+        || header->sourceSize != source.size()
+        || header->sourceModified != source.lastModified().toMSecsSinceEpoch()) {
+        return false;
+    }
+
+    const auto fits = [size](quint64 offset, quint64 bytes) {
+        return offset <= quint64(size) && bytes <= quint64(size) - offset;
+    };
+
+    if (header->wordOffsetsOffset % sizeof(quint32) != 0
+        || header->stringPoolOffset % sizeof(char16_t) != 0
+        || header->hashesOffset % sizeof(quint32) != 0
+        || header->wordIdsOffset % sizeof(quint32) != 0
+        || not fits(header->wordOffsetsOffset, (quint64(header->wordCount) + 1) * sizeof(quint32))
+        || not fits(header->stringPoolOffset, quint64(header->stringPoolLength) * sizeof(char16_t))
+        || not fits(header->hashesOffset, quint64(header->entryCount) * sizeof(quint32))
+        || not fits(header->wordIdsOffset, quint64(header->entryCount) * sizeof(quint32))) {
+        return false;
+    }
+
+    // lookup() takes a word's extent from two neighbouring offsets, and
+    // its id straight from the entries.
+    const quint32 *offsets = reinterpret_cast<const quint32 *>(data + header->wordOffsetsOffset);
+    for (quint32 id = 0; id < header->wordCount; ++id) {
+        if (offsets[id] > offsets[id + 1]) {
+            return false;
+        }
+    }
+
+    const quint32 *ids = reinterpret_cast<const quint32 *>(data + header->wordIdsOffset);
+    for (quint32 entry = 0; entry < header->entryCount; ++entry) {
+        if (ids[entry] >= header->wordCount) {
+            return false;
+        }
+    }
+
+    return offsets[header->wordCount] <= header->stringPoolLength;
+}
+
+QString SymSpellIndexPrivate::word(quint32 id) const
+{
+    const quint32 begin = word_offsets[id];
+    return QString(reinterpret_cast<const QChar *>(string_pool + begin), word_offsets[id + 1] - begin);
+}
+
+SymSpellIndex::SymSpellIndex()
+    : d_ptr(new SymSpellIndexPrivate)
+{}
+
+SymSpellIndex::~SymSpellIndex()
+{
+    close();
+}
+
+//! Maps the index stored in file_name. Returns false, leaving the index
+//! closed, if there is none, it is damaged or it was built from another
+//! version of source_file; the caller then builds it again.
+bool SymSpellIndex::open(const QString &file_name, const QString &source_file)
+{
+    Q_D(SymSpellIndex);
+
+    close();
+    d->file.setFileName(file_name);
+
+    if (not d->file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 size = d->file.size();
+    if (size < qint64(sizeof(Header))) {
+        close();
+        return false;
+    }
+
+    d->data = d->file.map(0, size);
+    if (not d->data) {
+        qWarning() << "Cannot map suggestion index" << file_name << d->file.errorString();
+        close();
+        return false;
+    }
+
+    d->header = reinterpret_cast<const Header *>(d->data);
+    if (not d->validate(size, QFileInfo(source_file))) {
+        close();
+        return false;
+    }
+
+    d->word_offsets = reinterpret_cast<const quint32 *>(d->data + d->header->wordOffsetsOffset);
+    d->string_pool = reinterpret_cast<const char16_t *>(d->data + d->header->stringPoolOffset);
+    d->hashes = reinterpret_cast<const quint32 *>(d->data + d->header->hashesOffset);
+    d->word_ids = reinterpret_cast<const quint32 *>(d->data + d->header->wordIdsOffset);
+    return true;
+}
+
+void SymSpellIndex::close()
+{
+    Q_D(SymSpellIndex);
+
+    if (d->data) {
+        d->file.unmap(const_cast<uchar *>(d->data));
+    }
+
+    d->file.close();
+    d->reset();
+}
+
+bool SymSpellIndex::isOpen() const
+{
+    Q_D(const SymSpellIndex);
+    return d->header != nullptr;
+}
+
+//! Returns up to limit (-1 for no limit) words within MaxDistance edits of
+//! word, ignoring case, closest first and then most frequent first. A
+//! differently cased word such as "Paris" for "paris" has distance 0.
+QVector<SymSpellIndex::Suggestion> SymSpellIndex::lookup(const QString &word, int limit,
+                                                         const FrequencyFunction &frequency) const
+{
+    Q_D(const SymSpellIndex);
+
+    QVector<Suggestion> result;
+    if (not isOpen() || word.isEmpty() || limit == 0) {
+        return result;
+    }
+
+    const QString key = word.toLower();
+    const MaliitKeyboard::Logic::EditDistance metric(key);
+    const quint32 *hashes_end = d->hashes + d->header->entryCount;
+
+    QVector<quint32> hashes;
+    deleteHashes(key.left(PrefixLength), &hashes);
+
+    // Gathered first, so that the distances are computed in one batch.
+    QStringList candidates;
+    QStringList lowered;
+    QSet<quint32> seen;
+    for (quint32 hash : hashes) {
+        const quint32 *begin = std::lower_bound(d->hashes, hashes_end, hash);
+        for (const quint32 *entry = begin; entry != hashes_end && *entry == hash; ++entry) {
+            const quint32 id = d->word_ids[entry - d->hashes];
+            if (seen.contains(id)) {
+                continue;
+            }
+            seen.insert(id);
+
+            const int length = d->word_offsets[id + 1] - d->word_offsets[id];
+            if (qAbs(length - key.length()) > MaxDistance) {
+                continue;
+            }
+
+            const QString candidate = d->word(id);
+            if (candidate == word) {
+                continue;
+            }
+
+            candidates.append(candidate);
+            lowered.append(candidate.toLower());
+        }
+    }
+
+    QVarLengthArray<int, 256> distances(candidates.size());
+    metric.distances(lowered, distances.data());
+
+    for (int index = 0; index < candidates.size(); ++index) {
+        const int distance = distances[index];
+        if (distance <= MaxDistance) {
+            const QString &candidate(candidates.at(index));
+            result.append(Suggestion{ candidate, distance, frequency ? frequency(candidate) : 0.0f });
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const Suggestion &a, const Suggestion &b) {
+        if (a.distance != b.distance) {
+            return a.distance < b.distance;
+        }
+        if (a.frequency != b.frequency) {
+            return a.frequency > b.frequency;
+        }
+        return a.word < b.word;
+    });
+
+    // Casing can make two candidates equal ("paris", "Paris" -> "Paris").
+    QVector<Suggestion> cased;
+    QSet<QString> words;
+    for (Suggestion &suggestion : result) {
+        if (limit >= 0 && cased.size() == limit) {
+            break;
+        }
+        suggestion.word = applyCase(suggestion.word, word);
+        if (suggestion.word != word && not words.contains(suggestion.word)) {
+            words.insert(suggestion.word);
+            cased.append(suggestion);
+        }
+    }
+
+    return cased;
+}
+
+//! The index of a dictionary lives next to its DictionaryCache file.
+QString SymSpellIndex::indexFileName(const QString &source_file)
+{
+    const QFileInfo info(source_file);
+    return info.absolutePath() + QDir::separator() + info.completeBaseName() + QStringLiteral(".symspell");
+}
+
+//! Indexes words into output_file, tied to the current version of
+//! source_file. The file is replaced atomically.
+bool SymSpellIndex::build(const QStringList &words, const QString &source_file,
+                          const QString &output_file)
+{
+    QString pool;
+    QVector<quint32> word_offsets;
+    QVector<quint64> entries;
+    QVector<quint32> hashes;
+
+    word_offsets.reserve(words.size() + 1);
+    entries.reserve(words.size() * 16);
+
+    for (int id = 0; id < words.size(); ++id) {
+        const QString &word = words.at(id);
+        word_offsets.append(pool.length());
+        pool.append(word);
+
+        deleteHashes(word.toLower().left(PrefixLength), &hashes);
+        for (quint32 hash : hashes) {
+            entries.append((quint64(hash) << 32) | quint32(id));
+        }
+    }
+    word_offsets.append(pool.length());
+
+    std::sort(entries.begin(), entries.end());
+
+    const QFileInfo source(source_file);
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, Magic, sizeof(header.magic));
+    header.version = Version;
+    header.maxDistance = MaxDistance;
+    header.prefixLength = PrefixLength;
+    header.wordCount = words.size();
+    header.entryCount = entries.size();
+    header.stringPoolLength = pool.length();
+    header.sourceSize = source.size();
+    header.sourceModified = source.lastModified().toMSecsSinceEpoch();
+
+    quint64 offset = align(sizeof(header));
+    header.wordOffsetsOffset = offset;
+    offset = align(offset + word_offsets.size() * sizeof(quint32));
+    header.stringPoolOffset = offset;
+    offset = align(offset + pool.length() * sizeof(char16_t));
+    header.hashesOffset = offset;
+    offset = align(offset + entries.size() * sizeof(quint32));
+    header.wordIdsOffset = offset;
+    offset = align(offset + entries.size() * sizeof(quint32));
+    header.fileSize = offset;
+
+    QByteArray data(int(offset), '\0');
+    char *out = data.data();
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + header.wordOffsetsOffset, word_offsets.constData(), word_offsets.size() * sizeof(quint32));
+    std::memcpy(out + header.stringPoolOffset, pool.constData(), pool.length() * sizeof(char16_t));
+
+    quint32 *hash_column = reinterpret_cast<quint32 *>(out + header.hashesOffset);
+    quint32 *id_column = reinterpret_cast<quint32 *>(out + header.wordIdsOffset);
+    for (int i = 0; i < entries.size(); ++i) {
+        hash_column[i] = quint32(entries.at(i) >> 32);
+        id_column[i] = quint32(entries.at(i));
+    }
+
+    QDir().mkpath(QFileInfo(output_file).absolutePath());
+    QSaveFile file(output_file);
+    if (not file.open(QIODevice::WriteOnly)
+        || file.write(data) != data.size()
+        || not file.commit()) {
+        qWarning() << __PRETTY_FUNCTION__ << "Cannot write suggestion index" << output_file << file.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,77 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_SYMSPELLINDEX_H
+#define MALIIT_KEYBOARD_SYMSPELLINDEX_H
+
+#include <QtCore>
+
+#include <functional>
+
+class SymSpellIndexPrivate;
+
+class SymSpellIndex
+{
+    Q_DISABLE_COPY(SymSpellIndex)
+    Q_DECLARE_PRIVATE(SymSpellIndex)
+
+public:
+    //! Largest edit distance of a suggestion.
+    static const int MaxDistance = 2;
+    //! Only this many leading characters of a word are indexed.
+    static const int PrefixLength = 7;
+
+    struct Suggestion
+    {
+        QString word;
+        int distance;
+        float frequency; //!< log10 probability, see FrequencyFunction.
+    };
+
+    //! Returns the log10 probability of a word, used to rank suggestions
+    //! of the same distance.
+    typedef std::function<float(const QString &word)> FrequencyFunction;
+
+    SymSpellIndex();
+    ~SymSpellIndex();
+
+    bool open(const QString &file_name, const QString &source_file);
+    void close();
+    bool isOpen() const;
+
+    QVector<Suggestion> lookup(const QString &word, int limit,
+                               const FrequencyFunction &frequency) const;
+
+    static QString indexFileName(const QString &source_file);
+    static bool build(const QStringList &words, const QString &source_file,
+                      const QString &output_file);
+
+private:
+    const QScopedPointer<SymSpellIndexPrivate> d_ptr;
+};
+
+#endif // MALIIT_KEYBOARD_SYMSPELLINDEX_H
@@ -0,0 +1,639 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "userlexicon.h"
+#include "taskexecutor.h"
+
+#include <QDebug>
+#include <QSaveFile>
+
+#include <cstring>
+
+using MaliitKeyboard::Logic::TaskExecutor;
+
+//! \class UserLexicon
+//! The words the user added to the dictionary, each with how often it was
+//! added or picked from the word ribbon.
+//!
+//! On disk the lexicon is a snapshot sorted by word, which is mapped
+//! read-only, and an append-only journal of the changes made since. Opening
+//! it maps the snapshot and replays the journal, which compaction keeps
+//! short, so it takes the same time however many words the user has.
+//!
+//! Changes are kept in a hash in memory and handed to a background
+//! TaskStrand for writing: added words right away, usage counts in batches
+//! of BatchSize. Once the journal holds CompactionThreshold records the
+//! writer folds everything into a new snapshot and empties the journal.
+//! Instances that never add words or record uses never write, so several
+//! may read the same lexicon.
+
+namespace {
+
+const char SnapshotMagic[8] = { 'M', 'K', 'U', 'S', 'R', 'L', 'E', 'X' };
+const char JournalMagic[8] = { 'M', 'K', 'U', 'S', 'R', 'J', 'N', 'L' };
+const quint32 Version = 1;
+
+// Usage counts are written once this many have piled up.
+const int BatchSize = 16;
+
+// Journals with this many records are folded into the snapshot.
+const int CompactionThreshold = 512;
+
+const int MaxWordLength = 0xffff;
+
+//! Snapshot layout.
+struct Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 wordCount;
+    quint32 stringPoolLength;  //!< In UTF-16 units.
+    quint32 reserved;
+    quint64 fileSize;
+    quint64 wordOffsetsOffset; //!< quint32[wordCount + 1], in UTF-16 units.
+    quint64 countsOffset;      //!< quint32[wordCount].
+    quint64 stringPoolOffset;  //!< char16_t[], words sorted by UTF-16 units.
+};
+
+//! The journal is this header followed by records, each a quint32 count,
+//! a quint16 length and the word in as many UTF-16 units. A record sets
+//! the count of its word; a torn record at the end is ignored.
+struct JournalHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 reserved;
+};
+
+const int RecordHeaderSize = sizeof(quint32) + sizeof(quint16);
+
+quint64 align(quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+
+int compareWord(const char16_t *text, int text_length, const QString &key)
+{
+    const int common = qMin(text_length, key.length());
+
+    for (int i = 0; i < common; ++i) {
+        const ushort a = text[i];
+        const ushort b = key.at(i).unicode();
+        if (a != b) {
+            return a < b ? -1 : 1;
+        }
+    }
+
+    return text_length == key.length() ? 0 : (text_length < key.length() ? -1 : 1);
+}
+
+void appendRecord(QByteArray *records, const QString &word, quint32 count)
+{
+    const quint16 length = quint16(word.length());
+    records->append(reinterpret_cast<const char *>(&count), sizeof(count));
+    records->append(reinterpret_cast<const char *>(&length), sizeof(length));
+    records->append(reinterpret_cast<const char *>(word.constData()), length * sizeof(QChar));
+}
+
+QByteArray journalHeader()
+{
+    JournalHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, JournalMagic, sizeof(header.magic));
+    header.version = Version;
+    return QByteArray(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+bool appendJournal(const QString &file_name, const QByteArray &records)
+{
+    QFile file(file_name);
+    if (not file.open(QIODevice::WriteOnly | QIODevice::Append)
+        || (file.size() == 0 && file.write(journalHeader()) != qint64(sizeof(JournalHeader)))
+        || file.write(records) != records.size()) {
+        qWarning() << __PRETTY_FUNCTION__ << "Cannot write user dictionary journal" << file_name << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QByteArray buildSnapshot(const QMap<QString, quint32> &words)
+{
+    QString pool;
+    QVector<quint32> word_offsets;
+    QVector<quint32> counts;
+
+    word_offsets.reserve(words.size() + 1);
+    counts.reserve(words.size());
+
+    for (auto it = words.constBegin(); it != words.constEnd(); ++it) {
+        word_offsets.append(pool.length());
+        pool.append(it.key());
+        counts.append(it.value());
+    }
+    word_offsets.append(pool.length());
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+    header.version = Version;
+    header.wordCount = counts.size();
+    header.stringPoolLength = pool.length();
+
+    quint64 offset = align(sizeof(header));
+    header.wordOffsetsOffset = offset;
+    offset = align(offset + word_offsets.size() * sizeof(quint32));
+    header.countsOffset = offset;
+    offset = align(offset + counts.size() * sizeof(quint32));
+    header.stringPoolOffset = offset;
+    offset = align(offset + pool.length() * sizeof(char16_t));
+    header.fileSize = offset;
+
+    QByteArray data(int(offset), '\0');
+    char *out = data.data();
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + header.wordOffsetsOffset, word_offsets.constData(), word_offsets.size() * sizeof(quint32));
+    std::memcpy(out + header.countsOffset, counts.constData(), counts.size() * sizeof(quint32));
+    std::memcpy(out + header.stringPoolOffset, pool.constData(), pool.length() * sizeof(char16_t));
+
+    return data;
+}
+
+bool writeSnapshot(const QString &file_name, const QMap<QString, quint32> &words)
+{
+    const QByteArray data = buildSnapshot(words);
+
+    QDir().mkpath(QFileInfo(file_name).absolutePath());
+    QSaveFile file(file_name);
+    if (not file.open(QIODevice::WriteOnly)
+        || file.write(data) != data.size()
+        || not file.commit()) {
+        qWarning() << __PRETTY_FUNCTION__ << "Cannot write user dictionary" << file_name << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+//! Replaces the snapshot with words and empties the journal, which the
+//! snapshot now includes.
+void compactFiles(const QString &file_name, const QString &journal_file,
+                  const QMap<QString, quint32> &words)
+{
+    if (not writeSnapshot(file_name, words)) {
+        return;
+    }
+
+    QFile journal(journal_file);
+    if (not journal.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || journal.write(journalHeader()) != qint64(sizeof(JournalHeader))) {
+        qWarning() << __PRETTY_FUNCTION__ << "Cannot empty user dictionary journal" << journal_file << journal.errorString();
+    }
+}
+
+} // unnamed namespace
+
+class UserLexiconPrivate
+{
+public:
+    QString file_name;
+    QFile file;
+    const uchar *data;
+    const Header *header;
+    const quint32 *word_offsets;
+    const quint32 *counts;
+    const char16_t *string_pool;
+
+    QHash<QString, quint32> changes; //!< Counts set since the snapshot was written.
+    QByteArray pending;              //!< Journal records not handed to the writer yet.
+    int pending_records;
+    int pending_uses;
+    int journal_records;             //!< Records in the journal, written or queued.
+    MaliitKeyboard::Logic::TaskStrand writer;
+
+    UserLexiconPrivate();
+
+    void reset();
+    void mapSnapshot();
+    bool validate(qint64 size) const;
+    void replayJournal();
+    void importText(const QString &text_file);
+    int find(const QString &word) const;
+    QString word(quint32 index) const;
+    QMap<QString, quint32> merged() const;
+    void setCount(const QString &word, quint32 count);
+    void writePending();
+};
+
+UserLexiconPrivate::UserLexiconPrivate()
+    : file_name()
+    , file()
+    , data(nullptr)
+    , header(nullptr)
+    , word_offsets(nullptr)
+    , counts(nullptr)
+    , string_pool(nullptr)
+    , changes()
+    , pending()
+    , pending_records(0)
+    , pending_uses(0)
+    , journal_records(0)
+    , writer()
+{}
+
+void UserLexiconPrivate::reset()
+{
+    data = nullptr;
+    header = nullptr;
+    word_offsets = nullptr;
+    counts = nullptr;
+    string_pool = nullptr;
+}
+
+//! Maps the snapshot; a missing or damaged one leaves the lexicon with
+//! just the words of the journal. A damaged snapshot is moved aside, so
+//! the next compaction replaces it instead of it failing every start.
+void UserLexiconPrivate::mapSnapshot()
+{
+    file.setFileName(file_name);
+    if (not file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const qint64 size = file.size();
+    if (size >= qint64(sizeof(Header))) {
+        data = file.map(0, size);
+    }
+    if (data) {
+        header = reinterpret_cast<const Header *>(data);
+    }
+
+    if (not header || not validate(size)) {
+        const QString damaged_file = file_name + QStringLiteral(".damaged");
+        qWarning() << __PRETTY_FUNCTION__ << "Moving damaged user dictionary" << file_name << "to" << damaged_file;
+        if (data) {
+            file.unmap(const_cast<uchar *>(data));
+        }
+        file.close();
+        reset();
+        QFile::remove(damaged_file);
+        QFile::rename(file_name, damaged_file);
+        return;
+    }
+
+    word_offsets = reinterpret_cast<const quint32 *>(data + header->wordOffsetsOffset);
+    counts = reinterpret_cast<const quint32 *>(data + header->countsOffset);
+    string_pool = reinterpret_cast<const char16_t *>(data + header->stringPoolOffset);
+}
+
+bool UserLexiconPrivate::validate(qint64 size) const
+{
+    if (memcmp(header->magic, SnapshotMagic, sizeof(header->magic)) != 0
+        || header->version != Version
+        || header->fileSize != quint64(size)) {
+        return false;
+    }
+
+    const auto fits = [size](quint64 offset, quint64 bytes) {
+        return offset <= quint64(size) && bytes <= quint64(size) - offset;
+    };
+
+    if (header->wordOffsetsOffset % sizeof(quint32) != 0
+        || header->countsOffset % sizeof(quint32) != 0
+        || header->stringPoolOffset % sizeof(char16_t) != 0
+        || not fits(header->wordOffsetsOffset, (quint64(header->wordCount) + 1) * sizeof(quint32))
+        || not fits(header->countsOffset, quint64(header->wordCount) * sizeof(quint32))
+        || not fits(header->stringPoolOffset, quint64(header->stringPoolLength) * sizeof(char16_t))) {
+        return false;
+    }
+
+    // find() and word() take the length of a word from two neighbouring
+    // offsets, so every one of them must be in order, not just the last.
+    const quint32 *offsets = reinterpret_cast<const quint32 *>(data + header->wordOffsetsOffset);
+    for (quint32 index = 0; index < header->wordCount; ++index) {
+        if (offsets[index] > offsets[index + 1]) {
+            return false;
+        }
+    }
+    return offsets[header->wordCount] <= header->stringPoolLength;
+}
+
+void UserLexiconPrivate::replayJournal()
+{
+    QFile journal(UserLexicon::journalFileName(file_name));
+    if (not journal.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const QByteArray contents = journal.readAll();
+    if (contents.size() < int(sizeof(JournalHeader))
+        || memcmp(contents.constData(), JournalMagic, sizeof(JournalMagic)) != 0) {
+        return;
+    }
+
+    const char *record = contents.constData() + sizeof(JournalHeader);
+    const char *end = contents.constData() + contents.size();
+
+    while (end - record >= RecordHeaderSize) {
+        quint32 count;
+        quint16 length;
+        std::memcpy(&count, record, sizeof(count));
+        std::memcpy(&length, record + sizeof(count), sizeof(length));
+        if (end - record - RecordHeaderSize < qint64(length) * qint64(sizeof(QChar))) {
+            break;
+        }
+
+        const QString word(reinterpret_cast<const QChar *>(record + RecordHeaderSize), length);
+        changes.insert(word, count);
+        ++journal_records;
+        record += RecordHeaderSize + length * sizeof(QChar);
+    }
+}
+
+//! Turns the plain text word list of older versions, one word per line,
+//! into a snapshot.
+void UserLexiconPrivate::importText(const QString &text_file)
+{
+    QFile file(text_file);
+    if (not file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QMap<QString, quint32> words;
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        const QString word = stream.readLine();
+        if (not word.isEmpty() && word.length() <= MaxWordLength) {
+            words.insert(word, 1);
+        }
+    }
+
+    writeSnapshot(file_name, words);
+}
+
+//! \return the index of word in the snapshot, or -1
+int UserLexiconPrivate::find(const QString &word) const
+{
+    if (not header) {
+        return -1;
+    }
+
+    int low = 0;
+    int high = int(header->wordCount);
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        const quint32 begin = word_offsets[middle];
+        const int order = compareWord(string_pool + begin, word_offsets[middle + 1] - begin, word);
+        if (order == 0) {
+            return middle;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return -1;
+}
+
+QString UserLexiconPrivate::word(quint32 index) const
+{
+    const quint32 begin = word_offsets[index];
+    return QString(reinterpret_cast<const QChar *>(string_pool + begin), word_offsets[index + 1] - begin);
+}
+
+//! \return every word with its current count, sorted
+QMap<QString, quint32> UserLexiconPrivate::merged() const
+{
+    QMap<QString, quint32> words;
+
+    if (header) {
+        for (quint32 index = 0; index < header->wordCount; ++index) {
+            words.insert(word(index), counts[index]);
+        }
+    }
+
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        words.insert(it.key(), it.value());
+    }
+
+    return words;
+}
+
+void UserLexiconPrivate::setCount(const QString &word, quint32 count)
+{
+    changes.insert(word, count);
+    appendRecord(&pending, word, count);
+    ++pending_records;
+}
+
+//! Hands the pending records to the writer.
+void UserLexiconPrivate::writePending()
+{
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    const QString journal_file = UserLexicon::journalFileName(file_name);
+    const QByteArray records = pending;
+    writer.post(TaskExecutor::Background, [journal_file, records]() {
+        appendJournal(journal_file, records);
+    });
+
+    journal_records += pending_records;
+    pending.clear();
+    pending_records = 0;
+    pending_uses = 0;
+}
+
+UserLexicon::UserLexicon()
+    : d_ptr(new UserLexiconPrivate)
+{}
+
+UserLexicon::~UserLexicon()
+{
+    close();
+}
+
+//! Opens the lexicon stored in file_name and its journal. A new lexicon
+//! starts out with the words of text_file, one per line, if given.
+//! \return false if file_name is empty
+bool UserLexicon::open(const QString &file_name, const QString &text_file)
+{
+    Q_D(UserLexicon);
+
+    close();
+    if (file_name.isEmpty()) {
+        return false;
+    }
+
+    d->file_name = file_name;
+
+    if (not QFile::exists(file_name) && not QFile::exists(journalFileName(file_name))
+        && not text_file.isEmpty() && QFile::exists(text_file)) {
+        d->importText(text_file);
+    }
+
+    d->mapSnapshot();
+    d->replayJournal();
+    return true;
+}
+
+//! Writes what is pending and closes the lexicon.
+void UserLexicon::close()
+{
+    Q_D(UserLexicon);
+
+    if (not isOpen()) {
+        return;
+    }
+
+    sync();
+
+    if (d->data) {
+        d->file.unmap(const_cast<uchar *>(d->data));
+    }
+    d->file.close();
+    d->reset();
+
+    d->file_name.clear();
+    d->changes.clear();
+    d->journal_records = 0;
+}
+
+bool UserLexicon::isOpen() const
+{
+    Q_D(const UserLexicon);
+    return not d->file_name.isEmpty();
+}
+
+bool UserLexicon::contains(const QString &word) const
+{
+    return count(word) > 0;
+}
+
+//! \return how often word was added or used, 0 if it is not in the lexicon
+quint32 UserLexicon::count(const QString &word) const
+{
+    Q_D(const UserLexicon);
+
+    const auto change = d->changes.constFind(word);
+    if (change != d->changes.constEnd()) {
+        return change.value();
+    }
+
+    const int index = d->find(word);
+    return index < 0 ? 0 : d->counts[index];
+}
+
+//! \return all words, sorted
+QStringList UserLexicon::words() const
+{
+    Q_D(const UserLexicon);
+    return d->merged().keys();
+}
+
+//! Adds word, or counts another addition of it, and writes it out right
+//! away.
+void UserLexicon::add(const QString &word)
+{
+    Q_D(UserLexicon);
+
+    if (not isOpen() || word.isEmpty() || word.length() > MaxWordLength) {
+        return;
+    }
+
+    d->setCount(word, count(word) + 1);
+    flush();
+}
+
+//! Counts a use of word, if it is in the lexicon. Uses are written in
+//! batches.
+void UserLexicon::recordUse(const QString &word)
+{
+    Q_D(UserLexicon);
+
+    const quint32 current = count(word);
+    if (current == 0) {
+        return;
+    }
+
+    d->setCount(word, current + 1);
+    if (++d->pending_uses >= BatchSize) {
+        flush();
+    }
+}
+
+//! Hands pending changes to the writer, compacting the lexicon once the
+//! journal is long enough. Does not wait for the writer.
+void UserLexicon::flush()
+{
+    Q_D(UserLexicon);
+
+    d->writePending();
+    if (d->journal_records >= CompactionThreshold) {
+        compact();
+    }
+}
+
+//! Has the writer fold the journal into a new snapshot.
+void UserLexicon::compact()
+{
+    Q_D(UserLexicon);
+
+    if (not isOpen()) {
+        return;
+    }
+
+    // The journal keeps every change until the new snapshot is in place.
+    d->writePending();
+
+    const QString file_name = d->file_name;
+    const QString journal_file = journalFileName(file_name);
+    const QMap<QString, quint32> words = d->merged();
+    d->writer.post(TaskExecutor::Background, [file_name, journal_file, words]() {
+        compactFiles(file_name, journal_file, words);
+    });
+
+    d->journal_records = 0;
+}
+
+//! Writes what is pending and returns once it is on disk.
+//!
+//! The lexicon is closed from tasks of the spelling strand, so the writes
+//! still queued run on the calling thread rather than being waited for:
+//! the executor may have no thread left to run them on.
+void UserLexicon::sync()
+{
+    Q_D(UserLexicon);
+
+    flush();
+    d->writer.drain();
+}
+
+QString UserLexicon::journalFileName(const QString &file_name)
+{
+    return file_name + QStringLiteral(".journal");
+}
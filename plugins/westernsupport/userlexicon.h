@@ -0,0 +1,64 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_USERLEXICON_H
+#define MALIIT_KEYBOARD_USERLEXICON_H
+
+#include <QtCore>
+
+class UserLexiconPrivate;
+
+class UserLexicon
+{
+    Q_DISABLE_COPY(UserLexicon)
+    Q_DECLARE_PRIVATE(UserLexicon)
+
+public:
+    UserLexicon();
+    ~UserLexicon();
+
+    bool open(const QString &file_name, const QString &text_file = QString());
+    void close();
+    bool isOpen() const;
+
+    bool contains(const QString &word) const;
+    quint32 count(const QString &word) const;
+    QStringList words() const;
+
+    void add(const QString &word);
+    void recordUse(const QString &word);
+    void flush();
+    void compact();
+    void sync();
+
+    static QString journalFileName(const QString &file_name);
+
+private:
+    const QScopedPointer<UserLexiconPrivate> d_ptr;
+};
+
+#endif // MALIIT_KEYBOARD_USERLEXICON_H
@@ -32,9 +32,14 @@
 
 #include <QtCore>
 
+using MaliitKeyboard::Logic::CharacterClassTable;
+
 WesternLanguageFeatures::WesternLanguageFeatures(QObject *parent) :
     QObject(parent)
 {
+    addCharacters(CharacterClassTable::SentenceBreak, QStringLiteral("!.?\r\n"));
+    addCharacters(CharacterClassTable::Separator, QStringLiteral(",.!?:;…\r\n"));
+    addCharacters(CharacterClassTable::Symbol, QStringLiteral(R"(*#+=()@~/\€£$¥₹%<>[]`^|_—–•§{}¡¿«»"“”„&0123456789)"));
 }
 
 WesternLanguageFeatures::~WesternLanguageFeatures() = default;
@@ -51,18 +56,13 @@ bool WesternLanguageFeatures::autoCapsAvailable() const
 
 bool WesternLanguageFeatures::activateAutoCaps(const QString &preedit) const
 {
-
-    static const QString sentenceBreak = QString::fromUtf8("!.?\r\n");
-
-    if (preedit.isEmpty()) {
+    if (preedit.isEmpty() || !preedit.at(preedit.length() - 1).isSpace()) {
         return false;
     }
 
-    if (sentenceBreak.contains(preedit.mid(preedit.length() - 2, 1)) && preedit.at(preedit.count() - 1).isSpace()) {
-        return true;
-    }
-
-    return false;
+    // A lone space counts as the start of a sentence.
+    return preedit.length() == 1
+            || characterClasses().isSentenceBreak(preedit.at(preedit.length() - 2));
 }
 
 QString WesternLanguageFeatures::appendixForReplacedPreedit(const QString &preedit) const
@@ -73,36 +73,6 @@ QString WesternLanguageFeatures::appendixForReplacedPreedit(const QString &preed
     return QStringLiteral(" ");
 }
 
-bool WesternLanguageFeatures::isSeparator(const QString &text) const
-{
-    static const QString separators = QStringLiteral(",.!?:;…\r\n");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (separators.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
-bool WesternLanguageFeatures::isSymbol(const QString &text) const
-{
-    static const QString symbols = QStringLiteral(R"(*#+=()@~/\€£$¥₹%<>[]`^|_—–•§{}¡¿«»"“”„&0123456789)");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (symbols.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
 bool WesternLanguageFeatures::ignoreSimilarity() const
 {
     return false;
@@ -117,3 +87,8 @@ bool WesternLanguageFeatures::restorePreedit() const
 {
     return true;
 }
+
+bool WesternLanguageFeatures::nextWordPrediction() const
+{
+    return true;
+}
@@ -45,12 +45,11 @@ public:
     virtual bool autoCapsAvailable() const;
     virtual bool activateAutoCaps(const QString &preedit) const;
     virtual QString appendixForReplacedPreedit(const QString &preedit) const;
-    virtual bool isSeparator(const QString &text) const;
     virtual QString fullStopSequence() const { return QStringLiteral("."); }
-    virtual bool isSymbol(const QString &text) const;
     virtual bool ignoreSimilarity() const;
     virtual bool wordEngineAvailable() const;
     virtual bool restorePreedit() const;
+    virtual bool nextWordPrediction() const;
 };
 
 #endif // MALIITKEYBOARD_LANGUAGEFEATURES_H
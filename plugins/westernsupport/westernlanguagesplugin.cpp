@@ -1,54 +1,48 @@
 #include "westernlanguagesplugin.h"
 #include "westernlanguagefeatures.h"
 
-#ifdef HAVE_PRESAGE
 #include "spellpredictworker.h"
-#endif
 
 #include <QDebug>
 
+using MaliitKeyboard::Logic::TaskExecutor;
+
 WesternLanguagesPlugin::WesternLanguagesPlugin(QObject *parent) :
     AbstractLanguagePlugin(parent)
   , m_languageFeatures(new WesternLanguageFeatures)
-  , m_spellPredictWorker(nullptr)
-  , m_spellPredictThread(nullptr)
+  , m_spellPredictWorker(new SpellPredictWorker)
   , m_spellCheckEnabled(false)
-  , m_processingSpelling(false)
+  , m_languageLoad(0)
 {
-#ifdef HAVE_PRESAGE
-    m_spellPredictThread = new QThread();
-    m_spellPredictWorker = new SpellPredictWorker();
-    m_spellPredictWorker->moveToThread(m_spellPredictThread);
-
-    connect(m_spellPredictWorker, &SpellPredictWorker::newSpellingSuggestions, this, &WesternLanguagesPlugin::spellCheckFinishedProcessing);
+    // The two halves of the worker run on the shared executor, each on its
+    // own strand, and report back through queued connections.
+    connect(m_spellPredictWorker, &SpellPredictWorker::newSpellingSuggestions, this, &WesternLanguagesPlugin::newSpellingSuggestions);
     connect(m_spellPredictWorker, &SpellPredictWorker::newPredictionSuggestions, this, &WesternLanguagesPlugin::newPredictionSuggestions);
-    connect(this, &WesternLanguagesPlugin::newSpellCheckWord, m_spellPredictWorker, &SpellPredictWorker::newSpellCheckWord);
-    connect(this, &WesternLanguagesPlugin::setSpellPredictLanguage, m_spellPredictWorker, &SpellPredictWorker::setLanguage);
-    connect(this, &WesternLanguagesPlugin::setSpellCheckLimit, m_spellPredictWorker, &SpellPredictWorker::setSpellCheckLimit);
-    connect(this, &WesternLanguagesPlugin::parsePredictionText, m_spellPredictWorker, &SpellPredictWorker::parsePredictionText);
-    connect(this, &WesternLanguagesPlugin::addToUserWordList, m_spellPredictWorker, &SpellPredictWorker::addToUserWordList);
-    connect(this, &WesternLanguagesPlugin::addOverride, m_spellPredictWorker, &SpellPredictWorker::addOverride);
-    m_spellPredictThread->start();
-#endif
+    connect(m_spellPredictWorker, &SpellPredictWorker::languageLoaded, this, &WesternLanguagesPlugin::languageReady);
 }
 
 WesternLanguagesPlugin::~WesternLanguagesPlugin()
 {
-#ifdef HAVE_PRESAGE
-    m_spellPredictWorker->deleteLater();
-    m_spellPredictThread->quit();
-    m_spellPredictThread->wait();
-#endif
+    m_predictionStrand.clear();
+    m_spellingStrand.clear();
+    delete m_spellPredictWorker;
 }
 
-void WesternLanguagesPlugin::predict(const QString& surroundingLeft, const QString& preedit)
+void WesternLanguagesPlugin::predict(quint64 generation, const QStringList& context, const QString& preedit)
 {
-    Q_EMIT parsePredictionText(surroundingLeft, preedit);
+    SpellPredictWorker *worker = m_spellPredictWorker;
+    worker->requestPrediction(generation);
+    m_predictionStrand.post(TaskExecutor::Interactive, [worker, generation, context, preedit]() {
+        worker->parsePredictionText(generation, context, preedit);
+    });
 }
 
 void WesternLanguagesPlugin::wordCandidateSelected(QString word)
 {
-    Q_UNUSED(word);
+    SpellPredictWorker *worker = m_spellPredictWorker;
+    m_spellingStrand.post(TaskExecutor::Background, [worker, word]() {
+        worker->recordWordUse(word);
+    });
 }
 
 AbstractLanguageFeatures* WesternLanguagesPlugin::languageFeature()
@@ -56,54 +50,41 @@ AbstractLanguageFeatures* WesternLanguagesPlugin::languageFeature()
     return m_languageFeatures;
 }
 
-void WesternLanguagesPlugin::spellCheckerSuggest(const QString& word, int limit)
+void WesternLanguagesPlugin::spellCheckerSuggest(quint64 generation, const QString& word, int limit)
 {
-    m_nextSpellWord = word;
-    // Don't accept new words whilst we're processing, so we only process the
-    // most recent input once the current processing has completed
-    if (!m_processingSpelling) {
-        m_processingSpelling = true;
-        Q_EMIT setSpellCheckLimit(limit);
-        Q_EMIT newSpellCheckWord(word);
-    }
+    // The worker drops this request if a newer one is queued by the time
+    // it gets to it, so only the most recent input reaches Hunspell.
+    SpellPredictWorker *worker = m_spellPredictWorker;
+    worker->requestSpellCheck(generation);
+    m_spellingStrand.post(TaskExecutor::Interactive, [worker, generation, word, limit]() {
+        worker->setSpellCheckLimit(limit);
+        worker->newSpellCheckWord(generation, word);
+    });
 }
 
 void WesternLanguagesPlugin::addToSpellCheckerUserWordList(const QString& word)
 {
-    Q_EMIT addToUserWordList(word);
+    SpellPredictWorker *worker = m_spellPredictWorker;
+    m_spellingStrand.post(TaskExecutor::Background, [worker, word]() {
+        worker->addToUserWordList(word);
+    });
+    m_predictionStrand.post(TaskExecutor::Background, [worker, word]() {
+        worker->addToPredictionWordList(word);
+    });
 }
 
 bool WesternLanguagesPlugin::setLanguage(const QString& languageId, const QString& pluginPath)
 {
-    Q_EMIT setSpellPredictLanguage(languageId, pluginPath);
-    loadOverrides(pluginPath);
+    // The worker emits languageLoaded() once the dictionaries, the language
+    // models and the overrides of both strands are in memory.
+    SpellPredictWorker *worker = m_spellPredictWorker;
+    const quint64 load = ++m_languageLoad;
+    worker->requestLanguage(load);
+    m_predictionStrand.post(TaskExecutor::Background, [worker, load, languageId, pluginPath]() {
+        worker->setPredictionLanguage(load, languageId, pluginPath);
+    });
+    m_spellingStrand.post(TaskExecutor::Background, [worker, load, languageId, pluginPath]() {
+        worker->setSpellingLanguage(load, languageId, pluginPath);
+    });
     return true;
 }
-
-void WesternLanguagesPlugin::addSpellingOverride(const QString& orig, const QString& overridden)
-{
-    Q_EMIT addOverride(orig, overridden);
-}
-
-void WesternLanguagesPlugin::loadOverrides(const QString& pluginPath) {
-    QFile overrideFile(pluginPath + QDir::separator() + "overrides.csv");
-    if (overrideFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QTextStream overrideStream(&overrideFile);
-        while (!overrideStream.atEnd()) {
-            QString line = overrideStream.readLine();
-            QStringList components = line.split(QStringLiteral(","));
-            if (components.length() == 2) {
-                addSpellingOverride(components.first(), components.last());
-            }
-        }
-    }
-}
-
-void WesternLanguagesPlugin::spellCheckFinishedProcessing(QString word, QStringList suggestions) {
-    Q_EMIT newSpellingSuggestions(word, suggestions);
-    if (word != m_nextSpellWord) {
-        Q_EMIT newSpellCheckWord(m_nextSpellWord);
-    } else {
-        m_processingSpelling = false;
-    }
-}
@@ -7,10 +7,9 @@
 #include "westernlanguagefeatures.h"
 #include "spellchecker.h"
 #include "abstractlanguageplugin.h"
+#include "taskexecutor.h"
 
-#ifdef HAVE_PRESAGE
 #include "spellpredictworker.h"
-#endif
 
 class WesternLanguageFeatures;
 class CandidatesCallback;
@@ -25,36 +24,23 @@ public:
     explicit WesternLanguagesPlugin(QObject *parent = nullptr);
     ~WesternLanguagesPlugin() override;
 
-    void predict(const QString& surroundingLeft, const QString& preedit) override;
+    void predict(quint64 generation, const QStringList& context, const QString& preedit) override;
     void wordCandidateSelected(QString word) override;
     AbstractLanguageFeatures* languageFeature() override;
 
     //! spell checker
-    void spellCheckerSuggest(const QString& word, int limit) override;
+    void spellCheckerSuggest(quint64 generation, const QString& word, int limit) override;
     void addToSpellCheckerUserWordList(const QString& word) override;
     bool setLanguage(const QString& languageId, const QString& pluginPath) override;
-    virtual void addSpellingOverride(const QString& orig, const QString& overridden);
-    virtual void loadOverrides(const QString& pluginPath);
-
-signals:
-    void newSpellCheckWord(QString word);
-    void setSpellCheckLimit(int limit);
-    void setSpellPredictLanguage(QString language, QString pluginPath);
-    void parsePredictionText(QString surroundingLeft, QString preedit);
-    void setPredictionLanguage(QString language);
-    void addToUserWordList(const QString& word);
-    void addOverride(const QString& orig, const QString& overridden);
-
-public slots:
-    void spellCheckFinishedProcessing(QString word, QStringList suggestions);
 
 private:
     WesternLanguageFeatures* m_languageFeatures;
     SpellPredictWorker *m_spellPredictWorker;
-    QThread *m_spellPredictThread;
+    // Predictions never wait for a slow spelling suggestion.
+    MaliitKeyboard::Logic::TaskStrand m_predictionStrand;
+    MaliitKeyboard::Logic::TaskStrand m_spellingStrand;
     bool m_spellCheckEnabled;
-    QString m_nextSpellWord;
-    bool m_processingSpelling;
+    quint64 m_languageLoad;
 };
 
 #endif // WESTERNLANGUAGESPLUGIN_H
@@ -31,6 +31,8 @@
 #ifndef MALIIT_KEYBOARD_ABSTRACTLANGUAGEFEATURES_H
 #define MALIIT_KEYBOARD_ABSTRACTLANGUAGEFEATURES_H
 
+#include "characterclasstable.h"
+
 #include <QObject>
 #include <maliit/plugins/abstractinputmethod.h>
 
@@ -45,9 +47,13 @@ public:
     virtual bool autoCapsAvailable() const = 0;
     virtual bool activateAutoCaps(const QString &preedit) const = 0;
     virtual QString appendixForReplacedPreedit(const QString &preedit) const = 0;
-    virtual bool isSeparator(const QString &text) const { Q_UNUSED(text); return false; }
+    // Whether the last character of text is a separator or a symbol, as
+    // classified by characterClasses().
+    bool isSeparator(const QString &text) const { return m_characterClasses.classesOfLast(text) & MaliitKeyboard::Logic::CharacterClassTable::Separator; }
+    bool isSeparator(QChar c) const { return m_characterClasses.isSeparator(c); }
     virtual QString fullStopSequence() const { return QString(); }
-    virtual bool isSymbol(const QString &text) const { Q_UNUSED(text); return false; }
+    bool isSymbol(const QString &text) const { return m_characterClasses.classesOfLast(text) & MaliitKeyboard::Logic::CharacterClassTable::Symbol; }
+    bool isSymbol(QChar c) const { return m_characterClasses.isSymbol(c); }
     // Typically we disable auto-correct if the predicted word isn't similar
     // to the user's input. However for input methods such as pinyin this
     // can be disabled by implementing this method to return true.
@@ -57,6 +63,8 @@ public:
     virtual bool restorePreedit() const { return true; }
     virtual bool commitOnSpace() const { return true; }
     virtual bool showPrimaryInPreedit() const { return false; }
+    // Whether the plugin predicts the next word when given an empty preedit.
+    virtual bool nextWordPrediction() const { return false; }
 
     /*!
      * \brief Whether we should delay committing the candidate word selected.
@@ -84,8 +92,19 @@ public:
     Maliit::TextContentType contentType() const { return m_contentType; }
     void setContentType(Maliit::TextContentType contentType) { m_contentType = contentType; }
 
+    const MaliitKeyboard::Logic::CharacterClassTable &characterClasses() const { return m_characterClasses; }
+
+protected:
+    // Plugins classify the characters of their language once, from their
+    // constructor, instead of overriding isSeparator() and isSymbol().
+    void addCharacters(MaliitKeyboard::Logic::CharacterClassTable::Class characterClass, const QString &characters)
+    {
+        m_characterClasses.add(characterClass, characters);
+    }
+
 private:
     Maliit::TextContentType m_contentType;
+    MaliitKeyboard::Logic::CharacterClassTable m_characterClasses;
 };
 
 #endif // MALIIT_KEYBOARD_ABSTRACTLANGUAGEFEATURES_H
@@ -33,9 +33,10 @@ AbstractLanguagePlugin::AbstractLanguagePlugin(QObject *parent)
 
 AbstractLanguagePlugin::~AbstractLanguagePlugin() = default;
 
-void AbstractLanguagePlugin::predict(const QString& surroundingLeft, const QString& preedit) 
+void AbstractLanguagePlugin::predict(quint64 generation, const QStringList& context, const QString& preedit)
 {
-    Q_UNUSED(surroundingLeft)
+    Q_UNUSED(generation)
+    Q_UNUSED(context)
     Q_UNUSED(preedit)
 }
  
@@ -49,8 +50,9 @@ AbstractLanguageFeatures* AbstractLanguagePlugin::languageFeature()
     return nullptr;
 }
 
-void AbstractLanguagePlugin::spellCheckerSuggest(const QString& word, int limit)
+void AbstractLanguagePlugin::spellCheckerSuggest(quint64 generation, const QString& word, int limit)
 {
+    Q_UNUSED(generation)
     Q_UNUSED(word)
     Q_UNUSED(limit)
 }
@@ -41,19 +41,19 @@ public:
     AbstractLanguagePlugin(QObject *parent = nullptr);
     ~AbstractLanguagePlugin() override;
 
-    void predict(const QString& surroundingLeft, const QString& preedit) override;
+    void predict(quint64 generation, const QStringList& context, const QString& preedit) override;
     void wordCandidateSelected(QString word) override;
     AbstractLanguageFeatures* languageFeature() override;
 
     //! spell checker
-    void spellCheckerSuggest(const QString& word, int limit) override;
+    void spellCheckerSuggest(quint64 generation, const QString& word, int limit) override;
     void addToSpellCheckerUserWordList(const QString& word) override;
     bool setLanguage(const QString& languageId, const QString& pluginPath) override;
 
 signals:
-    void newSpellingSuggestions(QString word, QStringList suggestions,
+    void newSpellingSuggestions(quint64 generation, QString word, QStringList suggestions,
                                 int strategy = UpdateCandidateListStrategy::ClearWhenNeeded);
-    void newPredictionSuggestions(QString word, QStringList suggestions,
+    void newPredictionSuggestions(quint64 generation, QString word, QStringList suggestions,
                                   int strategy = UpdateCandidateListStrategy::ClearWhenNeeded);
     /*!
      * \brief Manually request text to be committed.
@@ -64,6 +64,13 @@ signals:
      * \sa AbstractLanguageFeatures::shouldDelayCandidateCommit()
      */
     void commitTextRequested(const QString &text);
+    /*!
+     * \brief The language requested by setLanguage() is loaded.
+     *
+     * Plugins whose setLanguage() returns true load the language in the
+     * background and must emit this signal once they are done.
+     */
+    void languageReady(const QString &languageId);
 };
 
 #endif // ABSTRACTLANGUAGEPLUGIN_H
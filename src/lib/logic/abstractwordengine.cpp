@@ -29,6 +29,7 @@
  */
 
 #include "abstractwordengine.h"
+#include "latencystats.h"
 
 namespace MaliitKeyboard {
 namespace Logic {
@@ -55,6 +56,13 @@ namespace Logic {
 //! Needs to be implemented by derived classes. Will not be called if engine
 //! is disabled or text model has no preedit.
 
+//! \fn quint64 AbstractWordEngine::generation() const
+//! \brief Returns the generation of the newest candidate request.
+//!
+//! Every change to the text model starts a new generation. Results that
+//! arrive tagged with an older generation are stale and must be dropped.
+//! \sa RequestGeneration
+
 //! \property AbstractWordEngine::enabled
 //! \brief Whether the engine provides updates for word candidates.
 
@@ -62,12 +70,14 @@ class AbstractWordEnginePrivate
 {
 public:
     bool enabled;
+    quint64 generation;
 
     explicit AbstractWordEnginePrivate();
 };
 
 AbstractWordEnginePrivate::AbstractWordEnginePrivate()
     : enabled(false)
+    , generation(0)
 {}
 
 
@@ -110,12 +120,24 @@ void AbstractWordEngine::setEnabled(bool enabled)
 }
 
 
+//! \brief Returns whether the language of the engine is loaded.
+//!
+//! Engines loading languages in the background return false until they
+//! emit languageReady(). Always true by default.
+bool AbstractWordEngine::isLanguageReady() const
+{
+    return true;
+}
+
+
 //! \brief Clears the current candidates.
 //!
 //! Only has an effect when word engine is enabled, in which case
 //! candidatesCanged() is emitted.
 void AbstractWordEngine::clearCandidates()
 {
+    invalidateRequests();
+
     if (isEnabled()) {
         Q_EMIT candidatesChanged(WordCandidateList());
     }
@@ -128,6 +150,10 @@ void AbstractWordEngine::clearCandidates()
 //! Can trigger emission of candidatesChanged().
 void AbstractWordEngine::computeCandidates(Model::Text *text)
 {
+    MALIIT_LATENCY_SCOPE(ComputeCandidates);
+
+    invalidateRequests();
+
     // FIXME: add possiblity to turn off the error correction for
     // entries that does not need it (like password entries).  Also,
     // with that we probably will want to turn off preedit styling at
@@ -147,6 +173,51 @@ void AbstractWordEngine::computeCandidates(Model::Text *text)
     fetchCandidates(text);
 }
 
+//! \brief Computes candidates for the word after the cursor, once a word
+//! and the space after it have been committed.
+//! \param text The text model, with an empty preedit.
+//! \param capitalize Whether the next word starts with a capital letter,
+//!                   as when auto-caps is active after a sentence break.
+//!
+//! Can trigger emission of candidatesChanged().
+void AbstractWordEngine::computeNextWordCandidates(Model::Text *text, bool capitalize)
+{
+    invalidateRequests();
+
+    if (not isEnabled()
+        || not text
+        || not text->preedit().isEmpty()) {
+        return;
+    }
+
+    fetchNextWordCandidates(text, capitalize);
+}
+
+quint64 AbstractWordEngine::generation() const
+{
+    Q_D(const AbstractWordEngine);
+    return d->generation;
+}
+
+//! \brief Starts a new generation, making all outstanding requests stale.
+void AbstractWordEngine::invalidateRequests()
+{
+    Q_D(AbstractWordEngine);
+    ++d->generation;
+}
+
+//! \brief Fetches candidates for the next word.
+//! \param text The text model, with an empty preedit.
+//! \param capitalize Whether the candidates are to be capitalized.
+//!
+//! Engines without next-word prediction keep the default, which offers
+//! nothing.
+void AbstractWordEngine::fetchNextWordCandidates(Model::Text *text, bool capitalize)
+{
+    Q_UNUSED(text);
+    Q_UNUSED(capitalize);
+}
+
 //! \brief Adds a word to user dictionary.
 //! \param word A word.
 //!
@@ -176,6 +247,15 @@ void AbstractWordEngine::setAutoCorrectEnabled(bool on)
     qDebug() << Q_FUNC_INFO << "should be implemented by inherited class";
 }
 
+//! \brief Tells which language plugins are likely to be used next.
+//! \param pluginPaths The plugins of the enabled languages.
+//!
+//! Engines may use this to keep those plugins loaded. Does nothing by default.
+void AbstractWordEngine::setEnabledLanguagePlugins(const QStringList &pluginPaths)
+{
+    Q_UNUSED(pluginPaths);
+}
+
 /*
 AbstractLanguageFeature* AbstractWordEngine::languageFeature()
 {
@@ -58,6 +58,7 @@ public:
     virtual ~AbstractWordEngine();
 
     virtual bool isEnabled() const;
+    virtual bool isLanguageReady() const;
     Q_SLOT virtual void setEnabled(bool enabled);
     Q_SIGNAL void enabledChanged(bool enabled);
 
@@ -67,6 +68,7 @@ public:
 
     virtual void clearCandidates();
     void computeCandidates(Model::Text *text);
+    void computeNextWordCandidates(Model::Text *text, bool capitalize);
     Q_SIGNAL void candidatesChanged(const WordCandidateList &candidates);
 
     virtual void addToUserDictionary(const QString &word);
@@ -76,16 +78,23 @@ public:
 public Q_SLOTS:
     virtual void onWordCandidateSelected(QString word) = 0;
     virtual void onLanguageChanged(const QString& pluginPath, const QString& languageId) = 0;
+    virtual void setEnabledLanguagePlugins(const QStringList &pluginPaths);
     virtual void updateQmlCandidates(QStringList qmlCandidates) = 0;
 
+protected:
+    quint64 generation() const;
+    void invalidateRequests();
+
 signals:
     void preeditFaceChanged(Model::Text::PreeditFace face);
     void primaryCandidateChanged(QString candidate);
     void pluginChanged();
+    void languageReady(const QString &languageId);
     void commitTextRequested(const QString &text);
 
 private:
     virtual void fetchCandidates(Model::Text *text) = 0;
+    virtual void fetchNextWordCandidates(Model::Text *text, bool capitalize);
     const QScopedPointer<AbstractWordEnginePrivate> d_ptr;
 };
 
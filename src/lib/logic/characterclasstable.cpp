@@ -0,0 +1,97 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "characterclasstable.h"
+
+#include <algorithm>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+namespace {
+
+const int BlockSize = 256;
+
+}
+
+CharacterClassTable::CharacterClassTable()
+    : m_blocks(BlockSize, 0)
+    , m_astral()
+{
+    // Every block starts out as the shared empty one.
+    std::fill(m_index, m_index + 256, 0);
+}
+
+//! Adds all \a characters to \a character_class, in addition to any class
+//! they already belong to.
+void CharacterClassTable::add(Class character_class, const QString &characters)
+{
+    const QVector<uint> code_points = characters.toUcs4();
+
+    for (uint code_point : code_points) {
+        if (code_point >= 0x10000) {
+            m_astral[code_point] |= character_class;
+            continue;
+        }
+
+        quint16 &block = m_index[code_point >> 8];
+        if (block == 0) {
+            block = m_blocks.size() / BlockSize;
+            m_blocks.resize(m_blocks.size() + BlockSize);
+        }
+
+        m_blocks[block * BlockSize + (code_point & 0xff)] |= character_class;
+    }
+}
+
+//! Returns the Class flags of the last character of \a text, 0 if \a text
+//! is empty.
+int CharacterClassTable::classesOfLast(const QString &text) const
+{
+    const int length = text.length();
+    if (length == 0) {
+        return 0;
+    }
+
+    const QChar last = text.at(length - 1);
+    if (last.isLowSurrogate() && length > 1 && text.at(length - 2).isHighSurrogate()) {
+        return classes(QChar::surrogateToUcs4(text.at(length - 2), last));
+    }
+
+    return classes(last.unicode());
+}
+
+//! Whether both tables classify every character the same. Copies of a
+//! table share their blocks, so comparing them is cheap.
+bool CharacterClassTable::operator==(const CharacterClassTable &other) const
+{
+    return std::equal(m_index, m_index + 256, other.m_index)
+        && m_blocks == other.m_blocks
+        && m_astral == other.m_astral;
+}
+
+}} // namespace Logic, MaliitKeyboard
@@ -0,0 +1,102 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_CHARACTERCLASSTABLE_H
+#define MALIIT_KEYBOARD_CHARACTERCLASSTABLE_H
+
+#include <QtCore>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+//! \class CharacterClassTable
+//! Which characters a language treats as separators, symbols or sentence
+//! breaks.
+//!
+//! A language plugin fills the table once, when it is created, after which
+//! every query is a lookup. Code points of the Basic Multilingual Plane go
+//! through a two level table: one block of flags per 256 code points, where
+//! all blocks without a classified character share the same empty block.
+//! The few astral code points a language may classify are kept in a hash.
+//!
+//! Word characters don't depend on the language, so they aren't stored:
+//! isWordCharacter() matches what \\w matches in a QRegExp, and
+//! isWordJoiner() the apostrophes of words like "don't". Model::Text and
+//! maliit-lmcompile split words with both, so context words are looked up
+//! in the language model as they were counted.
+class CharacterClassTable
+{
+public:
+    enum Class {
+        Separator = 0x1,
+        Symbol = 0x2,
+        SentenceBreak = 0x4
+    };
+
+    CharacterClassTable();
+
+    void add(Class character_class, const QString &characters);
+
+    //! Returns the Class flags of a code point, 0 for none.
+    inline int classes(uint code_point) const
+    {
+        if (code_point < 0x10000) {
+            return m_blocks.at(m_index[code_point >> 8] * 256 + (code_point & 0xff));
+        }
+        return m_astral.value(code_point);
+    }
+
+    int classesOfLast(const QString &text) const;
+
+    bool operator==(const CharacterClassTable &other) const;
+    bool operator!=(const CharacterClassTable &other) const { return not (*this == other); }
+
+    bool isSeparator(QChar c) const { return classes(c.unicode()) & Separator; }
+    bool isSymbol(QChar c) const { return classes(c.unicode()) & Symbol; }
+    bool isSentenceBreak(QChar c) const { return classes(c.unicode()) & SentenceBreak; }
+
+    static bool isWordCharacter(QChar c)
+    {
+        return c.isLetterOrNumber() || c.isMark() || c == QLatin1Char('_');
+    }
+
+    //! Whether c joins the word characters around it into one word. A word
+    //! never starts or ends with one.
+    static bool isWordJoiner(QChar c)
+    {
+        return c == QLatin1Char('\'') || c == QChar(0x2019);
+    }
+
+private:
+    quint16 m_index[256];
+    QVector<quint8> m_blocks;
+    QHash<uint, quint8> m_astral;
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_CHARACTERCLASSTABLE_H
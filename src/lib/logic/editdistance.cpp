@@ -0,0 +1,366 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "editdistance.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MALIIT_KEYBOARD_EDITDISTANCE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+namespace {
+
+const int MaxBitParallelLength = 64;
+
+//! Match masks of the pattern, as handed to the kernels below.
+struct MatchTable
+{
+    const quint64 *latin;
+    const QPair<ushort, quint64> *other;
+    int other_count;
+
+    inline quint64 operator()(ushort c) const
+    {
+        if (c < 256) {
+            return latin[c];
+        }
+
+        for (int index = 0; index < other_count; ++index) {
+            if (other[index].first == c) {
+                return other[index].second;
+            }
+        }
+
+        return 0;
+    }
+};
+
+// Myers' bit-parallel algorithm, in Hyyrö's formulation for the distance
+// between two whole strings: bit i of the vertical delta vectors pv/mv
+// tells whether D[i + 1][j] is one more/less than D[i][j]. score tracks the
+// last row, D[m][j], starting from D[m][0] = m.
+int myers(const MatchTable &match, int m, const ushort *text, int n)
+{
+    const quint64 last = quint64(1) << (m - 1);
+    quint64 pv = ~quint64(0);
+    quint64 mv = 0;
+    int score = m;
+
+    for (int j = 0; j < n; ++j) {
+        const quint64 eq = match(text[j]);
+        const quint64 xv = eq | mv;
+        const quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+        quint64 ph = mv | ~(xh | pv);
+        quint64 mh = pv & xh;
+
+        if (ph & last) {
+            ++score;
+        } else if (mh & last) {
+            --score;
+        }
+
+        // D[0][j] = j, so the first row always increases.
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+
+    return score;
+}
+
+int dynamicProgramming(const ushort *pattern, int m, const ushort *text, int n)
+{
+    QVarLengthArray<int, 128> row(n + 1);
+
+    for (int j = 0; j <= n; ++j) {
+        row[j] = j;
+    }
+
+    for (int i = 1; i <= m; ++i) {
+        int diagonal = row[0];
+        row[0] = i;
+
+        for (int j = 1; j <= n; ++j) {
+            const int above = row[j];
+            const int cost = (pattern[i - 1] == text[j - 1]) ? 0 : 1;
+            row[j] = std::min(std::min(above + 1, row[j - 1] + 1), diagonal + cost);
+            diagonal = above;
+        }
+    }
+
+    return row[n];
+}
+
+//! One group of texts scored side by side, one per vector lane.
+template <int Lanes>
+struct LaneBatch
+{
+    const ushort *data[Lanes];
+    int size[Lanes];
+    int longest;
+
+    LaneBatch(const QStringList &texts, int first)
+        : longest(0)
+    {
+        for (int lane = 0; lane < Lanes; ++lane) {
+            const QString &text(texts.at(first + lane));
+            data[lane] = text.utf16();
+            size[lane] = text.size();
+            longest = std::max(longest, size[lane]);
+        }
+    }
+
+    //! Loads the match mask of column j of each lane, and whether the lane
+    //! is still inside its text.
+    inline void column(const MatchTable &match, int j, quint64 *eq, quint64 *active) const
+    {
+        for (int lane = 0; lane < Lanes; ++lane) {
+            const bool inside = j < size[lane];
+            active[lane] = inside ? ~quint64(0) : 0;
+            eq[lane] = inside ? match(data[lane][j]) : 0;
+        }
+    }
+};
+
+// The batch kernels run myers() for groups of texts, one per lane, and
+// return the index of the first text left over for the scalar loop.
+
+#if defined(MALIIT_KEYBOARD_EDITDISTANCE_AVX2)
+__attribute__((target("avx2")))
+int myersBatchAvx2(const MatchTable &match, int m, const QStringList &texts, int *results)
+{
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m128i shift = _mm_cvtsi32_si128(m - 1);
+
+    int first = 0;
+    for (; first + 4 <= texts.size(); first += 4) {
+        const LaneBatch<4> batch(texts, first);
+        alignas(32) quint64 eq[4];
+        alignas(32) quint64 active[4];
+
+        __m256i pv = ones;
+        __m256i mv = _mm256_setzero_si256();
+        __m256i score = _mm256_set1_epi64x(m);
+
+        for (int j = 0; j < batch.longest; ++j) {
+            batch.column(match, j, eq, active);
+            const __m256i e = _mm256_load_si256(reinterpret_cast<const __m256i *>(eq));
+            const __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i *>(active));
+
+            const __m256i xv = _mm256_or_si256(e, mv);
+            const __m256i xh = _mm256_or_si256(
+                        _mm256_xor_si256(_mm256_add_epi64(_mm256_and_si256(e, pv), pv), pv), e);
+            __m256i ph = _mm256_or_si256(mv, _mm256_xor_si256(_mm256_or_si256(xh, pv), ones));
+            __m256i mh = _mm256_and_si256(pv, xh);
+
+            const __m256i delta = _mm256_sub_epi64(
+                        _mm256_and_si256(_mm256_srl_epi64(ph, shift), one),
+                        _mm256_and_si256(_mm256_srl_epi64(mh, shift), one));
+            score = _mm256_add_epi64(score, _mm256_and_si256(delta, a));
+
+            ph = _mm256_or_si256(_mm256_slli_epi64(ph, 1), one);
+            mh = _mm256_slli_epi64(mh, 1);
+            pv = _mm256_or_si256(mh, _mm256_xor_si256(_mm256_or_si256(xv, ph), ones));
+            mv = _mm256_and_si256(ph, xv);
+        }
+
+        alignas(32) qint64 scores[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(scores), score);
+        for (int lane = 0; lane < 4; ++lane) {
+            results[first + lane] = int(scores[lane]);
+        }
+    }
+
+    return first;
+}
+
+bool cpuHasAvx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+#if defined(__SSE2__)
+int myersBatchSse2(const MatchTable &match, int m, const QStringList &texts, int *results)
+{
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i one = _mm_set_epi32(0, 1, 0, 1);
+    const __m128i shift = _mm_cvtsi32_si128(m - 1);
+
+    int first = 0;
+    for (; first + 2 <= texts.size(); first += 2) {
+        const LaneBatch<2> batch(texts, first);
+        alignas(16) quint64 eq[2];
+        alignas(16) quint64 active[2];
+
+        __m128i pv = ones;
+        __m128i mv = _mm_setzero_si128();
+        __m128i score = _mm_set_epi32(0, m, 0, m);
+
+        for (int j = 0; j < batch.longest; ++j) {
+            batch.column(match, j, eq, active);
+            const __m128i e = _mm_load_si128(reinterpret_cast<const __m128i *>(eq));
+            const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i *>(active));
+
+            const __m128i xv = _mm_or_si128(e, mv);
+            const __m128i xh = _mm_or_si128(
+                        _mm_xor_si128(_mm_add_epi64(_mm_and_si128(e, pv), pv), pv), e);
+            __m128i ph = _mm_or_si128(mv, _mm_xor_si128(_mm_or_si128(xh, pv), ones));
+            __m128i mh = _mm_and_si128(pv, xh);
+
+            const __m128i delta = _mm_sub_epi64(
+                        _mm_and_si128(_mm_srl_epi64(ph, shift), one),
+                        _mm_and_si128(_mm_srl_epi64(mh, shift), one));
+            score = _mm_add_epi64(score, _mm_and_si128(delta, a));
+
+            ph = _mm_or_si128(_mm_slli_epi64(ph, 1), one);
+            mh = _mm_slli_epi64(mh, 1);
+            pv = _mm_or_si128(mh, _mm_xor_si128(_mm_or_si128(xv, ph), ones));
+            mv = _mm_and_si128(ph, xv);
+        }
+
+        alignas(16) qint64 scores[2];
+        _mm_store_si128(reinterpret_cast<__m128i *>(scores), score);
+        results[first] = int(scores[0]);
+        results[first + 1] = int(scores[1]);
+    }
+
+    return first;
+}
+#endif
+
+} // unnamed namespace
+
+EditDistance::EditDistance(const QString &pattern)
+    : m_pattern(pattern)
+    , m_latin()
+    , m_other()
+{
+    const int length = std::min(m_pattern.size(), MaxBitParallelLength);
+    const ushort *data = m_pattern.utf16();
+
+    for (int i = 0; i < length; ++i) {
+        const quint64 bit = quint64(1) << i;
+        const ushort c = data[i];
+
+        if (c < 256) {
+            m_latin[c] |= bit;
+            continue;
+        }
+
+        bool found = false;
+        for (QPair<ushort, quint64> &entry : m_other) {
+            if (entry.first == c) {
+                entry.second |= bit;
+                found = true;
+                break;
+            }
+        }
+
+        if (not found) {
+            m_other.append(qMakePair(c, bit));
+        }
+    }
+}
+
+//! \brief Returns the Levenshtein distance between the pattern and text.
+int EditDistance::distance(const QString &text) const
+{
+    return distance(text.constData(), text.size());
+}
+
+//! \brief Returns the Levenshtein distance between the pattern and the
+//! size code units starting at text.
+int EditDistance::distance(const QChar *text, int size) const
+{
+    const int m = m_pattern.size();
+    const ushort *data = reinterpret_cast<const ushort *>(text);
+
+    if (m == 0) {
+        return size;
+    }
+
+    if (m > MaxBitParallelLength) {
+        return dynamicProgramming(m_pattern.utf16(), m, data, size);
+    }
+
+    const MatchTable match = { m_latin, m_other.constData(), m_other.size() };
+    return myers(match, m, data, size);
+}
+
+//! \brief Stores the distance between the pattern and each of texts in
+//! results, which must have room for texts.size() entries.
+void EditDistance::distances(const QStringList &texts, int *results) const
+{
+    const int m = m_pattern.size();
+
+    if (m == 0 || m > MaxBitParallelLength) {
+        for (int index = 0; index < texts.size(); ++index) {
+            results[index] = distance(texts.at(index));
+        }
+        return;
+    }
+
+    const MatchTable match = { m_latin, m_other.constData(), m_other.size() };
+    int first = 0;
+
+#if defined(MALIIT_KEYBOARD_EDITDISTANCE_AVX2)
+    if (cpuHasAvx2()) {
+        first = myersBatchAvx2(match, m, texts, results);
+    }
+#if defined(__SSE2__)
+    else {
+        first = myersBatchSse2(match, m, texts, results);
+    }
+#endif
+#elif defined(__SSE2__)
+    first = myersBatchSse2(match, m, texts, results);
+#endif
+
+    for (int index = first; index < texts.size(); ++index) {
+        const QString &text(texts.at(index));
+        results[index] = myers(match, m, text.utf16(), text.size());
+    }
+}
+
+//! \brief Returns the Levenshtein distance between first and second.
+int EditDistance::distance(const QString &first, const QString &second)
+{
+    return EditDistance(first).distance(second);
+}
+
+}} // namespace Logic, MaliitKeyboard
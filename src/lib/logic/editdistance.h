@@ -0,0 +1,72 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_EDITDISTANCE_H
+#define MALIIT_KEYBOARD_EDITDISTANCE_H
+
+#include <QtCore>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+//! \class EditDistance
+//! Levenshtein distance from one pattern to any number of texts.
+//!
+//! The pattern is preprocessed once into one bit mask per character, after
+//! which Myers' bit-parallel algorithm computes a distance in one pass over
+//! the text with a handful of word operations per character. Patterns of up
+//! to 64 UTF-16 code units take the bit-parallel path; longer ones fall back
+//! to the classic dynamic programming recurrence.
+//!
+//! distances() scores a whole list of texts in one call. On x86 it runs
+//! several texts side by side in SSE2 or, where the CPU supports it, AVX2
+//! registers; elsewhere it loops over the portable implementation.
+//!
+//! Nothing is allocated on the heap, so an EditDistance can be created on
+//! the stack for each comparison.
+class EditDistance
+{
+public:
+    explicit EditDistance(const QString &pattern);
+
+    int distance(const QString &text) const;
+    int distance(const QChar *text, int size) const;
+    void distances(const QStringList &texts, int *results) const;
+
+    static int distance(const QString &first, const QString &second);
+
+private:
+    quint64 matchMask(ushort c) const;
+
+    const QString m_pattern;
+    quint64 m_latin[256];
+    QVarLengthArray<QPair<ushort, quint64>, 16> m_other;
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_EDITDISTANCE_H
@@ -29,6 +29,7 @@
  */
 
 #include "eventhandler.h"
+#include "latencystats.h"
 #include "models/layout.h"
 
 namespace MaliitKeyboard {
@@ -76,6 +77,9 @@ void EventHandler::onKeyPressed(QString label, QString action)
 
 void EventHandler::onKeyReleased(QString label, QString action)
 {
+    MALIIT_LATENCY_KEYSTROKE();
+    MALIIT_LATENCY_SCOPE(KeyReleased);
+
     Key key;
     key.setLabel(label);
 
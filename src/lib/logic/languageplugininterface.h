@@ -19,18 +19,24 @@ class LanguagePluginInterface
 public:
     virtual ~LanguagePluginInterface() = default;
 
-    virtual void predict(const QString& surroundingLeft, const QString& preedit) = 0;
+    //! Requests predictions for preedit, given the words before it (oldest
+    //! first, see Model::Text::contextWords()). Results are reported back
+    //! tagged with the same generation; requests superseded by a newer
+    //! generation may be dropped without reporting anything.
+    virtual void predict(quint64 generation, const QStringList& context, const QString& preedit) = 0;
     virtual void wordCandidateSelected(QString word) = 0;
 
     virtual AbstractLanguageFeatures* languageFeature() = 0;
 
     //! spell checker
-    virtual void spellCheckerSuggest(const QString& word, int limit) = 0;
+    virtual void spellCheckerSuggest(quint64 generation, const QString& word, int limit) = 0;
     virtual void addToSpellCheckerUserWordList(const QString& word) = 0;
+    //! Returns true if the language is being loaded in the background, in
+    //! which case languageReady() is emitted when it is done.
     virtual bool setLanguage(const QString& languageId, const QString &pluginPath) = 0;
 };
 
-#define LanguagePluginInterface_iid "com.lomiri.LomiriKeyboard.LanguagePluginInterface"
+#define LanguagePluginInterface_iid "com.lomiri.LomiriKeyboard.LanguagePluginInterface/3"
 
 Q_DECLARE_INTERFACE(LanguagePluginInterface, LanguagePluginInterface_iid)
 
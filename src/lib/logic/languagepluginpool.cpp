@@ -0,0 +1,595 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "languagepluginpool.h"
+#include "abstractlanguageplugin.h"
+#include "taskexecutor.h"
+
+#include <QCryptographicHash>
+#include <QStandardPaths>
+
+#include <limits>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+namespace {
+
+const qint64 DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+const int DEFAULT_WARM_UP_DELAY = 3000;
+
+// Hunspell keeps its dictionaries in hash tables that are a few times larger
+// than the files they were read from.
+const int DICTIONARY_MEMORY_FACTOR = 3;
+
+// Hunspell is not thread-safe, so each half of the plugin's worker loads its
+// own when the compiled dictionary cannot answer.
+const int HUNSPELL_INSTANCES = 2;
+
+QString languageOfPlugin(const QString &pluginPath)
+{
+    return QFileInfo(pluginPath).dir().dirName();
+}
+
+QString dictionaryPath()
+{
+    const QString prefix = qgetenv("KEYBOARD_PREFIX_PATH");
+    if (not prefix.isEmpty()) {
+        return prefix + QDir::separator() + HUNSPELL_DICT_PATH;
+    }
+    return QStringLiteral(HUNSPELL_DICT_PATH);
+}
+
+//! The compiled dictionary cache and suggestion index of a dictionary,
+//! named as by DictionaryCache::cacheFileName() and
+//! SymSpellIndex::indexFileName().
+QStringList compiledDictionaryFiles(const QFileInfo &affFile,
+                                    const QFileInfo &dicFile)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(affFile.absoluteFilePath().toUtf8());
+    hash.addData("\n", 1);
+    hash.addData(dicFile.absoluteFilePath().toUtf8());
+
+    const QString baseName(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+                           + QDir::separator() + QStringLiteral("maliit-keyboard")
+                           + QDir::separator() + QStringLiteral("dictionaries")
+                           + QDir::separator() + QString::fromLatin1(hash.result().toHex()));
+
+    return QStringList() << baseName + QStringLiteral(".dict")
+                         << baseName + QStringLiteral(".symspell");
+}
+
+//! Rough memory cost of keeping a plugin resident: its library and data
+//! files and the compiled dictionary, which are mapped once, plus the
+//! hunspell dictionary that each half of its worker may load.
+qint64 estimatePluginSize(const QString &pluginPath,
+                          const QString &languageId)
+{
+    qint64 size = 0;
+
+    const QFileInfoList files(QFileInfo(pluginPath).dir().entryInfoList(QDir::Files));
+    for (const QFileInfo &file : files) {
+        size += file.size();
+    }
+
+    if (languageId.isEmpty()) {
+        return size;
+    }
+
+    // Same lookup as SpellChecker::setLanguage(), which uses the first match.
+    const QDir dictionaries(dictionaryPath());
+    const QFileInfoList affMatches(dictionaries.entryInfoList(QStringList(languageId + QStringLiteral("*.aff")),
+                                                              QDir::Files));
+    const QFileInfoList dicMatches(dictionaries.entryInfoList(QStringList(languageId + QStringLiteral("*.dic")),
+                                                              QDir::Files));
+    if (affMatches.isEmpty() or dicMatches.isEmpty()) {
+        return size;
+    }
+
+    const QFileInfo &affFile = affMatches.first();
+    const QFileInfo &dicFile = dicMatches.first();
+    size += (affFile.size() + dicFile.size()) * DICTIONARY_MEMORY_FACTOR * HUNSPELL_INSTANCES;
+
+    // Mapped once for both halves; the word filter they share is small next to them.
+    for (const QString &compiledFile : compiledDictionaryFiles(affFile, dicFile)) {
+        size += QFileInfo(compiledFile).size();
+    }
+
+    return size;
+}
+
+//! Loads the library on the executor. Resolving and relocating it is the
+//! part worth moving off the main thread; the plugin object itself has to
+//! live there, so onPreloaded() creates it.
+void preload(QPluginLoader *loader,
+             const QString &pluginPath,
+             LanguagePluginPool *pool)
+{
+    loader->load();
+    const qint64 size = estimatePluginSize(pluginPath, languageOfPlugin(pluginPath));
+    QMetaObject::invokeMethod(pool, "onPreloaded", Qt::QueuedConnection,
+                              Q_ARG(QString, pluginPath),
+                              Q_ARG(qint64, size));
+}
+
+} // unnamed namespace
+
+struct PluginEntry
+{
+    QPluginLoader *loader = nullptr;
+    QObject *instance = nullptr;
+    LanguagePluginInterface *plugin = nullptr;
+    QString languageId;
+    qint64 size = 0;
+    quint64 last_used = 0;
+    bool language_ready = false;
+    bool preloading = false;
+    bool warming_up = false;
+    bool discarded = false;
+};
+
+class LanguagePluginPoolPrivate
+{
+public:
+    QHash<QString, PluginEntry> entries;
+    QStringList enabled_plugins;
+    QSet<QString> failed_plugins;
+    QString active_plugin;
+    QString requested_plugin; //!< Passed to load(), pinned until activated.
+    QString error_string;
+    qint64 memory_budget;
+    quint64 use_counter;
+    QTimer warm_up_timer;
+    // Libraries are loaded one at a time, in the background lane. Being
+    // created before any plugin, this also creates the shared executor from
+    // the keyboard rather than from a plugin that may be unloaded.
+    TaskStrand loader;
+    int loads_in_flight;
+
+    explicit LanguagePluginPoolPrivate();
+
+    bool isPinned(const QString &pluginPath) const;
+    void release(const QString &pluginPath);
+    void evict();
+    qint64 residentSize() const;
+};
+
+LanguagePluginPoolPrivate::LanguagePluginPoolPrivate()
+    : memory_budget(DEFAULT_MEMORY_BUDGET)
+    , use_counter(0)
+    , loads_in_flight(0)
+{
+    warm_up_timer.setSingleShot(true);
+    warm_up_timer.setInterval(DEFAULT_WARM_UP_DELAY);
+}
+
+//! Whether pluginPath is in use, or about to be, and must stay loaded.
+bool LanguagePluginPoolPrivate::isPinned(const QString &pluginPath) const
+{
+    return pluginPath == active_plugin || pluginPath == requested_plugin;
+}
+
+void LanguagePluginPoolPrivate::release(const QString &pluginPath)
+{
+    auto it = entries.find(pluginPath);
+    if (it == entries.end()) {
+        return;
+    }
+
+    // The loader is still in use by the background thread, onPreloaded()
+    // finishes the job.
+    if (it->preloading) {
+        it->discarded = true;
+        return;
+    }
+
+    delete it->instance;
+    it->loader->unload();
+    delete it->loader;
+    entries.erase(it);
+}
+
+void LanguagePluginPoolPrivate::evict()
+{
+    while (residentSize() > memory_budget) {
+        QString victim;
+        quint64 oldest = std::numeric_limits<quint64>::max();
+
+        for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+            if (not isPinned(it.key()) && not it->preloading && it->last_used < oldest) {
+                victim = it.key();
+                oldest = it->last_used;
+            }
+        }
+
+        if (victim.isEmpty()) {
+            return;
+        }
+
+        qDebug() << "languagepluginpool.cpp evicting" << victim;
+        release(victim);
+    }
+}
+
+qint64 LanguagePluginPoolPrivate::residentSize() const
+{
+    qint64 size = 0;
+    for (const PluginEntry &entry : entries) {
+        if (not entry.discarded) {
+            size += entry.size;
+        }
+    }
+    return size;
+}
+
+LanguagePluginPool::LanguagePluginPool(QObject *parent)
+    : QObject(parent)
+    , d_ptr(new LanguagePluginPoolPrivate)
+{
+    Q_D(LanguagePluginPool);
+
+    connect(&d->warm_up_timer, &QTimer::timeout,
+            this, &LanguagePluginPool::warmUpNext);
+}
+
+LanguagePluginPool::~LanguagePluginPool()
+{
+    Q_D(LanguagePluginPool);
+
+    d->warm_up_timer.stop();
+    d->loader.clear();
+
+    // Libraries stay loaded: other objects may still reference their code
+    // while the process shuts down.
+    for (PluginEntry &entry : d->entries) {
+        delete entry.instance;
+        delete entry.loader;
+    }
+}
+
+//! Returns the plugin at pluginPath, loading it on the calling thread if it
+//! is not resident, and makes it the active one. Only meant for bootstrapping
+//! the first plugin; use load() to switch plugins without blocking.
+//! Returns nullptr if the plugin cannot be loaded, see errorString().
+LanguagePluginInterface *LanguagePluginPool::acquire(const QString &pluginPath,
+                                                     const QString &languageId)
+{
+    Q_D(LanguagePluginPool);
+
+    auto it = d->entries.find(pluginPath);
+    if (it == d->entries.end()) {
+        PluginEntry entry;
+        entry.loader = new QPluginLoader(pluginPath);
+        entry.size = estimatePluginSize(pluginPath, languageOfPlugin(pluginPath));
+        it = d->entries.insert(pluginPath, entry);
+    }
+
+    if (it->preloading) {
+        // onPreloaded() will find the plugin created.
+        d->loader.wait();
+        it->discarded = false;
+    }
+
+    if (not it->plugin && not instantiate(pluginPath, &*it)) {
+        d->failed_plugins.insert(pluginPath);
+        if (not it->preloading) {
+            d->release(pluginPath);
+        }
+        return nullptr;
+    }
+
+    LanguagePluginInterface *plugin = it->plugin;
+    if (not languageId.isEmpty()) {
+        setLanguage(pluginPath, languageId);
+    }
+    activate(pluginPath);
+    return plugin;
+}
+
+QString LanguagePluginPool::errorString() const
+{
+    Q_D(const LanguagePluginPool);
+    return d->error_string;
+}
+
+//! Starts loading the plugin at pluginPath in the background, unless it is
+//! resident already. Returns true if the plugin is resident, otherwise
+//! pluginLoaded() or pluginFailed() is emitted later.
+//!
+//! The plugin is kept loaded until it is activated or another plugin is
+//! requested, even if it is no longer enabled meanwhile.
+bool LanguagePluginPool::load(const QString &pluginPath)
+{
+    Q_D(LanguagePluginPool);
+
+    d->requested_plugin = pluginPath;
+    return startLoading(pluginPath);
+}
+
+bool LanguagePluginPool::startLoading(const QString &pluginPath)
+{
+    Q_D(LanguagePluginPool);
+
+    auto it = d->entries.find(pluginPath);
+    if (it != d->entries.end()) {
+        it->discarded = false;
+        if (it->plugin) {
+            return true;
+        }
+        if (it->preloading) {
+            it->warming_up = false;
+            return false;
+        }
+    }
+
+    PluginEntry entry;
+    entry.loader = new QPluginLoader(pluginPath);
+    entry.preloading = true;
+    d->entries.insert(pluginPath, entry);
+
+    QPluginLoader *loader = entry.loader;
+    ++d->loads_in_flight;
+    d->loader.post(TaskExecutor::Background, [loader, pluginPath, this]() {
+        preload(loader, pluginPath, this);
+    });
+    return false;
+}
+
+//! Returns the resident plugin at pluginPath, or nullptr.
+LanguagePluginInterface *LanguagePluginPool::plugin(const QString &pluginPath) const
+{
+    Q_D(const LanguagePluginPool);
+
+    const auto it = d->entries.constFind(pluginPath);
+    return it != d->entries.constEnd() ? it->plugin : nullptr;
+}
+
+//! Makes pluginPath the active plugin, which is never evicted, and evicts
+//! the least recently used others if the pool is over its budget.
+void LanguagePluginPool::activate(const QString &pluginPath)
+{
+    Q_D(LanguagePluginPool);
+
+    auto it = d->entries.find(pluginPath);
+    if (it == d->entries.end()) {
+        return;
+    }
+
+    it->last_used = ++d->use_counter;
+    d->active_plugin = pluginPath;
+    if (d->requested_plugin == pluginPath) {
+        d->requested_plugin.clear();
+    }
+    d->evict();
+}
+
+//! Switches the plugin at pluginPath to languageId, unless it uses it
+//! already. Returns true if the language is ready; otherwise the plugin is
+//! still loading it and languageReady() is emitted once it is done.
+bool LanguagePluginPool::setLanguage(const QString &pluginPath,
+                                     const QString &languageId)
+{
+    Q_D(LanguagePluginPool);
+
+    auto it = d->entries.find(pluginPath);
+    if (it == d->entries.end() || not it->plugin) {
+        return false;
+    }
+
+    if (it->languageId != languageId) {
+        it->languageId = languageId;
+        it->language_ready = false;
+        // Plugins returning false have nothing to load.
+        const bool loading = it->plugin->setLanguage(languageId, QFileInfo(pluginPath).absolutePath());
+        it = d->entries.find(pluginPath);
+        if (it != d->entries.end() && not loading) {
+            it->language_ready = true;
+        }
+    }
+
+    return it != d->entries.end() && it->language_ready;
+}
+
+bool LanguagePluginPool::isLanguageReady(const QString &pluginPath,
+                                         const QString &languageId) const
+{
+    Q_D(const LanguagePluginPool);
+
+    const auto it = d->entries.constFind(pluginPath);
+    return it != d->entries.constEnd() && it->plugin
+        && it->languageId == languageId && it->language_ready;
+}
+
+//! Sets the plugins worth keeping resident, usually those of the enabled
+//! languages. Plugins no longer listed are unloaded, except the active one
+//! and the one being loaded for a switch, and the others are warmed up after
+//! warmUpDelay().
+void LanguagePluginPool::setEnabledPlugins(const QStringList &pluginPaths)
+{
+    Q_D(LanguagePluginPool);
+
+    d->enabled_plugins = pluginPaths;
+    d->failed_plugins.clear();
+
+    const QStringList resident(d->entries.keys());
+    for (const QString &pluginPath : resident) {
+        if (not d->isPinned(pluginPath) && not pluginPaths.contains(pluginPath)) {
+            d->release(pluginPath);
+        }
+    }
+
+    d->warm_up_timer.start();
+}
+
+QStringList LanguagePluginPool::enabledPlugins() const
+{
+    Q_D(const LanguagePluginPool);
+    return d->enabled_plugins;
+}
+
+bool LanguagePluginPool::isResident(const QString &pluginPath) const
+{
+    return plugin(pluginPath) != nullptr;
+}
+
+//! Estimated memory used by the resident plugins, in bytes.
+qint64 LanguagePluginPool::residentSize() const
+{
+    Q_D(const LanguagePluginPool);
+    return d->residentSize();
+}
+
+void LanguagePluginPool::setMemoryBudget(qint64 bytes)
+{
+    Q_D(LanguagePluginPool);
+
+    d->memory_budget = bytes;
+    d->evict();
+}
+
+qint64 LanguagePluginPool::memoryBudget() const
+{
+    Q_D(const LanguagePluginPool);
+    return d->memory_budget;
+}
+
+//! Sets the delay between setEnabledPlugins() and the start of the warm-up,
+//! so that it does not compete with the startup of the keyboard itself.
+void LanguagePluginPool::setWarmUpDelay(int msecs)
+{
+    Q_D(LanguagePluginPool);
+    d->warm_up_timer.setInterval(msecs);
+}
+
+int LanguagePluginPool::warmUpDelay() const
+{
+    Q_D(const LanguagePluginPool);
+    return d->warm_up_timer.interval();
+}
+
+bool LanguagePluginPool::instantiate(const QString &pluginPath,
+                                     PluginEntry *entry)
+{
+    Q_D(LanguagePluginPool);
+
+    entry->instance = entry->loader->instance();
+    entry->plugin = qobject_cast<LanguagePluginInterface *>(entry->instance);
+
+    if (not entry->plugin) {
+        d->error_string = entry->instance ? QStringLiteral("Not a language plugin: %1").arg(pluginPath)
+                                          : entry->loader->errorString();
+        delete entry->instance;
+        entry->instance = nullptr;
+        return false;
+    }
+
+    connect(static_cast<AbstractLanguagePlugin *>(entry->plugin), &AbstractLanguagePlugin::languageReady,
+            this, [this, pluginPath](const QString &languageId) {
+                onPluginLanguageReady(pluginPath, languageId);
+            });
+
+    return true;
+}
+
+void LanguagePluginPool::onPluginLanguageReady(const QString &pluginPath,
+                                               const QString &languageId)
+{
+    Q_D(LanguagePluginPool);
+
+    auto it = d->entries.find(pluginPath);
+    if (it == d->entries.end() || it->languageId != languageId || it->language_ready) {
+        return;
+    }
+
+    it->language_ready = true;
+    Q_EMIT languageReady(pluginPath, languageId);
+}
+
+void LanguagePluginPool::warmUpNext()
+{
+    Q_D(LanguagePluginPool);
+
+    if (d->loads_in_flight > 0) {
+        return;
+    }
+
+    for (const QString &pluginPath : qAsConst(d->enabled_plugins)) {
+        if (d->entries.contains(pluginPath) || d->failed_plugins.contains(pluginPath)) {
+            continue;
+        }
+
+        startLoading(pluginPath);
+        d->entries[pluginPath].warming_up = true;
+        return;
+    }
+}
+
+void LanguagePluginPool::onPreloaded(const QString &pluginPath,
+                                     qint64 size)
+{
+    Q_D(LanguagePluginPool);
+
+    --d->loads_in_flight;
+
+    auto it = d->entries.find(pluginPath);
+    if (it == d->entries.end() || not it->preloading) {
+        return;
+    }
+
+    it->preloading = false;
+    it->size = size;
+
+    if (it->discarded) {
+        d->release(pluginPath);
+    } else if (it->plugin) {
+        // Created meanwhile by acquire().
+    } else if (it->warming_up && d->residentSize() > d->memory_budget) {
+        d->failed_plugins.insert(pluginPath);
+        d->release(pluginPath);
+    } else if (not instantiate(pluginPath, &*it)) {
+        qWarning() << __PRETTY_FUNCTION__ << "Loading" << pluginPath << "failed:" << d->error_string;
+        const QString error = d->error_string;
+        d->failed_plugins.insert(pluginPath);
+        if (d->requested_plugin == pluginPath) {
+            d->requested_plugin.clear();
+        }
+        d->release(pluginPath);
+        Q_EMIT pluginFailed(pluginPath, error);
+    } else if (it->warming_up) {
+        it->warming_up = false;
+        setLanguage(pluginPath, languageOfPlugin(pluginPath));
+        Q_EMIT pluginWarmedUp(pluginPath);
+    } else {
+        Q_EMIT pluginLoaded(pluginPath);
+    }
+
+    // One plugin per event loop iteration, to keep input responsive.
+    QTimer::singleShot(0, this, &LanguagePluginPool::warmUpNext);
+}
+
+}} // namespace Logic, MaliitKeyboard
@@ -0,0 +1,116 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_LANGUAGEPLUGINPOOL_H
+#define MALIIT_KEYBOARD_LANGUAGEPLUGINPOOL_H
+
+#include <QtCore>
+
+class LanguagePluginInterface;
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+class LanguagePluginPoolPrivate;
+struct PluginEntry;
+
+//! \class LanguagePluginPool
+//! Keeps the language plugins of the enabled languages loaded.
+//!
+//! Loading a plugin means loading its shared library and then its
+//! dictionaries and language model, so switching languages used to pay for
+//! both every time. The pool keeps plugins resident, keyed by plugin file,
+//! as long as their estimated memory use fits in the budget. Switching to a
+//! resident plugin is a hash lookup.
+//!
+//! load() never blocks: the shared library is loaded in the background lane
+//! of the TaskExecutor, the plugin is then created on the pool's thread and
+//! pluginLoaded() is emitted. Plugins load their dictionaries on their own
+//! worker thread, and languageReady() is emitted once they are done. Plugins
+//! of enabled but inactive languages are warmed up the same way, one at a
+//! time, after a delay.
+//!
+//! The language of a plugin is the name of the directory it is installed
+//! in, <languages dir>/<language>/lib<language>plugin.so.
+class LanguagePluginPool
+    : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(LanguagePluginPool)
+    Q_DECLARE_PRIVATE(LanguagePluginPool)
+
+public:
+    explicit LanguagePluginPool(QObject *parent = nullptr);
+    ~LanguagePluginPool() override;
+
+    LanguagePluginInterface *acquire(const QString &pluginPath,
+                                     const QString &languageId);
+    QString errorString() const;
+
+    bool load(const QString &pluginPath);
+    LanguagePluginInterface *plugin(const QString &pluginPath) const;
+    void activate(const QString &pluginPath);
+    bool setLanguage(const QString &pluginPath,
+                     const QString &languageId);
+    bool isLanguageReady(const QString &pluginPath,
+                         const QString &languageId) const;
+
+    void setEnabledPlugins(const QStringList &pluginPaths);
+    QStringList enabledPlugins() const;
+
+    bool isResident(const QString &pluginPath) const;
+    qint64 residentSize() const;
+
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const;
+
+    void setWarmUpDelay(int msecs);
+    int warmUpDelay() const;
+
+    Q_SIGNAL void pluginLoaded(const QString &pluginPath);
+    Q_SIGNAL void pluginFailed(const QString &pluginPath,
+                               const QString &errorString);
+    Q_SIGNAL void languageReady(const QString &pluginPath,
+                                const QString &languageId);
+    Q_SIGNAL void pluginWarmedUp(const QString &pluginPath);
+
+private:
+    bool startLoading(const QString &pluginPath);
+    bool instantiate(const QString &pluginPath,
+                     PluginEntry *entry);
+    void onPluginLanguageReady(const QString &pluginPath,
+                               const QString &languageId);
+    Q_SLOT void warmUpNext();
+    Q_SLOT void onPreloaded(const QString &pluginPath,
+                            qint64 size);
+
+    const QScopedPointer<LanguagePluginPoolPrivate> d_ptr;
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_LANGUAGEPLUGINPOOL_H
@@ -0,0 +1,249 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "latencystats.h"
+
+#include <chrono>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+namespace {
+
+const char * const InstanceProperty = "_maliit_keyboard_latency_stats";
+
+void atomicMax(std::atomic<quint64> &target, quint64 value)
+{
+    quint64 current = target.load(std::memory_order_relaxed);
+    while (current < value
+           && not target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // unnamed namespace
+
+LatencyHistogram::LatencyHistogram()
+    : m_count(0)
+    , m_total(0)
+    , m_maximum(0)
+{
+    for (std::atomic<quint64> &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(qint64 nsecs)
+{
+    const quint64 usecs = quint64(qMax<qint64>(nsecs, 0) / 1000);
+    const int index = usecs == 0 ? 0 : qMin<int>(64 - qCountLeadingZeroBits(usecs),
+                                                 BucketCount - 1);
+
+    m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(usecs, std::memory_order_relaxed);
+    atomicMax(m_maximum, usecs);
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<quint64> &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_total.store(0, std::memory_order_relaxed);
+    m_maximum.store(0, std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::bucket(int index) const
+{
+    return m_buckets[index].load(std::memory_order_relaxed);
+}
+
+//! Returns the mean duration in microseconds.
+qint64 LatencyHistogram::mean() const
+{
+    const quint64 samples = count();
+    return samples ? qint64(m_total.load(std::memory_order_relaxed) / samples) : 0;
+}
+
+//! Returns the longest duration in microseconds.
+qint64 LatencyHistogram::maximum() const
+{
+    return qint64(m_maximum.load(std::memory_order_relaxed));
+}
+
+//! Returns the upper bound, in microseconds, of the bucket holding the
+//! given fraction of the samples; 0.99 gives the 99th percentile.
+qint64 LatencyHistogram::percentile(double fraction) const
+{
+    quint64 samples = 0;
+    for (int index = 0; index < BucketCount; ++index) {
+        samples += bucket(index);
+    }
+
+    if (samples == 0) {
+        return 0;
+    }
+
+    const quint64 rank = qMax<quint64>(1, quint64(fraction * samples + 0.5));
+    quint64 seen = 0;
+    for (int index = 0; index < BucketCount; ++index) {
+        seen += bucket(index);
+        if (seen >= rank) {
+            return qMin(qint64(1) << index, maximum());
+        }
+    }
+
+    return maximum();
+}
+
+LatencyStats::LatencyStats()
+    : m_keystroke(0)
+{}
+
+//! Returns the process-wide instance, creating it on first use.
+//!
+//! The host creates it while setting up the input method, before any key
+//! event arrives, so plugin worker threads only ever read the property.
+LatencyStats *LatencyStats::instance()
+{
+    static std::atomic<LatencyStats *> cached(nullptr);
+
+    LatencyStats *stats = cached.load(std::memory_order_acquire);
+    if (stats) {
+        return stats;
+    }
+
+    QCoreApplication *application = QCoreApplication::instance();
+    if (application) {
+        const QVariant property = application->property(InstanceProperty);
+
+        if (property.isValid()) {
+            stats = reinterpret_cast<LatencyStats *>(property.value<quintptr>());
+        } else {
+            // Deliberately never freed: stages record until the process exits.
+            stats = new LatencyStats;
+            application->setProperty(InstanceProperty,
+                                     QVariant::fromValue(reinterpret_cast<quintptr>(stats)));
+        }
+    } else {
+        static LatencyStats local;
+        stats = &local;
+    }
+
+    cached.store(stats, std::memory_order_release);
+    return stats;
+}
+
+//! Returns a monotonic timestamp in nanoseconds, comparable across threads
+//! and modules.
+qint64 LatencyStats::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char *LatencyStats::stageName(Stage stage)
+{
+    switch (stage) {
+    case KeyReleased: return "key-released";
+    case EditorKeyReleased: return "editor-key-released";
+    case ComputeCandidates: return "compute-candidates";
+    case WorkerQueued: return "worker-queued";
+    case WorkerProcessing: return "worker-processing";
+    case RibbonUpdate: return "ribbon-update";
+    case KeystrokeToRibbon: return "keystroke-to-ribbon";
+    case StageCount: break;
+    }
+
+    return "unknown";
+}
+
+//! Marks the release of a key as the start of the stages measured from it.
+void LatencyStats::markKeystroke()
+{
+    m_keystroke.store(now(), std::memory_order_relaxed);
+}
+
+void LatencyStats::record(Stage stage, qint64 nsecs)
+{
+    m_histograms[stage].record(nsecs);
+}
+
+//! Records the time since the last keystroke, only the first time after it:
+//! a keystroke may update the ribbon several times, but only its first
+//! update is what the user waits for.
+void LatencyStats::recordSinceKeystroke(Stage stage)
+{
+    const qint64 keystroke = m_keystroke.exchange(0, std::memory_order_relaxed);
+    if (keystroke != 0) {
+        record(stage, now() - keystroke);
+    }
+}
+
+const LatencyHistogram &LatencyStats::histogram(Stage stage) const
+{
+    return m_histograms[stage];
+}
+
+//! Returns a text table of all stages, durations in microseconds.
+QString LatencyStats::dump() const
+{
+    QString result = QString::asprintf("%-22s%10s%10s%10s%10s%10s%10s\n",
+                                       "stage", "count", "mean", "p50", "p90", "p99", "max");
+
+    for (int index = 0; index < StageCount; ++index) {
+        const Stage stage = static_cast<Stage>(index);
+        const LatencyHistogram &stats(m_histograms[index]);
+
+        result += QString::asprintf("%-22s%10llu%10lld%10lld%10lld%10lld%10lld\n",
+                                    stageName(stage),
+                                    static_cast<unsigned long long>(stats.count()),
+                                    static_cast<long long>(stats.mean()),
+                                    static_cast<long long>(stats.percentile(0.5)),
+                                    static_cast<long long>(stats.percentile(0.9)),
+                                    static_cast<long long>(stats.percentile(0.99)),
+                                    static_cast<long long>(stats.maximum()));
+    }
+
+    return result;
+}
+
+void LatencyStats::reset()
+{
+    for (LatencyHistogram &stats : m_histograms) {
+        stats.reset();
+    }
+    m_keystroke.store(0, std::memory_order_relaxed);
+}
+
+}} // namespace Logic, MaliitKeyboard
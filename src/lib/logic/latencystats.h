@@ -0,0 +1,162 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_LATENCYSTATS_H
+#define MALIIT_KEYBOARD_LATENCYSTATS_H
+
+//! Keystroke-to-candidate latency instrumentation.
+//!
+//! Configuring with -Denable-latency-stats=ON defines
+//! MALIIT_KEYBOARD_LATENCY_STATS. Without it the MALIIT_LATENCY_* macros
+//! expand to nothing and none of the classes below exist.
+
+#ifdef MALIIT_KEYBOARD_LATENCY_STATS
+
+#include <QtCore>
+
+#include <atomic>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+//! \class LatencyHistogram
+//! Lock-free histogram of durations with power-of-two buckets.
+//!
+//! Bucket 0 counts durations below one microsecond and bucket n durations
+//! in [2^(n-1), 2^n) microseconds. Recording is a couple of relaxed atomic
+//! increments, so it is safe and cheap from any thread.
+class LatencyHistogram
+{
+public:
+    enum { BucketCount = 32 };
+
+    LatencyHistogram();
+
+    void record(qint64 nsecs);
+    void reset();
+
+    quint64 count() const;
+    quint64 bucket(int index) const;
+    qint64 mean() const;
+    qint64 maximum() const;
+    qint64 percentile(double fraction) const;
+
+private:
+    Q_DISABLE_COPY(LatencyHistogram)
+
+    std::atomic<quint64> m_buckets[BucketCount];
+    std::atomic<quint64> m_count;
+    std::atomic<quint64> m_total;
+    std::atomic<quint64> m_maximum;
+};
+
+//! \class LatencyStats
+//! One LatencyHistogram per stage of the path from a key release to the
+//! word ribbon.
+//!
+//! Language plugins link their own copy of this library, so the instance
+//! is created once per process and published as a dynamic property of the
+//! application object, where every module looks it up.
+class LatencyStats
+{
+public:
+    enum Stage
+    {
+        KeyReleased,          //!< EventHandler::onKeyReleased().
+        EditorKeyReleased,    //!< AbstractTextEditor::onKeyReleased().
+        ComputeCandidates,    //!< AbstractWordEngine::computeCandidates().
+        WorkerQueued,         //!< From the key release to a plugin worker starting.
+        WorkerProcessing,     //!< A plugin worker computing its results.
+        RibbonUpdate,         //!< WordRibbon::onWordCandidatesChanged().
+        KeystrokeToRibbon,    //!< From the key release to the first ribbon update.
+        StageCount
+    };
+
+    static LatencyStats *instance();
+    static qint64 now();
+    static const char *stageName(Stage stage);
+
+    void markKeystroke();
+    void record(Stage stage, qint64 nsecs);
+    void recordSinceKeystroke(Stage stage);
+
+    const LatencyHistogram &histogram(Stage stage) const;
+    QString dump() const;
+    void reset();
+
+private:
+    LatencyStats();
+    Q_DISABLE_COPY(LatencyStats)
+
+    LatencyHistogram m_histograms[StageCount];
+    std::atomic<qint64> m_keystroke;
+};
+
+//! Records the lifetime of the scope into the histogram of a stage.
+class LatencyScope
+{
+public:
+    explicit LatencyScope(LatencyStats::Stage stage)
+        : m_stage(stage)
+        , m_start(LatencyStats::now())
+    {}
+
+    ~LatencyScope()
+    {
+        LatencyStats::instance()->record(m_stage, LatencyStats::now() - m_start);
+    }
+
+private:
+    Q_DISABLE_COPY(LatencyScope)
+
+    const LatencyStats::Stage m_stage;
+    const qint64 m_start;
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+#define MALIIT_LATENCY_CONCAT_(a, b) a##b
+#define MALIIT_LATENCY_CONCAT(a, b) MALIIT_LATENCY_CONCAT_(a, b)
+
+#define MALIIT_LATENCY_SCOPE(stage) \
+    const MaliitKeyboard::Logic::LatencyScope MALIIT_LATENCY_CONCAT(latency_scope_, __LINE__) \
+        (MaliitKeyboard::Logic::LatencyStats::stage)
+#define MALIIT_LATENCY_KEYSTROKE() \
+    MaliitKeyboard::Logic::LatencyStats::instance()->markKeystroke()
+#define MALIIT_LATENCY_SINCE_KEYSTROKE(stage) \
+    MaliitKeyboard::Logic::LatencyStats::instance()->recordSinceKeystroke( \
+        MaliitKeyboard::Logic::LatencyStats::stage)
+
+#else
+
+#define MALIIT_LATENCY_SCOPE(stage) do {} while (false)
+#define MALIIT_LATENCY_KEYSTROKE() do {} while (false)
+#define MALIIT_LATENCY_SINCE_KEYSTROKE(stage) do {} while (false)
+
+#endif // MALIIT_KEYBOARD_LATENCY_STATS
+
+#endif // MALIIT_KEYBOARD_LATENCYSTATS_H
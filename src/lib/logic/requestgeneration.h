@@ -0,0 +1,77 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_REQUESTGENERATION_H
+#define MALIIT_KEYBOARD_REQUESTGENERATION_H
+
+#include <QtGlobal>
+
+#include <atomic>
+
+//! \class RequestGeneration
+//! Tracks the newest request generation handed to a worker.
+//!
+//! WordEngine tags every keystroke with a monotonically increasing
+//! generation that is passed through LanguagePluginInterface and returned
+//! with the results. The plugin records each generation here on the GUI
+//! thread when it queues a request, and the worker thread checks it before
+//! starting the work: anything older than the newest request has already
+//! been superseded and is dropped without touching the backend.
+class RequestGeneration
+{
+public:
+    RequestGeneration()
+        : m_latest(0)
+    {}
+
+    //! Records generation as requested. Thread-safe.
+    void request(quint64 generation)
+    {
+        quint64 latest = m_latest.load(std::memory_order_relaxed);
+        while (latest < generation
+               && not m_latest.compare_exchange_weak(latest, generation, std::memory_order_relaxed)) {
+        }
+    }
+
+    //! Returns the newest generation requested so far. Thread-safe.
+    quint64 latest() const
+    {
+        return m_latest.load(std::memory_order_relaxed);
+    }
+
+    //! Returns true if a request newer than generation has been made since.
+    bool isSuperseded(quint64 generation) const
+    {
+        return generation < latest();
+    }
+
+private:
+    Q_DISABLE_COPY(RequestGeneration)
+    std::atomic<quint64> m_latest;
+};
+
+#endif // MALIIT_KEYBOARD_REQUESTGENERATION_H
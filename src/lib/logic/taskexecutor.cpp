@@ -0,0 +1,369 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "taskexecutor.h"
+
+#include <atomic>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+namespace {
+
+const char *const InstanceProperty = "_maliit_keyboard_task_executor";
+const char *const WorkerThreadName = "maliit-keyboard-worker";
+
+//! Whether the calling thread is a worker of any executor. Plugins link
+//! their own copy of this code, so the thread is told by its name.
+bool isWorkerThread()
+{
+    return QThread::currentThread()->objectName() == QLatin1String(WorkerThreadName);
+}
+
+} // unnamed namespace
+
+struct StrandQueue
+{
+    QQueue<QPair<TaskExecutor::Lane, TaskExecutor::Task> > tasks;
+    bool queued = false;  //!< Waiting in a lane of the executor.
+    bool running = false; //!< One of its tasks is running.
+};
+
+//! Entry of a lane: a task without affinity, or a strand whose next task is
+//! due.
+struct Job
+{
+    StrandQueue *strand;
+    TaskExecutor::Task task;
+};
+
+class WorkerThread
+    : public QThread
+{
+public:
+    explicit WorkerThread(TaskExecutorPrivate *executor)
+        : m_executor(executor)
+    {
+        setObjectName(QLatin1String(WorkerThreadName));
+    }
+
+    void run() override;
+
+private:
+    TaskExecutorPrivate *const m_executor;
+};
+
+class TaskExecutorPrivate
+{
+public:
+    QMutex mutex;
+    QWaitCondition work_available;
+    QWaitCondition strand_idle;
+    QQueue<Job> lanes[TaskExecutor::LaneCount];
+    QVector<WorkerThread *> threads;
+    int background_running;
+    bool stopping;
+
+    explicit TaskExecutorPrivate();
+
+    void work();
+    bool takeJob(Job *job, TaskExecutor::Lane *lane);
+    void schedule(StrandQueue *strand);
+    void unschedule(StrandQueue *strand);
+};
+
+void WorkerThread::run()
+{
+    m_executor->work();
+}
+
+TaskExecutorPrivate::TaskExecutorPrivate()
+    : background_running(0)
+    , stopping(false)
+{}
+
+void TaskExecutorPrivate::work()
+{
+    QMutexLocker locker(&mutex);
+
+    forever {
+        Job job;
+        TaskExecutor::Lane lane;
+
+        while (not stopping && not takeJob(&job, &lane)) {
+            work_available.wait(&mutex);
+        }
+
+        if (stopping) {
+            return;
+        }
+
+        locker.unlock();
+        job.task();
+        job.task = TaskExecutor::Task();
+        locker.relock();
+
+        if (lane == TaskExecutor::Background) {
+            --background_running;
+        }
+
+        if (job.strand) {
+            job.strand->running = false;
+            schedule(job.strand);
+            strand_idle.wakeAll();
+        }
+    }
+}
+
+//! Takes the next job, interactive ones first. Must be called locked.
+bool TaskExecutorPrivate::takeJob(Job *job, TaskExecutor::Lane *lane)
+{
+    // Background work leaves one thread free for the next keystroke.
+    const int background_limit = qMax(1, threads.size() - 1);
+
+    for (int index = 0; index < TaskExecutor::LaneCount; ++index) {
+        if (index == TaskExecutor::Background && background_running >= background_limit) {
+            break;
+        }
+
+        QQueue<Job> &queue(lanes[index]);
+        while (not queue.isEmpty()) {
+            *job = queue.dequeue();
+
+            if (job->strand) {
+                job->strand->queued = false;
+                if (job->strand->tasks.isEmpty()) {
+                    continue;
+                }
+                job->task = job->strand->tasks.dequeue().second;
+                job->strand->running = true;
+            }
+
+            *lane = TaskExecutor::Lane(index);
+            if (*lane == TaskExecutor::Background) {
+                ++background_running;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//! Queues the strand in the lane of its next task, unless it is queued or
+//! running already. Must be called locked.
+void TaskExecutorPrivate::schedule(StrandQueue *strand)
+{
+    if (strand->queued || strand->running || strand->tasks.isEmpty()) {
+        return;
+    }
+
+    strand->queued = true;
+    lanes[strand->tasks.head().first].enqueue(Job{strand, TaskExecutor::Task()});
+    work_available.wakeOne();
+}
+
+//! Removes the strand from the lanes. Must be called locked.
+void TaskExecutorPrivate::unschedule(StrandQueue *strand)
+{
+    for (QQueue<Job> &queue : lanes) {
+        for (auto it = queue.begin(); it != queue.end();) {
+            it = (it->strand == strand) ? queue.erase(it) : it + 1;
+        }
+    }
+    strand->queued = false;
+}
+
+TaskExecutor::TaskExecutor(int threadCount,
+                           QObject *parent)
+    : QObject(parent)
+    , d_ptr(new TaskExecutorPrivate)
+{
+    Q_D(TaskExecutor);
+
+    for (int i = 0; i < qMax(1, threadCount); ++i) {
+        d->threads.append(new WorkerThread(d));
+    }
+
+    for (WorkerThread *thread : qAsConst(d->threads)) {
+        thread->start();
+    }
+}
+
+//! Stops the threads once their current tasks are done. Queued tasks are
+//! dropped.
+TaskExecutor::~TaskExecutor()
+{
+    Q_D(TaskExecutor);
+
+    {
+        QMutexLocker locker(&d->mutex);
+        d->stopping = true;
+        d->work_available.wakeAll();
+    }
+
+    for (WorkerThread *thread : qAsConst(d->threads)) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+//! Returns the executor shared by the keyboard and all language plugins,
+//! creating it on first use. It is a child of the application object.
+TaskExecutor *TaskExecutor::instance()
+{
+    static std::atomic<TaskExecutor *> cached(nullptr);
+
+    TaskExecutor *executor = cached.load(std::memory_order_acquire);
+    if (executor) {
+        return executor;
+    }
+
+    QCoreApplication *application = QCoreApplication::instance();
+    if (application) {
+        const QVariant property = application->property(InstanceProperty);
+
+        if (property.isValid()) {
+            executor = reinterpret_cast<TaskExecutor *>(property.value<quintptr>());
+        } else {
+            executor = new TaskExecutor(defaultThreadCount(), application);
+            application->setProperty(InstanceProperty,
+                                     QVariant::fromValue(reinterpret_cast<quintptr>(executor)));
+        }
+    } else {
+        static TaskExecutor local;
+        executor = &local;
+    }
+
+    cached.store(executor, std::memory_order_release);
+    return executor;
+}
+
+//! Two threads, so that background work never blocks interactive work, and
+//! at most four: there are only ever a few backends busy at once.
+int TaskExecutor::defaultThreadCount()
+{
+    return qBound(2, QThread::idealThreadCount(), 4);
+}
+
+int TaskExecutor::threadCount() const
+{
+    Q_D(const TaskExecutor);
+    return d->threads.size();
+}
+
+//! Runs task on any thread of the executor. It may run concurrently with
+//! any other task.
+void TaskExecutor::post(Lane lane,
+                        const Task &task)
+{
+    Q_D(TaskExecutor);
+
+    QMutexLocker locker(&d->mutex);
+    d->lanes[lane].enqueue(Job{nullptr, task});
+    d->work_available.wakeOne();
+}
+
+TaskStrand::TaskStrand(TaskExecutor *executor)
+    : m_executor(executor)
+    , m_queue(new StrandQueue)
+{}
+
+TaskStrand::~TaskStrand()
+{
+    clear();
+}
+
+void TaskStrand::post(TaskExecutor::Lane lane,
+                      const TaskExecutor::Task &task)
+{
+    TaskExecutorPrivate *const d = m_executor->d_func();
+
+    QMutexLocker locker(&d->mutex);
+    m_queue->tasks.enqueue(qMakePair(lane, task));
+    d->schedule(m_queue.data());
+}
+
+//! Drops the tasks that have not started yet and waits for the running one,
+//! if any. Must not be called from a task of this strand.
+void TaskStrand::clear()
+{
+    TaskExecutorPrivate *const d = m_executor->d_func();
+
+    QMutexLocker locker(&d->mutex);
+    m_queue->tasks.clear();
+    d->unschedule(m_queue.data());
+
+    while (m_queue->running) {
+        d->strand_idle.wait(&d->mutex);
+    }
+}
+
+//! Waits until all tasks posted so far have run.
+//!
+//! Must not be called from any task of an executor: the tasks of the strand
+//! may need the very thread, or background slot, the caller occupies. Use
+//! drain() there instead.
+void TaskStrand::wait()
+{
+    Q_ASSERT_X(not isWorkerThread(), Q_FUNC_INFO,
+               "waiting for a strand from an executor task can deadlock");
+
+    TaskExecutorPrivate *const d = m_executor->d_func();
+
+    QMutexLocker locker(&d->mutex);
+    while (m_queue->running || not m_queue->tasks.isEmpty()) {
+        d->strand_idle.wait(&d->mutex);
+    }
+}
+
+//! Runs the tasks that have not started yet on the calling thread, in
+//! order, after waiting for the running one, if any. Unlike wait(), this
+//! never needs a free thread of the executor, so it may be called from a
+//! task of another strand. Must not be called from a task of this strand.
+void TaskStrand::drain()
+{
+    TaskExecutorPrivate *const d = m_executor->d_func();
+
+    QQueue<QPair<TaskExecutor::Lane, TaskExecutor::Task> > tasks;
+    {
+        QMutexLocker locker(&d->mutex);
+
+        while (m_queue->running) {
+            d->strand_idle.wait(&d->mutex);
+        }
+
+        tasks.swap(m_queue->tasks);
+        d->unschedule(m_queue.data());
+    }
+
+    while (not tasks.isEmpty()) {
+        tasks.dequeue().second();
+    }
+}
+
+}} // namespace Logic, MaliitKeyboard
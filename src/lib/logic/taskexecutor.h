@@ -0,0 +1,119 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_TASKEXECUTOR_H
+#define MALIIT_KEYBOARD_TASKEXECUTOR_H
+
+#include <QtCore>
+
+#include <functional>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+class TaskExecutorPrivate;
+struct StrandQueue;
+
+//! \class TaskExecutor
+//! Keyboard-wide pool of worker threads shared by the language plugins.
+//!
+//! Work is posted to one of two lanes. The interactive lane is for work a
+//! keystroke waits for, such as predictions and spelling corrections; the
+//! background lane is for everything else: learning words, loading
+//! dictionaries and models, compaction. Interactive work is always picked
+//! first, and background work never occupies the last free thread, so a
+//! long dictionary load cannot delay a keystroke.
+//!
+//! Backends that are not thread-safe (Hunspell, presage, libpinyin, anthy)
+//! are driven through a TaskStrand, which runs its tasks one at a time.
+//!
+//! Language plugins each link their own copy of this library, so the
+//! executor is shared through instance(). The keyboard creates it before
+//! loading any plugin, which keeps the worker code out of plugins that may
+//! be unloaded.
+class TaskExecutor
+    : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TaskExecutor)
+    Q_DECLARE_PRIVATE(TaskExecutor)
+
+public:
+    enum Lane
+    {
+        Interactive,
+        Background,
+        LaneCount
+    };
+
+    typedef std::function<void()> Task;
+
+    explicit TaskExecutor(int threadCount = defaultThreadCount(),
+                          QObject *parent = nullptr);
+    ~TaskExecutor() override;
+
+    static TaskExecutor *instance();
+    static int defaultThreadCount();
+
+    int threadCount() const;
+    void post(Lane lane,
+              const Task &task);
+
+private:
+    friend class TaskStrand;
+    const QScopedPointer<TaskExecutorPrivate> d_ptr;
+};
+
+//! \class TaskStrand
+//! Runs tasks on a TaskExecutor one at a time, in the order they were
+//! posted, whatever their lane. The lane of the next task decides how soon
+//! the strand gets a thread.
+//!
+//! Objects whose code comes from a plugin must clear their strand before
+//! the plugin is unloaded; the destructor does so.
+class TaskStrand
+{
+    Q_DISABLE_COPY(TaskStrand)
+
+public:
+    explicit TaskStrand(TaskExecutor *executor = TaskExecutor::instance());
+    ~TaskStrand();
+
+    void post(TaskExecutor::Lane lane,
+              const TaskExecutor::Task &task);
+    void clear();
+    void wait();
+    void drain();
+
+private:
+    TaskExecutor *const m_executor;
+    const QScopedPointer<StrandQueue> m_queue;
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_TASKEXECUTOR_H
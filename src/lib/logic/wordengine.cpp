@@ -31,12 +31,74 @@
 
 #include "wordengine.h"
 #include "abstractlanguageplugin.h"
+#include "editdistance.h"
+#include "languagepluginpool.h"
+
+#include <algorithm>
 
 namespace MaliitKeyboard {
 namespace Logic {
 
 #define DEFAULT_PLUGIN MALIIT_KEYBOARD_LANGUAGES_DIR "/en/libenplugin.so"
 
+// Milliseconds to wait for the slower of spelling and prediction before
+// publishing the candidates of a keystroke without it.
+const int DEFAULT_MERGE_DEADLINE = 100;
+
+// Candidate buffers kept for reuse. A published buffer stays shared with the
+// word ribbon until the next list replaces it, so at least two are needed to
+// always find a released one.
+const int CANDIDATE_POOL_SIZE = 3;
+const int CANDIDATE_POOL_CAPACITY = 32;
+
+// Source weights for rank-derived scores: a candidate of rank r scores
+// weight / (r + 1). The best correction outranks the best prediction, but
+// not the predictions behind it.
+const float CORRECTION_WEIGHT = 1.0f;
+const float PREDICTION_WEIGHT = 0.9f;
+
+// Upper bound of the merged list; Pinyin alone can offer 100 entries.
+const int MAX_CANDIDATES = 100;
+
+// Milliseconds after which a language switch completes even though the
+// plugin has not been loaded, or has not reported its language as loaded.
+const int LANGUAGE_READY_TIMEOUT = 10000;
+
+struct ScoredCandidate
+{
+    QString word;
+    float score;
+    WordCandidate::Source source;
+    int order;
+};
+
+//! Results collected for the current generation until they are merged.
+struct PendingResults
+{
+    enum Source
+    {
+        Predictions = 0x1,
+        Corrections = 0x2
+    };
+
+    int expected = 0;
+    int received = 0;
+    bool next_word = false;
+    bool restored_preedit = false;
+    QStringList predictions;
+    QStringList corrections;
+
+    void reset()
+    {
+        expected = 0;
+        received = 0;
+        next_word = false;
+        restored_preedit = false;
+        predictions.clear();
+        corrections.clear();
+    }
+};
+
 //! \class WordEngine
 //! \brief Provides error correction (based on Hunspell) and word
 //! prediction (based on Presage).
@@ -56,60 +118,77 @@ public:
 
     bool auto_correct_enabled;
 
-    bool calculated_primary_candidate;
-
-    bool clear_candidates_on_incoming;
-
     LanguagePluginInterface* languagePlugin;
 
-    QPluginLoader pluginLoader;
+    LanguagePluginPool plugin_pool;
 
+    //! Language switch state machine, see WordEngine::onLanguageChanged().
+    enum LanguageState
+    {
+        LanguageReady,
+        LoadingPlugin,
+        LoadingLanguage
+    };
+
+    LanguageState language_state;
+    QString requested_plugin;
+    QString requested_language;
+    QTimer language_timeout;
+    // Requests that arrived during a switch, replayed once it completes.
+    bool fetch_queued;
+    QStringList queued_user_words;
+
+    WordCandidateList candidate_pool[CANDIDATE_POOL_SIZE];
+    int candidate_pool_index;
     WordCandidateList* candidates;
 
     Model::Text *currentText;
 
-    explicit WordEnginePrivate();
+    PendingResults pending;
+    QTimer merge_timer;
+    int merge_deadline;
 
-    QString currentPlugin;
-    void loadPlugin(QString pluginPath)
-    {
-        if (pluginPath == currentPlugin)
-            return;
+    // Scratch space of appendRankedCandidates(), kept to reuse its capacity.
+    QVector<ScoredCandidate> merge_scratch;
+    QVector<int> merge_slots;
 
-        delete languagePlugin;
-        pluginLoader.unload();
+    explicit WordEnginePrivate();
 
-        // to avoid hickups in libpresage, libpinyin
-        QLocale::setDefault(QLocale::c());
-        setlocale(LC_NUMERIC, "C");
+    WordCandidateList* nextCandidateBuffer();
+    void beginMerge(int count);
+    void mergeSource(WordCandidate::Source source,
+                     float weight,
+                     const QStringList &words);
 
+    QString currentPlugin;
+
+    static QString resolvePluginPath(const QString &pluginPath)
+    {
         if (pluginPath == DEFAULT_PLUGIN) {
             QString prefix = qgetenv("KEYBOARD_PREFIX_PATH");
             if (!prefix.isEmpty()) {
-                pluginPath = prefix + QDir::separator() + pluginPath;
+                return prefix + QDir::separator() + pluginPath;
             }
         }
+        return pluginPath;
+    }
 
-        pluginLoader.setFileName(pluginPath);
-        QObject *plugin = pluginLoader.instance();
+    // Only used to have a plugin from the start; language switches load
+    // plugins in the background.
+    void loadDefaultPlugin()
+    {
+        // to avoid hickups in libpresage, libpinyin
+        QLocale::setDefault(QLocale::c());
+        setlocale(LC_NUMERIC, "C");
 
-        if (plugin) {
-            languagePlugin = qobject_cast<LanguagePluginInterface *>(plugin);
-            if (!languagePlugin) {
-                qCritical() << "wordengine.cpp - loading plugin failed: " + pluginPath;
+        const QString pluginPath = resolvePluginPath(DEFAULT_PLUGIN);
+        languagePlugin = plugin_pool.acquire(pluginPath, QString());
 
-                // fallback
-                if (pluginPath != DEFAULT_PLUGIN)
-                    loadPlugin(DEFAULT_PLUGIN);
-            } else {
-                qDebug() << "wordengine.cpp plugin" << pluginPath << "loaded";
-                currentPlugin = pluginPath;
-            }
+        if (languagePlugin) {
+            qDebug() << "wordengine.cpp plugin" << pluginPath << "loaded";
+            currentPlugin = pluginPath;
         } else {
-            qCritical() << __PRETTY_FUNCTION__ << " Loading plugin failed: " << pluginLoader.errorString();
-            // fallback
-            if (pluginPath != DEFAULT_PLUGIN)
-                loadPlugin(DEFAULT_PLUGIN);
+            qCritical() << __PRETTY_FUNCTION__ << " Loading plugin failed: " << plugin_pool.errorString();
         }
     }
 };
@@ -120,13 +199,103 @@ WordEnginePrivate::WordEnginePrivate()
     , use_spell_checker(false)
     , is_preedit_capitalized(false)
     , auto_correct_enabled(false)
-    , calculated_primary_candidate(false)
-    , clear_candidates_on_incoming(false)
     , languagePlugin(nullptr)
+    , language_state(LanguageReady)
+    , fetch_queued(false)
+    , candidate_pool_index(0)
+    , candidates(&candidate_pool[0])
     , currentText(nullptr)
+    , merge_deadline(DEFAULT_MERGE_DEADLINE)
+{
+    for (WordCandidateList &buffer : candidate_pool) {
+        buffer.reserve(CANDIDATE_POOL_CAPACITY);
+    }
+    language_timeout.setSingleShot(true);
+    language_timeout.setInterval(LANGUAGE_READY_TIMEOUT);
+    loadDefaultPlugin();
+}
+
+//! \brief Returns an empty buffer for the next candidate list.
+//!
+//! Buffers are taken from a small ring and only reused once no published
+//! snapshot refers to them any more, so the capacity they grew to is kept
+//! and steady-state typing does not allocate.
+WordCandidateList* WordEnginePrivate::nextCandidateBuffer()
 {
-    loadPlugin(DEFAULT_PLUGIN);
-    candidates = new WordCandidateList();
+    for (int i = 1; i <= CANDIDATE_POOL_SIZE; ++i) {
+        const int index = (candidate_pool_index + i) % CANDIDATE_POOL_SIZE;
+        WordCandidateList &buffer(candidate_pool[index]);
+
+        if (buffer.isDetached()) {
+            candidate_pool_index = index;
+            buffer.clear();
+            return &buffer;
+        }
+    }
+
+    // Every buffer is still held by a consumer; give up the oldest one to
+    // them and start a new one in its place.
+    candidate_pool_index = (candidate_pool_index + 1) % CANDIDATE_POOL_SIZE;
+    WordCandidateList &buffer(candidate_pool[candidate_pool_index]);
+    buffer = WordCandidateList();
+    buffer.reserve(CANDIDATE_POOL_CAPACITY);
+    return &buffer;
+}
+
+void WordEnginePrivate::beginMerge(int count)
+{
+    merge_scratch.clear();
+
+    // Open addressing over indices into merge_scratch, kept at most half
+    // full so probe sequences stay short.
+    int slots = 16;
+    while (slots < count * 2) {
+        slots *= 2;
+    }
+    merge_slots.fill(-1, slots);
+}
+
+void WordEnginePrivate::mergeSource(WordCandidate::Source source,
+                                    float weight,
+                                    const QStringList &words)
+{
+    const uint mask = merge_slots.size() - 1;
+
+    for (int rank = 0; rank < words.size(); ++rank) {
+        QString word(words.at(rank));
+        if (word.isEmpty()) {
+            continue;
+        }
+
+        if (is_preedit_capitalized) {
+            word[0] = word.at(0).toUpper();
+        }
+
+        const float score = weight / (rank + 1);
+        uint slot = qHash(word) & mask;
+
+        for (;;) {
+            const int index = merge_slots.at(slot);
+
+            if (index < 0) {
+                const ScoredCandidate entry = { word, score, source, merge_scratch.size() };
+                merge_slots[slot] = entry.order;
+                merge_scratch.append(entry);
+                break;
+            }
+
+            ScoredCandidate &existing(merge_scratch[index]);
+            if (existing.word == word) {
+                if (score > existing.score) {
+                    existing.score = score;
+                    existing.source = source;
+                }
+                break;
+            }
+
+            slot = (slot + 1) & mask;
+        }
+    }
 }
 
 
@@ -137,6 +306,21 @@ WordEngine::WordEngine(QObject *parent)
     : AbstractWordEngine(parent)
     , d_ptr(new WordEnginePrivate)
 {
+    Q_D(WordEngine);
+
+    d->merge_timer.setSingleShot(true);
+    connect(&d->merge_timer, &QTimer::timeout,
+            this, &WordEngine::publishCandidates);
+
+    connect(&d->plugin_pool, &LanguagePluginPool::pluginLoaded,
+            this, &WordEngine::onPluginLoaded);
+    connect(&d->plugin_pool, &LanguagePluginPool::pluginFailed,
+            this, &WordEngine::onPluginFailed);
+    connect(&d->plugin_pool, &LanguagePluginPool::languageReady,
+            this, &WordEngine::onPluginLanguageReady);
+    connect(&d->language_timeout, &QTimer::timeout,
+            this, &WordEngine::onLanguageTimeout);
+
     Q_EMIT preeditFaceChanged(Model::Text::PreeditDefault);
 }
 
@@ -153,9 +337,17 @@ bool WordEngine::isEnabled() const
             d->languagePlugin->languageFeature()->wordEngineAvailable());
 }
 
-void WordEngine::appendToCandidates(WordCandidateList *candidates,
-                                    WordCandidate::Source source,
-                                    const QString &candidate)
+//! \brief Appends the corrections and predictions to \a candidates, best
+//! first.
+//!
+//! Both lists are expected to be ordered by the plugin, best first. Each
+//! entry is scored from its rank and the weight of its source, so the order
+//! of the merged list does not depend on which source finished first. A word
+//! offered by both sources is listed once, with its best score, and at most
+//! MAX_CANDIDATES entries are kept.
+void WordEngine::appendRankedCandidates(WordCandidateList *candidates,
+                                        const QStringList &corrections,
+                                        const QStringList &predictions)
 {
     Q_D(WordEngine);
 
@@ -163,16 +355,23 @@ void WordEngine::appendToCandidates(WordCandidateList *candidates,
         return;
     }
 
-    QString changed_candidate(candidate);
+    d->beginMerge(corrections.size() + predictions.size());
+    d->mergeSource(WordCandidate::SourceSpellChecking, CORRECTION_WEIGHT, corrections);
+    d->mergeSource(WordCandidate::SourcePrediction, PREDICTION_WEIGHT, predictions);
 
-    if (not changed_candidate.isEmpty() && d->is_preedit_capitalized) {
-        changed_candidate[0] = changed_candidate.at(0).toUpper();
-    }
+    QVector<ScoredCandidate> &merged(d->merge_scratch);
+    const auto better = [](const ScoredCandidate &lhs, const ScoredCandidate &rhs) {
+        return lhs.score > rhs.score
+                || (lhs.score == rhs.score && lhs.order < rhs.order);
+    };
 
-    WordCandidate word_candidate(source, changed_candidate);
+    // Bounded top-k selection, O(n log k).
+    const int count = qMin(merged.size(), MAX_CANDIDATES);
+    std::partial_sort(merged.begin(), merged.begin() + count, merged.end(), better);
 
-    if (not candidates->contains(word_candidate)) {
-        candidates->append(word_candidate);
+    for (int index = 0; index < count; ++index) {
+        const ScoredCandidate &entry(merged.at(index));
+        candidates->append(WordCandidate(entry.source, entry.word, entry.score));
     }
 }
 
@@ -235,127 +434,164 @@ void WordEngine::onWordCandidateSelected(QString word)
 
 void WordEngine::updateQmlCandidates(QStringList qmlCandidates)
 {
-    WordCandidateList candidates;
-    Q_FOREACH(const QString &qmlCandidate, qmlCandidates) {
-        appendToCandidates(&candidates, WordCandidate::SourcePrediction, qmlCandidate);
-    }
-    Q_EMIT candidatesChanged(candidates);
+    Q_D(WordEngine);
+
+    d->candidates = d->nextCandidateBuffer();
+    appendRankedCandidates(d->candidates, QStringList(), qmlCandidates);
+    Q_EMIT candidatesChanged(*d->candidates);
 }
 
 void WordEngine::fetchCandidates(Model::Text *text)
 {
     Q_D(WordEngine);
 
-    d->calculated_primary_candidate = false;
+    d->currentText = text;
 
-    // Allow the current candidates to remain on the word ribbon until
-    // a new set have been calculated.
-    d->clear_candidates_on_incoming = true;
+    // Only the latest text matters, it is read again once the switch is done.
+    if (d->language_state != WordEnginePrivate::LanguageReady) {
+        d->fetch_queued = true;
+        return;
+    }
 
-    d->currentText = text;
+    // The current candidates remain on the word ribbon until the
+    // results for this generation have been merged.
+    d->pending.reset();
 
     const QString &preedit(text->preedit());
     d->is_preedit_capitalized = not preedit.isEmpty() && preedit.at(0).isUpper();
 
-    Q_EMIT candidatesChanged(*d->candidates);
-
     Q_EMIT primaryCandidateChanged(QString());
 
     if (d->use_predictive_text) {
-        d->languagePlugin->predict(text->surroundingLeft(), preedit);
+        d->pending.expected |= PendingResults::Predictions;
+        const QStringList context = text->contextWords(languageFeature()->characterClasses());
+        d->languagePlugin->predict(generation(), context, preedit);
     }
 
     if (d->use_spell_checker) {
-        d->languagePlugin->spellCheckerSuggest(preedit, 5);
+        d->pending.expected |= PendingResults::Corrections;
+        d->languagePlugin->spellCheckerSuggest(generation(), preedit, 5);
+    }
+
+    if (d->pending.expected) {
+        d->merge_timer.start(d->merge_deadline);
     }
 }
 
-void WordEngine::newSpellingSuggestions(QString word, QStringList suggestions, int strategy)
+//! \brief Asks the language plugin for the words most likely to follow
+//! the committed text.
+//!
+//! Only predictions are requested, with an empty preedit, and they are
+//! published without a user candidate, see publishCandidates(). They are
+//! capitalized like a capitalized preedit if the editor asks for it.
+void WordEngine::fetchNextWordCandidates(Model::Text *text, bool capitalize)
 {
     Q_D(WordEngine);
 
-    if (d->currentText && word != d->currentText->preedit()) {
-        // Don't add suggestions coming in for a previous word
+    d->currentText = text;
+
+    // Stale next-word candidates are worse than none; skip during a switch.
+    if (not d->use_predictive_text
+        || d->language_state != WordEnginePrivate::LanguageReady
+        || not d->languagePlugin->languageFeature()->nextWordPrediction()) {
         return;
     }
 
-    // Spelling and prediction suggestions arrive asynchronously
-    // So we need to ensure only one primary candidate is selected
-    suggestionMutex.lock();
+    d->is_preedit_capitalized = capitalize;
 
-    if (d->clear_candidates_on_incoming) {
-        clearCandidates();
-        d->clear_candidates_on_incoming = false;
-    } else if (strategy == UpdateCandidateListStrategy::AlwaysClear) {
-        clearCandidates();
-    }
+    d->pending.reset();
+    d->pending.next_word = true;
+    d->pending.expected |= PendingResults::Predictions;
+    const QStringList context = text->contextWords(languageFeature()->characterClasses());
+    d->languagePlugin->predict(generation(), context, QString());
+    d->merge_timer.start(d->merge_deadline);
+}
 
-    Q_FOREACH(const QString &correction, suggestions) {
-        appendToCandidates(d->candidates, WordCandidate::SourceSpellChecking, correction);
-    }
+void WordEngine::newSpellingSuggestions(quint64 generation, QString word, QStringList suggestions, int strategy)
+{
+    Q_D(WordEngine);
+    Q_UNUSED(word)
+    // Every publish rebuilds the list, whatever the strategy.
+    Q_UNUSED(strategy)
 
-    calculatePrimaryCandidate();
+    if (generation != this->generation()) {
+        // Don't add suggestions coming in for a previous keystroke
+        return;
+    }
 
-    Q_EMIT candidatesChanged(*d->candidates);
+    d->pending.corrections = suggestions;
+    d->pending.received |= PendingResults::Corrections;
 
-    suggestionMutex.unlock();
+    mergeCandidates();
 }
 
-void WordEngine::newPredictionSuggestions(QString word, QStringList suggestions, int strategy)
+void WordEngine::newPredictionSuggestions(quint64 generation, QString word, QStringList suggestions, int strategy)
 {
     Q_D(WordEngine);
+    Q_UNUSED(word)
+    Q_UNUSED(strategy)
 
-    if (d->currentText && word != d->currentText->preedit()) {
-        // Don't add suggestions coming in for a previous word
+    if (generation != this->generation()) {
+        // Don't add suggestions coming in for a previous keystroke
         return;
     }
 
-    // Spelling and prediction suggestions arrive asynchronously
-    // So we need to ensure only one primary candidate is selected
-    suggestionMutex.lock();
+    d->pending.predictions = suggestions;
+    d->pending.received |= PendingResults::Predictions;
 
-    if (d->clear_candidates_on_incoming) {
-        clearCandidates();
-        d->clear_candidates_on_incoming = false;
-    } else if (strategy == UpdateCandidateListStrategy::AlwaysClear) {
-        clearCandidates();
-    }
+    mergeCandidates();
+}
 
-    Q_FOREACH(const QString &correction, suggestions) {
-        appendToCandidates(d->candidates, WordCandidate::SourcePrediction, correction);
-    }
+//! \brief Publishes the pending results once every expected source has
+//! reported for the current generation.
+//!
+//! If a source is slower than the merge deadline, whatever has arrived is
+//! published when the deadline expires and the late source is merged in
+//! when it arrives.
+void WordEngine::mergeCandidates()
+{
+    Q_D(WordEngine);
 
-    if (strategy == UpdateCandidateListStrategy::AlwaysClear) {
-        forceCalculatePrimaryCandidate();
-    } else {
-        calculatePrimaryCandidate();
+    if (d->merge_timer.isActive()
+        && (d->pending.received & d->pending.expected) != d->pending.expected) {
+        return;
     }
 
-    Q_EMIT candidatesChanged(*d->candidates);
-
-    suggestionMutex.unlock();
+    publishCandidates();
 }
 
-void WordEngine::calculatePrimaryCandidate()
+void WordEngine::publishCandidates()
 {
     Q_D(WordEngine);
 
-    if (d->calculated_primary_candidate) {
-        // We don't want to evaluate the primary candidate twice per
-        // word if we're getting both predictions and spellchecking
-        // suggestions
+    d->merge_timer.stop();
+
+    if (not d->pending.received) {
+        // Nothing arrived before the deadline; keep the current candidates.
         return;
     }
 
-    return calculatePrimaryCandidateImpl();
-}
+    if (d->pending.next_word) {
+        // Nothing has been typed yet: there is no user input to offer, and
+        // no candidate may become primary and replace it on space.
+        d->candidates = d->nextCandidateBuffer();
+        appendRankedCandidates(d->candidates, QStringList(), d->pending.predictions);
+        Q_EMIT candidatesChanged(*d->candidates);
+        return;
+    }
 
-void WordEngine::forceCalculatePrimaryCandidate()
-{
-    return calculatePrimaryCandidateImpl();
+    resetCandidates();
+
+    appendRankedCandidates(d->candidates, d->pending.corrections, d->pending.predictions);
+
+    // A late source publishes a rebuilt, possibly re-ranked list, so its
+    // primary candidate is chosen again and reported to the editor.
+    calculatePrimaryCandidate();
+
+    Q_EMIT candidatesChanged(*d->candidates);
 }
 
-void WordEngine::calculatePrimaryCandidateImpl()
+void WordEngine::calculatePrimaryCandidate()
 {
     Q_D(WordEngine);
 
@@ -387,14 +623,19 @@ void WordEngine::calculatePrimaryCandidateImpl()
         primary.setPrimary(true);
         d->candidates->replace(0, primary);
         Q_EMIT primaryCandidateChanged(primary.word());
-    } else if (d->currentText && d->currentText->restoredPreedit()) {
+    } else if (d->pending.restored_preedit
+               || (d->currentText && d->currentText->restoredPreedit())) {
         // The pre-edit has just been restored by the user pressing backspace after
-        // auto-completing a word, so the user input should be the primary candidate
+        // auto-completing a word, so the user input should be the primary candidate,
+        // also in the list a late source publishes for the same keystroke
         WordCandidate primary = d->candidates->value(0);
         primary.setPrimary(true);
         d->candidates->replace(0, primary);
         Q_EMIT primaryCandidateChanged(primary.word());
-        d->currentText->setRestoredPreedit(false);
+        d->pending.restored_preedit = true;
+        if (d->currentText) {
+            d->currentText->setRestoredPreedit(false);
+        }
     } else if (!d->languagePlugin->languageFeature()->ignoreSimilarity()
                && !similarWords(d->candidates->at(0).word(), d->candidates->at(primaryIndex).word())) {
         // The prediction is too different to the user input, so the user input
@@ -410,30 +651,74 @@ void WordEngine::calculatePrimaryCandidateImpl()
         d->candidates->replace(primaryIndex, primary);
         Q_EMIT primaryCandidateChanged(primary.word());
     }
-
-    if (d->candidates->size() > 1) {
-        d->calculated_primary_candidate = true;
-    }
-
 }
 
 void WordEngine::addToUserDictionary(const QString &word)
 {
     Q_D(WordEngine);
+
+    // The word belongs to the dictionary of the language being switched to.
+    if (d->language_state == WordEnginePrivate::LoadingPlugin) {
+        d->queued_user_words.append(word);
+        return;
+    }
+
     d->languagePlugin->addToSpellCheckerUserWordList(word);
 }
 
+//! \brief Switches to the language plugin at \a pluginPath and its
+//! language \a languageId.
+//!
+//! Never blocks: the plugin is loaded in the background if it is not
+//! resident, and then loads its language on its own worker thread. The
+//! current plugin stays in use until the new one is loaded. Candidate
+//! requests arriving meanwhile are held back and replayed, for the latest
+//! text only, when languageReady() is emitted. A newer switch supersedes a
+//! pending one, and a switch still pending after languageTimeout() is ended
+//! by onLanguageTimeout().
 void WordEngine::onLanguageChanged(const QString &pluginPath, const QString &languageId)
 {
     Q_D(WordEngine);
 
-    d->loadPlugin(pluginPath);
+    // Results of the previous language are of no use any more.
+    clearCandidates();
 
-    setWordPredictionEnabled(d->requested_prediction_state);
+    d->requested_plugin = WordEnginePrivate::resolvePluginPath(pluginPath);
+    d->requested_language = languageId;
+    d->language_state = WordEnginePrivate::LoadingPlugin;
+    d->language_timeout.start();
+
+    if (d->plugin_pool.load(d->requested_plugin)) {
+        onPluginLoaded(d->requested_plugin);
+    }
+}
 
-    d->languagePlugin->setLanguage(languageId, QFileInfo(d->currentPlugin).absolutePath());
+void WordEngine::onPluginLoaded(const QString &pluginPath)
+{
+    Q_D(WordEngine);
 
-    Q_EMIT enabledChanged(isEnabled());
+    if (d->language_state != WordEnginePrivate::LoadingPlugin
+        || pluginPath != d->requested_plugin) {
+        return;
+    }
+
+    // The previous plugin stays resident in the pool; it must not keep
+    // delivering results to the engine.
+    if (d->languagePlugin) {
+        disconnect(static_cast<AbstractLanguagePlugin *>(d->languagePlugin), nullptr, this, nullptr);
+    }
+
+    if (pluginPath != d->currentPlugin)
+        qDebug() << "wordengine.cpp plugin" << pluginPath << "loaded";
+
+    // to avoid hickups in libpresage, libpinyin
+    QLocale::setDefault(QLocale::c());
+    setlocale(LC_NUMERIC, "C");
+
+    d->plugin_pool.activate(pluginPath);
+    d->languagePlugin = d->plugin_pool.plugin(pluginPath);
+    d->currentPlugin = pluginPath;
+    d->language_state = WordEnginePrivate::LoadingLanguage;
 
     connect(static_cast<AbstractLanguagePlugin *>(d->languagePlugin), &AbstractLanguagePlugin::newSpellingSuggestions,
             this, &WordEngine::newSpellingSuggestions);
@@ -442,51 +727,127 @@ void WordEngine::onLanguageChanged(const QString &pluginPath, const QString &lan
     connect(static_cast<AbstractLanguagePlugin *>(d->languagePlugin), &AbstractLanguagePlugin::commitTextRequested,
             this, &WordEngine::commitTextRequested);
 
+    setWordPredictionEnabled(d->requested_prediction_state);
+
+    Q_EMIT enabledChanged(isEnabled());
     Q_EMIT pluginChanged();
+
+    // Requests sent from now on are queued behind the language on the
+    // plugin's worker, so they may be sent before it is loaded.
+    for (const QString &word : qAsConst(d->queued_user_words)) {
+        d->languagePlugin->addToSpellCheckerUserWordList(word);
+    }
+    d->queued_user_words.clear();
+
+    if (d->plugin_pool.setLanguage(pluginPath, d->requested_language)) {
+        finishLanguageSwitch();
+    } else {
+        d->language_timeout.start();
+    }
 }
 
-AbstractLanguageFeatures* WordEngine::languageFeature()
+void WordEngine::onPluginFailed(const QString &pluginPath, const QString &errorString)
 {
     Q_D(WordEngine);
-    return d->languagePlugin->languageFeature();
+
+    if (d->language_state != WordEnginePrivate::LoadingPlugin
+        || pluginPath != d->requested_plugin) {
+        return;
+    }
+
+    qCritical() << __PRETTY_FUNCTION__ << " Loading plugin failed: " << errorString;
+
+    // fallback
+    const QString defaultPlugin = WordEnginePrivate::resolvePluginPath(DEFAULT_PLUGIN);
+    if (pluginPath != defaultPlugin) {
+        onLanguageChanged(DEFAULT_PLUGIN, d->requested_language);
+    } else {
+        d->requested_plugin = d->currentPlugin;
+        d->language_state = WordEnginePrivate::LoadingLanguage;
+        finishLanguageSwitch();
+    }
 }
 
-bool WordEngine::similarWords(QString word1, QString word2) {
-    // Calculate the Levenshtein distance between the first word and the
-    // beginning of the second word. If the distance is too great then word2
-    // is not considered to be a suitable prediction for word1.
-    word2 = word2.left(word1.size());
-    if (word1 == word2) {
-        return true;
+//! Ends a switch that takes too long. A plugin that is not loaded in time
+//! is given up on as if it had failed; a language that is not reported as
+//! loaded in time is used anyway.
+void WordEngine::onLanguageTimeout()
+{
+    Q_D(WordEngine);
+
+    if (d->language_state == WordEnginePrivate::LoadingPlugin) {
+        onPluginFailed(d->requested_plugin, QStringLiteral("Timed out"));
+    } else {
+        finishLanguageSwitch();
     }
+}
 
-    int *v0 = (int *) malloc(sizeof(int) * word1.size() + 1);
-    int *v1 = (int *) malloc(sizeof(int) * word1.size() + 1);
+void WordEngine::onPluginLanguageReady(const QString &pluginPath, const QString &languageId)
+{
+    Q_D(WordEngine);
 
-    for (int i = 0; i < word2.size() + 1; i++) {
-        v0[i] = i;
-        v1[i] = 0;
+    if (d->language_state == WordEnginePrivate::LoadingLanguage
+        && pluginPath == d->currentPlugin
+        && languageId == d->requested_language) {
+        finishLanguageSwitch();
     }
+}
 
-    for (int i = 0; i < word1.size(); i++) {
-        v1[0] = i + 1;
+void WordEngine::finishLanguageSwitch()
+{
+    Q_D(WordEngine);
 
-        for (int j = 0; j < word2.size(); j++) {
-            int cost = (word1[i] == word2[i]) ? 0 : 1;
-            v1[j + 1] = std::min(v1[j] + 1, v0[j + 1] + 1);
-            v1[j + 1] = std::min(v1[j] + 1, v0[j] + cost);
-        }
+    if (d->language_state != WordEnginePrivate::LoadingLanguage) {
+        return;
+    }
 
-        for (int j = 0; j < word1.size() + 1; j++) {
-            v0[j] = v1[j];
-        }
+    if (d->language_timeout.isActive()) {
+        d->language_timeout.stop();
+    } else if (not d->plugin_pool.isLanguageReady(d->currentPlugin, d->requested_language)) {
+        qWarning() << __PRETTY_FUNCTION__ << "Language" << d->requested_language
+                   << "not reported as loaded, continuing anyway";
     }
 
-    double threshold = std::max(word1.size() / 3.0, 3.0);
-    int distance = v1[word2.size()];
+    d->language_state = WordEnginePrivate::LanguageReady;
+
+    if (d->fetch_queued) {
+        d->fetch_queued = false;
+        computeCandidates(d->currentText);
+    }
+
+    Q_EMIT languageReady(d->requested_language);
+}
+
+//! Returns false while a language switch is in progress.
+bool WordEngine::isLanguageReady() const
+{
+    Q_D(const WordEngine);
+    return d->language_state == WordEnginePrivate::LanguageReady;
+}
+
+//! Keeps the given plugins resident and warms them up in the background,
+//! so that switching to their languages does not load anything.
+void WordEngine::setEnabledLanguagePlugins(const QStringList &pluginPaths)
+{
+    Q_D(WordEngine);
+    d->plugin_pool.setEnabledPlugins(pluginPaths);
+}
+
+AbstractLanguageFeatures* WordEngine::languageFeature()
+{
+    Q_D(WordEngine);
+    return d->languagePlugin->languageFeature();
+}
+
+bool WordEngine::similarWords(const QString &word1, const QString &word2) {
+    // Calculate the Levenshtein distance between the first word and the
+    // beginning of the second word. If the distance is too great then word2
+    // is not considered to be a suitable prediction for word1.
+    const EditDistance editDistance(word1);
+    const int distance = editDistance.distance(word2.constData(),
+                                               qMin(word1.size(), word2.size()));
 
-    free(v0);
-    free(v1);
+    double threshold = std::max(word1.size() / 3.0, 3.0);
 
     return distance <= threshold;
 }
@@ -494,14 +855,54 @@ bool WordEngine::similarWords(QString word1, QString word2) {
 void WordEngine::clearCandidates()
 {
     Q_D(WordEngine);
-    if(isEnabled()) {
-        d->candidates = new WordCandidateList();
-        if (d->currentText) {
-            WordCandidate userCandidate(WordCandidate::SourceUser, d->currentText->preedit());
-            d->candidates->append(userCandidate);
-        }
+
+    invalidateRequests();
+    d->merge_timer.stop();
+    d->pending.reset();
+
+    if (isEnabled()) {
+        resetCandidates();
         Q_EMIT candidatesChanged(*d->candidates);
     }
 }
 
+void WordEngine::resetCandidates()
+{
+    Q_D(WordEngine);
+
+    d->candidates = d->nextCandidateBuffer();
+    if (d->currentText) {
+        WordCandidate userCandidate(WordCandidate::SourceUser, d->currentText->preedit());
+        d->candidates->append(userCandidate);
+    }
+}
+
+//! \brief Sets how long, in milliseconds, the results of one keystroke are
+//! collected before the candidates are published without the slower source.
+void WordEngine::setMergeDeadline(int msecs)
+{
+    Q_D(WordEngine);
+    d->merge_deadline = msecs;
+}
+
+int WordEngine::mergeDeadline() const
+{
+    Q_D(const WordEngine);
+    return d->merge_deadline;
+}
+
+//! Sets how long a language switch may take before it is ended anyway, see
+//! onLanguageChanged().
+void WordEngine::setLanguageTimeout(int msecs)
+{
+    Q_D(WordEngine);
+    d->language_timeout.setInterval(msecs);
+}
+
+int WordEngine::languageTimeout() const
+{
+    Q_D(const WordEngine);
+    return d->language_timeout.interval();
+}
+
 }} // namespace Logic, MaliitKeyboard
@@ -38,7 +38,6 @@
 #include "languageplugininterface.h"
 
 #include <QtCore>
-#include <QMutex>
 
 namespace MaliitKeyboard {
 namespace Logic {
@@ -58,6 +57,7 @@ public:
 
     //! \reimp
     bool isEnabled() const override;
+    bool isLanguageReady() const override;
     void setWordPredictionEnabled(bool enabled) override;
 
     void addToUserDictionary(const QString &word) override;
@@ -66,36 +66,48 @@ public:
     void clearCandidates() override;
     //! \reimp_end
 
-    void appendToCandidates(WordCandidateList *candidates,
-                                        WordCandidate::Source source,
-                                        const QString &candidate);
+    void appendRankedCandidates(WordCandidateList *candidates,
+                                const QStringList &corrections,
+                                const QStringList &predictions);
 
     Q_SLOT void onWordCandidateSelected(QString word) override;
     Q_SLOT void onLanguageChanged(const QString& pluginPath, const QString& languageId) override;
+    Q_SLOT void setEnabledLanguagePlugins(const QStringList &pluginPaths) override;
 
     Q_SLOT void updateQmlCandidates(QStringList qmlCandidates) override;
-    Q_SLOT void newSpellingSuggestions(QString word, QStringList suggestions,
+    Q_SLOT void newSpellingSuggestions(quint64 generation, QString word, QStringList suggestions,
                                        int strategy = UpdateCandidateListStrategy::ClearWhenNeeded);
-    Q_SLOT void newPredictionSuggestions(QString word, QStringList suggestions,
+    Q_SLOT void newPredictionSuggestions(quint64 generation, QString word, QStringList suggestions,
                                          int strategy = UpdateCandidateListStrategy::ClearWhenNeeded);
 
     AbstractLanguageFeatures* languageFeature() override;
 
+    void setMergeDeadline(int msecs);
+    int mergeDeadline() const;
+
+    void setLanguageTimeout(int msecs);
+    int languageTimeout() const;
+
 private:
     //! \reimp
     void fetchCandidates(Model::Text *text) override;
+    void fetchNextWordCandidates(Model::Text *text, bool capitalize) override;
     //! \reimp_end
 
-    //! Calculate the primary candidate if there is not any.
+    //! Replace the candidates with the user input, keeping the generation.
+    void resetCandidates();
+    Q_SLOT void onPluginLoaded(const QString &pluginPath);
+    Q_SLOT void onPluginFailed(const QString &pluginPath, const QString &errorString);
+    Q_SLOT void onPluginLanguageReady(const QString &pluginPath, const QString &languageId);
+    Q_SLOT void onLanguageTimeout();
+    Q_SLOT void finishLanguageSwitch();
+    void mergeCandidates();
+    Q_SLOT void publishCandidates();
+    //! Marks the primary candidate of the list being published.
     void calculatePrimaryCandidate();
-    //! Calculate the primary candidate unconditionally.
-    void forceCalculatePrimaryCandidate();
-    void calculatePrimaryCandidateImpl();
-    bool similarWords(QString word1, QString word2);
+    bool similarWords(const QString &word1, const QString &word2);
 
     const QScopedPointer<WordEnginePrivate> d_ptr;
-
-    QMutex suggestionMutex;
 };
 
 }} // namespace Logic, MaliitKeyboard
@@ -30,6 +30,7 @@
  */
 
 #include "text.h"
+#include "logic/characterclasstable.h"
 
 //! \class Text
 //! \brief Represents the text state of the editor
@@ -40,6 +41,21 @@
 namespace MaliitKeyboard {
 namespace Model {
 
+namespace {
+
+// Bounds the backward scan for context words, so that a long run of
+// characters without a word break does not make it depend on the document.
+const int MaxContextScan = 256;
+
+using MaliitKeyboard::Logic::CharacterClassTable;
+
+bool isWordPart(QChar c)
+{
+    return CharacterClassTable::isWordCharacter(c) || CharacterClassTable::isWordJoiner(c);
+}
+
+} // unnamed namespace
+
 //! C'tor
 Text::Text()
     : m_preedit()
@@ -48,6 +64,12 @@ Text::Text()
     , m_face(PreeditDefault)
     , m_cursor_position(0)
     , m_restored_preedit(false)
+    , m_context_words()
+    , m_context_valid(false)
+    , m_context_classes()
+    , m_token_start(0)
+    , m_token_at_signs(0)
+    , m_token_valid(false)
 {}
 
 //! Returns current preedit.
@@ -73,12 +95,29 @@ void Text::setPreedit(const QString &preedit,
 
     m_preedit = preedit;
     m_cursor_position = cursor_pos_override;
+    m_token_valid = false;
 }
 
 //! Append to preedit.
 //! \param appendix the string to append to current preedit.
 void Text::appendToPreedit(const QString &appendix)
 {
+    if (m_token_valid && m_cursor_position == m_preedit.length()) {
+        // Typing at the end only moves the token forward.
+        int position = lengthBeforeCursor();
+        for (const QChar &c : appendix) {
+            ++position;
+            if (c.isSpace()) {
+                m_token_start = position;
+                m_token_at_signs = 0;
+            } else if (c == QLatin1Char('@')) {
+                ++m_token_at_signs;
+            }
+        }
+    } else {
+        m_token_valid = false;
+    }
+
     m_preedit.insert(m_cursor_position, appendix);
     m_cursor_position += appendix.length();
 }
@@ -96,6 +135,14 @@ bool Text::removeFromPreedit(int length)
     if (preedit().length() < length || m_cursor_position < length)
         return false;
 
+    if (m_token_valid && m_cursor_position == m_preedit.length()
+        && lengthBeforeCursor() - length >= m_token_start) {
+        // Deleting within the current token only drops its '@'.
+        m_token_at_signs -= m_preedit.rightRef(length).count(QLatin1Char('@'));
+    } else {
+        m_token_valid = false;
+    }
+
     m_preedit.remove(m_cursor_position-length, length);
     m_cursor_position -= length;
     return true;
@@ -109,8 +156,15 @@ void Text::commitPreedit()
     // we would expect the text editor to just update the surrounding text.
     // Raises the question whether we should have commitPreedit here at all,
     // but it does preserve some consistency at least.
+    // The text before the cursor, and so its token, only stays the same if
+    // the cursor was at the end of the surrounding text.
+    if (m_surrounding_offset != uint(m_surrounding.length())) {
+        m_token_valid = false;
+    }
+
     m_surrounding += m_preedit;
     m_surrounding_offset += m_preedit.length();
+    m_context_valid = false;
     m_preedit.clear();
     m_primary_candidate.clear();
     m_face = PreeditDefault;
@@ -148,11 +202,217 @@ QString Text::surroundingRight() const
     return m_surrounding.mid(m_surrounding_offset);
 }
 
+//! Returns up to MaxContextWords words left of cursor position, oldest
+//! first, for word prediction. The words never reach back across a
+//! sentence break of \a classes, the table of the current language,
+//! matching how language models split their corpus.
+//!
+//! The window is only rebuilt after the surrounding text, its offset,
+//! a commit or the language changed it, and then only scans back from the
+//! cursor until it is full, so typing costs nothing and the cost never
+//! depends on the length of the document.
+QStringList Text::contextWords(const Logic::CharacterClassTable &classes) const
+{
+    if (m_context_valid && m_context_classes == classes) {
+        return m_context_words;
+    }
+
+    m_context_words.clear();
+    m_context_valid = true;
+    m_context_classes = classes;
+
+    int end = qMin<int>(m_surrounding_offset, m_surrounding.length());
+    const int scan_begin = qMax(0, end - MaxContextScan);
+
+    while (m_context_words.size() < MaxContextWords && end > scan_begin) {
+        while (end > scan_begin && not CharacterClassTable::isWordCharacter(m_surrounding.at(end - 1))) {
+            if (classes.isSentenceBreak(m_surrounding.at(end - 1))) {
+                return m_context_words;
+            }
+            --end;
+        }
+
+        int begin = end;
+        while (begin > scan_begin && isWordPart(m_surrounding.at(begin - 1))) {
+            --begin;
+        }
+
+        // A word cut off by the scan limit is not a word of its own.
+        if (begin == end
+            || (begin == scan_begin && begin > 0 && isWordPart(m_surrounding.at(begin - 1)))) {
+            break;
+        }
+
+        while (CharacterClassTable::isWordJoiner(m_surrounding.at(begin))) {
+            ++begin;
+        }
+
+        m_context_words.prepend(m_surrounding.mid(begin, end - begin));
+        end = begin;
+    }
+
+    return m_context_words;
+}
+
+//! Returns the length of the text before the cursor, that is of
+//! surroundingLeft() followed by preedit().
+int Text::lengthBeforeCursor() const
+{
+    return qMin<int>(m_surrounding_offset, m_surrounding.length()) + m_preedit.length();
+}
+
+//! Returns the character at index of the text before the cursor, without
+//! building that text.
+QChar Text::characterAt(int index) const
+{
+    const int left = qMin<int>(m_surrounding_offset, m_surrounding.length());
+    return index < left ? m_surrounding.at(index) : m_preedit.at(index - left);
+}
+
+//! Finds the current token by scanning back to the previous whitespace.
+//! Only needed after the text was replaced; typing and deleting at the end
+//! of the preedit keep the token up to date.
+void Text::updateToken() const
+{
+    if (m_token_valid) {
+        return;
+    }
+
+    m_token_start = lengthBeforeCursor();
+    m_token_at_signs = 0;
+
+    while (m_token_start > 0 && not characterAt(m_token_start - 1).isSpace()) {
+        --m_token_start;
+        if (characterAt(m_token_start) == QLatin1Char('@')) {
+            ++m_token_at_signs;
+        }
+    }
+
+    m_token_valid = true;
+}
+
+//! Returns the last \a length characters of surroundingLeft() followed by
+//! preedit(), or all of them if there are fewer. Costs O(length), whatever
+//! the length of the document.
+QString Text::textBeforeCursor(int length) const
+{
+    const int end = lengthBeforeCursor();
+    const int begin = qMax(0, end - length);
+    const int left = end - m_preedit.length();
+
+    if (begin >= left) {
+        return m_preedit.mid(begin - left);
+    }
+
+    return m_surrounding.mid(begin, left - begin) + m_preedit;
+}
+
+//! Returns the character \a distance positions before the cursor, counting
+//! the preedit, or a null character at the start of the text.
+QChar Text::characterBeforeCursor(int distance) const
+{
+    const int index = lengthBeforeCursor() - distance;
+    return (distance > 0 && index >= 0) ? characterAt(index) : QChar();
+}
+
+//! Returns the character right of the cursor in the surrounding text, or
+//! a null character at the end of the text.
+QChar Text::characterAfterCursor() const
+{
+    return m_surrounding_offset < uint(m_surrounding.length())
+            ? m_surrounding.at(m_surrounding_offset) : QChar();
+}
+
+//! Returns the number of whitespace characters right before the cursor.
+int Text::whitespaceBeforeCursor() const
+{
+    const int end = lengthBeforeCursor();
+    int begin = end;
+    while (begin > 0 && characterAt(begin - 1).isSpace()) {
+        --begin;
+    }
+    return end - begin;
+}
+
+//! Returns the token the cursor is in: the text before the cursor back to
+//! the previous whitespace, which is empty right after whitespace.
+QString Text::currentToken() const
+{
+    updateToken();
+    return textBeforeCursor(lengthBeforeCursor() - m_token_start);
+}
+
+//! Returns the token before the whitespace that precedes the current token.
+QString Text::previousToken() const
+{
+    updateToken();
+
+    int end = m_token_start;
+    while (end > 0 && characterAt(end - 1).isSpace()) {
+        --end;
+    }
+
+    int begin = end;
+    while (begin > 0 && not characterAt(begin - 1).isSpace()) {
+        --begin;
+    }
+
+    QString token;
+    token.reserve(end - begin);
+    for (int index = begin; index < end; ++index) {
+        token.append(characterAt(index));
+    }
+    return token;
+}
+
+//! Returns whether the current token contains an '@', as e-mail addresses
+//! do. Answered from the cached token, in constant time while typing.
+bool Text::currentTokenHasAtSign() const
+{
+    updateToken();
+    return m_token_at_signs > 0;
+}
+
+//! Returns whether nothing precedes the cursor on its line.
+bool Text::atLineStart() const
+{
+    const QChar previous = characterBeforeCursor();
+    return previous.isNull() || previous == QLatin1Char('\n');
+}
+
+//! Returns whether the rest of the line right of the cursor is whitespace.
+bool Text::restOfLineBlank() const
+{
+    for (int index = m_surrounding_offset; index < m_surrounding.length(); ++index) {
+        const QChar c = m_surrounding.at(index);
+        if (c == QLatin1Char('\n')) {
+            return true;
+        }
+        if (not c.isSpace()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! Returns whether all the text right of the cursor is whitespace.
+bool Text::restOfTextBlank() const
+{
+    for (int index = m_surrounding_offset; index < m_surrounding.length(); ++index) {
+        if (not m_surrounding.at(index).isSpace()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 //! Set text surrounding cursor position.
 //! \param surrounding the updated surrounding text.
 void Text::setSurrounding(const QString &surrounding)
 {
     m_surrounding = surrounding;
+    m_context_valid = false;
+    m_token_valid = false;
 }
 
 //! Returns offset of cursor position in surrounding text.
@@ -166,7 +426,11 @@ uint Text::surroundingOffset() const
 //! \param offset the updated offset.
 void Text::setSurroundingOffset(uint offset)
 {
-    m_surrounding_offset = offset;
+    if (offset != m_surrounding_offset) {
+        m_surrounding_offset = offset;
+        m_context_valid = false;
+        m_token_valid = false;
+    }
 }
 
 //! Returns face of preedit.
@@ -32,6 +32,8 @@
 #ifndef MALIIT_KEYBOARD_TEXT_H
 #define MALIIT_KEYBOARD_TEXT_H
 
+#include "logic/characterclasstable.h"
+
 #include <QtCore>
 
 namespace MaliitKeyboard {
@@ -48,6 +50,9 @@ public:
         PreeditActive         //!< Preedit region with active suggestions.
     };
 
+    //! Number of words kept in the context window left of the cursor.
+    static const int MaxContextWords = 4;
+
 private:
     QString m_preedit; //!< current text segment that is edited.
     QString m_surrounding; //!< text to left and right side of cursor position, in current text block.
@@ -56,6 +61,16 @@ private:
     PreeditFace m_face; //!< face of preedit.
     int m_cursor_position; //!< position of cursor in preedit string.
     bool m_restored_preedit; //!< indicates that the preedit has just been restored by the user pressing backspace
+    mutable QStringList m_context_words; //!< words left of cursor position, oldest first.
+    mutable bool m_context_valid; //!< whether m_context_words matches surrounding text and offset.
+    mutable Logic::CharacterClassTable m_context_classes; //!< table m_context_words was split with.
+    mutable int m_token_start; //!< start of the current token in the text before the cursor.
+    mutable int m_token_at_signs; //!< number of '@' in the current token.
+    mutable bool m_token_valid; //!< whether m_token_start and m_token_at_signs are up to date.
+
+    int lengthBeforeCursor() const;
+    QChar characterAt(int index) const;
+    void updateToken() const;
 
 public:
     explicit Text();
@@ -73,6 +88,18 @@ public:
     QString surrounding() const;
     QString surroundingLeft() const;
     QString surroundingRight() const;
+    QStringList contextWords(const Logic::CharacterClassTable &classes) const;
+
+    QString textBeforeCursor(int length) const;
+    QChar characterBeforeCursor(int distance = 1) const;
+    QChar characterAfterCursor() const;
+    int whitespaceBeforeCursor() const;
+    QString currentToken() const;
+    QString previousToken() const;
+    bool currentTokenHasAtSign() const;
+    bool atLineStart() const;
+    bool restOfLineBlank() const;
+    bool restOfTextBlank() const;
     void setSurrounding(const QString &surrounding);
 
     uint surroundingOffset() const;
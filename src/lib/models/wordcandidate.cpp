@@ -34,78 +34,26 @@
 namespace MaliitKeyboard {
 
 WordCandidate::WordCandidate()
-    : m_origin()
-    , m_area()
-    , m_label()
+    : m_word()
+    , m_score(0.0f)
     , m_source(SourceUnknown)
-    , m_word()
     , m_primary(false)
 {}
 
-WordCandidate::WordCandidate(Source source, const QString &word)
-    : m_origin()
-    , m_area()
-    , m_label()
+WordCandidate::WordCandidate(Source source, const QString &word, float score)
+    : m_word(word)
+    , m_score(score)
     , m_source(source)
-    , m_word(word)
     , m_primary(false)
-{
-    if (source == WordCandidate::SourceUser) {
-        m_label = QStringLiteral(QT_TR_NOOP("Add '%1' to user dictionary")).arg(word);
-    } else {
-        m_label = word;
-    }
-}
-
-bool WordCandidate::valid() const
-{
-    return (m_area.size().isValid()
-            && not m_label.isEmpty());
-}
-
-QRect WordCandidate::rect() const
-{
-    return QRect(m_origin, m_area.size());
-}
-
-QPoint WordCandidate::origin() const
-{
-    return m_origin;
-}
-
-void WordCandidate::setOrigin(const QPoint &origin)
-{
-    m_origin = origin;
-}
-
-Area WordCandidate::area() const
-{
-    return m_area;
-}
-
-Area & WordCandidate::rArea()
-{
-    return m_area;
-}
-
-void WordCandidate::setArea(const Area &area)
-{
-    m_area = area;
-}
+{}
 
 QString WordCandidate::label() const
 {
-    return m_label;
-}
-
-QString & WordCandidate::rLabel()
-{
-    return m_label;
-}
+    if (m_source == WordCandidate::SourceUser) {
+        return QStringLiteral(QT_TR_NOOP("Add '%1' to user dictionary")).arg(m_word);
+    }
 
-void WordCandidate::setLabel(const QString &label)
-{
-    m_label = label;
+    return m_word;
 }
 
 WordCandidate::Source WordCandidate::source() const
@@ -128,6 +76,16 @@ void WordCandidate::setWord(const QString &word)
     m_word = word;
 }
 
+float WordCandidate::score() const
+{
+    return m_score;
+}
+
+void WordCandidate::setScore(float score)
+{
+    m_score = score;
+}
+
 bool WordCandidate::primary() const
 {
     return m_primary;
@@ -141,10 +99,8 @@ void WordCandidate::setPrimary(const bool primary)
 bool operator==(const WordCandidate &lhs,
                 const WordCandidate &rhs)
 {
-    return (lhs.origin() == rhs.origin()
-            && lhs.area() == rhs.area()
-            && lhs.label() == rhs.label()
-            && lhs.source() == rhs.source());
+    return (lhs.source() == rhs.source()
+            && lhs.word() == rhs.word());
 }
 
 bool operator!=(const WordCandidate &lhs,
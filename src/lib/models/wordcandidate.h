@@ -32,12 +32,16 @@
 #ifndef MALIIT_KEYBOARD_WORDCANDIDATE_H
 #define MALIIT_KEYBOARD_WORDCANDIDATE_H
 
-#include "models/area.h"
-
 #include <QtCore>
 
 namespace MaliitKeyboard {
 
+//! A single entry of the word ribbon.
+//!
+//! Candidates are published as implicitly shared WordCandidateList snapshots
+//! and copied around a lot, so they only carry what the ribbon and the word
+//! engine need. The label shown for a candidate is derived from its word and
+//! source on demand.
 class WordCandidate
 {
 public:
@@ -49,31 +53,16 @@ public:
     };
 
 private:
-    QPoint m_origin;
-    Area m_area;
-    QString m_label;
-    Source m_source;
     QString m_word;
+    float m_score;
+    Source m_source;
     bool m_primary;
 
 public:
     explicit WordCandidate();
-    WordCandidate(Source source, const QString &word);
-
-    // read-only properties:
-    bool valid() const;
-    QRect rect() const;
-
-    QPoint origin() const;
-    void setOrigin(const QPoint &origin);
-
-    Area area() const;
-    Area & rArea();
-    void setArea(const Area &area);
+    WordCandidate(Source source, const QString &word, float score = 0.0f);
 
     QString label() const;
-    QString & rLabel();
-    void setLabel(const QString &label);
 
     Source source() const;
     void setSource(Source source);
@@ -81,11 +70,14 @@ public:
     QString word() const;
     void setWord(const QString &word);
 
+    float score() const;
+    void setScore(float score);
+
     bool primary() const;
     void setPrimary(const bool primary);
 };
 
-typedef QList<WordCandidate> WordCandidateList;
+typedef QVector<WordCandidate> WordCandidateList;
 
 bool operator==(const WordCandidate &lhs,
                 const WordCandidate &rhs);
@@ -95,4 +87,6 @@ bool operator!=(const WordCandidate &lhs,
 
 } // namespace MaliitKeyboard
 
+Q_DECLARE_TYPEINFO(MaliitKeyboard::WordCandidate, Q_MOVABLE_TYPE);
+
 #endif // MALIIT_KEYBOARD_WORDCANDIDATE_H
@@ -30,6 +30,7 @@
  */
 
 #include "wordribbon.h"
+#include "logic/latencystats.h"
 
 namespace MaliitKeyboard {
 
@@ -179,13 +180,15 @@ void WordRibbon::onWordCandidateReleased(const WordCandidate &candidate)
 
 void WordRibbon::onWordCandidatesChanged(const WordCandidateList &candidates)
 {
-    qDebug() << "word ribbon: candidates changed";
-    clearCandidates();
+    MALIIT_LATENCY_SCOPE(RibbonUpdate);
 
-    for (int index = 0; index < candidates.count(); ++index) {
-        WordCandidate word_candidate(candidates.at(index));
-        appendCandidate(word_candidate);
-    }
+    // Keep a shared snapshot of the list and reset the model once, instead
+    // of copying the candidates one row insertion at a time.
+    beginResetModel();
+    m_candidates = candidates;
+    endResetModel();
+
+    MALIIT_LATENCY_SINCE_KEYSTROKE(KeystrokeToRibbon);
 }
 
 void WordRibbon::setWordRibbonVisible(bool visible)
@@ -0,0 +1,664 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// maliit-lmcompile: turns plain UTF-8 text corpora into the binary n-gram
+// model read by NGramModel (see plugins/westernsupport/ngrammodelformat.h).
+//
+// Tokenizing and counting run in parallel over chunks of the input. All
+// merging is commutative and every table is sorted before it is written,
+// so the output only depends on the input and the options, never on the
+// number of threads or their scheduling.
+
+#include "characterclasstable.h"
+#include "ngrammodelformat.h"
+
+#include <QString>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    std::uint32_t order = 3;
+    std::uint64_t maxSize = 8 * 1024 * 1024;
+    std::uint32_t minCount = 2;
+    unsigned threads = 0;
+    float logProbStep = 0.04f;
+    float backoffPenalty = 1.0f;
+    std::string output;
+    std::vector<std::string> inputs;
+};
+
+void usage()
+{
+    std::cerr << "Usage: maliit-lmcompile [options] -o <model.lm> <corpus.txt>...\n"
+                 "  --order <n>          highest n-gram order, 1-" << NGramFormat::MaxOrder << " (default 3)\n"
+                 "  --max-size <bytes>   size budget, accepts K and M suffixes (default 8M)\n"
+                 "  --min-count <n>      drop n-grams seen fewer times (default 2)\n"
+                 "  --threads <n>        worker threads (default: number of cores)\n"
+                 "  --step <log10>       probability quantization step (default 0.04)\n"
+                 "  --backoff <log10>    penalty per backed off order (default 1.0)\n";
+}
+
+bool parseSize(const std::string &text, std::uint64_t *size)
+{
+    char *end = nullptr;
+    const unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    std::uint64_t factor = 1;
+
+    if (end && (*end == 'K' || *end == 'k')) {
+        factor = 1024;
+        ++end;
+    } else if (end && (*end == 'M' || *end == 'm')) {
+        factor = 1024 * 1024;
+        ++end;
+    }
+
+    if (end == text.c_str() || *end != '\0') {
+        return false;
+    }
+
+    *size = value * factor;
+    return true;
+}
+
+bool parseArguments(int argc, char **argv, Options *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "-o" && hasValue) {
+            options->output = argv[++i];
+        } else if (arg == "--order" && hasValue) {
+            options->order = std::atoi(argv[++i]);
+        } else if (arg == "--max-size" && hasValue) {
+            if (!parseSize(argv[++i], &options->maxSize)) {
+                return false;
+            }
+        } else if (arg == "--min-count" && hasValue) {
+            options->minCount = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            options->threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--step" && hasValue) {
+            options->logProbStep = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--backoff" && hasValue) {
+            options->backoffPenalty = std::strtof(argv[++i], nullptr);
+        } else if (!arg.empty() && arg[0] == '-') {
+            return false;
+        } else {
+            options->inputs.push_back(arg);
+        }
+    }
+
+    return !options->output.empty() && !options->inputs.empty()
+        && options->order >= 1 && options->order <= NGramFormat::MaxOrder
+        && options->logProbStep > 0.0f;
+}
+
+// Tokenizer ----------------------------------------------------------------
+//
+// Must agree with Model::Text::contextWords() and NGramModel: words are
+// split with the classifiers of CharacterClassTable, over UTF-16 code units
+// as in a QString, lowercased with QString::toLower(), and sentences end at
+// the SentenceBreak characters of the plugins that ship a compiled model
+// (WesternLanguageFeatures, KoreanLanguageFeatures).
+
+using MaliitKeyboard::Logic::CharacterClassTable;
+
+bool isSentenceBreak(QChar c)
+{
+    return c == QLatin1Char('.') || c == QLatin1Char('!') || c == QLatin1Char('?')
+        || c == QLatin1Char('\r') || c == QLatin1Char('\n');
+}
+
+//! Calls sentence(words) for every sentence of the UTF-8 text [begin, end),
+//! where words are lowercased UTF-16 strings.
+template <typename Callback>
+void tokenize(const char *begin, const char *end, Callback sentence)
+{
+    const QString text = QString::fromUtf8(begin, int(end - begin));
+    std::vector<std::u16string> words;
+    int wordBegin = 0;
+
+    const auto flushWord = [&](int wordEnd) {
+        // Joiners only glue words together, they never start or end one.
+        while (wordBegin < wordEnd && CharacterClassTable::isWordJoiner(text.at(wordBegin))) {
+            ++wordBegin;
+        }
+        while (wordEnd > wordBegin && CharacterClassTable::isWordJoiner(text.at(wordEnd - 1))) {
+            --wordEnd;
+        }
+        if (wordEnd > wordBegin) {
+            const QString word = text.mid(wordBegin, wordEnd - wordBegin).toLower();
+            words.emplace_back(reinterpret_cast<const char16_t *>(word.utf16()), word.size());
+        }
+    };
+
+    for (int i = 0; i < text.size(); ++i) {
+        const QChar c = text.at(i);
+        if (CharacterClassTable::isWordCharacter(c) || CharacterClassTable::isWordJoiner(c)) {
+            continue;
+        }
+
+        flushWord(i);
+        wordBegin = i + 1;
+
+        if (isSentenceBreak(c) && !words.empty()) {
+            sentence(words);
+            words.clear();
+        }
+    }
+
+    flushWord(text.size());
+    if (!words.empty()) {
+        sentence(words);
+    }
+}
+
+// Counting -----------------------------------------------------------------
+
+template <std::size_t N>
+using Gram = std::array<std::uint32_t, N>;
+
+template <std::size_t N>
+struct GramHash
+{
+    std::size_t operator()(const Gram<N> &gram) const
+    {
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        for (std::uint32_t id : gram) {
+            h = (h ^ id) * 0x100000001b3ull;
+        }
+        return static_cast<std::size_t>(h ^ (h >> 29));
+    }
+};
+
+template <std::size_t N>
+using GramCounts = std::unordered_map<Gram<N>, std::uint64_t, GramHash<N>>;
+
+//! Splits the corpus into one chunk per thread, cutting only after a line
+//! break so that no sentence is split between two chunks.
+std::vector<std::pair<const char *, const char *>> chunks(const std::string &corpus, unsigned count)
+{
+    std::vector<std::pair<const char *, const char *>> result;
+    const char *begin = corpus.data();
+    const char *end = corpus.data() + corpus.size();
+    const std::size_t step = corpus.size() / count + 1;
+
+    while (begin < end) {
+        const char *cut = begin + std::min<std::size_t>(step, end - begin);
+        while (cut < end && *(cut - 1) != '\n') {
+            ++cut;
+        }
+        result.emplace_back(begin, cut);
+        begin = cut;
+    }
+
+    return result;
+}
+
+template <typename Work>
+void parallel(const std::vector<std::pair<const char *, const char *>> &parts, Work work)
+{
+    std::vector<std::thread> threads;
+    threads.reserve(parts.size());
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        threads.emplace_back(work, i, parts[i].first, parts[i].second);
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+struct Counts
+{
+    std::vector<std::u16string> words;      // sorted by UTF-16 code unit
+    std::vector<std::uint64_t> wordCounts;
+    std::uint64_t totalWords = 0;
+    GramCounts<2> bigrams;
+    GramCounts<3> trigrams;
+};
+
+Counts count(const std::string &corpus, const Options &options, unsigned threadCount)
+{
+    const auto parts = chunks(corpus, threadCount);
+    Counts counts;
+
+    // Pass 1: vocabulary.
+    std::vector<std::unordered_map<std::u16string, std::uint64_t>> localWords(parts.size());
+    parallel(parts, [&localWords](std::size_t index, const char *begin, const char *end) {
+        auto &words = localWords[index];
+        tokenize(begin, end, [&words](const std::vector<std::u16string> &sentence) {
+            for (const std::u16string &word : sentence) {
+                ++words[word];
+            }
+        });
+    });
+
+    std::map<std::u16string, std::uint64_t> merged;
+    for (auto &local : localWords) {
+        for (auto &entry : local) {
+            merged[entry.first] += entry.second;
+        }
+        local.clear();
+    }
+
+    for (const auto &entry : merged) {
+        counts.totalWords += entry.second;
+        if (entry.second >= options.minCount) {
+            counts.words.push_back(entry.first);
+            counts.wordCounts.push_back(entry.second);
+        }
+    }
+
+    if (options.order < 2) {
+        return counts;
+    }
+
+    // Pass 2: higher orders, over word ids of the vocabulary above.
+    const auto idOf = [&counts](const std::u16string &word, std::uint32_t *id) {
+        const auto it = std::lower_bound(counts.words.begin(), counts.words.end(), word);
+        if (it == counts.words.end() || *it != word) {
+            return false;
+        }
+        *id = static_cast<std::uint32_t>(it - counts.words.begin());
+        return true;
+    };
+
+    std::vector<GramCounts<2>> localBigrams(parts.size());
+    std::vector<GramCounts<3>> localTrigrams(parts.size());
+    const std::uint32_t order = options.order;
+
+    parallel(parts, [&](std::size_t index, const char *begin, const char *end) {
+        auto &bigrams = localBigrams[index];
+        auto &trigrams = localTrigrams[index];
+        std::vector<std::uint32_t> ids;
+        std::vector<bool> known;
+
+        tokenize(begin, end, [&](const std::vector<std::u16string> &sentence) {
+            ids.resize(sentence.size());
+            known.resize(sentence.size());
+            for (std::size_t i = 0; i < sentence.size(); ++i) {
+                known[i] = idOf(sentence[i], &ids[i]);
+            }
+            for (std::size_t i = 1; i < sentence.size(); ++i) {
+                if (known[i - 1] && known[i]) {
+                    ++bigrams[Gram<2>{{ids[i - 1], ids[i]}}];
+                    if (order > 2 && i > 1 && known[i - 2]) {
+                        ++trigrams[Gram<3>{{ids[i - 2], ids[i - 1], ids[i]}}];
+                    }
+                }
+            }
+        });
+    });
+
+    for (auto &local : localBigrams) {
+        for (const auto &entry : local) {
+            counts.bigrams[entry.first] += entry.second;
+        }
+        local = GramCounts<2>();
+    }
+    for (auto &local : localTrigrams) {
+        for (const auto &entry : local) {
+            counts.trigrams[entry.first] += entry.second;
+        }
+        local = GramCounts<3>();
+    }
+
+    return counts;
+}
+
+// Pruning ------------------------------------------------------------------
+
+//! Number of values in a descending-sorted list that are >= threshold.
+std::uint64_t countAtLeast(const std::vector<std::uint64_t> &sortedDescending, std::uint64_t threshold)
+{
+    return std::upper_bound(sortedDescending.begin(), sortedDescending.end(), threshold,
+                            std::greater_equal<std::uint64_t>()) - sortedDescending.begin();
+}
+
+//! Finds per-order count thresholds so that the model fits in maxSize.
+//!
+//! Thresholds never decrease with the order. Since an n-gram is never seen
+//! more often than its prefix or its last word, this keeps the trie closed:
+//! every kept n-gram has its prefix and its words kept too.
+std::array<std::uint64_t, NGramFormat::MaxOrder> pruneThresholds(const Counts &counts, const Options &options)
+{
+    std::array<std::vector<std::uint64_t>, NGramFormat::MaxOrder> sorted;
+    sorted[0] = counts.wordCounts;
+    for (const auto &entry : counts.bigrams) {
+        sorted[1].push_back(entry.second);
+    }
+    for (const auto &entry : counts.trigrams) {
+        sorted[2].push_back(entry.second);
+    }
+
+    std::uint64_t averageWordBytes = 0;
+    for (const std::u16string &word : counts.words) {
+        averageWordBytes += word.size() * sizeof(char16_t);
+    }
+    averageWordBytes = counts.words.empty() ? 0 : averageWordBytes / counts.words.size();
+
+    for (auto &level : sorted) {
+        std::sort(level.begin(), level.end(), std::greater<std::uint64_t>());
+    }
+
+    // Bytes per kept entry: unigrams carry string, offset, rank, prob,
+    // child offset and successor offset; higher orders carry word id, prob,
+    // child and successor offsets, and at most one successor entry each.
+    const std::uint64_t perEntry[NGramFormat::MaxOrder] = { averageWordBytes + 17, 17, 9 };
+
+    std::array<std::uint64_t, NGramFormat::MaxOrder> thresholds;
+    thresholds.fill(options.minCount);
+
+    const auto bytes = [&](std::uint32_t level) {
+        return countAtLeast(sorted[level], thresholds[level]) * perEntry[level];
+    };
+
+    for (;;) {
+        std::uint64_t total = sizeof(NGramFormat::Header) + 64;
+        std::uint32_t largest = 0;
+        for (std::uint32_t level = 0; level < options.order; ++level) {
+            total += bytes(level);
+            if (bytes(level) >= bytes(largest)) {
+                largest = level;
+            }
+        }
+
+        if (total <= options.maxSize || bytes(largest) == 0) {
+            break;
+        }
+
+        // Raise the threshold of the most expensive order just enough to
+        // drop its least frequent entries.
+        const std::uint64_t kept = countAtLeast(sorted[largest], thresholds[largest]);
+        const std::uint64_t smallest = sorted[largest][kept - 1];
+        thresholds[largest] = smallest + 1;
+
+        for (std::uint32_t level = largest + 1; level < NGramFormat::MaxOrder; ++level) {
+            thresholds[level] = std::max(thresholds[level], thresholds[level - 1]);
+        }
+    }
+
+    return thresholds;
+}
+
+// Writing ------------------------------------------------------------------
+
+std::uint8_t quantize(double probability, float step)
+{
+    const double q = std::round(-std::log10(probability) / step);
+    return static_cast<std::uint8_t>(std::min(255.0, std::max(0.0, q)));
+}
+
+class Writer
+{
+public:
+    std::uint64_t reserve(std::uint64_t bytes)
+    {
+        const std::uint64_t offset = NGramFormat::align(m_data.size());
+        m_data.resize(offset + bytes);
+        return offset;
+    }
+
+    template <typename T>
+    std::uint64_t write(const std::vector<T> &values)
+    {
+        const std::uint64_t offset = reserve(values.size() * sizeof(T));
+        if (!values.empty()) {
+            std::memcpy(&m_data[offset], values.data(), values.size() * sizeof(T));
+        }
+        return offset;
+    }
+
+    std::vector<char> &data() { return m_data; }
+
+private:
+    std::vector<char> m_data;
+};
+
+bool writeModel(const Counts &counts, const Options &options)
+{
+    const auto thresholds = pruneThresholds(counts, options);
+
+    // Final vocabulary and the mapping from counting ids to model ids.
+    // Dropping words keeps the UTF-16 order, so ids stay sorted.
+    std::vector<std::uint32_t> remap(counts.words.size(), UINT32_MAX);
+    std::vector<std::uint32_t> kept;
+    for (std::uint32_t id = 0; id < counts.words.size(); ++id) {
+        if (counts.wordCounts[id] >= thresholds[0]) {
+            remap[id] = static_cast<std::uint32_t>(kept.size());
+            kept.push_back(id);
+        }
+    }
+
+    std::vector<Gram<2>> bigrams;
+    for (const auto &entry : counts.bigrams) {
+        if (options.order > 1 && entry.second >= thresholds[1]) {
+            bigrams.push_back(Gram<2>{{remap[entry.first[0]], remap[entry.first[1]]}});
+        }
+    }
+    std::sort(bigrams.begin(), bigrams.end());
+
+    std::vector<Gram<3>> trigrams;
+    for (const auto &entry : counts.trigrams) {
+        if (options.order > 2 && entry.second >= thresholds[2]) {
+            trigrams.push_back(Gram<3>{{remap[entry.first[0]], remap[entry.first[1]], remap[entry.first[2]]}});
+        }
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+
+    const std::uint32_t vocabulary = static_cast<std::uint32_t>(kept.size());
+    if (vocabulary == 0) {
+        std::cerr << "maliit-lmcompile: corpus is empty after pruning" << std::endl;
+        return false;
+    }
+
+    const auto unmapped = [&kept](std::uint32_t id) { return kept[id]; };
+
+    Writer writer;
+    writer.reserve(sizeof(NGramFormat::Header));
+
+    // Writes the successor table of a level from its child offsets and the
+    // probabilities of the level below it.
+    const auto writeSuccessors = [&writer](NGramFormat::Level *level,
+                                           const std::vector<std::uint32_t> &children,
+                                           const std::vector<std::uint8_t> &childProbs) {
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> successors;
+        std::vector<std::uint32_t> best;
+        offsets.reserve(children.size());
+
+        for (std::size_t node = 0; node + 1 < children.size(); ++node) {
+            offsets.push_back(static_cast<std::uint32_t>(successors.size()));
+
+            best.clear();
+            for (std::uint32_t child = children[node]; child < children[node + 1]; ++child) {
+                best.push_back(child);
+            }
+
+            // Quantized probabilities grow as they get less likely; ties keep
+            // the word order, so the table does not depend on the sort.
+            const std::size_t count = std::min<std::size_t>(best.size(), NGramFormat::SuccessorCount);
+            std::partial_sort(best.begin(), best.begin() + count, best.end(),
+                              [&childProbs](std::uint32_t a, std::uint32_t b) {
+                return childProbs[a] < childProbs[b] || (childProbs[a] == childProbs[b] && a < b);
+            });
+            successors.insert(successors.end(), best.begin(), best.begin() + count);
+        }
+        offsets.push_back(static_cast<std::uint32_t>(successors.size()));
+
+        level->successorOffsets = writer.write(offsets);
+        level->successors = writer.write(successors);
+    };
+
+    NGramFormat::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, NGramFormat::Magic, sizeof(header.magic));
+    header.version = NGramFormat::Version;
+    header.order = options.order;
+    header.vocabularySize = vocabulary;
+    header.logProbStep = options.logProbStep;
+    header.backoffPenalty = options.backoffPenalty;
+
+    // Strings.
+    std::vector<std::uint32_t> stringOffsets;
+    std::vector<char16_t> pool;
+    stringOffsets.reserve(vocabulary + 1);
+    for (std::uint32_t id = 0; id < vocabulary; ++id) {
+        stringOffsets.push_back(static_cast<std::uint32_t>(pool.size()));
+        const std::u16string &word = counts.words[unmapped(id)];
+        pool.insert(pool.end(), word.begin(), word.end());
+    }
+    stringOffsets.push_back(static_cast<std::uint32_t>(pool.size()));
+    header.stringOffsetsOffset = writer.write(stringOffsets);
+    header.stringPoolOffset = writer.write(pool);
+
+    // Unigrams.
+    std::vector<std::uint8_t> unigramProbs(vocabulary);
+    std::vector<std::uint32_t> rank(vocabulary);
+    for (std::uint32_t id = 0; id < vocabulary; ++id) {
+        unigramProbs[id] = quantize(double(counts.wordCounts[unmapped(id)]) / counts.totalWords,
+                                    options.logProbStep);
+        rank[id] = id;
+    }
+    std::stable_sort(rank.begin(), rank.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return counts.wordCounts[unmapped(a)] > counts.wordCounts[unmapped(b)];
+    });
+    header.unigramRankOffset = writer.write(rank);
+    header.levels[0].nodeCount = vocabulary;
+    header.levels[0].probsOffset = writer.write(unigramProbs);
+
+    if (options.order > 1) {
+        std::vector<std::uint32_t> children(vocabulary + 1, 0);
+        std::vector<std::uint32_t> ids;
+        std::vector<std::uint8_t> probs;
+        for (const Gram<2> &gram : bigrams) {
+            ++children[gram[0] + 1];
+            ids.push_back(gram[1]);
+            const auto found = counts.bigrams.find(Gram<2>{{unmapped(gram[0]), unmapped(gram[1])}});
+            probs.push_back(quantize(double(found->second) / counts.wordCounts[unmapped(gram[0])],
+                                     options.logProbStep));
+        }
+        for (std::uint32_t i = 1; i <= vocabulary; ++i) {
+            children[i] += children[i - 1];
+        }
+        header.levels[0].childOffsets = writer.write(children);
+        header.levels[1].nodeCount = bigrams.size();
+        header.levels[1].wordIdsOffset = writer.write(ids);
+        header.levels[1].probsOffset = writer.write(probs);
+        writeSuccessors(&header.levels[0], children, probs);
+    }
+
+    if (options.order > 2) {
+        std::vector<std::uint32_t> children(bigrams.size() + 1, 0);
+        std::vector<std::uint32_t> ids;
+        std::vector<std::uint8_t> probs;
+        for (const Gram<3> &gram : trigrams) {
+            const Gram<2> parent{{gram[0], gram[1]}};
+            const std::size_t node = std::lower_bound(bigrams.begin(), bigrams.end(), parent) - bigrams.begin();
+            ++children[node + 1];
+            ids.push_back(gram[2]);
+            const auto found = counts.trigrams.find(Gram<3>{{unmapped(gram[0]), unmapped(gram[1]), unmapped(gram[2])}});
+            const auto context = counts.bigrams.find(Gram<2>{{unmapped(gram[0]), unmapped(gram[1])}});
+            probs.push_back(quantize(double(found->second) / context->second, options.logProbStep));
+        }
+        for (std::size_t i = 1; i < children.size(); ++i) {
+            children[i] += children[i - 1];
+        }
+        header.levels[1].childOffsets = writer.write(children);
+        header.levels[2].nodeCount = trigrams.size();
+        header.levels[2].wordIdsOffset = writer.write(ids);
+        header.levels[2].probsOffset = writer.write(probs);
+        writeSuccessors(&header.levels[1], children, probs);
+    }
+
+    std::vector<char> &data = writer.data();
+    data.resize(NGramFormat::align(data.size()));
+    header.fileSize = data.size();
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    const std::string temporary = options.output + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+    out.close();
+
+    if (!out || std::rename(temporary.c_str(), options.output.c_str()) != 0) {
+        std::cerr << "maliit-lmcompile: cannot write " << options.output << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    std::cout << options.output << ": " << vocabulary << " words, "
+              << bigrams.size() << " bigrams, " << trigrams.size() << " trigrams, "
+              << data.size() << " bytes" << std::endl;
+    return true;
+}
+
+} // unnamed namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseArguments(argc, argv, &options)) {
+        usage();
+        return 2;
+    }
+
+    std::string corpus;
+    for (const std::string &input : options.inputs) {
+        std::ifstream in(input, std::ios::binary);
+        if (!in) {
+            std::cerr << "maliit-lmcompile: cannot read " << input << std::endl;
+            return 1;
+        }
+        corpus.append(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        corpus.push_back('\n');
+    }
+
+    const unsigned threads = options.threads ? options.threads
+                                             : std::max(1u, std::thread::hardware_concurrency());
+
+    const Counts counts = count(corpus, options, threads);
+    return writeModel(counts, options) ? 0 : 1;
+}
@@ -38,21 +38,95 @@
 
 namespace MaliitKeyboard {
 
+namespace {
+
+//! Whether the replacement changes surrounding text, rather than at most
+//! moving the cursor.
+bool replacesText(const AbstractTextEditor::Replacement &replacement)
+{
+    return replacement.start != 0 || replacement.length != 0;
+}
+
+} // unnamed namespace
+
+//! \class Editor
+//! \brief Sends the edits of AbstractTextEditor to the input method host.
+//!
+//! A single key release can produce several preedit updates, for instance
+//! from the key itself and then from the word engine changing the preedit
+//! face or primary candidate. Each one is a round trip to the application,
+//! so preedit updates are held back until control returns to the event
+//! loop and only the last one is sent. An update that replaces surrounding
+//! text is never dropped, and commits, key events and actions flush the
+//! pending update first, so the application sees everything in order.
+
 Editor::Editor(const EditorOptions &options,
                Model::Text *text,
                Logic::AbstractWordEngine *word_engine,
                QObject *parent)
     : AbstractTextEditor(options, text, word_engine, parent)
     , m_host(nullptr)
-{}
+    , m_has_pending_preedit(false)
+    , m_pending_preedit()
+    , m_flush_timer()
+    , m_sent_preedit_updates(0)
+    , m_suppressed_preedit_updates(0)
+{
+    m_flush_timer.setSingleShot(true);
+    m_flush_timer.setInterval(0);
+    connect(&m_flush_timer, &QTimer::timeout, this, &Editor::flush);
+}
 
 Editor::~Editor() = default;
 
 void Editor::setHost(MAbstractInputMethodHost *host)
 {
+    // Updates meant for another host are of no use to this one.
+    m_flush_timer.stop();
+    m_has_pending_preedit = false;
+
     m_host = host;
 }
 
+//! \brief Sends the pending preedit update, if any, right away.
+void Editor::flush()
+{
+    m_flush_timer.stop();
+
+    if (not m_has_pending_preedit) {
+        return;
+    }
+    m_has_pending_preedit = false;
+
+    const PreeditUpdate &update = m_pending_preedit;
+
+    QList<Maliit::PreeditTextFormat> format_list;
+    const int start (0);
+    const int length (update.preedit.length());
+
+    format_list.append(Maliit::PreeditTextFormat(start,
+                                                 length,
+                                                 static_cast< ::Maliit::PreeditFace>(update.face)));
+
+    m_host->sendPreeditString(update.preedit, format_list, update.replacement.start,
+                              update.replacement.length, update.replacement.cursor_position);
+
+    ++m_sent_preedit_updates;
+}
+
+//! \brief Returns how many preedit updates were sent to the host.
+quint64 Editor::sentPreeditUpdates() const
+{
+    return m_sent_preedit_updates;
+}
+
+//! \brief Returns how many preedit updates were dropped because a later
+//! one replaced them before they were sent.
+quint64 Editor::suppressedPreeditUpdates() const
+{
+    return m_suppressed_preedit_updates;
+}
+
 void Editor::sendPreeditString(const QString &preedit,
                                Model::Text::PreeditFace face,
                                const Replacement &replacement)
@@ -63,19 +137,24 @@ void Editor::sendPreeditString(const QString &preedit,
         return;
     }
 
-    QList<Maliit::PreeditTextFormat> format_list;
-    const int start (0);
-    const int length (preedit.length());
+    if (m_has_pending_preedit) {
+        if (replacesText(m_pending_preedit.replacement)) {
+            flush();
+        } else {
+            ++m_suppressed_preedit_updates;
+        }
+    }
 
-    format_list.append(Maliit::PreeditTextFormat(start,
-                                                 length,
-                                                 static_cast< ::Maliit::PreeditFace>(face)));
+    m_pending_preedit.preedit = preedit;
+    m_pending_preedit.face = face;
+    m_pending_preedit.replacement = replacement;
+    m_has_pending_preedit = true;
 
-    m_host->sendPreeditString(preedit, format_list, replacement.start,
-                              replacement.length, replacement.cursor_position);
+    m_flush_timer.start();
 }
 
-void Editor::sendCommitString(const QString &commit)
+void Editor::sendCommitString(const QString &commit,
+                              const Replacement &replacement)
 {
     if (not m_host) {
         qWarning() << __PRETTY_FUNCTION__
@@ -83,7 +162,9 @@ void Editor::sendCommitString(const QString &commit)
         return;
     }
 
-    m_host->sendCommitString(commit);
+    flush();
+    m_host->sendCommitString(commit, replacement.start,
+                             replacement.length, replacement.cursor_position);
 }
 
 void Editor::sendKeyEvent(const QKeyEvent &ev)
@@ -94,6 +175,7 @@ void Editor::sendKeyEvent(const QKeyEvent &ev)
         return;
     }
 
+    flush();
     m_host->sendKeyEvent(ev);
 }
 
@@ -105,6 +187,7 @@ void Editor::invokeAction(const QString &action, const QKeySequence &sequence)
         return;
     }
 
+    flush();
     m_host->invokeAction(action, sequence);
 }
 
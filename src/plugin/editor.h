@@ -48,7 +48,19 @@ class Editor
     Q_DISABLE_COPY(Editor)
 
 private:
+    struct PreeditUpdate
+    {
+        QString preedit;
+        Model::Text::PreeditFace face;
+        Replacement replacement;
+    };
+
     MAbstractInputMethodHost *m_host;
+    bool m_has_pending_preedit;
+    PreeditUpdate m_pending_preedit;
+    QTimer m_flush_timer;
+    quint64 m_sent_preedit_updates;
+    quint64 m_suppressed_preedit_updates;
 
 public:
     explicit Editor(const EditorOptions &options,
@@ -59,12 +71,17 @@ public:
 
     void setHost(MAbstractInputMethodHost *host);
 
+    void flush();
+    quint64 sentPreeditUpdates() const;
+    quint64 suppressedPreeditUpdates() const;
+
 private:
     //! \reimp
     void sendPreeditString(const QString &preedit,
                                    Model::Text::PreeditFace face,
                                    const Replacement &replacement) override;
-    void sendCommitString(const QString &commit) override;
+    void sendCommitString(const QString &commit,
+                          const Replacement &replacement) override;
     void sendKeyEvent(const QKeyEvent &ev) override;
     void invokeAction(const QString &command, const QKeySequence &sequence) override;
     //! \reimp_end
@@ -0,0 +1,99 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "hoststate.h"
+
+#include <maliit/plugins/abstractinputmethodhost.h>
+
+namespace MaliitKeyboard {
+
+HostState::HostState()
+    : m_has_selection_valid(false)
+    , m_has_selection(false)
+    , m_prediction_valid(false)
+    , m_prediction_enabled(false)
+    , m_content_type_valid(false)
+    , m_content_type(0)
+    , m_surrounding_text_valid(false)
+    , m_surrounding_text()
+    , m_cursor_position(-1)
+{}
+
+//! \brief Queries each part of the state from \a host once.
+HostState HostState::capture(MAbstractInputMethodHost *host)
+{
+    HostState state;
+
+    state.m_has_selection = host->hasSelection(state.m_has_selection_valid);
+    state.m_prediction_enabled = host->predictionEnabled(state.m_prediction_valid);
+    state.m_content_type = host->contentType(state.m_content_type_valid);
+    state.m_surrounding_text_valid = host->surroundingText(state.m_surrounding_text,
+                                                           state.m_cursor_position);
+
+    return state;
+}
+
+//! \brief Returns the Change flags of the parts that differ from \a previous.
+//!
+//! A part changes when its validity does, or when it is valid and its value
+//! differs. The host hands out the same shared string for as long as the
+//! text stays the same, so comparing the surrounding text is usually a
+//! pointer comparison.
+int HostState::changesFrom(const HostState &previous) const
+{
+    int changes = 0;
+
+    if (m_has_selection_valid != previous.m_has_selection_valid
+            || (m_has_selection_valid && m_has_selection != previous.m_has_selection)) {
+        changes |= SelectionChanged;
+    }
+
+    if (m_prediction_valid != previous.m_prediction_valid
+            || (m_prediction_valid && m_prediction_enabled != previous.m_prediction_enabled)) {
+        changes |= PredictionChanged;
+    }
+
+    if (m_content_type_valid != previous.m_content_type_valid
+            || (m_content_type_valid && m_content_type != previous.m_content_type)) {
+        changes |= ContentTypeChanged;
+    }
+
+    if (m_surrounding_text_valid != previous.m_surrounding_text_valid) {
+        changes |= SurroundingTextChanged | CursorPositionChanged;
+    } else if (m_surrounding_text_valid) {
+        if (m_surrounding_text != previous.m_surrounding_text) {
+            changes |= SurroundingTextChanged;
+        }
+        if (m_cursor_position != previous.m_cursor_position) {
+            changes |= CursorPositionChanged;
+        }
+    }
+
+    return changes;
+}
+
+} // namespace MaliitKeyboard
@@ -0,0 +1,86 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_HOSTSTATE_H
+#define MALIIT_KEYBOARD_HOSTSTATE_H
+
+#include <QtCore>
+
+class MAbstractInputMethodHost;
+
+namespace MaliitKeyboard {
+
+//! \class HostState
+//! \brief What InputMethod::update() reads from the input method host,
+//! captured once per update.
+//!
+//! Each part carries the validity flag the host reported along with it. A
+//! default constructed HostState has no valid part, so every part of a
+//! captured state counts as changed from it.
+class HostState
+{
+public:
+    enum Change
+    {
+        SelectionChanged = 0x1,
+        PredictionChanged = 0x2,
+        ContentTypeChanged = 0x4,
+        SurroundingTextChanged = 0x8,
+        CursorPositionChanged = 0x10
+    };
+
+    HostState();
+
+    static HostState capture(MAbstractInputMethodHost *host);
+
+    int changesFrom(const HostState &previous) const;
+
+    bool hasSelectionValid() const { return m_has_selection_valid; }
+    bool hasSelection() const { return m_has_selection; }
+    bool predictionValid() const { return m_prediction_valid; }
+    bool predictionEnabled() const { return m_prediction_enabled; }
+    bool contentTypeValid() const { return m_content_type_valid; }
+    int contentType() const { return m_content_type; }
+    bool surroundingTextValid() const { return m_surrounding_text_valid; }
+    const QString &surroundingText() const { return m_surrounding_text; }
+    int cursorPosition() const { return m_cursor_position; }
+
+private:
+    bool m_has_selection_valid;
+    bool m_has_selection;
+    bool m_prediction_valid;
+    bool m_prediction_enabled;
+    bool m_content_type_valid;
+    int m_content_type;
+    bool m_surrounding_text_valid;
+    QString m_surrounding_text;
+    int m_cursor_position;
+};
+
+} // namespace MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_HOSTSTATE_H
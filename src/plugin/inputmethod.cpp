@@ -56,6 +56,9 @@ namespace {
 
 const char * const actionKeyName = "actionKey";
 
+// activateAutoCaps() only looks at how the text before the cursor ends.
+const int AutoCapsContextLength = 8;
+
 Qt::ScreenOrientation rotationAngleToScreenOrientation(int angle)
 {
     bool portraitIsPrimary = QGuiApplication::primaryScreen()->primaryOrientation()
@@ -160,6 +163,8 @@ void InputMethod::show()
 
     if(!d->m_settings.stayHidden()) {
         d->m_geometry->setShown(true);
+        // Nothing was applied while hidden, so apply everything.
+        d->host_state = HostState();
         update();
         d->view->setVisible(true);
     }
@@ -189,8 +194,12 @@ void InputMethod::reset()
     //we need to clear preedit/word candidates in this case
     qDebug() << "inputMethod::reset()";
     Q_D(InputMethod);
+    // Whatever the editor has yet to send happened before the reset.
+    d->editor.flush();
     d->editor.clearPreedit();
     d->previous_position = -1;
+    // The next update applies the new editor's state in full.
+    d->host_state = HostState();
     Q_EMIT keyboardReset();
 }
 
@@ -348,6 +357,7 @@ void InputMethod::onEnabledLanguageSettingsChanged()
     if (!d->enabledLanguages.contains(d->activeLanguage)) {
         setActiveLanguage(d->enabledLanguages.front());
     }
+    d->updateEnabledLanguagePlugins();
     Q_EMIT enabledLanguagesChanged(d->enabledLanguages);
 }
 
@@ -415,49 +425,70 @@ void InputMethod::update()
         return;
     }
 
-    bool valid;
-
-    bool hasSelection = d->host->hasSelection(valid);
+    // Ask the host once; the parts that did not change since the last
+    // update are not applied again.
+    const HostState state = HostState::capture(d->host);
+    const int changes = state.changesFrom(d->host_state);
+    d->host_state = state;
 
-    if (valid && hasSelection != d->hasSelection) {
-        d->hasSelection = hasSelection;
+    if ((changes & HostState::SelectionChanged)
+            && state.hasSelectionValid() && state.hasSelection() != d->hasSelection) {
+        d->hasSelection = state.hasSelection();
         Q_EMIT hasSelectionChanged(d->hasSelection);
     }
 
-    bool emitPredictionEnabled = false;
+    // updateWordEngine() turns the word engine off for some content types,
+    // so a change of either re-derives both. Switching language plugins
+    // resets the snapshot, which covers alwaysShowSuggestions().
+    if (changes & (HostState::PredictionChanged | HostState::ContentTypeChanged)) {
+        bool emitPredictionEnabled = false;
 
-    bool newPredictionEnabled = inputMethodHost()->predictionEnabled(valid)
-                                || d->editor.wordEngine()->languageFeature()->alwaysShowSuggestions();
+        bool newPredictionEnabled = state.predictionEnabled()
+                                    || d->editor.wordEngine()->languageFeature()->alwaysShowSuggestions();
 
-    if (!valid)
-        newPredictionEnabled = true;
+        if (!state.predictionValid())
+            newPredictionEnabled = true;
 
-    if (d->wordEngineEnabled != newPredictionEnabled) {
-        d->wordEngineEnabled = newPredictionEnabled;
-        emitPredictionEnabled = true;
-    }
+        if (d->wordEngineEnabled != newPredictionEnabled) {
+            d->wordEngineEnabled = newPredictionEnabled;
+            emitPredictionEnabled = true;
+        }
 
-    TextContentType newContentType = static_cast<TextContentType>( inputMethodHost()->contentType(valid) );
-    if (!valid) {
-        newContentType = FreeTextContentType;
-    }
-    setContentType(newContentType);
+        TextContentType newContentType = static_cast<TextContentType>(state.contentType());
+        if (!state.contentTypeValid()) {
+            newContentType = FreeTextContentType;
+        }
+        setContentType(newContentType);
 
-    if (emitPredictionEnabled) {
-        updateWordEngine();
+        if (emitPredictionEnabled) {
+            updateWordEngine();
+        }
     }
 
+    const bool wasAutocapsEnabled = d->autocapsEnabled;
     updateAutoCaps();
 
-    QString text;
-    int position;
-    bool ok = d->host->surroundingText(text, position);
-    if (ok) {
-        d->editor.text()->setSurrounding(text);
-        d->editor.text()->setSurroundingOffset(position);
+    if (state.surroundingTextValid()) {
+        Model::Text *model = d->editor.text();
 
-        checkAutocaps();
-        d->previous_position = position;
+        // Between updates the editor only appends the preedit to the model
+        // or clears it, which changes its length, so the text itself only
+        // gets replaced when the host reports a change.
+        const bool textChanged = (changes & HostState::SurroundingTextChanged)
+                || model->surrounding().size() != state.surroundingText().size();
+        if (textChanged) {
+            model->setSurrounding(state.surroundingText());
+        }
+        model->setSurroundingOffset(state.cursorPosition());
+
+        if (textChanged
+                || (changes & (HostState::SurroundingTextChanged
+                               | HostState::CursorPositionChanged
+                               | HostState::ContentTypeChanged))
+                || d->autocapsEnabled != wasAutocapsEnabled) {
+            checkAutocaps();
+        }
+        d->previous_position = state.cursorPosition();
     }
 }
 
@@ -510,19 +541,11 @@ void InputMethod::checkAutocaps()
     Q_D(InputMethod);
 
     if (d->autocapsEnabled) {
-        QString text;
-        int position;
-        bool ok = d->host->surroundingText(text, position);
-        QString textOnLeft = d->editor.text()->surroundingLeft() + d->editor.text()->preedit();
-        if (textOnLeft.contains(QLatin1String("\n"))) {
-            textOnLeft = textOnLeft.split(QStringLiteral("\n")).last();
-        }
-        QStringList leftHandWords = textOnLeft.split(QStringLiteral(" "));
-        bool email_detected = false;
-        if (!leftHandWords.isEmpty() && leftHandWords.last().contains(QLatin1String("@"))) {
-            email_detected = true;
-        }
-        if (ok && !email_detected && ((textOnLeft.isEmpty() && d->editor.text()->preedit().isEmpty())
+        const Model::Text *model = d->editor.text();
+        const QString textOnLeft = model->atLineStart() ? QString()
+                                                        : model->textBeforeCursor(AutoCapsContextLength);
+        const bool email_detected = model->currentTokenHasAtSign();
+        if (!email_detected && (model->atLineStart()
                 || d->editor.wordEngine()->languageFeature()->activateAutoCaps(textOnLeft)
                 || d->editor.wordEngine()->languageFeature()->activateAutoCaps(textOnLeft.trimmed()))) {
             Q_EMIT activateAutocaps();
@@ -765,12 +788,10 @@ bool InputMethod::languageIsSupported(const QString plugin) {
 
 void InputMethod::onLanguageChanged(const QString &language) {
     Q_D(InputMethod);
-    for (const auto& languagePath : std::as_const(d->languagesPaths)) {
-        QFile languagePlugin(languagePath + QDir::separator() + language + QDir::separator() + QStringLiteral("lib%1plugin.so").arg(language));
-        if (languagePlugin.exists()) {
-            Q_EMIT languagePluginChanged(languagePlugin.fileName(), language);
-            return;
-        }
+    const QString pluginPath = d->languagePluginPath(language);
+    if (!pluginPath.isEmpty()) {
+        Q_EMIT languagePluginChanged(pluginPath, language);
+        return;
     }
     qCritical() << "Couldn't find word engine plugin for " << language;
 }
@@ -780,6 +801,7 @@ void InputMethod::onPluginPathsChanged(const QStringList& pluginPaths) {
     Q_UNUSED(pluginPaths);
 
     d->updateLanguagesPaths();
+    d->updateEnabledLanguagePlugins();
 }
 
 void InputMethod::showSystemSettings()
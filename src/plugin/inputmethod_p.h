@@ -21,9 +21,13 @@
 #include "editor.h"
 #include "feedback.h"
 #include "gettext.h"
+#include "hoststate.h"
 
 #include "keyboardgeometry.h"
 #include "keyboardsettings.h"
+#ifdef MALIIT_KEYBOARD_LATENCY_STATS
+#include "latencymonitor.h"
+#endif
 
 #include "models/wordribbon.h"
 #include "logic/eventhandler.h"
@@ -70,6 +74,10 @@ QQuickView *createWindow(MAbstractInputMethodHost *host)
 class InputMethodPrivate
 {
 public:
+#ifdef MALIIT_KEYBOARD_LATENCY_STATS
+    // First, so the shared statistics exist before any plugin is loaded.
+    LatencyMonitor latency_monitor;
+#endif
     InputMethod* q;
     Editor editor;
     SharedOverride actionKeyOverrider;
@@ -98,6 +106,7 @@ public:
     WordRibbon* wordRibbon;
 
     int previous_position;
+    HostState host_state; //!< What the host reported at the last update().
 
     QStringList languagesPaths;
     QString currentPluginPath;
@@ -234,6 +243,29 @@ public:
         languagesPaths.append(m_settings.pluginPaths());
     }
 
+    QString languagePluginPath(const QString &language) const
+    {
+        for (const auto& languagePath : std::as_const(languagesPaths)) {
+            QFile languagePlugin(languagePath + QDir::separator() + language + QDir::separator() + QStringLiteral("lib%1plugin.so").arg(language));
+            if (languagePlugin.exists()) {
+                return languagePlugin.fileName();
+            }
+        }
+        return QString();
+    }
+
+    void updateEnabledLanguagePlugins()
+    {
+        QStringList pluginPaths;
+        for (const auto& language : std::as_const(enabledLanguages)) {
+            const QString pluginPath = languagePluginPath(language);
+            if (!pluginPath.isEmpty()) {
+                pluginPaths.append(pluginPath);
+            }
+        }
+        editor.wordEngine()->setEnabledLanguagePlugins(pluginPaths);
+    }
+
     /*
      * register settings
      */
@@ -0,0 +1,130 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "latencymonitor.h"
+
+#include "logic/latencystats.h"
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <QSocketNotifier>
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace MaliitKeyboard
+{
+
+namespace {
+
+const char * const ServiceName = "org.maliit.keyboard.LatencyStats";
+const char * const ObjectPath = "/org/maliit/keyboard/LatencyStats";
+
+// Written to by the signal handler, read by the event loop. Only
+// async-signal-safe calls are allowed in between.
+int g_signal_fds[2] = { -1, -1 };
+
+} // unnamed namespace
+
+LatencyMonitor::LatencyMonitor(QObject *parent)
+    : QObject(parent)
+    , m_notifier(nullptr)
+{
+    // Creates the shared instance before any plugin looks for it.
+    Logic::LatencyStats::instance();
+
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, g_signal_fds) == 0) {
+        m_notifier = new QSocketNotifier(g_signal_fds[1], QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated,
+                this, &LatencyMonitor::onDumpRequested);
+
+        struct sigaction action = {};
+        action.sa_handler = &LatencyMonitor::handleSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+
+        if (::sigaction(SIGUSR1, &action, nullptr) != 0) {
+            qWarning() << __PRETTY_FUNCTION__ << "Could not install SIGUSR1 handler";
+        }
+    } else {
+        qWarning() << __PRETTY_FUNCTION__ << "Could not create signal socket pair";
+    }
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (not bus.registerObject(QLatin1String(ObjectPath), this,
+                               QDBusConnection::ExportScriptableSlots)
+        || not bus.registerService(QLatin1String(ServiceName))) {
+        qWarning() << __PRETTY_FUNCTION__ << "Could not export latency statistics on the session bus";
+    }
+}
+
+LatencyMonitor::~LatencyMonitor()
+{
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    bus.unregisterService(QLatin1String(ServiceName));
+    bus.unregisterObject(QLatin1String(ObjectPath));
+
+    if (m_notifier) {
+        ::signal(SIGUSR1, SIG_DFL);
+        ::close(g_signal_fds[0]);
+        ::close(g_signal_fds[1]);
+        g_signal_fds[0] = g_signal_fds[1] = -1;
+    }
+}
+
+//! Returns the latency table, durations in microseconds.
+QString LatencyMonitor::Dump() const
+{
+    return Logic::LatencyStats::instance()->dump();
+}
+
+//! Clears all histograms.
+void LatencyMonitor::Reset()
+{
+    Logic::LatencyStats::instance()->reset();
+}
+
+void LatencyMonitor::handleSignal(int signal)
+{
+    Q_UNUSED(signal)
+
+    const char byte = 1;
+    const ssize_t written = ::write(g_signal_fds[0], &byte, sizeof(byte));
+    Q_UNUSED(written)
+}
+
+void LatencyMonitor::onDumpRequested()
+{
+    char byte;
+    const ssize_t read = ::read(g_signal_fds[1], &byte, sizeof(byte));
+    Q_UNUSED(read)
+
+    qInfo().noquote() << "Keystroke latency (microseconds):\n" + Dump();
+}
+
+} // namespace MaliitKeyboard
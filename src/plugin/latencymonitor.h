@@ -0,0 +1,71 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_LATENCYMONITOR_H
+#define MALIIT_KEYBOARD_LATENCYMONITOR_H
+
+#include <QObject>
+
+class QSocketNotifier;
+
+namespace MaliitKeyboard
+{
+
+//! \class LatencyMonitor
+//! Makes the latency histograms of Logic::LatencyStats readable at runtime.
+//!
+//! The statistics are exported on the session bus as
+//! org.maliit.keyboard.LatencyStats at /org/maliit/keyboard/LatencyStats,
+//! and written to the log when the process receives SIGUSR1:
+//!
+//!   dbus-send --session --print-reply --dest=org.maliit.keyboard.LatencyStats \
+//!       /org/maliit/keyboard/LatencyStats org.maliit.keyboard.LatencyStats.Dump
+//!   kill -USR1 $(pidof maliit-server)
+//!
+//! Only built with -Denable-latency-stats=ON.
+class LatencyMonitor : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.maliit.keyboard.LatencyStats")
+
+public:
+    explicit LatencyMonitor(QObject *parent = nullptr);
+    ~LatencyMonitor() override;
+
+    Q_SCRIPTABLE QString Dump() const;
+    Q_SCRIPTABLE void Reset();
+
+private:
+    Q_SLOT void onDumpRequested();
+    static void handleSignal(int signal);
+
+    QSocketNotifier *m_notifier;
+};
+
+} // namespace MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_LATENCYMONITOR_H
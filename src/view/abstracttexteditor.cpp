@@ -32,11 +32,20 @@
 #include "abstracttexteditor.h"
 #include "models/wordribbon.h"
 #include "logic/abstractlanguagefeatures.h"
+#include "logic/latencystats.h"
 
 #include <QElapsedTimer>
 
 namespace MaliitKeyboard {
 
+namespace {
+
+// activateAutoCaps() only looks at how the text before the cursor ends, so
+// it is given that end rather than the whole document.
+const int AutoCapsContextLength = 8;
+
+} // unnamed namespace
+
 //! \class EditorOptions
 //! \brief Plain struct implementing editor options.
 
@@ -78,12 +87,15 @@ namespace MaliitKeyboard {
 //! ignored if its value is lesser than zero. Otherwise it describes a
 //! position of cursor relatively to the beginning of preedit.
 
-//! \fn void AbstractTextEditor::sendCommitString(const QString &commit)
+//! \fn void AbstractTextEditor::sendCommitString(const QString &commit, const Replacement &replacement)
 //! \brief Commits a string to application.
 //! \param commit String to be commited in place of preedit.
+//! \param replacement Surrounding text replaced by \a commit.
 //!
 //! Implementations of this method should discard current preedit and
-//! commit given \a commit in its place.
+//! commit given \a commit in its place. Unlike for sendPreeditString(),
+//! the start of \a replacement is relative to the cursor, so a negative
+//! start with an equal length replaces the text right before the cursor.
 
 //! \fn void AbstractTextEditor::sendKeyEvent(const QKeyEvent &ev)
 //! \brief Sends a key event to application.
@@ -348,6 +360,7 @@ void AbstractTextEditor::onKeyPressed(const Key &key)
 void AbstractTextEditor::onKeyReleased(const Key &key)
 {
     Q_D(AbstractTextEditor);
+    MALIIT_LATENCY_SCOPE(EditorKeyReleased);
 
     if (not d->valid()) {
         return;
@@ -361,13 +374,15 @@ void AbstractTextEditor::onKeyReleased(const Key &key)
     bool email_detected = false;
 
     // Detect if the user is entering an email address and avoid spacing, autocaps and autocomplete changes
-    QString textOnLeft = d->text->surroundingLeft() + d->text->preedit();
-    if (key.action() == Key::ActionBackspace) {
-        textOnLeft.chop(1);
-    }
-    QStringList leftHandWords = textOnLeft.split(QStringLiteral(" "));
-    if (!d->word_engine->languageFeature()->alwaysShowSuggestions() && !leftHandWords.isEmpty() && leftHandWords.last().contains(QLatin1String("@"))) {
-        email_detected = true;
+    if (!d->word_engine->languageFeature()->alwaysShowSuggestions()) {
+        if (key.action() != Key::ActionBackspace) {
+            email_detected = d->text->currentTokenHasAtSign();
+        } else {
+            // Look at the token as it is after the backspace.
+            const QString token = d->text->currentToken();
+            email_detected = token.isEmpty() ? d->text->previousToken().contains(QLatin1Char('@'))
+                                             : token.leftRef(token.length() - 1).contains(QLatin1Char('@'));
+        }
     }
 
     // we reset the flags here so that we won't have to add boilerplate code later
@@ -392,7 +407,7 @@ void AbstractTextEditor::onKeyReleased(const Key &key)
 
         if (d->preedit_enabled) {
             if (!enablePreeditAtInsertion &&
-                    (d->text->surroundingRight().left(1).contains(QRegExp(R"([\w])")) || email_detected)) {
+                    (Logic::CharacterClassTable::isWordCharacter(d->text->characterAfterCursor()) || email_detected)) {
                 // We're editing in the middle of a word or entering an email address, so just insert characters directly
                 d->text->appendToPreedit(text);
                 commitPreedit();
@@ -403,7 +418,7 @@ void AbstractTextEditor::onKeyReleased(const Key &key)
                 d->text->appendToPreedit(text);
                 commitPreedit();
                 if (!email_detected) {
-                    auto_caps_activated = d->word_engine->languageFeature()->activateAutoCaps(d->text->surroundingLeft() + d->text->preedit() + text);
+                    auto_caps_activated = d->word_engine->languageFeature()->activateAutoCaps(d->text->textBeforeCursor(AutoCapsContextLength) + text);
                 }
                 alreadyAppended = true;
             }
@@ -415,7 +430,7 @@ void AbstractTextEditor::onKeyReleased(const Key &key)
 
                 d->text->appendToPreedit(text);
                 if (!email_detected) {
-                    auto_caps_activated = d->word_engine->languageFeature()->activateAutoCaps(d->text->surroundingLeft() + d->text->preedit());
+                    auto_caps_activated = d->word_engine->languageFeature()->activateAutoCaps(d->text->textBeforeCursor(AutoCapsContextLength));
                 }
                 commitPreedit();
                 alreadyAppended = true;
@@ -474,13 +489,7 @@ void AbstractTextEditor::onKeyReleased(const Key &key)
 
     case Key::ActionSpace: {
         QString space = QStringLiteral(" ");
-        QString textOnLeft = d->text->surroundingLeft() + d->text->preedit();
-        QString textOnLeftTrimmed = textOnLeft.trimmed();
-        QStringList textOnRightList = d->text->surroundingRight().split(QStringLiteral("\n"));
-        QString textOnRight;
-        if (!textOnRightList.isEmpty()) {
-            textOnRight = textOnRightList.first().trimmed();
-        }
+        QString textOnLeft = d->text->textBeforeCursor(AutoCapsContextLength);
         bool auto_caps_activated = d->word_engine->languageFeature()->activateAutoCaps(textOnLeft);
         const bool replace_preedit = d->auto_correct_enabled
                                      && not d->text->primaryCandidate().isEmpty()
@@ -506,7 +515,7 @@ void AbstractTextEditor::onKeyReleased(const Key &key)
         }
 
         if (replace_preedit) {
-            if (!textOnRight.isEmpty() && d->editing_middle_of_text) {
+            if (!d->text->restOfLineBlank() && d->editing_middle_of_text) {
                 // Don't insert a space if we are correcting a word in the middle of a sentence
                 space = QString();
                 d->look_for_a_double_space = false;
@@ -539,11 +548,10 @@ void AbstractTextEditor::onKeyReleased(const Key &key)
                  && textOnLeft.count() >= 2
                  && textOnLeft.at(textOnLeft.count() - 1).isSpace()
                  && !textOnLeft.at(textOnLeft.count() - 2).isSpace()
-                 && textOnLeftTrimmed.count() > 0
-                 && !d->word_engine->languageFeature()->isSeparator(textOnLeftTrimmed.at(textOnLeftTrimmed.count() - 1))
-                 && !(textOnLeftTrimmed.endsWith(QLatin1String(")"))
-                      && textOnLeftTrimmed.count() > 1
-                      && d->word_engine->languageFeature()->isSeparator(textOnLeftTrimmed.at(textOnLeftTrimmed.count() - 2)))) {
+                 && !d->word_engine->languageFeature()->isSeparator(textOnLeft.at(textOnLeft.count() - 2))
+                 && !(textOnLeft.at(textOnLeft.count() - 2) == QLatin1Char(')')
+                      && textOnLeft.count() > 2
+                      && d->word_engine->languageFeature()->isSeparator(textOnLeft.at(textOnLeft.count() - 3)))) {
             removeTrailingWhitespaces();
             if (!d->word_engine->languageFeature()->commitOnSpace()) {
                 // Commit when inserting a fullstop if we don't insert on spaces
@@ -557,7 +565,7 @@ void AbstractTextEditor::onKeyReleased(const Key &key)
             }
 
             // we need to re-evaluate autocaps after our changes to the preedit
-            textOnLeft = d->text->surroundingLeft() + d->text->preedit();
+            textOnLeft = d->text->textBeforeCursor(AutoCapsContextLength);
             auto_caps_activated = d->word_engine->languageFeature()->activateAutoCaps(textOnLeft);
             full_stop_inserted = true;
             d->look_for_a_triple_space = true;
@@ -758,7 +766,7 @@ void AbstractTextEditor::replaceAndCommitPreedit(const QString &replacement)
     const bool auto_caps_activated = d->word_engine->languageFeature()->activateAutoCaps(d->text->preedit());
     d->appendix_for_previous_preedit = d->word_engine->languageFeature()->appendixForReplacedPreedit(d->text->preedit());
     if (d->auto_correct_enabled) {
-        if ((!d->text->surroundingRight().trimmed().isEmpty() && d->editing_middle_of_text) || d->word_engine->languageFeature()->contentType() == Maliit::UrlContentType) {
+        if ((!d->text->restOfTextBlank() && d->editing_middle_of_text) || d->word_engine->languageFeature()->contentType() == Maliit::UrlContentType) {
             // Don't insert a space if we are correcting a word in the middle of a sentence or if we're in a Url field
             d->appendix_for_previous_preedit = QString();
             d->editing_middle_of_text = false;
@@ -897,6 +905,10 @@ void AbstractTextEditor::setDoubleSpaceFullStopEnabled(bool enabled)
 }
 
 //! \brief Commits current preedit.
+//!
+//! If a word was completed, that is the preedit ends with a space, the word
+//! engine is asked for the words likely to follow it. They are capitalized
+//! when the committed text activates auto-caps.
 void AbstractTextEditor::commitPreedit()
 {
     Q_D(AbstractTextEditor);
@@ -905,22 +917,31 @@ void AbstractTextEditor::commitPreedit()
         return;
     }
 
+    const bool word_completed = d->text->preedit().endsWith(QLatin1Char(' '));
+
     sendCommitString(d->text->preedit());
     d->text->commitPreedit();
     d->word_engine->clearCandidates();
+
+    if (word_completed) {
+        // Same check as InputMethod::checkAutocaps() once the cursor moved.
+        AbstractLanguageFeatures *features = d->word_engine->languageFeature();
+        const QString textOnLeft = d->text->textBeforeCursor(AutoCapsContextLength);
+        const bool capitalize = d->auto_caps_enabled
+                && (features->activateAutoCaps(textOnLeft)
+                    || features->activateAutoCaps(textOnLeft.trimmed()));
+
+        d->word_engine->computeNextWordCandidates(d->text.data(), capitalize);
+    }
 }
 
 void AbstractTextEditor::removeTrailingWhitespaces()
 {
     Q_D(AbstractTextEditor);
 
-    const QString textOnLeft = d->text->surroundingLeft() + d->text->preedit();
+    const int whitespace = d->text->whitespaceBeforeCursor();
 
-    QString::const_iterator begin = textOnLeft.cbegin();
-    QString::const_iterator i = textOnLeft.cend();
-    while (i != begin) {
-        --i;
-        if (!i->isSpace()) break;
+    for (int i = 0; i < whitespace; ++i) {
         singleBackspace();
     }
 }
@@ -965,9 +986,7 @@ void AbstractTextEditor::autoRepeatWordBackspace()
     Q_D(AbstractTextEditor);
 
     if (d->text->surroundingOffset() > 0) {
-        QString word = wordLeftOfCursor();
-        for (int i=0; i<word.length(); ++i)
-            singleBackspace();
+        bulkBackspace(wordLeftOfCursor().length());
     } else {
         singleBackspace();
     }
@@ -1020,15 +1039,23 @@ void AbstractTextEditor::sendPreeditString(const QString &preedit,
     sendPreeditString(preedit, face, Replacement());
 }
 
+//! \brief Commits string to application with no replacement.
+//! \param commit String to commit.
+void AbstractTextEditor::sendCommitString(const QString &commit)
+{
+    sendCommitString(commit, Replacement());
+}
+
 //! \brief AbstractTextEditor::singleBackspace deletes one charater at he current
 //! cursor position.
 void AbstractTextEditor::singleBackspace()
 {
     Q_D(AbstractTextEditor);
     bool in_word = false;
-    QString textOnLeft = d->text->surroundingLeft();
+    QString textOnLeft;
 
     if (d->text->preedit().isEmpty()) {
+        textOnLeft = d->text->textBeforeCursor(AutoCapsContextLength + 1);
         in_word = textOnLeft.right(1) != QLatin1String(" ");
         sendKeyPressAndReleaseEvents(Qt::Key_Backspace, Qt::NoModifier);
         // Deletion of surrounding text isn't updated in the model until later
@@ -1037,7 +1064,7 @@ void AbstractTextEditor::singleBackspace()
     } else {
         in_word = true;
         d->text->removeFromPreedit(1);
-        textOnLeft += d->text->preedit();
+        textOnLeft = d->text->textBeforeCursor(AutoCapsContextLength);
 
         // Clear previous word candidates
         Q_EMIT wordCandidatesChanged(WordCandidateList());
@@ -1074,7 +1101,86 @@ void AbstractTextEditor::singleBackspace()
         }
     }
 
-    if(!d->text->surroundingRight().trimmed().isEmpty()) {
+    if(!d->text->restOfTextBlank()) {
+        d->editing_middle_of_text = true;
+    }
+    d->backspace_sent = true;
+}
+
+//! \brief Deletes \a length characters before the cursor, as that many
+//! calls to singleBackspace() would, with at most one preedit update and
+//! one commit sent to the application.
+//!
+//! As with singleBackspace(), characters are taken from the preedit while
+//! there is one, and from the surrounding text after that.
+void AbstractTextEditor::bulkBackspace(int length)
+{
+    Q_D(AbstractTextEditor);
+
+    if (length <= 1) {
+        singleBackspace();
+        return;
+    }
+
+    bool in_word = false;
+    int surrounding_length = 0;
+    QString textOnLeft;
+
+    if (d->text->preedit().isEmpty()) {
+        surrounding_length = qMin(length, int(d->text->surroundingOffset()));
+        textOnLeft = d->text->textBeforeCursor(AutoCapsContextLength + surrounding_length);
+        in_word = textOnLeft.right(1) != QLatin1String(" ");
+    } else {
+        in_word = true;
+        // Only what is left of the cursor can be deleted from the preedit.
+        const int preedit_length = qMin(length, d->text->cursorPosition());
+        d->text->removeFromPreedit(preedit_length);
+
+        // Clear previous word candidates
+        Q_EMIT wordCandidatesChanged(WordCandidateList());
+        if (not d->text->preedit().isEmpty()) {
+            sendPreeditString(d->text->preedit(), d->text->preeditFace(),
+                              Replacement(d->text->cursorPosition()));
+        }
+
+        Q_EMIT preeditChanged(d->text->preedit());
+        Q_EMIT cursorPositionChanged(d->text->cursorPosition());
+
+        if (d->text->preedit().isEmpty()) {
+            d->word_engine->clearCandidates();
+            d->text->commitPreedit();
+            surrounding_length = qMin(length - preedit_length, int(d->text->surroundingOffset()));
+        }
+
+        textOnLeft = d->text->textBeforeCursor(AutoCapsContextLength + surrounding_length);
+    }
+
+    if (d->text->preedit().isEmpty()) {
+        // One commit both flushes the preedit, see singleBackspace(), and
+        // deletes the rest. The model learns of the deletion with the next
+        // update from the host.
+        sendCommitString(QString(), surrounding_length > 0
+                         ? Replacement(-surrounding_length, surrounding_length, -1)
+                         : Replacement());
+        textOnLeft.chop(surrounding_length);
+    }
+
+    if (in_word && textOnLeft.right(1) == QLatin1String(" ")) {
+        d->deleted_words++;
+    }
+
+    textOnLeft = textOnLeft.trimmed();
+
+    const bool auto_caps_activated = d->word_engine->languageFeature()->activateAutoCaps(textOnLeft);
+    if (d->auto_caps_enabled) {
+        if (auto_caps_activated) {
+            Q_EMIT autoCapsActivated();
+        } else if(!textOnLeft.isEmpty()) {
+            Q_EMIT autoCapsDeactivated();
+        }
+    }
+
+    if(!d->text->restOfTextBlank()) {
         d->editing_middle_of_text = true;
     }
     d->backspace_sent = true;
@@ -1233,26 +1339,37 @@ void AbstractTextEditor::checkPreeditReentry(bool uncommittedDelete)
 
     int currentOffset = text()->surroundingOffset();
     if(currentOffset > 1 && currentOffset <= text()->surrounding().size()) {
-        QString lastChar;
+        QChar lastChar;
         if(uncommittedDelete) {
             // -2 for just deleted character that hasn't been committed and to reach character before cursor
             lastChar = text()->surrounding().at(currentOffset-2);
         } else {
             lastChar = text()->surrounding().at(currentOffset-1);
         }
-        if(!QRegExp(R"(\W+)").exactMatch(lastChar) && !d->word_engine->languageFeature()->isSymbol(lastChar)) {
-            QStringList leftWords = text()->surroundingLeft().trimmed().split(QRegExp(R"([\s\d]+)"));
-            int trimDiff = text()->surroundingLeft().size() - text()->surroundingLeft().trimmed().size();
-            if(leftWords.last().isEmpty()) {
+        if(Logic::CharacterClassTable::isWordCharacter(lastChar) && !d->word_engine->languageFeature()->isSymbol(lastChar)) {
+            // Words are delimited by whitespace and digits here.
+            const auto isDelimiter = [](const QChar &c) { return c.isSpace() || c.isDigit(); };
+            int trimDiff = text()->whitespaceBeforeCursor();
+            int distance = trimDiff + 1;
+            if(not text()->characterBeforeCursor(distance).isNull()
+               && isDelimiter(text()->characterBeforeCursor(distance))) {
                 // If removed char was punctuation trimming will result in an empty entry
-                leftWords.removeLast();
+                while (not text()->characterBeforeCursor(distance).isNull()
+                       && isDelimiter(text()->characterBeforeCursor(distance))) {
+                    ++distance;
+                }
                 trimDiff += 1;
             }
-            if(d->text->surroundingRight().left(1).contains(QRegExp(R"([\w])"))) {
+            if(Logic::CharacterClassTable::isWordCharacter(d->text->characterAfterCursor())) {
                 // Don't enter pre-edit in the middle of a word
                 return;
             }
-            QString recreatedPreedit = leftWords.last();
+            QString recreatedPreedit;
+            for (QChar c = text()->characterBeforeCursor(distance);
+                 not c.isNull() && not isDelimiter(c);
+                 c = text()->characterBeforeCursor(++distance)) {
+                recreatedPreedit.prepend(c);
+            }
             if(trimDiff == 0 && uncommittedDelete) {
                 // Remove the last character from the word if we weren't just deleting a space
                 // as the last backspace hasn't been committed yet.
@@ -168,11 +168,15 @@ private:
     virtual void sendPreeditString(const QString &preedit,
                                    Model::Text::PreeditFace face,
                                    const Replacement &replacement) = 0;
-    virtual void sendCommitString(const QString &commit) = 0;
+    void sendCommitString(const QString &commit);
+
+    virtual void sendCommitString(const QString &commit,
+                                  const Replacement &replacement) = 0;
     virtual void sendKeyEvent(const QKeyEvent &ev) = 0;
     virtual void invokeAction(const QString &action, const QKeySequence &sequence) = 0;
 
     virtual void singleBackspace();
+    void bulkBackspace(int length);
 
     void removeTrailingWhitespaces();
     Q_SLOT void autoRepeatBackspace();
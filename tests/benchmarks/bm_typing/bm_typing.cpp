@@ -0,0 +1,349 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+//! Replays recorded typing traces through the real input path and reports
+//! what every keystroke costs:
+//!
+//!   EventHandler -> AbstractTextEditor -> WordEngine -> language plugin
+//!
+//! A trace is a text file with one key release per line,
+//!
+//!   <milliseconds since start> TAB <action> TAB <label>
+//!
+//! where action is "insert" for plain character keys or one of the actions
+//! understood by EventHandler::onKeyReleased(), such as "space" or
+//! "backspace". Empty lines and lines starting with '#' are ignored.
+//!
+//! For every keystroke the harness measures the time from the key release
+//! to the next word candidate update, and the number of operator new calls
+//! made meanwhile on any thread. Keystrokes that produce no update within
+//! the timeout are counted but excluded from the latency percentiles.
+//!
+//! Runs headless; set QT_QPA_PLATFORM=offscreen when no display is around.
+
+#include "inputmethodhostprobe.h"
+
+#include "logic/eventhandler.h"
+#include "logic/wordengine.h"
+#include "models/text.h"
+#include "plugin/editor.h"
+#include "view/setup.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QTextStream>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace MaliitKeyboard;
+
+namespace {
+
+std::atomic<quint64> g_allocations(0);
+
+const int LanguageLoadTimeout = 30000;
+
+struct KeyEvent
+{
+    qint64 timestamp;
+    QString action;
+    QString label;
+};
+
+struct Sample
+{
+    qint64 latency;
+    quint64 allocations;
+    bool updated;
+};
+
+bool loadTrace(const QString &fileName, QVector<KeyEvent> *events)
+{
+    QFile file(fileName);
+    if (not file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Cannot open trace" << fileName;
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    int lineNumber = 0;
+    while (not stream.atEnd()) {
+        const QString line = stream.readLine();
+        ++lineNumber;
+
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        const QStringList fields = line.split('\t');
+        bool ok = false;
+        const qint64 timestamp = fields.value(0).toLongLong(&ok);
+
+        if (fields.size() != 3 || not ok) {
+            qWarning() << fileName << ":" << lineNumber << "malformed trace line";
+            return false;
+        }
+
+        const QString action = fields.at(1) == QLatin1String("insert") ? QString() : fields.at(1);
+        const KeyEvent event = { timestamp, action, fields.at(2) };
+        events->append(event);
+    }
+
+    return true;
+}
+
+qint64 percentile(QVector<qint64> values, double fraction)
+{
+    if (values.isEmpty()) {
+        return 0;
+    }
+
+    const int index = qBound(0, int(fraction * values.size() + 0.5) - 1, values.size() - 1);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values.at(index);
+}
+
+bool waitForLanguage(Logic::WordEngine *engine,
+                     const QString &pluginPath,
+                     const QString &languageId)
+{
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(engine, &Logic::AbstractWordEngine::languageReady, &loop, &QEventLoop::quit);
+
+    engine->onLanguageChanged(pluginPath, languageId);
+    if (not engine->isLanguageReady()) {
+        timer.start(LanguageLoadTimeout);
+        loop.exec();
+    }
+
+    return engine->isLanguageReady();
+}
+
+} // unnamed namespace
+
+void *operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+int main(int argc, char **argv)
+{
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Replays typing traces through the word engine."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("trace"), QStringLiteral("Trace files to replay."));
+    QCommandLineOption pluginOption(QStringLiteral("plugin"),
+                                    QStringLiteral("Language plugin to load."),
+                                    QStringLiteral("path"), QStringLiteral(BENCHMARK_PLUGIN));
+    QCommandLineOption languageOption(QStringLiteral("language"),
+                                      QStringLiteral("Language of the plugin."),
+                                      QStringLiteral("id"), QStringLiteral("en"));
+    QCommandLineOption realtimeOption(QStringLiteral("realtime"),
+                                      QStringLiteral("Keep the recorded pauses between keystrokes."));
+    QCommandLineOption autoCorrectOption(QStringLiteral("auto-correct"),
+                                         QStringLiteral("Enable auto-correction."));
+    QCommandLineOption timeoutOption(QStringLiteral("timeout"),
+                                     QStringLiteral("Milliseconds to wait for a candidate update."),
+                                     QStringLiteral("ms"), QStringLiteral("1000"));
+    QCommandLineOption maxP99Option(QStringLiteral("max-p99"),
+                                    QStringLiteral("Fail if the p99 latency exceeds this."),
+                                    QStringLiteral("ms"));
+    QCommandLineOption maxAllocationsOption(QStringLiteral("max-allocations"),
+                                            QStringLiteral("Fail if the mean allocations per key exceed this."),
+                                            QStringLiteral("count"));
+    parser.addOptions({ pluginOption, languageOption, realtimeOption, autoCorrectOption,
+                        timeoutOption, maxP99Option, maxAllocationsOption });
+    parser.process(app);
+
+    QStringList traces = parser.positionalArguments();
+    if (traces.isEmpty()) {
+        traces << QStringLiteral(BENCHMARK_TRACE);
+    }
+
+    QVector<KeyEvent> events;
+    Q_FOREACH (const QString &trace, traces) {
+        if (not loadTrace(trace, &events)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    Logic::WordEngine *engine = new Logic::WordEngine;
+    Editor editor(EditorOptions(), new Model::Text, engine);
+    Logic::EventHandler eventHandler;
+    InputMethodHostProbe host;
+
+    Setup::connectAll(&eventHandler, &editor);
+    editor.setHost(&host);
+
+    // Language switches complete in the background; measure typing only.
+    if (not waitForLanguage(engine, parser.value(pluginOption), parser.value(languageOption))) {
+        qWarning() << "Language" << parser.value(languageOption) << "could not be loaded";
+        return EXIT_FAILURE;
+    }
+
+    engine->setWordPredictionEnabled(true);
+    engine->setSpellcheckerEnabled(true);
+    engine->setEnabled(true);
+    editor.setAutoCorrectEnabled(parser.isSet(autoCorrectOption));
+
+    if (not engine->isEnabled()) {
+        qWarning() << "Word engine could not be enabled with" << parser.value(pluginOption);
+        return EXIT_FAILURE;
+    }
+
+    const int timeout = parser.value(timeoutOption).toInt();
+    bool updated = false;
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(&editor, &AbstractTextEditor::wordCandidatesChanged,
+                     [&updated, &loop]() {
+        updated = true;
+        loop.quit();
+    });
+
+    // Pauses use their own loop, so that a late update cannot cut one short.
+    QEventLoop pause;
+
+    // Lets the plugin load its dictionaries and model before timing.
+    QTimer::singleShot(timeout, &pause, &QEventLoop::quit);
+    pause.exec();
+
+    QVector<Sample> samples;
+    samples.reserve(events.size());
+
+    QElapsedTimer wall;
+    QElapsedTimer keystroke;
+    qint64 busy = 0;
+    qint64 previousTimestamp = events.isEmpty() ? 0 : events.first().timestamp;
+    wall.start();
+
+    for (const KeyEvent &event : events) {
+        if (parser.isSet(realtimeOption)) {
+            const qint64 gap = event.timestamp - previousTimestamp;
+            if (gap > 0) {
+                QTimer::singleShot(int(gap), &pause, &QEventLoop::quit);
+                pause.exec();
+            }
+            previousTimestamp = event.timestamp;
+        }
+
+        updated = false;
+        const quint64 allocations = g_allocations.load(std::memory_order_relaxed);
+        keystroke.start();
+
+        eventHandler.onKeyReleased(event.label, event.action);
+
+        if (not updated) {
+            timer.start(timeout);
+            loop.exec();
+            timer.stop();
+        }
+
+        const qint64 latency = keystroke.nsecsElapsed();
+        busy += latency;
+        const Sample sample = { latency,
+                                g_allocations.load(std::memory_order_relaxed) - allocations,
+                                updated };
+        samples.append(sample);
+    }
+
+    const qint64 elapsed = wall.nsecsElapsed();
+
+    QVector<qint64> latencies;
+    quint64 allocations = 0;
+    int missed = 0;
+    for (const Sample &sample : samples) {
+        allocations += sample.allocations;
+        if (sample.updated) {
+            latencies.append(sample.latency);
+        } else {
+            ++missed;
+        }
+    }
+
+    const double keys = qMax(1, samples.size());
+    const double p50 = percentile(latencies, 0.5) / 1e6;
+    const double p99 = percentile(latencies, 0.99) / 1e6;
+    const double max = (latencies.isEmpty() ? 0 : *std::max_element(latencies.begin(), latencies.end())) / 1e6;
+    const double allocationsPerKey = allocations / keys;
+
+    std::printf("keystrokes:         %d\n", samples.size());
+    std::printf("without update:     %d\n", missed);
+    std::printf("wall time:          %.1f ms\n", elapsed / 1e6);
+    std::printf("throughput:         %.1f keys/s\n", busy > 0 ? keys * 1e9 / busy : 0.0);
+    std::printf("latency p50:        %.3f ms\n", p50);
+    std::printf("latency p99:        %.3f ms\n", p99);
+    std::printf("latency max:        %.3f ms\n", max);
+    std::printf("allocations/key:    %.1f\n", allocationsPerKey);
+    std::printf("commit history:     %s\n", qPrintable(host.commitStringHistory()));
+
+    int result = EXIT_SUCCESS;
+
+    if (parser.isSet(maxP99Option) && p99 > parser.value(maxP99Option).toDouble()) {
+        std::printf("FAIL: p99 latency %.3f ms exceeds %s ms\n", p99, qPrintable(parser.value(maxP99Option)));
+        result = EXIT_FAILURE;
+    }
+
+    if (parser.isSet(maxAllocationsOption)
+        && allocationsPerKey > parser.value(maxAllocationsOption).toDouble()) {
+        std::printf("FAIL: %.1f allocations per key exceed %s\n", allocationsPerKey,
+                    qPrintable(parser.value(maxAllocationsOption)));
+        result = EXIT_FAILURE;
+    }
+
+    return result;
+}
@@ -34,6 +34,8 @@
 
 InputMethodHostProbe::InputMethodHostProbe()
     : m_commit_string_history()
+    , m_last_commit_replace_start(0)
+    , m_last_commit_replace_length(0)
     , m_last_preedit_string()
     , m_last_key_event(QEvent::None, 0, Qt::NoModifier)
     , m_key_event_count(0)
@@ -49,16 +51,26 @@ QString InputMethodHostProbe::commitStringHistory() const
     return m_commit_string_history;
 }
 
+int InputMethodHostProbe::lastCommitReplaceStart() const
+{
+    return m_last_commit_replace_start;
+}
+
+int InputMethodHostProbe::lastCommitReplaceLength() const
+{
+    return m_last_commit_replace_length;
+}
+
 void InputMethodHostProbe::sendCommitString(const QString &string,
                                             int replace_start,
                                             int replace_length,
                                             int cursor_pos)
 {
-    Q_UNUSED(replace_start)
-    Q_UNUSED(replace_length)
     Q_UNUSED(cursor_pos)
 
     m_commit_string_history.append(string);
+    m_last_commit_replace_start = replace_start;
+    m_last_commit_replace_length = replace_length;
 }
 
 QString InputMethodHostProbe::lastPreeditString() const
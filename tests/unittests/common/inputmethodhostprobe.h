@@ -44,6 +44,8 @@ class InputMethodHostProbe
 
 private:
     QString m_commit_string_history;
+    int m_last_commit_replace_start;
+    int m_last_commit_replace_length;
     QString m_last_preedit_string;
     QKeyEvent m_last_key_event;
     int m_key_event_count;
@@ -57,6 +59,8 @@ public:
     InputMethodHostProbe();
 
     QString commitStringHistory() const;
+    int lastCommitReplaceStart() const;
+    int lastCommitReplaceLength() const;
     void sendCommitString(const QString &string,
                           int replace_start,
                           int replace_length,
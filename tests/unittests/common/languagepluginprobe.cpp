@@ -0,0 +1,102 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "languagepluginprobe.h"
+
+LanguagePluginProbe::LanguagePluginProbe(QObject *parent)
+    : AbstractLanguagePlugin(parent)
+    , m_languageFeatures()
+{}
+
+LanguagePluginProbe::~LanguagePluginProbe() = default;
+
+void LanguagePluginProbe::predict(quint64 generation, const QStringList &context, const QString &preedit)
+{
+    count("predictRequests");
+    setProperty("lastContext", context);
+    setProperty("lastPreedit", preedit);
+    setProperty("lastGeneration", generation);
+
+    const QStringList predictions = property("predictions").toStringList();
+    reply("predictionDelay", [this, generation, preedit, predictions]() {
+        Q_EMIT newPredictionSuggestions(generation, preedit, predictions);
+    });
+}
+
+AbstractLanguageFeatures *LanguagePluginProbe::languageFeature()
+{
+    return &m_languageFeatures;
+}
+
+void LanguagePluginProbe::spellCheckerSuggest(quint64 generation, const QString &word, int limit)
+{
+    count("spellCheckRequests");
+    setProperty("lastGeneration", generation);
+
+    const QStringList corrections = property("corrections").toStringList().mid(0, limit);
+    reply("correctionDelay", [this, generation, word, corrections]() {
+        Q_EMIT newSpellingSuggestions(generation, word, corrections);
+    });
+}
+
+void LanguagePluginProbe::addToSpellCheckerUserWordList(const QString &word)
+{
+    setProperty("userWords", property("userWords").toStringList() << word);
+}
+
+bool LanguagePluginProbe::setLanguage(const QString &languageId, const QString &pluginPath)
+{
+    Q_UNUSED(pluginPath)
+
+    setProperty("language", languageId);
+
+    const QVariant delay = property("languageDelay");
+    if (not delay.isValid()) {
+        return false;
+    }
+
+    if (delay.toInt() >= 0) {
+        QTimer::singleShot(delay.toInt(), this, [this, languageId]() {
+            Q_EMIT languageReady(languageId);
+        });
+    }
+    return true;
+}
+
+void LanguagePluginProbe::count(const char *name)
+{
+    setProperty(name, property(name).toInt() + 1);
+}
+
+//! Calls send after the delay set in the property delayName, if any.
+void LanguagePluginProbe::reply(const char *delayName, const std::function<void()> &send)
+{
+    const int delay = property(delayName).toInt();
+    if (delay >= 0) {
+        QTimer::singleShot(delay, this, send);
+    }
+}
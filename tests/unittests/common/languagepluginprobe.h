@@ -0,0 +1,79 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_LANGUAGEPLUGINPROBE_H
+#define MALIIT_KEYBOARD_LANGUAGEPLUGINPROBE_H
+
+#include "abstractlanguageplugin.h"
+#include "westernlanguagefeatures.h"
+
+#include <QtCore>
+
+#include <functional>
+
+//! \class LanguagePluginProbe
+//! Language plugin for tests, loaded through QPluginLoader like a real one.
+//!
+//! The plugin links its own copy of this class, so tests script it through
+//! dynamic properties of the instance, which they get from QPluginLoader:
+//! - "predictions", "corrections" (QStringList): the results to send;
+//! - "predictionDelay", "correctionDelay" (int): milliseconds before the
+//!   results are sent, never if negative;
+//! - "languageDelay" (int): milliseconds before languageReady() is
+//!   emitted, never if negative. Without it setLanguage() has nothing to
+//!   load.
+//!
+//! It records the requests in "predictRequests", "spellCheckRequests"
+//! (int), "lastContext" (QStringList), "lastPreedit" (QString),
+//! "lastGeneration" (quint64), "language" (QString) and "userWords"
+//! (QStringList).
+class LanguagePluginProbe
+    : public AbstractLanguagePlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID "io.maliit.keyboard.LanguagePlugin.1" FILE "languagepluginprobe.json")
+    Q_INTERFACES(LanguagePluginInterface)
+
+public:
+    explicit LanguagePluginProbe(QObject *parent = nullptr);
+    ~LanguagePluginProbe() override;
+
+    void predict(quint64 generation, const QStringList &context, const QString &preedit) override;
+    AbstractLanguageFeatures *languageFeature() override;
+
+    void spellCheckerSuggest(quint64 generation, const QString &word, int limit) override;
+    void addToSpellCheckerUserWordList(const QString &word) override;
+    bool setLanguage(const QString &languageId, const QString &pluginPath) override;
+
+private:
+    void count(const char *name);
+    void reply(const char *delayName, const std::function<void()> &send);
+
+    WesternLanguageFeatures m_languageFeatures;
+};
+
+#endif // MALIIT_KEYBOARD_LANGUAGEPLUGINPROBE_H
@@ -46,4 +46,36 @@ void waitForSignal(QObject *obj,
     loop.exec();
 }
 
+QString installLanguagePluginProbe(const QString &languagesDir,
+                                   const QString &language,
+                                   qint64 padding)
+{
+    const QString dir = languagesDir + QDir::separator() + language;
+    const QString pluginPath = dir + QStringLiteral("/lib%1plugin.so").arg(language);
+
+    QDir().mkpath(dir);
+    QFile::remove(pluginPath);
+    if (not QFile::copy(QStringLiteral(LANGUAGE_PLUGIN_PROBE), pluginPath)) {
+        return QString();
+    }
+
+    QFile data(dir + QStringLiteral("/padding.dat"));
+    if (not data.open(QIODevice::WriteOnly) || not data.resize(padding)) {
+        return QString();
+    }
+
+    return pluginPath;
+}
+
+QObject *languagePluginInstance(const QString &pluginPath)
+{
+    return QPluginLoader(pluginPath).instance();
+}
+
+bool writeFile(const QString &fileName, const QByteArray &contents)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(contents) == contents.size();
+}
+
 } // namespace TestUtils
@@ -32,6 +32,9 @@
 #ifndef TESTUTILS_H
 #define TESTUTILS_H
 
+#include <QtGlobal>
+
+class QByteArray;
 class QObject;
 class QString;
 
@@ -41,6 +44,19 @@ namespace TestUtils {
 void waitForSignal(QObject *obj,
                    const char *signal,
                    int timeout = 1000);
+
+// Installs a copy of the language plugin probe as the plugin of language
+// in languagesDir, next to a data file of padding bytes. Returns its path.
+QString installLanguagePluginProbe(const QString &languagesDir,
+                                   const QString &language,
+                                   qint64 padding = 0);
+
+// Returns the instance of the plugin at pluginPath, which is the one a
+// language plugin pool creates too.
+QObject *languagePluginInstance(const QString &pluginPath);
+
+// Replaces the contents of fileName. Returns false if it cannot be written.
+bool writeFile(const QString &fileName, const QByteArray &contents);
 } // namespace TestUtils
 
 #endif
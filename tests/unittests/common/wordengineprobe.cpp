@@ -69,8 +69,7 @@ void WordEngineProbe::fetchCandidates(Model::Text *text)
         } else {
             // simulates case when there are some candidates, preedit
             // spelling correctnes is not important here.
-            WordCandidate candidate;
-            candidate.rLabel() = preedit + "d";
+            WordCandidate candidate(WordCandidate::SourcePrediction, preedit + "d");
             result << candidate;
             face = Model::Text::PreeditActive;
         }
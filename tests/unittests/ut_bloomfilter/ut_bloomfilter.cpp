@@ -0,0 +1,78 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "bloomfilter.h"
+
+#include <QtCore>
+#include <QtTest>
+
+class TestBloomFilter : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void testNull()
+    {
+        BloomFilter filter;
+        QVERIFY(filter.isNull());
+        QVERIFY(not filter.contains(QStringLiteral("word")));
+
+        filter.insert(QStringLiteral("word"));
+        QVERIFY(not filter.contains(QStringLiteral("word")));
+    }
+
+    Q_SLOT void testContains()
+    {
+        const int count = 20000;
+        BloomFilter filter(count, 0.01);
+        QVERIFY(not filter.isNull());
+        QVERIFY(filter.hashCount() >= 1);
+
+        for (int i = 0; i < count; ++i) {
+            filter.insert(QStringLiteral("word%1").arg(i));
+        }
+
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(filter.contains(QStringLiteral("word%1").arg(i)));
+        }
+
+        int false_positives = 0;
+        for (int i = count; i < 2 * count; ++i) {
+            if (filter.contains(QStringLiteral("word%1").arg(i))) {
+                ++false_positives;
+            }
+        }
+        QVERIFY2(false_positives < count / 50, qPrintable(QString::number(false_positives)));
+
+        filter.clear();
+        QVERIFY(filter.isNull());
+        QVERIFY(not filter.contains(QStringLiteral("word0")));
+    }
+};
+
+QTEST_MAIN(TestBloomFilter)
+#include "ut_bloomfilter.moc"
@@ -0,0 +1,250 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "dictionarycache.h"
+#include "dictionarycacheformat.h"
+#include "utils.h"
+
+#include <QtCore>
+#include <QtTest>
+
+#include <cstring>
+
+namespace {
+
+const char AffixFile[] =
+        "SET UTF-8\n"
+        "TRY esianrtolcdugmphbyfvkwz\n"
+        "NEEDAFFIX X\n"
+        "FORBIDDENWORD F\n"
+        "KEEPCASE K\n"
+        "\n"
+        "PFX U Y 1\n"
+        "PFX U 0 un .\n"
+        "\n"
+        "SFX S Y 3\n"
+        "SFX S y ies [^aeiou]y\n"
+        "SFX S 0 s [aeiou]y\n"
+        "SFX S 0 s [^y]\n"
+        "\n"
+        "SFX D N 1\n"
+        "SFX D 0 ed .\n";
+
+const char DictionaryFile[] =
+        "8\n"
+        "cry/SU\n"
+        "boy/S\n"
+        "do/U\n"
+        "walk/DSU\n"
+        "tie/XS\n"
+        "Paris\n"
+        "pH/K\n"
+        "runned/F\n";
+
+} // unnamed namespace
+
+Q_DECLARE_METATYPE(DictionaryCache::Verdict)
+
+class TestDictionaryCache : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+    QString m_aff_file;
+    QString m_dic_file;
+
+    Q_SLOT void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        QVERIFY(m_dir.isValid());
+
+        m_aff_file = m_dir.filePath(QStringLiteral("xx_XX.aff"));
+        m_dic_file = m_dir.filePath(QStringLiteral("xx_XX.dic"));
+        QVERIFY(TestUtils::writeFile(m_aff_file, AffixFile));
+        QVERIFY(TestUtils::writeFile(m_dic_file, DictionaryFile));
+
+        QFile::remove(DictionaryCache::cacheFileName(m_aff_file, m_dic_file));
+    }
+
+    Q_SLOT void testCheck_data()
+    {
+        QTest::addColumn<QString>("word");
+        QTest::addColumn<DictionaryCache::Verdict>("expected");
+
+        QTest::newRow("stem") << QStringLiteral("cry") << DictionaryCache::Correct;
+        QTest::newRow("suffix with strip") << QStringLiteral("cries") << DictionaryCache::Correct;
+        QTest::newRow("suffix condition") << QStringLiteral("boys") << DictionaryCache::Correct;
+        QTest::newRow("wrong suffix condition") << QStringLiteral("boies") << DictionaryCache::Incorrect;
+        QTest::newRow("stripped condition") << QStringLiteral("crys") << DictionaryCache::Incorrect;
+        QTest::newRow("prefix") << QStringLiteral("undo") << DictionaryCache::Correct;
+        QTest::newRow("cross product") << QStringLiteral("uncries") << DictionaryCache::Correct;
+        QTest::newRow("no cross product") << QStringLiteral("unwalked") << DictionaryCache::Incorrect;
+        QTest::newRow("affix without flag") << QStringLiteral("dos") << DictionaryCache::Incorrect;
+        QTest::newRow("need affix, bare") << QStringLiteral("tie") << DictionaryCache::Incorrect;
+        QTest::newRow("need affix, affixed") << QStringLiteral("ties") << DictionaryCache::Correct;
+        QTest::newRow("forbidden") << QStringLiteral("runned") << DictionaryCache::Incorrect;
+        QTest::newRow("capitalized") << QStringLiteral("Cries") << DictionaryCache::Correct;
+        QTest::newRow("upper case") << QStringLiteral("WALKED") << DictionaryCache::Correct;
+        QTest::newRow("proper noun") << QStringLiteral("Paris") << DictionaryCache::Correct;
+        QTest::newRow("proper noun, upper case") << QStringLiteral("PARIS") << DictionaryCache::Correct;
+        QTest::newRow("proper noun, lower case") << QStringLiteral("paris") << DictionaryCache::Incorrect;
+        QTest::newRow("keep case") << QStringLiteral("pH") << DictionaryCache::Correct;
+        QTest::newRow("keep case, upper case") << QStringLiteral("PH") << DictionaryCache::Incorrect;
+        QTest::newRow("hyphenated") << QStringLiteral("walk-in") << DictionaryCache::Unknown;
+        QTest::newRow("mixed case") << QStringLiteral("wALK") << DictionaryCache::Unknown;
+    }
+
+    Q_SLOT void testCheck()
+    {
+        QFETCH(QString, word);
+        QFETCH(DictionaryCache::Verdict, expected);
+
+        DictionaryCache cache;
+        QVERIFY(cache.open(m_aff_file, m_dic_file));
+        QVERIFY(cache.isExact());
+        QCOMPARE(cache.check(word), expected);
+    }
+
+    Q_SLOT void testWords()
+    {
+        DictionaryCache cache;
+        QVERIFY(cache.open(m_aff_file, m_dic_file));
+
+        const QStringList expected = {
+            QStringLiteral("Paris"), QStringLiteral("boy"), QStringLiteral("boys"),
+            QStringLiteral("cries"), QStringLiteral("cry"), QStringLiteral("do"),
+            QStringLiteral("pH"), QStringLiteral("ties"), QStringLiteral("uncries"),
+            QStringLiteral("uncry"), QStringLiteral("undo"), QStringLiteral("unwalk"),
+            QStringLiteral("unwalks"), QStringLiteral("walk"), QStringLiteral("walked"),
+            QStringLiteral("walks")
+        };
+        const QStringList words = cache.words(100);
+        QCOMPARE(words, expected);
+
+        for (const QString &word : words) {
+            QCOMPARE(cache.check(word), DictionaryCache::Correct);
+        }
+
+        QVERIFY(cache.words(expected.size() - 1).isEmpty());
+    }
+
+    Q_SLOT void testReuseAndInvalidate()
+    {
+        DictionaryCache cache;
+        QVERIFY(cache.open(m_aff_file, m_dic_file));
+
+        const QString file_name = DictionaryCache::cacheFileName(m_aff_file, m_dic_file);
+        QCOMPARE(cache.fileName(), file_name);
+        QVERIFY(file_name.startsWith(DictionaryCache::cacheDirectory()));
+        const QDateTime compiled = QFileInfo(file_name).lastModified();
+
+        DictionaryCache again;
+        QVERIFY(again.open(m_aff_file, m_dic_file));
+        QCOMPARE(QFileInfo(file_name).lastModified(), compiled);
+        QCOMPARE(again.check(QStringLiteral("maliit")), DictionaryCache::Incorrect);
+
+        // A changed dictionary is compiled again; the old mapping stays valid.
+        QVERIFY(TestUtils::writeFile(m_dic_file, QByteArray(DictionaryFile) + "maliit/S\n"));
+        DictionaryCache updated;
+        QVERIFY(updated.open(m_aff_file, m_dic_file));
+        QCOMPARE(updated.check(QStringLiteral("maliits")), DictionaryCache::Correct);
+        QCOMPARE(cache.check(QStringLiteral("cries")), DictionaryCache::Correct);
+
+        QVERIFY(TestUtils::writeFile(m_dic_file, DictionaryFile));
+    }
+
+    Q_SLOT void testDamagedCache_data()
+    {
+        QTest::addColumn<bool>("flags");
+
+        QTest::newRow("stem offsets") << false;
+        QTest::newRow("flag offsets") << true;
+    }
+
+    Q_SLOT void testDamagedCache()
+    {
+        QFETCH(bool, flags);
+
+        const QString file_name = DictionaryCache::cacheFileName(m_aff_file, m_dic_file);
+        {
+            DictionaryCache cache;
+            QVERIFY(cache.open(m_aff_file, m_dic_file));
+        }
+
+        QFile file(file_name);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QByteArray compiled = file.readAll();
+        file.close();
+
+        // Make the second entry end before it starts; the last offset, the
+        // only one checked before, stays in range.
+        DictionaryFormat::Header header;
+        std::memcpy(&header, compiled.constData(), sizeof(header));
+        QVERIFY(header.stemCount >= 3);
+        const quint64 offset = flags ? header.flagOffsetsOffset : header.stemOffsetsOffset;
+        quint32 ends[3];
+        std::memcpy(ends, compiled.constData() + offset, sizeof(ends));
+        ends[1] = ends[2] + 1;
+        QByteArray damaged = compiled;
+        std::memcpy(damaged.data() + offset, ends, sizeof(ends));
+        QVERIFY(TestUtils::writeFile(file_name, damaged));
+
+        // The damaged file is compiled again instead of being read.
+        DictionaryCache cache;
+        QVERIFY(cache.open(m_aff_file, m_dic_file));
+        QCOMPARE(cache.check(QStringLiteral("cries")), DictionaryCache::Correct);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), compiled);
+    }
+
+    Q_SLOT void testInexact()
+    {
+        const QString aff_file = m_dir.filePath(QStringLiteral("yy_YY.aff"));
+        const QString dic_file = m_dir.filePath(QStringLiteral("yy_YY.dic"));
+        QVERIFY(TestUtils::writeFile(aff_file, QByteArray(AffixFile) + "COMPOUNDFLAG C\n"));
+        QVERIFY(TestUtils::writeFile(dic_file, DictionaryFile));
+
+        DictionaryCache cache;
+        QVERIFY(cache.open(aff_file, dic_file));
+        QVERIFY(not cache.isExact());
+        QCOMPARE(cache.check(QStringLiteral("cries")), DictionaryCache::Correct);
+        QCOMPARE(cache.check(QStringLiteral("crys")), DictionaryCache::Unknown);
+    }
+
+    Q_SLOT void testMissingDictionary()
+    {
+        DictionaryCache cache;
+        QVERIFY(not cache.open(m_dir.filePath(QStringLiteral("none.aff")),
+                               m_dir.filePath(QStringLiteral("none.dic"))));
+        QVERIFY(not cache.isOpen());
+        QCOMPARE(cache.check(QStringLiteral("cry")), DictionaryCache::Unknown);
+    }
+};
+
+QTEST_MAIN(TestDictionaryCache)
+#include "ut_dictionarycache.moc"
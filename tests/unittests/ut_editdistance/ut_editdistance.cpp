@@ -0,0 +1,164 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "logic/editdistance.h"
+
+#include <QtCore>
+#include <QtTest>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+namespace {
+
+// Straightforward full-matrix Levenshtein distance to check against.
+int referenceDistance(const QString &first, const QString &second)
+{
+    QVector<QVector<int> > d(first.size() + 1, QVector<int>(second.size() + 1));
+
+    for (int i = 0; i <= first.size(); ++i) {
+        d[i][0] = i;
+    }
+    for (int j = 0; j <= second.size(); ++j) {
+        d[0][j] = j;
+    }
+
+    for (int i = 1; i <= first.size(); ++i) {
+        for (int j = 1; j <= second.size(); ++j) {
+            const int cost = (first.at(i - 1) == second.at(j - 1)) ? 0 : 1;
+            d[i][j] = qMin(qMin(d[i - 1][j] + 1, d[i][j - 1] + 1), d[i - 1][j - 1] + cost);
+        }
+    }
+
+    return d[first.size()][second.size()];
+}
+
+QString randomWord(int maxLength)
+{
+    static const QString alphabet = QString::fromUtf8("abcdeé中二");
+    const int length = qrand() % (maxLength + 1);
+
+    QString word;
+    for (int i = 0; i < length; ++i) {
+        word.append(alphabet.at(qrand() % alphabet.size()));
+    }
+    return word;
+}
+
+QStringList candidateList()
+{
+    return QStringList() << "hello" << "help" << "helmet" << "held" << "hell"
+                         << "yellow" << "shell" << "hero" << "heel" << "halo";
+}
+
+} // namespace
+
+class TestEditDistance : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void testDistance_data()
+    {
+        QTest::addColumn<QString>("first");
+        QTest::addColumn<QString>("second");
+        QTest::addColumn<int>("distance");
+
+        QTest::newRow("equal") << QString("keyboard") << QString("keyboard") << 0;
+        QTest::newRow("empty pattern") << QString() << QString("abc") << 3;
+        QTest::newRow("empty text") << QString("abc") << QString() << 3;
+        QTest::newRow("substitution") << QString("kitten") << QString("sitten") << 1;
+        QTest::newRow("kitten sitting") << QString("kitten") << QString("sitting") << 3;
+        QTest::newRow("insertion") << QString("helo") << QString("hello") << 1;
+        QTest::newRow("deletion") << QString("hello") << QString("helo") << 1;
+        QTest::newRow("non-latin") << QString::fromUtf8("你好吗") << QString::fromUtf8("你们好") << 2;
+        QTest::newRow("64 code units") << QString(64, 'a') << QString(63, 'a') + "b" << 1;
+        QTest::newRow("65 code units") << QString(65, 'a') << QString(64, 'a') << 1;
+    }
+
+    Q_SLOT void testDistance()
+    {
+        QFETCH(QString, first);
+        QFETCH(QString, second);
+        QFETCH(int, distance);
+
+        QCOMPARE(EditDistance::distance(first, second), distance);
+        QCOMPARE(EditDistance(first).distance(second.constData(), second.size()), distance);
+    }
+
+    Q_SLOT void testAgainstReference()
+    {
+        qsrand(1);
+
+        for (int round = 0; round < 500; ++round) {
+            const QString pattern = randomWord(round % 5 == 0 ? 80 : 16);
+            const EditDistance editDistance(pattern);
+
+            QStringList texts;
+            for (int index = 0; index < round % 11; ++index) {
+                texts.append(randomWord(round % 5 == 0 ? 80 : 16));
+            }
+
+            QVector<int> results(texts.size());
+            editDistance.distances(texts, results.data());
+
+            for (int index = 0; index < texts.size(); ++index) {
+                const int expected = referenceDistance(pattern, texts.at(index));
+                QCOMPARE(editDistance.distance(texts.at(index)), expected);
+                QCOMPARE(results.at(index), expected);
+            }
+        }
+    }
+
+    Q_SLOT void benchmarkDistance()
+    {
+        int distance = 0;
+
+        QBENCHMARK {
+            distance = EditDistance::distance(QStringLiteral("helo"), QStringLiteral("hello"));
+        }
+
+        QCOMPARE(distance, 1);
+    }
+
+    Q_SLOT void benchmarkDistances()
+    {
+        const QStringList texts = candidateList();
+        QVector<int> results(texts.size());
+
+        QBENCHMARK {
+            EditDistance(QStringLiteral("helo")).distances(texts, results.data());
+        }
+
+        QCOMPARE(results.at(0), 1);
+    }
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+QTEST_MAIN(MaliitKeyboard::Logic::TestEditDistance)
+#include "ut_editdistance.moc"
@@ -155,6 +155,29 @@ private:
         QCOMPARE(host.commitStringHistory(), expected_commit_history);
     }
 
+    Q_SLOT void testPreeditCoalescing()
+    {
+        Editor editor(EditorOptions(), new Model::Text, new Logic::WordEngineProbe);
+        InputMethodHostProbe host;
+        editor.setHost(&host);
+        editor.setPreeditEnabled(true);
+
+        appendInput(&editor, "abc");
+
+        // Nothing is sent before control returns to the event loop, and
+        // then only the last preedit.
+        QVERIFY(not host.preeditStringSent());
+        QCoreApplication::processEvents();
+        QCOMPARE(host.lastPreeditString(), QString("abc"));
+        QCOMPARE(editor.sentPreeditUpdates(), quint64(1));
+        QVERIFY(editor.suppressedPreeditUpdates() >= 2);
+
+        // The pending preedit reaches the host before the commit does.
+        appendInput(&editor, "d ");
+        QCOMPARE(host.commitStringHistory(), QString("abcd "));
+        QCOMPARE(editor.sentPreeditUpdates(), quint64(2));
+    }
+
     Q_SLOT void testAutoCaps_data()
     {
         QTest::addColumn<bool>("enable_auto_correct");
@@ -254,6 +277,58 @@ private:
         QCOMPARE(auto_caps_activated_spy.count(), expected_auto_caps_activated_count);
     }
 
+    Q_SLOT void testNextWordCandidates_data()
+    {
+        QTest::addColumn<bool>("enable_auto_caps");
+        QTest::addColumn<QString>("input");
+        QTest::addColumn<int>("expected_request_count");
+        QTest::addColumn<QStringList>("expected_context");
+        QTest::addColumn<bool>("expected_capitalize");
+
+        QTest::newRow("no word completed")
+                << true << "Hello." << 0 << QStringList() << false;
+        QTest::newRow("word")
+                << true << "Hello " << 1 << (QStringList() << "Hello") << false;
+        QTest::newRow("comma")
+                << true << "Hello, " << 1 << (QStringList() << "Hello") << false;
+        QTest::newRow("end of sentence")
+                << true << "Hello. " << 1 << QStringList() << true;
+        QTest::newRow("end of sentence, autocaps disabled")
+                << false << "Hello. " << 1 << QStringList() << false;
+        QTest::newRow("word after end of sentence")
+                << true << "Hello. World " << 2 << (QStringList() << "World") << false;
+    }
+
+    Q_SLOT void testNextWordCandidates()
+    {
+        QFETCH(bool, enable_auto_caps);
+        QFETCH(QString, input);
+        QFETCH(int, expected_request_count);
+        QFETCH(QStringList, expected_context);
+        QFETCH(bool, expected_capitalize);
+
+        Logic::WordEngineProbe *word_engine = new Logic::WordEngineProbe;
+        Editor editor(EditorOptions(), new Model::Text, word_engine);
+        QSignalSpy requests(word_engine, &Logic::WordEngineProbe::nextWordCandidatesRequested);
+
+        InputMethodHostProbe host;
+        editor.setHost(&host);
+
+        editor.wordEngine()->setWordPredictionEnabled(true);
+        editor.wordEngine()->setEnabled(true);
+        editor.setPreeditEnabled(true);
+        editor.setAutoCapsEnabled(enable_auto_caps);
+
+        appendInput(&editor, input);
+
+        // Asked once per committed word, for the words following it.
+        QCOMPARE(requests.count(), expected_request_count);
+        if (expected_request_count > 0) {
+            QCOMPARE(requests.last().at(0).toStringList(), expected_context);
+            QCOMPARE(requests.last().at(1).toBool(), expected_capitalize);
+        }
+    }
+
     Q_SLOT void testRegressionIssue2()
     {
         QSKIP("Test failing, but working correctly in live keyboard…");
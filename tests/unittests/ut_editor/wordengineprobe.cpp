@@ -47,36 +47,6 @@ bool MockLanguageFeatures::activateAutoCaps(const QString &preedit) const
     return false;
 }
 
-bool MockLanguageFeatures::isSeparator(const QString &text) const
-{
-    static const QString separators = QString::fromUtf8(",.!?:;\r\n");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (separators.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
-bool MockLanguageFeatures::isSymbol(const QString &text) const
-{
-    static const QString symbols = QString::fromUtf8("#()[]");
-
-    if (text.isEmpty()) {
-        return false;
-    }
-
-    if (symbols.contains(text.right(1))) {
-        return true;
-    }
-
-    return false;
-}
-
 namespace MaliitKeyboard {
 namespace Logic {
 
@@ -119,6 +89,13 @@ void WordEngineProbe::fetchCandidates(Model::Text *text)
     Q_EMIT(candidatesChanged(result));
 }
 
+//! \brief Reports the request, without any candidates.
+void WordEngineProbe::fetchNextWordCandidates(Model::Text *text, bool capitalize)
+{
+    const MockLanguageFeatures features;
+    Q_EMIT nextWordCandidatesRequested(text->contextWords(features.characterClasses()), capitalize);
+}
+
 AbstractLanguageFeatures* WordEngineProbe::languageFeature()
 {
     return new MockLanguageFeatures();
@@ -39,11 +39,14 @@
 class MockLanguageFeatures : public AbstractLanguageFeatures
 {
 public:
-    explicit MockLanguageFeatures() {}
+    explicit MockLanguageFeatures()
+    {
+        addCharacters(MaliitKeyboard::Logic::CharacterClassTable::SentenceBreak, QString::fromUtf8("!.?\r\n"));
+        addCharacters(MaliitKeyboard::Logic::CharacterClassTable::Separator, QString::fromUtf8(",.!?:;\r\n"));
+        addCharacters(MaliitKeyboard::Logic::CharacterClassTable::Symbol, QString::fromUtf8("#()[]"));
+    }
     virtual ~MockLanguageFeatures() {}
 
-    virtual bool isSeparator(const QString &text) const;
-    virtual bool isSymbol(const QString &text) const;
     virtual bool alwaysShowSuggestions() const { return false; }
     virtual bool autoCapsAvailable() const { return true; }
     virtual bool activateAutoCaps(const QString &preedit) const;
@@ -73,8 +76,11 @@ public:
 
     Q_SLOT void updateQmlCandidates(QStringList) override {};
 
+    Q_SIGNAL void nextWordCandidatesRequested(const QStringList &context, bool capitalize);
+
 private:
     virtual void fetchCandidates(Model::Text *text);
+    void fetchNextWordCandidates(Model::Text *text, bool capitalize) override;
 
     QHash<QString, QString> candidates;
 };
@@ -0,0 +1,146 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "plugin/hoststate.h"
+
+#include <inputmethodhostprobe.h>
+
+#include <QtCore>
+#include <QtTest>
+
+namespace {
+
+//! Reports whatever state the test sets up.
+class HostStub
+    : public InputMethodHostProbe
+{
+public:
+    QString text;
+    int position = 0;
+    bool textValid = true;
+    bool selection = false;
+    bool prediction = true;
+    int type = 0;
+
+    int contentType(bool &valid) override { valid = true; return type; }
+    bool predictionEnabled(bool &valid) override { valid = true; return prediction; }
+    bool hasSelection(bool &valid) override { valid = true; return selection; }
+
+    bool surroundingText(QString &surrounding, int &cursor_position) override
+    {
+        if (not textValid) {
+            return false;
+        }
+
+        surrounding = text;
+        cursor_position = position;
+        return true;
+    }
+};
+
+} // unnamed namespace
+
+namespace MaliitKeyboard {
+
+class TestHostState : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void testCapture()
+    {
+        HostStub host;
+        host.text = QString("Hello wor");
+        host.position = 9;
+        host.selection = true;
+        host.type = 2;
+
+        const HostState state = HostState::capture(&host);
+        QVERIFY(state.surroundingTextValid());
+        QCOMPARE(state.surroundingText(), QString("Hello wor"));
+        QCOMPARE(state.cursorPosition(), 9);
+        QVERIFY(state.hasSelectionValid());
+        QVERIFY(state.hasSelection());
+        QVERIFY(state.predictionValid());
+        QVERIFY(state.predictionEnabled());
+        QVERIFY(state.contentTypeValid());
+        QCOMPARE(state.contentType(), 2);
+
+        // Nothing was seen before the first update.
+        QCOMPARE(state.changesFrom(HostState()),
+                 HostState::SelectionChanged | HostState::PredictionChanged
+                 | HostState::ContentTypeChanged | HostState::SurroundingTextChanged
+                 | HostState::CursorPositionChanged);
+    }
+
+    Q_SLOT void testChanges()
+    {
+        HostStub host;
+        host.text = QString("Hello");
+        host.position = 5;
+
+        HostState previous = HostState::capture(&host);
+        HostState state = HostState::capture(&host);
+        QCOMPARE(state.changesFrom(previous), 0);
+
+        host.position = 2;
+        previous = state;
+        state = HostState::capture(&host);
+        QCOMPARE(state.changesFrom(previous), int(HostState::CursorPositionChanged));
+
+        host.text = QString("Help");
+        host.selection = true;
+        previous = state;
+        state = HostState::capture(&host);
+        QCOMPARE(state.changesFrom(previous),
+                 HostState::SurroundingTextChanged | HostState::SelectionChanged);
+
+        host.prediction = false;
+        host.type = 1;
+        previous = state;
+        state = HostState::capture(&host);
+        QCOMPARE(state.changesFrom(previous),
+                 HostState::PredictionChanged | HostState::ContentTypeChanged);
+
+        // Losing the surrounding text changes both the text and the cursor.
+        host.textValid = false;
+        previous = state;
+        state = HostState::capture(&host);
+        QVERIFY(not state.surroundingTextValid());
+        QCOMPARE(state.changesFrom(previous),
+                 HostState::SurroundingTextChanged | HostState::CursorPositionChanged);
+
+        previous = state;
+        state = HostState::capture(&host);
+        QCOMPARE(state.changesFrom(previous), 0);
+    }
+};
+
+} // namespace MaliitKeyboard
+
+QTEST_MAIN(MaliitKeyboard::TestHostState)
+#include "ut_hoststate.moc"
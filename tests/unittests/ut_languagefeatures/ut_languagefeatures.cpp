@@ -65,6 +65,83 @@ private:
         QString result = m_languageFeatures.appendixForReplacedPreedit(preedit);
         QCOMPARE(result, expectedResult);
     }
+
+    Q_SLOT void testCharacterClasses_data()
+    {
+        QTest::addColumn<QString>("text");
+        QTest::addColumn<bool>("separator");
+        QTest::addColumn<bool>("symbol");
+
+        QTest::newRow("empty") << QString() << false << false;
+        QTest::newRow("letter") << QString("word") << false << false;
+        QTest::newRow("comma") << QString("word,") << true << false;
+        QTest::newRow("ellipsis") << QString::fromUtf8("word…") << true << false;
+        QTest::newRow("newline") << QString("\n") << true << false;
+        QTest::newRow("digit") << QString("4") << false << true;
+        QTest::newRow("euro") << QString::fromUtf8("€") << false << true;
+        QTest::newRow("quote") << QString::fromUtf8("“") << false << true;
+        QTest::newRow("only last counts") << QString(",a") << false << false;
+        QTest::newRow("astral") << QString::fromUtf8("😀") << false << false;
+    }
+
+    Q_SLOT void testCharacterClasses()
+    {
+        QFETCH(QString, text);
+        QFETCH(bool, separator);
+        QFETCH(bool, symbol);
+
+        QCOMPARE(m_languageFeatures.isSeparator(text), separator);
+        QCOMPARE(m_languageFeatures.isSymbol(text), symbol);
+    }
+
+    Q_SLOT void testActivateAutoCaps_data()
+    {
+        QTest::addColumn<QString>("text");
+        QTest::addColumn<bool>("expectedResult");
+
+        QTest::newRow("empty") << QString() << false;
+        QTest::newRow("lone space") << QString(" ") << true;
+        QTest::newRow("after full stop") << QString("Done. ") << true;
+        QTest::newRow("after question") << QString("Why? ") << true;
+        QTest::newRow("new line") << QString("Hi\n ") << true;
+        QTest::newRow("no space") << QString("Done.") << false;
+        QTest::newRow("after comma") << QString("Well, ") << false;
+        QTest::newRow("after word") << QString("Hello ") << false;
+    }
+
+    Q_SLOT void testActivateAutoCaps()
+    {
+        QFETCH(QString, text);
+        QFETCH(bool, expectedResult);
+
+        QCOMPARE(m_languageFeatures.activateAutoCaps(text), expectedResult);
+    }
+
+    Q_SLOT void testCharacterClassTable()
+    {
+        Logic::CharacterClassTable table;
+        table.add(Logic::CharacterClassTable::Separator, QString::fromUtf8(",😀"));
+        table.add(Logic::CharacterClassTable::Symbol, QString::fromUtf8(",€"));
+
+        QCOMPARE(table.classes(','), int(Logic::CharacterClassTable::Separator
+                                         | Logic::CharacterClassTable::Symbol));
+        QCOMPARE(table.classes(0x20ac), int(Logic::CharacterClassTable::Symbol));
+        QCOMPARE(table.classes(0x1f600), int(Logic::CharacterClassTable::Separator));
+        QCOMPARE(table.classes('a'), 0);
+        QCOMPARE(table.classes(0x20ad), 0);
+        QCOMPARE(table.classes(0x1f601), 0);
+
+        QCOMPARE(table.classesOfLast(QString::fromUtf8("a😀")), int(Logic::CharacterClassTable::Separator));
+        QCOMPARE(table.classesOfLast(QString()), 0);
+
+        QVERIFY(Logic::CharacterClassTable::isWordCharacter(QChar('a')));
+        QVERIFY(Logic::CharacterClassTable::isWordCharacter(QChar('7')));
+        QVERIFY(Logic::CharacterClassTable::isWordCharacter(QChar('_')));
+        QVERIFY(Logic::CharacterClassTable::isWordCharacter(QChar(0x0301)));
+        QVERIFY(not Logic::CharacterClassTable::isWordCharacter(QChar('-')));
+        QVERIFY(not Logic::CharacterClassTable::isWordCharacter(QChar(' ')));
+        QVERIFY(not Logic::CharacterClassTable::isWordCharacter(QChar()));
+    }
 };
 
 } // namespace
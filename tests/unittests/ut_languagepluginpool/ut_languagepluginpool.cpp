@@ -0,0 +1,249 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "logic/languagepluginpool.h"
+#include "utils.h"
+
+#include <QtCore>
+#include <QtTest>
+
+#include <limits>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+namespace {
+
+// Every probe is the same library next to the same amount of data, so all
+// of them are estimated at the same size.
+const qint64 PADDING = 4096;
+
+//! Loads pluginPath, waiting for it if needed, and activates it.
+bool loadPlugin(LanguagePluginPool *pool, const QString &pluginPath)
+{
+    if (not pool->load(pluginPath)) {
+        QSignalSpy loaded(pool, &LanguagePluginPool::pluginLoaded);
+        if (not loaded.wait(5000) || loaded.first().first().toString() != pluginPath) {
+            return false;
+        }
+    }
+
+    pool->activate(pluginPath);
+    return true;
+}
+
+} // unnamed namespace
+
+class TestLanguagePluginPool : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+    QString m_a;
+    QString m_b;
+    QString m_c;
+    QString m_broken;
+
+    Q_SLOT void initTestCase()
+    {
+        QVERIFY(m_dir.isValid());
+        // Keeps the size estimate from finding the system's dictionaries.
+        qputenv("KEYBOARD_PREFIX_PATH", m_dir.path().toUtf8());
+
+        const QString languages = m_dir.filePath(QStringLiteral("languages"));
+        m_a = TestUtils::installLanguagePluginProbe(languages, QStringLiteral("probe_a"), PADDING);
+        m_b = TestUtils::installLanguagePluginProbe(languages, QStringLiteral("probe_b"), PADDING);
+        m_c = TestUtils::installLanguagePluginProbe(languages, QStringLiteral("probe_c"), PADDING);
+        QVERIFY(not m_a.isEmpty() && not m_b.isEmpty() && not m_c.isEmpty());
+
+        QVERIFY(QDir().mkpath(languages + QStringLiteral("/probe_x")));
+        m_broken = languages + QStringLiteral("/probe_x/libprobe_xplugin.so");
+        QFile broken(m_broken);
+        QVERIFY(broken.open(QIODevice::WriteOnly));
+        QVERIFY(broken.write("not a library") > 0);
+    }
+
+    Q_SLOT void testResidentLookup()
+    {
+        LanguagePluginPool pool;
+        QSignalSpy loaded(&pool, &LanguagePluginPool::pluginLoaded);
+
+        QVERIFY(not pool.isResident(m_a));
+        QVERIFY(not pool.load(m_a));
+        QVERIFY(loaded.wait(5000));
+        QCOMPARE(loaded.takeFirst().first().toString(), m_a);
+
+        LanguagePluginInterface *plugin = pool.plugin(m_a);
+        QVERIFY(plugin);
+        pool.activate(m_a);
+
+        // A resident plugin is a lookup, without loading or signals.
+        QVERIFY(pool.load(m_a));
+        QCOMPARE(pool.plugin(m_a), plugin);
+        QTest::qWait(50);
+        QVERIFY(loaded.isEmpty());
+
+        // The probe has nothing to load for a language.
+        QVERIFY(pool.setLanguage(m_a, QStringLiteral("xx")));
+        QVERIFY(pool.isLanguageReady(m_a, QStringLiteral("xx")));
+        QCOMPARE(TestUtils::languagePluginInstance(m_a)->property("language").toString(),
+                 QStringLiteral("xx"));
+    }
+
+    Q_SLOT void testLanguageReady()
+    {
+        LanguagePluginPool pool;
+        QVERIFY(loadPlugin(&pool, m_a));
+        TestUtils::languagePluginInstance(m_a)->setProperty("languageDelay", 10);
+
+        QSignalSpy ready(&pool, &LanguagePluginPool::languageReady);
+        QVERIFY(not pool.setLanguage(m_a, QStringLiteral("xx")));
+        QVERIFY(not pool.isLanguageReady(m_a, QStringLiteral("xx")));
+
+        QVERIFY(ready.wait(5000));
+        QCOMPARE(ready.first().at(0).toString(), m_a);
+        QCOMPARE(ready.first().at(1).toString(), QStringLiteral("xx"));
+        QVERIFY(pool.isLanguageReady(m_a, QStringLiteral("xx")));
+
+        // Setting the same language again loads nothing.
+        QVERIFY(pool.setLanguage(m_a, QStringLiteral("xx")));
+    }
+
+    Q_SLOT void testEviction()
+    {
+        LanguagePluginPool pool;
+        QVERIFY(loadPlugin(&pool, m_a));
+
+        const qint64 size = pool.residentSize();
+        QVERIFY(size >= PADDING);
+        pool.setMemoryBudget(2 * size + size / 2);
+
+        QVERIFY(loadPlugin(&pool, m_b));
+        QVERIFY(pool.isResident(m_a));
+
+        // Activating a third plugin evicts the least recently used one.
+        QVERIFY(loadPlugin(&pool, m_c));
+        QVERIFY(not pool.isResident(m_a));
+        QVERIFY(pool.isResident(m_b));
+        QVERIFY(pool.isResident(m_c));
+        QCOMPARE(pool.residentSize(), 2 * size);
+
+        pool.activate(m_b);
+        QVERIFY(loadPlugin(&pool, m_a));
+        QVERIFY(not pool.isResident(m_c));
+        QVERIFY(pool.isResident(m_b));
+
+        // The active plugin stays, even over budget.
+        pool.setMemoryBudget(0);
+        QVERIFY(pool.isResident(m_a));
+        QVERIFY(not pool.isResident(m_b));
+        QCOMPARE(pool.residentSize(), size);
+    }
+
+    Q_SLOT void testWarmUpAndUnload()
+    {
+        LanguagePluginPool pool;
+        pool.setMemoryBudget(std::numeric_limits<qint64>::max());
+        pool.setWarmUpDelay(0);
+        QVERIFY(loadPlugin(&pool, m_a));
+
+        QSignalSpy warmed(&pool, &LanguagePluginPool::pluginWarmedUp);
+        QSignalSpy loaded(&pool, &LanguagePluginPool::pluginLoaded);
+        pool.setEnabledPlugins(QStringList() << m_a << m_b << m_c);
+
+        // One at a time, in the order they are enabled, each with the
+        // language named after its directory.
+        QTRY_COMPARE_WITH_TIMEOUT(warmed.count(), 2, 5000);
+        QCOMPARE(warmed.at(0).first().toString(), m_b);
+        QCOMPARE(warmed.at(1).first().toString(), m_c);
+        QVERIFY(pool.isLanguageReady(m_b, QStringLiteral("probe_b")));
+        QVERIFY(pool.isLanguageReady(m_c, QStringLiteral("probe_c")));
+        QVERIFY(loaded.isEmpty());
+
+        // Plugins no longer enabled are unloaded, except the active one.
+        pool.setEnabledPlugins(QStringList() << m_b);
+        QVERIFY(pool.isResident(m_a));
+        QVERIFY(pool.isResident(m_b));
+        QVERIFY(not pool.isResident(m_c));
+    }
+
+    Q_SLOT void testDiscardDuringPreload()
+    {
+        LanguagePluginPool pool;
+        QSignalSpy loaded(&pool, &LanguagePluginPool::pluginLoaded);
+        QSignalSpy failed(&pool, &LanguagePluginPool::pluginFailed);
+
+        QVERIFY(not pool.load(m_a));
+        QVERIFY(not pool.load(m_b));
+
+        // a is given up while it loads; b, which was asked for last, is
+        // kept for the switch even though it is not enabled.
+        pool.setEnabledPlugins(QStringList());
+
+        QVERIFY(loaded.wait(5000));
+        QCOMPARE(loaded.count(), 1);
+        QCOMPARE(loaded.first().first().toString(), m_b);
+        QVERIFY(failed.isEmpty());
+        QVERIFY(not pool.isResident(m_a));
+        QVERIFY(pool.isResident(m_b));
+    }
+
+    Q_SLOT void testAcquireWhilePreloading()
+    {
+        LanguagePluginPool pool;
+        QSignalSpy loaded(&pool, &LanguagePluginPool::pluginLoaded);
+
+        QVERIFY(not pool.load(m_a));
+        LanguagePluginInterface *plugin = pool.acquire(m_a, QString());
+        QVERIFY(plugin);
+        QCOMPARE(pool.plugin(m_a), plugin);
+
+        // The preload finishes without creating another instance.
+        QTest::qWait(100);
+        QVERIFY(loaded.isEmpty());
+        QCOMPARE(pool.plugin(m_a), plugin);
+    }
+
+    Q_SLOT void testFailedPlugin()
+    {
+        LanguagePluginPool pool;
+        QSignalSpy failed(&pool, &LanguagePluginPool::pluginFailed);
+
+        QVERIFY(not pool.load(m_broken));
+        QVERIFY(failed.wait(5000));
+        QCOMPARE(failed.first().first().toString(), m_broken);
+        QVERIFY(not pool.isResident(m_broken));
+        QVERIFY(not pool.acquire(m_broken, QString()));
+        QVERIFY(not pool.errorString().isEmpty());
+    }
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+QTEST_MAIN(MaliitKeyboard::Logic::TestLanguagePluginPool)
+#include "ut_languagepluginpool.moc"
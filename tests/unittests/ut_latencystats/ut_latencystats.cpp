@@ -0,0 +1,144 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "logic/latencystats.h"
+
+#include <QtCore>
+#include <QtTest>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+class TestLatencyStats : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void init()
+    {
+        LatencyStats::instance()->reset();
+    }
+
+    Q_SLOT void testBuckets()
+    {
+        LatencyHistogram histogram;
+
+        histogram.record(500);          // < 1us
+        histogram.record(1000);         // 1us
+        histogram.record(3000);         // [2, 4) us
+        histogram.record(-1);           // clock skew counts as 0
+
+        QCOMPARE(histogram.count(), quint64(4));
+        QCOMPARE(histogram.bucket(0), quint64(2));
+        QCOMPARE(histogram.bucket(1), quint64(1));
+        QCOMPARE(histogram.bucket(2), quint64(1));
+        QCOMPARE(histogram.maximum(), qint64(3));
+        QCOMPARE(histogram.mean(), qint64(1));
+
+        histogram.reset();
+        QCOMPARE(histogram.count(), quint64(0));
+        QCOMPARE(histogram.percentile(0.5), qint64(0));
+    }
+
+    Q_SLOT void testPercentiles()
+    {
+        LatencyHistogram histogram;
+
+        for (int i = 0; i < 98; ++i) {
+            histogram.record(100 * 1000);       // 100us, bucket [64, 128)
+        }
+        histogram.record(10 * 1000 * 1000);     // 10ms
+        histogram.record(20 * 1000 * 1000);     // 20ms
+
+        QCOMPARE(histogram.percentile(0.5), qint64(128));
+        QCOMPARE(histogram.percentile(0.9), qint64(128));
+        QCOMPARE(histogram.percentile(0.99), qint64(16384));
+        QCOMPARE(histogram.percentile(1.0), qint64(20000));
+    }
+
+    Q_SLOT void testSharedInstance()
+    {
+        LatencyStats *stats = LatencyStats::instance();
+
+        QCOMPARE(LatencyStats::instance(), stats);
+        QVERIFY(qApp->property("_maliit_keyboard_latency_stats").isValid());
+    }
+
+    Q_SLOT void testMacros()
+    {
+        const LatencyHistogram &scope(LatencyStats::instance()->histogram(LatencyStats::RibbonUpdate));
+        const LatencyHistogram &since(LatencyStats::instance()->histogram(LatencyStats::KeystrokeToRibbon));
+
+        MALIIT_LATENCY_KEYSTROKE();
+        {
+            MALIIT_LATENCY_SCOPE(RibbonUpdate);
+            QTest::qSleep(2);
+        }
+        MALIIT_LATENCY_SINCE_KEYSTROKE(KeystrokeToRibbon);
+
+        QCOMPARE(scope.count(), quint64(1));
+        QVERIFY(scope.maximum() >= 1000);
+        QCOMPARE(since.count(), quint64(1));
+        QVERIFY(since.maximum() >= scope.maximum());
+    }
+
+    Q_SLOT void testOncePerKeystroke()
+    {
+        const LatencyHistogram &since(LatencyStats::instance()->histogram(LatencyStats::KeystrokeToRibbon));
+
+        // Nothing to measure from before the first keystroke.
+        MALIIT_LATENCY_SINCE_KEYSTROKE(KeystrokeToRibbon);
+        QCOMPARE(since.count(), quint64(0));
+
+        // Only the first of several ribbon updates counts.
+        MALIIT_LATENCY_KEYSTROKE();
+        MALIIT_LATENCY_SINCE_KEYSTROKE(KeystrokeToRibbon);
+        MALIIT_LATENCY_SINCE_KEYSTROKE(KeystrokeToRibbon);
+        QCOMPARE(since.count(), quint64(1));
+
+        MALIIT_LATENCY_KEYSTROKE();
+        MALIIT_LATENCY_SINCE_KEYSTROKE(KeystrokeToRibbon);
+        QCOMPARE(since.count(), quint64(2));
+    }
+
+    Q_SLOT void testDump()
+    {
+        LatencyStats::instance()->record(LatencyStats::ComputeCandidates, 5000);
+
+        const QStringList lines = LatencyStats::instance()->dump().split('\n', QString::SkipEmptyParts);
+
+        QCOMPARE(lines.size(), int(LatencyStats::StageCount) + 1);
+        QVERIFY(lines.at(0).startsWith("stage"));
+        QVERIFY(lines.at(LatencyStats::ComputeCandidates + 1).startsWith("compute-candidates"));
+        QVERIFY(lines.at(LatencyStats::ComputeCandidates + 1).contains(" 1 "));
+    }
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+QTEST_MAIN(MaliitKeyboard::Logic::TestLatencyStats)
+#include "ut_latencystats.moc"
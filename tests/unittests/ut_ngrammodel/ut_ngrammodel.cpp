@@ -0,0 +1,339 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "ngrammodel.h"
+#include "ngrammodelformat.h"
+#include "westernlanguagefeatures.h"
+#include "models/text.h"
+
+#include <QtCore>
+#include <QtTest>
+
+#include <cstring>
+
+namespace {
+
+const char *const ModelFile = NGRAM_MODEL_FILE;
+
+QByteArray readModel()
+{
+    QFile file(QString::fromLatin1(ModelFile));
+    if (not file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+NGramFormat::Header headerOf(const QByteArray &data)
+{
+    NGramFormat::Header header;
+    memcpy(&header, data.constData(), sizeof(header));
+    return header;
+}
+
+quint32 valueAt(const QByteArray &data, quint64 array, quint64 index)
+{
+    quint32 value;
+    memcpy(&value, data.constData() + array + index * sizeof(quint32), sizeof(value));
+    return value;
+}
+
+//! Returns a copy of data with the index-th entry of the uint32_t array at
+//! offset array set to value.
+QByteArray patched(const QByteArray &data, quint64 array, quint64 index, quint32 value)
+{
+    QByteArray result(data);
+    memcpy(result.data() + array + index * sizeof(quint32), &value, sizeof(value));
+    return result;
+}
+
+QByteArray patched(const QByteArray &data, const NGramFormat::Header &header)
+{
+    QByteArray result(data);
+    memcpy(result.data(), &header, sizeof(header));
+    return result;
+}
+
+} // unnamed namespace
+
+class TestNGramModel : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    Q_SLOT void initTestCase()
+    {
+        QVERIFY(m_dir.isValid());
+
+        const QByteArray data = readModel();
+        QVERIFY(data.size() > int(sizeof(NGramFormat::Header)));
+
+        // The corrupted models below need every order to be populated.
+        const NGramFormat::Header header = headerOf(data);
+        QCOMPARE(header.order, NGramFormat::MaxOrder);
+        QVERIFY(header.levels[1].nodeCount > 0);
+        QVERIFY(header.levels[2].nodeCount > 0);
+    }
+
+    Q_SLOT void testOpen()
+    {
+        NGramModel model;
+        QVERIFY(not model.isOpen());
+        QVERIFY(model.predict(QStringList(), QStringLiteral("th"), 3).isEmpty());
+
+        QVERIFY(model.open(QString::fromLatin1(ModelFile)));
+        QVERIFY(model.isOpen());
+        QCOMPARE(model.fileName(), QString::fromLatin1(ModelFile));
+
+        const QStringList words = model.predict(QStringList(), QStringLiteral("Th"), 3);
+        QCOMPARE(words.size(), 3);
+        QCOMPARE(words.first(), QStringLiteral("the"));
+        for (const QString &word : words) {
+            QVERIFY(word.startsWith(QLatin1String("th")));
+        }
+
+        QCOMPARE(model.predict(QStringList() << QStringLiteral("the"), QString(), 1),
+                 QStringList() << QStringLiteral("cat"));
+        QCOMPARE(model.predict(QStringList() << QStringLiteral("cat") << QStringLiteral("sat"),
+                               QStringLiteral("o"), 1),
+                 QStringList() << QStringLiteral("on"));
+        QVERIFY(model.predict(QStringList(), QStringLiteral("zebra"), 3).isEmpty());
+
+        float the = 0;
+        float rat = 0;
+        QVERIFY(model.unigram(QStringLiteral("the"), &the));
+        QVERIFY(model.unigram(QStringLiteral("rat"), &rat));
+        QVERIFY(the > rat);
+        QVERIFY(not model.unigram(QStringLiteral("zebra"), &the));
+
+        model.close();
+        QVERIFY(not model.isOpen());
+        QVERIFY(model.predict(QStringList(), QStringLiteral("th"), 3).isEmpty());
+    }
+
+    Q_SLOT void testNextWord()
+    {
+        NGramModel model;
+        QVERIFY(model.open(QString::fromLatin1(ModelFile)));
+
+        // Followers of the context, best first, from the successor tables.
+        QCOMPARE(model.predict(QStringList() << QStringLiteral("cat") << QStringLiteral("sat"),
+                               QString(), 2),
+                 QStringList() << QStringLiteral("on") << QStringLiteral("there"));
+
+        const QStringList after_the = model.predict(QStringList() << QStringLiteral("The"),
+                                                    QString(), 3);
+        QCOMPARE(after_the.size(), 3);
+        QCOMPARE(after_the.at(0), QStringLiteral("cat"));
+        QCOMPARE(QSet<QString>::fromList(after_the.mid(1)),
+                 QSet<QString>() << QStringLiteral("dog") << QStringLiteral("mat"));
+
+        // Unknown words back off to the known part of the context, and to
+        // the most likely words without any.
+        QCOMPARE(model.predict(QStringList() << QStringLiteral("zebra") << QStringLiteral("the"),
+                               QString(), 1),
+                 QStringList() << QStringLiteral("cat"));
+        QCOMPARE(model.predict(QStringList() << QStringLiteral("zebra"), QString(), 1),
+                 QStringList() << QStringLiteral("the"));
+    }
+
+    Q_SLOT void testContextWordsAreKnown()
+    {
+        NGramModel model;
+        QVERIFY(model.open(QString::fromLatin1(ModelFile)));
+
+        // Model::Text splits and the model folds words as they were counted.
+        MaliitKeyboard::Model::Text text;
+        text.setSurrounding(QString::fromUtf8("\u0130zmir isn't far, don\u2019t "));
+        text.setSurroundingOffset(text.surrounding().length());
+
+        const WesternLanguageFeatures features;
+        const QStringList context = text.contextWords(features.characterClasses());
+        QCOMPARE(context.size(), 4);
+        for (const QString &word : context) {
+            float log_probability;
+            QVERIFY2(model.unigram(word, &log_probability), qPrintable(word));
+        }
+
+        QCOMPARE(model.predict(context.mid(0, 1), QString(), 1),
+                 QStringList() << QStringLiteral("isn't"));
+        QCOMPARE(model.predict(context.mid(0, 2), QStringLiteral("F"), 1),
+                 QStringList() << QStringLiteral("far"));
+    }
+
+    Q_SLOT void testCursor_data()
+    {
+        // Every step is "<context words>|<prefix>", predicted in order with
+        // the same cursor.
+        QTest::addColumn<QStringList>("steps");
+
+        QTest::newRow("typing")
+                << (QStringList() << "the cat|" << "the cat|s" << "the cat|sa"
+                                  << "the cat|sat" << "the cat|satx");
+        QTest::newRow("backspace")
+                << (QStringList() << "|the" << "|th" << "|t" << "|" << "|t" << "|th");
+        QTest::newRow("mid-word edit")
+                << (QStringList() << "on the|m" << "on the|ma" << "on the|mx"
+                                  << "on the|l" << "on the|lo" << "|lo" << "on the|ta");
+        QTest::newRow("context change")
+                << (QStringList() << "the|c" << "the|ca" << "cat|s" << "the cat|s"
+                                  << "dog|s" << "zebra the|c" << "|c" << "the|ca");
+        QTest::newRow("next word")
+                << (QStringList() << "the|" << "cat sat|" << "cat sat|o" << "sat on|"
+                                  << "zebra|" << "the cat|");
+    }
+
+    Q_SLOT void testCursor()
+    {
+        QFETCH(QStringList, steps);
+
+        NGramModel model;
+        QVERIFY(model.open(QString::fromLatin1(ModelFile)));
+
+        NGramModel::Cursor cursor;
+        for (const QString &step : steps) {
+            const QStringList context = step.section('|', 0, 0).split(' ', QString::SkipEmptyParts);
+            const QString prefix = step.section('|', 1);
+            QCOMPARE(model.predict(context, prefix, 5, &cursor),
+                     model.predict(context, prefix, 5));
+        }
+    }
+
+    Q_SLOT void testCursorAfterReopen()
+    {
+        const QStringList context(QStringLiteral("the"));
+        NGramModel model;
+        NGramModel::Cursor cursor;
+
+        QVERIFY(model.open(QString::fromLatin1(ModelFile)));
+        QCOMPARE(model.predict(context, QStringLiteral("ca"), 5, &cursor),
+                 model.predict(context, QStringLiteral("ca"), 5));
+
+        model.close();
+        QVERIFY(model.predict(context, QStringLiteral("cat"), 5, &cursor).isEmpty());
+
+        // The ranges cached for the old mapping must not be reused.
+        QVERIFY(model.open(QString::fromLatin1(ModelFile)));
+        QCOMPARE(model.predict(context, QStringLiteral("cat"), 5, &cursor),
+                 model.predict(context, QStringLiteral("cat"), 5));
+        QCOMPARE(model.predict(context, QStringLiteral("c"), 5, &cursor),
+                 model.predict(context, QStringLiteral("c"), 5));
+
+        // Nor by another model opened on the same file.
+        NGramModel other;
+        QVERIFY(other.open(QString::fromLatin1(ModelFile)));
+        QCOMPARE(other.predict(context, QStringLiteral("ca"), 5, &cursor),
+                 other.predict(context, QStringLiteral("ca"), 5));
+        QCOMPARE(model.predict(context, QStringLiteral("ca"), 5, &cursor),
+                 model.predict(context, QStringLiteral("ca"), 5));
+    }
+
+    Q_SLOT void testRejectDamagedModel_data()
+    {
+        QTest::addColumn<QByteArray>("data");
+
+        const QByteArray data = readModel();
+        const NGramFormat::Header header = headerOf(data);
+        const quint32 vocabulary = header.vocabularySize;
+        const NGramFormat::Level &unigrams = header.levels[0];
+        const NGramFormat::Level &bigrams = header.levels[1];
+
+        QTest::newRow("empty") << QByteArray();
+        QTest::newRow("truncated header") << data.left(int(sizeof(NGramFormat::Header)) / 2);
+        QTest::newRow("truncated") << data.left(data.size() - 8);
+
+        QByteArray magic(data);
+        magic[0] = 'X';
+        QTest::newRow("magic") << magic;
+
+        NGramFormat::Header version(header);
+        ++version.version;
+        QTest::newRow("version") << patched(data, version);
+
+        NGramFormat::Header order(header);
+        order.order = NGramFormat::MaxOrder + 1;
+        QTest::newRow("order") << patched(data, order);
+
+        NGramFormat::Header nodes(header);
+        ++nodes.levels[0].nodeCount;
+        QTest::newRow("unigram count") << patched(data, nodes);
+
+        NGramFormat::Header beyond(header);
+        beyond.levels[2].probsOffset = header.fileSize;
+        QTest::newRow("array beyond end") << patched(data, beyond);
+
+        NGramFormat::Header misaligned(header);
+        misaligned.levels[1].wordIdsOffset += 2;
+        QTest::newRow("misaligned array") << patched(data, misaligned);
+
+        QTest::newRow("string offsets not monotonic")
+                << patched(data, header.stringOffsetsOffset, 1,
+                           valueAt(data, header.stringOffsetsOffset, 2) + 1);
+        QTest::newRow("string pool overflow")
+                << patched(data, header.stringOffsetsOffset, vocabulary, 0x7fffffff);
+        QTest::newRow("unigram rank out of range")
+                << patched(data, header.unigramRankOffset, 0, vocabulary);
+        QTest::newRow("word id out of range")
+                << patched(data, bigrams.wordIdsOffset, 0, vocabulary);
+        QTest::newRow("child offsets not monotonic")
+                << patched(data, unigrams.childOffsets, 0, 0xffffffff);
+        QTest::newRow("child offset out of range")
+                << patched(data, unigrams.childOffsets, unigrams.nodeCount,
+                           bigrams.nodeCount + 1);
+        QTest::newRow("successor offsets not monotonic")
+                << patched(data, unigrams.successorOffsets, 0, 0xffffffff);
+        QTest::newRow("successor out of range")
+                << patched(data, unigrams.successors, 0, bigrams.nodeCount);
+        QTest::newRow("trigram successor out of range")
+                << patched(data, bigrams.successors, 0, header.levels[2].nodeCount);
+    }
+
+    Q_SLOT void testRejectDamagedModel()
+    {
+        QFETCH(QByteArray, data);
+
+        const QString file_name = m_dir.filePath(QStringLiteral("damaged.lm"));
+        QFile file(file_name);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        QCOMPARE(file.write(data), qint64(data.size()));
+        file.close();
+
+        NGramModel model;
+        QVERIFY(not model.open(file_name));
+        QVERIFY(not model.isOpen());
+        QVERIFY(model.predict(QStringList(), QStringLiteral("th"), 3).isEmpty());
+
+        // A damaged file does not keep a good model from opening afterwards.
+        QVERIFY(model.open(QString::fromLatin1(ModelFile)));
+        QVERIFY(not model.predict(QStringList(), QStringLiteral("th"), 3).isEmpty());
+    }
+};
+
+QTEST_MAIN(TestNGramModel)
+#include "ut_ngrammodel.moc"
@@ -481,6 +481,7 @@ private:
                                                                       cursor_position));
 
         test_setup.notifier.notify(update_event.data());
+        test_setup.editor.flush();
 
         QCOMPARE(test_setup.host.preeditStringSent(), expected_preedit_string_sent);
         if (expected_preedit_string_sent) {
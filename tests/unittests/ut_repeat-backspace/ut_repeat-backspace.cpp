@@ -207,6 +207,37 @@ private:
         QCOMPARE(host->keyEventCount(), 4);
     }
 
+    /*
+     * testWordRepeat verifies that once auto-repeat deletes whole words,
+     * a word is deleted with one commit replacing it instead of one key
+     * event per character.
+     */
+    Q_SLOT void testWordRepeat()
+    {
+        EditorOptions word_options(options);
+        word_options.backspace_word_switch_threshold = 0;
+        word_options.backspace_word_interval = 1000;
+
+        editor.reset(new Editor(word_options, new Model::Text, new Logic::WordEngineProbe));
+        editor->setHost(host.data());
+        editor->text()->setSurrounding("hello world");
+        editor->text()->setSurroundingOffset(11);
+
+        Key backspace;
+        backspace.setAction(Key::ActionBackspace);
+
+        editor->onKeyPressed(backspace);
+        QTest::qWait(delay);
+
+        QCOMPARE(host->keyEventCount(), 0);
+        QCOMPARE(host->lastCommitReplaceStart(), -11);
+        QCOMPARE(host->lastCommitReplaceLength(), 11);
+        QCOMPARE(host->commitStringHistory(), QString());
+
+        editor->onKeyReleased(backspace);
+        QCOMPARE(host->keyEventCount(), 0);
+    }
+
     Q_SLOT void testInvalidSurroundingText_data()
     {   
         QTest::addColumn<Method>("initiate");
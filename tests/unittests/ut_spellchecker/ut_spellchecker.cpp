@@ -0,0 +1,189 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "spellchecker.h"
+#include "utils.h"
+
+#include <QtCore>
+#include <QtTest>
+
+namespace {
+
+const char AffixFile[] =
+        "SET UTF-8\n"
+        "SFX S Y 3\n"
+        "SFX S y ies [^aeiou]y\n"
+        "SFX S 0 s [aeiou]y\n"
+        "SFX S 0 s [^y]\n";
+
+const char DictionaryFile[] =
+        "4\n"
+        "cry/S\n"
+        "boy/S\n"
+        "walk/S\n"
+        "Paris\n";
+
+} // unnamed namespace
+
+class TestSpellChecker : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    Q_SLOT void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        QVERIFY(m_dir.isValid());
+
+        qputenv("KEYBOARD_PREFIX_PATH", m_dir.path().toUtf8());
+        QVERIFY(QDir().mkpath(SpellChecker::dictPath()));
+        QVERIFY(TestUtils::writeFile(SpellChecker::dictPath() + QStringLiteral("/xx_XX.aff"), AffixFile));
+        QVERIFY(TestUtils::writeFile(SpellChecker::dictPath() + QStringLiteral("/xx_XX.dic"), DictionaryFile));
+
+        const QString lexicon = QStandardPaths::writableLocation(QStandardPaths::DataLocation)
+                + QStringLiteral("/xx_XX_userDictionary.lex");
+        QFile::remove(lexicon);
+        QFile::remove(lexicon + QStringLiteral(".journal"));
+    }
+
+    Q_SLOT void testSpell()
+    {
+        SpellChecker checker;
+        QVERIFY(checker.setLanguage(QStringLiteral("xx_XX")));
+        QVERIFY(checker.setEnabled(true));
+        checker.prepareSuggestions();
+
+        QVERIFY(checker.spell(QStringLiteral("cries")));
+        QVERIFY(checker.spell(QStringLiteral("Cries")));
+        QVERIFY(checker.spell(QStringLiteral("PARIS")));
+        QVERIFY(not checker.spell(QStringLiteral("paris")));
+        QVERIFY(not checker.spell(QStringLiteral("crys")));
+
+        SpellChecker::Statistics statistics = checker.statistics();
+        QCOMPARE(statistics.checks, quint64(5));
+        QCOMPARE(statistics.cacheHits, quint64(0));
+        QCOMPARE(statistics.backendChecks, quint64(0));
+
+        QVERIFY(checker.spell(QStringLiteral("cries")));
+        QVERIFY(not checker.spell(QStringLiteral("crys")));
+        statistics = checker.statistics();
+        QCOMPARE(statistics.checks, quint64(7));
+        QCOMPARE(statistics.cacheHits, quint64(2));
+
+        checker.resetStatistics();
+        const QStringList misspellings = {
+            QStringLiteral("wlak"), QStringLiteral("bouy"), QStringLiteral("crie"),
+            QStringLiteral("paros"), QStringLiteral("walkes"), QStringLiteral("boyes"),
+            QStringLiteral("kry"), QStringLiteral("wakl"), QStringLiteral("bo"),
+            QStringLiteral("criess")
+        };
+        for (const QString &word : misspellings) {
+            QVERIFY(not checker.spell(word));
+        }
+
+        // Each misspelling passes the filter with a chance of about 1%.
+        statistics = checker.statistics();
+        QCOMPARE(statistics.checks, quint64(misspellings.size()));
+        QVERIFY(statistics.filterRejections >= quint64(misspellings.size() - 2));
+    }
+
+    Q_SLOT void testUpdateWord()
+    {
+        SpellChecker checker;
+        QVERIFY(checker.setLanguage(QStringLiteral("xx_XX")));
+        QVERIFY(checker.setEnabled(true));
+        checker.prepareSuggestions();
+
+        QVERIFY(not checker.spell(QStringLiteral("maliit")));
+        QVERIFY(not checker.spell(QStringLiteral("Maliit")));
+
+        checker.updateWord(QStringLiteral("maliit"));
+        QVERIFY(checker.spell(QStringLiteral("maliit")));
+        QVERIFY(checker.spell(QStringLiteral("Maliit")));
+
+        // Switching languages forgets the remembered answers.
+        QVERIFY(checker.spell(QStringLiteral("cries")));
+        QVERIFY(checker.setLanguage(QStringLiteral("xx_XX")));
+        checker.resetStatistics();
+        QVERIFY(checker.spell(QStringLiteral("cries")));
+        QCOMPARE(checker.statistics().cacheHits, quint64(0));
+    }
+
+    Q_SLOT void testSharedDictionary()
+    {
+        SpellChecker prepared;
+        QVERIFY(prepared.setLanguage(QStringLiteral("xx_XX")));
+        QVERIFY(prepared.setEnabled(true));
+
+        SpellChecker checker;
+        QVERIFY(checker.setLanguage(QStringLiteral("xx_XX")));
+        QVERIFY(checker.setEnabled(true));
+
+        // The filter built for one spell checker serves the other as well.
+        prepared.prepareChecks();
+        QVERIFY(not checker.spell(QStringLiteral("wlak")));
+        QVERIFY(not checker.spell(QStringLiteral("bouy")));
+        QVERIFY(checker.statistics().filterRejections >= 1);
+
+        // And outlives it.
+        QVERIFY(prepared.setEnabled(false));
+        checker.resetStatistics();
+        QVERIFY(checker.spell(QStringLiteral("walks")));
+        QVERIFY(not checker.spell(QStringLiteral("wakl")));
+        QVERIFY(not checker.spell(QStringLiteral("kry")));
+        QVERIFY(checker.statistics().filterRejections >= 1);
+    }
+
+    Q_SLOT void testUserWordList()
+    {
+        {
+            SpellChecker checker;
+            QVERIFY(checker.setLanguage(QStringLiteral("xx_XX")));
+            QVERIFY(checker.setEnabled(true));
+
+            checker.addToUserWordList(QStringLiteral("walkie"));
+            checker.addToUserWordList(QStringLiteral("walkin"));
+            checker.recordUse(QStringLiteral("walkin"));
+            QVERIFY(checker.spell(QStringLiteral("walkie")));
+        }
+
+        // Written to the lexicon; the more used word is suggested first.
+        SpellChecker checker;
+        QVERIFY(checker.setLanguage(QStringLiteral("xx_XX")));
+        QVERIFY(checker.setEnabled(true));
+        checker.prepareSuggestions();
+
+        QVERIFY(checker.spell(QStringLiteral("walkin")));
+        QCOMPARE(checker.suggest(QStringLiteral("walki"), 3),
+                 QStringList() << QStringLiteral("walkin") << QStringLiteral("walkie") << QStringLiteral("walk"));
+    }
+};
+
+QTEST_MAIN(TestSpellChecker)
+#include "ut_spellchecker.moc"
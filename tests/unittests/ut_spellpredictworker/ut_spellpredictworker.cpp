@@ -0,0 +1,205 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "spellpredictworker.h"
+#include "logic/taskexecutor.h"
+
+#include <QtCore>
+#include <QtTest>
+
+using MaliitKeyboard::Logic::TaskExecutor;
+using MaliitKeyboard::Logic::TaskStrand;
+
+namespace {
+
+// Languages without any dictionary or model, which load instantly.
+const QString LanguageA = QStringLiteral("xx");
+const QString LanguageB = QStringLiteral("yy");
+
+QString pluginPath()
+{
+    return QDir::tempPath() + QStringLiteral("/ut_spellpredictworker");
+}
+
+} // unnamed namespace
+
+class TestSpellPredictWorker : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void testSupersededPrediction()
+    {
+        SpellPredictWorker worker;
+        QSignalSpy predictions(&worker, &SpellPredictWorker::newPredictionSuggestions);
+
+        // Both keystrokes are queued before the worker gets to the first.
+        worker.requestPrediction(1);
+        worker.requestPrediction(2);
+
+        worker.parsePredictionText(1, QStringList(), QStringLiteral("he"));
+        QVERIFY(predictions.isEmpty());
+
+        worker.parsePredictionText(2, QStringList(), QStringLiteral("hel"));
+        QCOMPARE(predictions.count(), 1);
+        QCOMPARE(predictions.first().at(0).toULongLong(), quint64(2));
+        QCOMPARE(predictions.first().at(1).toString(), QStringLiteral("hel"));
+
+        // The newest request is answered even if asked again.
+        worker.parsePredictionText(2, QStringList(), QStringLiteral("hel"));
+        QCOMPARE(predictions.count(), 2);
+    }
+
+    Q_SLOT void testSupersededSpellCheck()
+    {
+        SpellPredictWorker worker;
+        QSignalSpy suggestions(&worker, &SpellPredictWorker::newSpellingSuggestions);
+
+        worker.requestSpellCheck(1);
+        worker.requestSpellCheck(2);
+
+        worker.newSpellCheckWord(1, QStringLiteral("he"));
+        QVERIFY(suggestions.isEmpty());
+
+        worker.newSpellCheckWord(2, QStringLiteral("hel"));
+        QCOMPARE(suggestions.count(), 1);
+        QCOMPARE(suggestions.first().at(0).toULongLong(), quint64(2));
+        QCOMPARE(suggestions.first().at(1).toString(), QStringLiteral("hel"));
+    }
+
+    Q_SLOT void testHalvesTrackedSeparately()
+    {
+        SpellPredictWorker worker;
+        QSignalSpy predictions(&worker, &SpellPredictWorker::newPredictionSuggestions);
+        QSignalSpy suggestions(&worker, &SpellPredictWorker::newSpellingSuggestions);
+
+        // A newer spell check does not supersede an older prediction.
+        worker.requestPrediction(1);
+        worker.requestSpellCheck(2);
+
+        worker.parsePredictionText(1, QStringList(), QStringLiteral("he"));
+        worker.newSpellCheckWord(2, QStringLiteral("he"));
+        QCOMPARE(predictions.count(), 1);
+        QCOMPARE(suggestions.count(), 1);
+    }
+
+    Q_SLOT void testLanguageLoadedByBothHalves()
+    {
+        SpellPredictWorker worker;
+        QSignalSpy loaded(&worker, &SpellPredictWorker::languageLoaded);
+
+        worker.requestLanguage(1);
+        worker.setPredictionLanguage(1, LanguageA, pluginPath());
+        QVERIFY(loaded.isEmpty());
+
+        worker.setSpellingLanguage(1, LanguageA, pluginPath());
+        QCOMPARE(loaded.count(), 1);
+        QCOMPARE(loaded.first().at(0).toString(), LanguageA);
+    }
+
+    Q_SLOT void testLanguageSwitchedBack()
+    {
+        SpellPredictWorker worker;
+        QSignalSpy loaded(&worker, &SpellPredictWorker::languageLoaded);
+
+        worker.requestLanguage(1);
+        worker.setPredictionLanguage(1, LanguageA, pluginPath());
+        worker.setSpellingLanguage(1, LanguageA, pluginPath());
+        QCOMPARE(loaded.count(), 1);
+
+        // Switching to B and back to A before the halves get to it: the
+        // prediction half being done does not make the language loaded
+        // while the spelling half still has both loads ahead of it.
+        worker.requestLanguage(2);
+        worker.requestLanguage(3);
+        worker.setPredictionLanguage(2, LanguageB, pluginPath());
+        worker.setPredictionLanguage(3, LanguageA, pluginPath());
+        QCOMPARE(loaded.count(), 1);
+
+        worker.setSpellingLanguage(2, LanguageB, pluginPath());
+        QCOMPARE(loaded.count(), 1);
+        worker.setSpellingLanguage(3, LanguageA, pluginPath());
+        QCOMPARE(loaded.count(), 2);
+        QCOMPARE(loaded.last().at(0).toString(), LanguageA);
+    }
+
+    Q_SLOT void testSupersededLoadNotReported()
+    {
+        SpellPredictWorker worker;
+        QSignalSpy loaded(&worker, &SpellPredictWorker::languageLoaded);
+
+        // A load superseded before both halves are done with it is never reported.
+        worker.requestLanguage(1);
+        worker.setPredictionLanguage(1, LanguageA, pluginPath());
+        worker.requestLanguage(2);
+        worker.setSpellingLanguage(1, LanguageA, pluginPath());
+        QVERIFY(loaded.isEmpty());
+
+        worker.setPredictionLanguage(2, LanguageB, pluginPath());
+        worker.setSpellingLanguage(2, LanguageB, pluginPath());
+        QCOMPARE(loaded.count(), 1);
+        QCOMPARE(loaded.first().at(0).toString(), LanguageB);
+    }
+
+    Q_SLOT void testHalvesOnStrands()
+    {
+        TaskExecutor executor(3);
+        TaskStrand predictionStrand(&executor);
+        TaskStrand spellingStrand(&executor);
+        SpellPredictWorker worker;
+        QSignalSpy loaded(&worker, &SpellPredictWorker::languageLoaded);
+
+        // Holds both strands until every switch is queued, as when the
+        // user flips through languages faster than they load.
+        QSemaphore start;
+        predictionStrand.post(TaskExecutor::Background, [&start]() { start.acquire(); });
+        spellingStrand.post(TaskExecutor::Background, [&start]() { start.acquire(); });
+
+        const QStringList languages = QStringList() << LanguageA << LanguageB << LanguageA;
+        quint64 load = 0;
+        for (const QString &language : languages) {
+            const quint64 current = ++load;
+            worker.requestLanguage(current);
+            predictionStrand.post(TaskExecutor::Background, [&worker, current, language]() {
+                worker.setPredictionLanguage(current, language, pluginPath());
+            });
+            spellingStrand.post(TaskExecutor::Background, [&worker, current, language]() {
+                worker.setSpellingLanguage(current, language, pluginPath());
+            });
+        }
+
+        start.release(2);
+        predictionStrand.wait();
+        spellingStrand.wait();
+
+        QCOMPARE(loaded.count(), 1);
+        QCOMPARE(loaded.first().at(0).toString(), LanguageA);
+    }
+};
+
+QTEST_MAIN(TestSpellPredictWorker)
+#include "ut_spellpredictworker.moc"
@@ -0,0 +1,212 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "symspellindex.h"
+#include "logic/editdistance.h"
+#include "utils.h"
+
+#include <QtCore>
+#include <QtTest>
+
+#include <cstring>
+
+namespace {
+
+QStringList suggestedWords(const QVector<SymSpellIndex::Suggestion> &suggestions)
+{
+    QStringList words;
+    for (const SymSpellIndex::Suggestion &suggestion : suggestions) {
+        words.append(suggestion.word);
+    }
+    return words;
+}
+
+QString randomWord(int max_length)
+{
+    const int length = 1 + qrand() % max_length;
+    QString word;
+    for (int i = 0; i < length; ++i) {
+        word.append(QChar('a' + qrand() % 5));
+    }
+    return word;
+}
+
+} // unnamed namespace
+
+class TestSymSpellIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+    QString m_source_file;
+
+    bool buildIndex(const QStringList &words, SymSpellIndex *index)
+    {
+        const QString index_file = SymSpellIndex::indexFileName(m_source_file);
+        return SymSpellIndex::build(words, m_source_file, index_file)
+                && index->open(index_file, m_source_file);
+    }
+
+    Q_SLOT void initTestCase()
+    {
+        QVERIFY(m_dir.isValid());
+
+        m_source_file = m_dir.filePath(QStringLiteral("xx_XX.dict"));
+        QFile source(m_source_file);
+        QVERIFY(source.open(QIODevice::WriteOnly));
+        source.write("dictionary");
+    }
+
+    Q_SLOT void testLookup()
+    {
+        const QStringList words = {
+            QStringLiteral("Paris"), QStringLiteral("hello"), QStringLiteral("help"),
+            QStringLiteral("the"), QStringLiteral("then"), QStringLiteral("they"),
+            QStringLiteral("walked"), QStringLiteral("walking"), QStringLiteral("world")
+        };
+
+        SymSpellIndex index;
+        QVERIFY(buildIndex(words, &index));
+
+        const SymSpellIndex::FrequencyFunction frequency = [](const QString &word) {
+            return word == QLatin1String("help") ? -2.0f : -3.0f;
+        };
+
+        QCOMPARE(suggestedWords(index.lookup(QStringLiteral("helo"), -1, frequency)),
+                 QStringList({ QStringLiteral("help"), QStringLiteral("hello") }));
+        QCOMPARE(suggestedWords(index.lookup(QStringLiteral("Helo"), 1, frequency)),
+                 QStringList({ QStringLiteral("Help") }));
+        QCOMPARE(suggestedWords(index.lookup(QStringLiteral("HELO"), 1, frequency)),
+                 QStringList({ QStringLiteral("HELP") }));
+        QCOMPARE(suggestedWords(index.lookup(QStringLiteral("paris"), 1, frequency)),
+                 QStringList({ QStringLiteral("Paris") }));
+        QCOMPARE(suggestedWords(index.lookup(QStringLiteral("walkinng"), 1, frequency)),
+                 QStringList({ QStringLiteral("walking") }));
+        QCOMPARE(index.lookup(QStringLiteral("the"), 5, frequency).size(), 2);
+        QVERIFY(index.lookup(QStringLiteral("xylophone"), 5, frequency).isEmpty());
+
+        const QVector<SymSpellIndex::Suggestion> suggestions = index.lookup(QStringLiteral("wrld"), 1, frequency);
+        QCOMPARE(suggestions.size(), 1);
+        QCOMPARE(suggestions.first().word, QStringLiteral("world"));
+        QCOMPARE(suggestions.first().distance, 1);
+        QCOMPARE(suggestions.first().frequency, -3.0f);
+    }
+
+    // The deletes of the first PrefixLength characters must find every
+    // word within MaxDistance, whatever the length of the words.
+    Q_SLOT void testMatchesBruteForce()
+    {
+        qsrand(42);
+
+        QStringList words;
+        for (int i = 0; i < 500; ++i) {
+            words.append(randomWord(12));
+        }
+        words.removeDuplicates();
+        std::sort(words.begin(), words.end());
+
+        SymSpellIndex index;
+        QVERIFY(buildIndex(words, &index));
+
+        for (int i = 0; i < 200; ++i) {
+            const QString query = randomWord(12);
+            const MaliitKeyboard::Logic::EditDistance metric(query);
+
+            QStringList expected;
+            for (const QString &word : words) {
+                if (word != query && metric.distance(word) <= SymSpellIndex::MaxDistance) {
+                    expected.append(word);
+                }
+            }
+
+            QStringList found = suggestedWords(index.lookup(query, -1, SymSpellIndex::FrequencyFunction()));
+            std::sort(found.begin(), found.end());
+            QCOMPARE(found, expected);
+        }
+    }
+
+    Q_SLOT void testDamagedIndex_data()
+    {
+        // Byte offsets of fields of the index header.
+        QTest::addColumn<int>("arrayField");
+        QTest::addColumn<int>("element");
+        QTest::addColumn<int>("value");
+
+        // The second word ends before it starts.
+        QTest::newRow("word offsets") << 56 << 1 << 100;
+        // An entry names a word past the last one.
+        QTest::newRow("word id") << 80 << 0 << 3;
+    }
+
+    Q_SLOT void testDamagedIndex()
+    {
+        QFETCH(int, arrayField);
+        QFETCH(int, element);
+        QFETCH(int, value);
+
+        SymSpellIndex built;
+        QVERIFY(buildIndex(QStringList({ QStringLiteral("alpha"), QStringLiteral("beta"),
+                                         QStringLiteral("gamma") }), &built));
+        built.close();
+
+        const QString index_file = SymSpellIndex::indexFileName(m_source_file);
+        QFile file(index_file);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QByteArray contents = file.readAll();
+        file.close();
+
+        quint64 array;
+        std::memcpy(&array, contents.constData() + arrayField, sizeof(array));
+        const quint32 damaged = quint32(value);
+        std::memcpy(contents.data() + array + element * sizeof(quint32), &damaged, sizeof(damaged));
+        QVERIFY(TestUtils::writeFile(index_file, contents));
+
+        SymSpellIndex index;
+        QVERIFY(not index.open(index_file, m_source_file));
+        QVERIFY(not index.isOpen());
+    }
+
+    Q_SLOT void testStaleIndex()
+    {
+        SymSpellIndex index;
+        QVERIFY(buildIndex(QStringList({ QStringLiteral("word") }), &index));
+        index.close();
+
+        QFile source(m_source_file);
+        QVERIFY(source.open(QIODevice::Append));
+        source.write(" changed");
+        source.close();
+
+        QVERIFY(not index.open(SymSpellIndex::indexFileName(m_source_file), m_source_file));
+        QVERIFY(not index.isOpen());
+        QVERIFY(index.lookup(QStringLiteral("wrd"), 5, SymSpellIndex::FrequencyFunction()).isEmpty());
+    }
+};
+
+QTEST_MAIN(TestSymSpellIndex)
+#include "ut_symspellindex.moc"
@@ -0,0 +1,181 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "logic/taskexecutor.h"
+
+#include <QtCore>
+#include <QtTest>
+
+#include <atomic>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+class TestTaskExecutor : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void testStrandRunsInOrder()
+    {
+        TaskExecutor executor(4);
+        TaskStrand strand(&executor);
+
+        QVector<int> order;
+        std::atomic<int> running(0);
+        std::atomic<int> overlaps(0);
+
+        for (int i = 0; i < 200; ++i) {
+            const TaskExecutor::Lane lane = (i % 3) ? TaskExecutor::Interactive
+                                                    : TaskExecutor::Background;
+            strand.post(lane, [&order, &running, &overlaps, i]() {
+                if (running.fetch_add(1) != 0) {
+                    ++overlaps;
+                }
+                order.append(i);
+                running.fetch_sub(1);
+            });
+        }
+        strand.wait();
+
+        QCOMPARE(overlaps.load(), 0);
+        QCOMPARE(order.size(), 200);
+        for (int i = 0; i < order.size(); ++i) {
+            QCOMPARE(order.at(i), i);
+        }
+    }
+
+    Q_SLOT void testInteractiveFirst()
+    {
+        TaskExecutor executor(2);
+        TaskStrand slow(&executor);
+        TaskStrand queued(&executor);
+        TaskStrand interactive(&executor);
+
+        QSemaphore started;
+        QSemaphore gate;
+        std::atomic<bool> queuedRan(false);
+        std::atomic<bool> interactiveRan(false);
+
+        slow.post(TaskExecutor::Background, [&started, &gate]() {
+            started.release();
+            gate.acquire();
+        });
+        started.acquire();
+
+        // Background work never takes the last free thread...
+        queued.post(TaskExecutor::Background, [&queuedRan]() {
+            queuedRan = true;
+        });
+        // ... which stays available to interactive work.
+        interactive.post(TaskExecutor::Interactive, [&interactiveRan]() {
+            interactiveRan = true;
+        });
+        interactive.wait();
+
+        QVERIFY(interactiveRan);
+        QVERIFY(not queuedRan);
+
+        gate.release();
+        queued.wait();
+        QVERIFY(queuedRan);
+    }
+
+    Q_SLOT void testClear()
+    {
+        TaskExecutor executor(2);
+        TaskStrand strand(&executor);
+
+        QSemaphore started;
+        QSemaphore gate;
+        std::atomic<bool> firstDone(false);
+        std::atomic<bool> secondRan(false);
+
+        strand.post(TaskExecutor::Interactive, [&started, &gate, &firstDone]() {
+            started.release();
+            gate.acquire();
+            firstDone = true;
+        });
+        started.acquire();
+        strand.post(TaskExecutor::Interactive, [&secondRan]() {
+            secondRan = true;
+        });
+
+        executor.post(TaskExecutor::Interactive, [&gate]() {
+            QThread::msleep(50);
+            gate.release();
+        });
+
+        // Drops the second task and waits for the first one.
+        strand.clear();
+        QVERIFY(firstDone);
+
+        strand.wait();
+        QVERIFY(not secondRan);
+    }
+
+    Q_SLOT void testDrainFromBackgroundTask()
+    {
+        // One background slot, taken by the task that drains the writer.
+        TaskExecutor executor(2);
+        TaskStrand caller(&executor);
+        TaskStrand writer(&executor);
+
+        QVector<int> order;
+        std::atomic<bool> done(false);
+
+        caller.post(TaskExecutor::Background, [&writer, &order, &done]() {
+            for (int i = 0; i < 3; ++i) {
+                writer.post(TaskExecutor::Background, [&order, i]() {
+                    order.append(i);
+                });
+            }
+            // wait() would never return here: the writer tasks need the
+            // background slot this task occupies.
+            writer.drain();
+            done = true;
+        });
+        caller.wait();
+
+        QVERIFY(done);
+        QCOMPARE(order, QVector<int>() << 0 << 1 << 2);
+    }
+
+    Q_SLOT void testSharedInstance()
+    {
+        TaskExecutor *executor = TaskExecutor::instance();
+
+        QCOMPARE(TaskExecutor::instance(), executor);
+        QVERIFY(qApp->property("_maliit_keyboard_task_executor").isValid());
+        QVERIFY(executor->threadCount() >= 2);
+    }
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+QTEST_MAIN(MaliitKeyboard::Logic::TestTaskExecutor)
+#include "ut_taskexecutor.moc"
@@ -26,12 +26,25 @@
  */
 
 #include "models/text.h"
+#include "logic/characterclasstable.h"
 
 #include <QtCore>
 #include <QtTest>
 
 namespace MaliitKeyboard {
 
+namespace {
+
+//! The sentence breaks of WesternLanguageFeatures.
+Logic::CharacterClassTable westernClasses()
+{
+    Logic::CharacterClassTable classes;
+    classes.add(Logic::CharacterClassTable::SentenceBreak, QString::fromUtf8("!.?\r\n"));
+    return classes;
+}
+
+} // unnamed namespace
+
 class TestText : public QObject
 {
     Q_OBJECT
@@ -90,6 +103,134 @@ private:
         QCOMPARE(text.surrounding(), surrounding);
         QCOMPARE(ok, returnValue);
     }
+
+    Q_SLOT void testContextWords_data()
+    {
+        QTest::addColumn<QString>("surrounding");
+        QTest::addColumn<int>("offset");
+        QTest::addColumn<QStringList>("contextWords");
+
+        QTest::newRow("empty") << QString() << 0 << QStringList();
+        QTest::newRow("one word") << QString("hello ") << 6
+                                  << (QStringList() << "hello");
+        QTest::newRow("window is bounded") << QString("one two three four five six") << 27
+                                           << (QStringList() << "three" << "four" << "five" << "six");
+        QTest::newRow("stops at sentence") << QString("Done. It's late, isn't it") << 25
+                                           << (QStringList() << "It's" << "late" << "isn't" << "it");
+        QTest::newRow("at sentence start") << QString("Done. ") << 6 << QStringList();
+        QTest::newRow("carriage return breaks") << QString("Dear Sir,\r\nthank you") << 20
+                                                << (QStringList() << "thank" << "you");
+        QTest::newRow("ellipsis does not break") << QString::fromUtf8("Wait\u2026 what") << 10
+                                                 << (QStringList() << "Wait" << "what");
+        QTest::newRow("left of cursor only") << QString("one two three") << 7
+                                             << (QStringList() << "one" << "two");
+        QTest::newRow("offset past end") << QString("one two") << 20
+                                         << (QStringList() << "one" << "two");
+        QTest::newRow("apostrophes only inside words")
+                << QString::fromUtf8("'quoted' words\u2019 don''t") << 22
+                << (QStringList() << "quoted" << "words" << "don''t");
+        QTest::newRow("marks and underscores")
+                << QString::fromUtf8("cafe\u0301 snake_case") << 16
+                << (QStringList() << QString::fromUtf8("cafe\u0301") << "snake_case");
+    }
+
+    Q_SLOT void testContextWords()
+    {
+        QFETCH(QString, surrounding);
+        QFETCH(int, offset);
+        QFETCH(QStringList, contextWords);
+
+        Model::Text text;
+        text.setSurrounding(surrounding);
+        text.setSurroundingOffset(offset);
+
+        QCOMPARE(text.contextWords(westernClasses()), contextWords);
+    }
+
+    Q_SLOT void testContextWordsFollowCommit()
+    {
+        const Logic::CharacterClassTable classes = westernClasses();
+        Model::Text text;
+        text.setSurrounding("see you");
+        text.setSurroundingOffset(7);
+        QCOMPARE(text.contextWords(classes), QStringList() << "see" << "you");
+
+        // Typing does not touch the window, committing does.
+        text.setPreedit(" later");
+        QCOMPARE(text.contextWords(classes), QStringList() << "see" << "you");
+        text.commitPreedit();
+        QCOMPARE(text.contextWords(classes), QStringList() << "see" << "you" << "later");
+
+        text.setSurroundingOffset(3);
+        QCOMPARE(text.contextWords(classes), QStringList() << "see");
+    }
+
+    Q_SLOT void testContextWordsFollowLanguage()
+    {
+        Model::Text text;
+        text.setSurrounding("Done. see you");
+        text.setSurroundingOffset(13);
+        QCOMPARE(text.contextWords(westernClasses()), QStringList() << "see" << "you");
+
+        // The window is rebuilt whenever the sentence breaks change.
+        const Logic::CharacterClassTable no_breaks;
+        QCOMPARE(text.contextWords(no_breaks), QStringList() << "Done" << "see" << "you");
+        QCOMPARE(text.contextWords(westernClasses()), QStringList() << "see" << "you");
+    }
+
+    Q_SLOT void testTokens()
+    {
+        Model::Text text;
+        text.setSurrounding("mail me at foo@ba");
+        text.setSurroundingOffset(17);
+        text.appendToPreedit("r");
+
+        QCOMPARE(text.currentToken(), QString("foo@bar"));
+        QCOMPARE(text.previousToken(), QString("at"));
+        QVERIFY(text.currentTokenHasAtSign());
+
+        text.appendToPreedit(" ");
+        QCOMPARE(text.currentToken(), QString());
+        QCOMPARE(text.previousToken(), QString("foo@bar"));
+        QVERIFY(not text.currentTokenHasAtSign());
+
+        QVERIFY(text.removeFromPreedit(1));
+        QCOMPARE(text.currentToken(), QString("foo@bar"));
+        QVERIFY(text.currentTokenHasAtSign());
+
+        text.commitPreedit();
+        QCOMPARE(text.currentToken(), QString("foo@bar"));
+
+        text.setSurroundingOffset(10);
+        QCOMPARE(text.currentToken(), QString("at"));
+        QVERIFY(not text.currentTokenHasAtSign());
+    }
+
+    Q_SLOT void testBoundaries()
+    {
+        Model::Text text;
+        text.setSurrounding("one\ntwo  three \nfour");
+
+        text.setSurroundingOffset(4);
+        QVERIFY(text.atLineStart());
+        QCOMPARE(text.characterAfterCursor(), QChar('t'));
+
+        text.setSurroundingOffset(9);
+        QVERIFY(not text.atLineStart());
+        QCOMPARE(text.whitespaceBeforeCursor(), 2);
+        QCOMPARE(text.textBeforeCursor(4), QString("wo  "));
+        QCOMPARE(text.characterBeforeCursor(3), QChar('o'));
+        QVERIFY(not text.restOfLineBlank());
+
+        text.setSurroundingOffset(14);
+        QVERIFY(text.restOfLineBlank());
+        QVERIFY(not text.restOfTextBlank());
+
+        text.setSurroundingOffset(20);
+        QVERIFY(text.restOfTextBlank());
+        QCOMPARE(text.characterAfterCursor(), QChar());
+        QCOMPARE(text.textBeforeCursor(100), text.surroundingLeft());
+    }
 };
 
 } // namespace
@@ -0,0 +1,225 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "userlexicon.h"
+#include "logic/taskexecutor.h"
+#include "utils.h"
+
+#include <QtCore>
+#include <QtTest>
+
+#include <cstring>
+
+class TestUserLexicon : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    Q_SLOT void initTestCase()
+    {
+        QVERIFY(m_dir.isValid());
+    }
+
+    Q_SLOT void testAddAndReopen()
+    {
+        const QString file_name = m_dir.filePath(QStringLiteral("add.lex"));
+
+        UserLexicon lexicon;
+        QVERIFY(lexicon.open(file_name));
+        QVERIFY(not lexicon.contains(QStringLiteral("maliit")));
+
+        lexicon.add(QStringLiteral("maliit"));
+        lexicon.add(QStringLiteral("Qt"));
+        lexicon.add(QStringLiteral("maliit"));
+        lexicon.recordUse(QStringLiteral("Qt"));
+        lexicon.recordUse(QStringLiteral("unknown"));
+
+        QCOMPARE(lexicon.count(QStringLiteral("maliit")), quint32(2));
+        QCOMPARE(lexicon.count(QStringLiteral("Qt")), quint32(2));
+        QVERIFY(not lexicon.contains(QStringLiteral("unknown")));
+        QCOMPARE(lexicon.words(), QStringList() << QStringLiteral("Qt") << QStringLiteral("maliit"));
+
+        // Only the journal has been written so far.
+        lexicon.close();
+        QVERIFY(not QFile::exists(file_name));
+        QVERIFY(QFile::exists(UserLexicon::journalFileName(file_name)));
+
+        QVERIFY(lexicon.open(file_name));
+        QCOMPARE(lexicon.count(QStringLiteral("maliit")), quint32(2));
+        QCOMPARE(lexicon.count(QStringLiteral("Qt")), quint32(2));
+    }
+
+    Q_SLOT void testCompact()
+    {
+        const QString file_name = m_dir.filePath(QStringLiteral("compact.lex"));
+
+        UserLexicon lexicon;
+        QVERIFY(lexicon.open(file_name));
+        for (int i = 0; i < 100; ++i) {
+            lexicon.add(QStringLiteral("word%1").arg(i));
+        }
+        lexicon.compact();
+        lexicon.add(QStringLiteral("word1"));
+        lexicon.sync();
+
+        QVERIFY(QFile::exists(file_name));
+
+        UserLexicon reader;
+        QVERIFY(reader.open(file_name));
+        QCOMPARE(reader.words().size(), 100);
+        QCOMPARE(reader.count(QStringLiteral("word0")), quint32(1));
+        QCOMPARE(reader.count(QStringLiteral("word1")), quint32(2));
+        QCOMPARE(reader.count(QStringLiteral("word99")), quint32(1));
+        QVERIFY(not reader.contains(QStringLiteral("word100")));
+    }
+
+    Q_SLOT void testTornJournal()
+    {
+        const QString file_name = m_dir.filePath(QStringLiteral("torn.lex"));
+
+        {
+            UserLexicon lexicon;
+            QVERIFY(lexicon.open(file_name));
+            lexicon.add(QStringLiteral("first"));
+            lexicon.add(QStringLiteral("second"));
+        }
+
+        QFile journal(UserLexicon::journalFileName(file_name));
+        QVERIFY(journal.resize(journal.size() - 2));
+
+        UserLexicon lexicon;
+        QVERIFY(lexicon.open(file_name));
+        QVERIFY(lexicon.contains(QStringLiteral("first")));
+        QVERIFY(not lexicon.contains(QStringLiteral("second")));
+    }
+
+    Q_SLOT void testDamagedSnapshot()
+    {
+        const QString file_name = m_dir.filePath(QStringLiteral("damaged.lex"));
+
+        {
+            UserLexicon lexicon;
+            QVERIFY(lexicon.open(file_name));
+            lexicon.add(QStringLiteral("alpha"));
+            lexicon.add(QStringLiteral("beta"));
+            lexicon.add(QStringLiteral("gamma"));
+            lexicon.compact();
+        }
+
+        // Make the second word end before it starts; only the last offset
+        // stays within the string pool.
+        QFile file(file_name);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QByteArray contents = file.readAll();
+        file.close();
+        quint64 offsets_offset;
+        std::memcpy(&offsets_offset, contents.constData() + 32, sizeof(offsets_offset));
+        quint32 offsets[4];
+        std::memcpy(offsets, contents.constData() + offsets_offset, sizeof(offsets));
+        offsets[1] = offsets[2] + 1;
+        std::memcpy(contents.data() + offsets_offset, offsets, sizeof(offsets));
+        QVERIFY(TestUtils::writeFile(file_name, contents));
+
+        // The lexicon starts out empty and moves the snapshot aside.
+        UserLexicon lexicon;
+        QVERIFY(lexicon.open(file_name));
+        QVERIFY(not lexicon.contains(QStringLiteral("beta")));
+        QVERIFY(lexicon.words().isEmpty());
+        QVERIFY(not QFile::exists(file_name));
+        QVERIFY(QFile::exists(file_name + QStringLiteral(".damaged")));
+
+        lexicon.add(QStringLiteral("delta"));
+        lexicon.compact();
+        lexicon.close();
+
+        UserLexicon reader;
+        QVERIFY(reader.open(file_name));
+        QCOMPARE(reader.words(), QStringList() << QStringLiteral("delta"));
+    }
+
+    Q_SLOT void testCloseFromBackgroundTask()
+    {
+        using MaliitKeyboard::Logic::TaskExecutor;
+        using MaliitKeyboard::Logic::TaskStrand;
+
+        const QString file_name = m_dir.filePath(QStringLiteral("background.lex"));
+
+        // Take every background slot but one, which the closing task gets:
+        // the writer then has none left to run on.
+        TaskExecutor *executor = TaskExecutor::instance();
+        const int blockers = qMax(1, executor->threadCount() - 1) - 1;
+        QSemaphore started;
+        QSemaphore gate;
+        for (int i = 0; i < blockers; ++i) {
+            executor->post(TaskExecutor::Background, [&started, &gate]() {
+                started.release();
+                gate.acquire();
+            });
+        }
+        started.acquire(blockers);
+
+        UserLexicon lexicon;
+        QVERIFY(lexicon.open(file_name));
+
+        QSemaphore closed;
+        TaskStrand spelling(executor);
+        spelling.post(TaskExecutor::Background, [&lexicon, &closed]() {
+            lexicon.add(QStringLiteral("background"));
+            lexicon.close();
+            closed.release();
+        });
+
+        const bool closedInTime = closed.tryAcquire(1, 5000);
+        gate.release(blockers);
+        QVERIFY(closedInTime);
+
+        UserLexicon reader;
+        QVERIFY(reader.open(file_name));
+        QVERIFY(reader.contains(QStringLiteral("background")));
+    }
+
+    Q_SLOT void testImportText()
+    {
+        const QString text_file = m_dir.filePath(QStringLiteral("words.dic"));
+        const QString file_name = m_dir.filePath(QStringLiteral("words.lex"));
+        QVERIFY(TestUtils::writeFile(text_file, "maliit\nkeyboard\n\n"));
+
+        UserLexicon lexicon;
+        QVERIFY(lexicon.open(file_name, text_file));
+        QCOMPARE(lexicon.words(), QStringList() << QStringLiteral("keyboard") << QStringLiteral("maliit"));
+
+        // The text file is only read once.
+        QVERIFY(TestUtils::writeFile(text_file, "other\n"));
+        QVERIFY(lexicon.open(file_name, text_file));
+        QVERIFY(not lexicon.contains(QStringLiteral("other")));
+    }
+};
+
+QTEST_MAIN(TestUserLexicon)
+#include "ut_userlexicon.moc"
@@ -1,8 +1,12 @@
 
 
 #include "models/wordribbon.h"
+#include "models/text.h"
+#include "logic/wordengine.h"
+#include "logic/taskexecutor.h"
 #include "plugin/inputmethod.h"
 #include "common/inputmethodhostprobe.h"
+#include "utils.h"
 
 #include <maliit/plugins/abstractinputmethodhost.h>
 
@@ -10,11 +14,491 @@
 
 using namespace MaliitKeyboard;
 
+Q_DECLARE_METATYPE(WordCandidateList)
+
+namespace {
+
+// Enables the engine with both sources.
+void enable(Logic::WordEngine *engine)
+{
+    engine->setEnabled(true);
+    engine->setWordPredictionEnabled(true);
+    engine->setSpellcheckerEnabled(true);
+}
+
+// Switches to pluginPath and waits for the switch to complete.
+bool switchTo(Logic::WordEngine *engine, const QString &pluginPath, const QString &languageId)
+{
+    QSignalSpy ready(engine, &Logic::AbstractWordEngine::languageReady);
+    engine->onLanguageChanged(pluginPath, languageId);
+    return not ready.isEmpty() || ready.wait(5000);
+}
+
+QObject *probe(const QString &pluginPath)
+{
+    return TestUtils::languagePluginInstance(pluginPath);
+}
+
+// The words of the index-th list published to spy, user input included.
+QStringList published(const QSignalSpy &spy, int index)
+{
+    QStringList words;
+    for (const WordCandidate &candidate : spy.at(index).first().value<WordCandidateList>()) {
+        words.append(candidate.word());
+    }
+    return words;
+}
+
+} // unnamed namespace
 
 class TestWordEngine: public QObject
 {
   Q_OBJECT
 private:
+  QTemporaryDir m_dir;
+  QString m_default;
+  QString m_a;
+  QString m_b;
+  QString m_broken;
+
+  Q_SLOT void initTestCase() {
+    qRegisterMetaType<WordCandidateList>("WordCandidateList");
+    QVERIFY(m_dir.isValid());
+
+    // The engine starts out with the default plugin, found under the prefix.
+    qputenv("KEYBOARD_PREFIX_PATH", m_dir.path().toUtf8());
+    m_default = TestUtils::installLanguagePluginProbe(m_dir.path() + QDir::separator() + MALIIT_KEYBOARD_LANGUAGES_DIR,
+                                                      QStringLiteral("en"));
+
+    const QString languages = m_dir.filePath(QStringLiteral("languages"));
+    m_a = TestUtils::installLanguagePluginProbe(languages, QStringLiteral("probe_a"));
+    m_b = TestUtils::installLanguagePluginProbe(languages, QStringLiteral("probe_b"));
+    QVERIFY(not m_default.isEmpty() && not m_a.isEmpty() && not m_b.isEmpty());
+
+    m_broken = languages + QStringLiteral("/probe_a/libbrokenplugin.so");
+    QFile broken(m_broken);
+    QVERIFY(broken.open(QIODevice::WriteOnly));
+    QVERIFY(broken.write("not a library") > 0);
+  }
+
+  Q_SLOT void testSwitchQueuesRequests() {
+    Logic::WordEngine engine;
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    QObject *a = probe(m_a);
+    a->setProperty("languageDelay", 20);
+
+    QSignalSpy ready(&engine, &Logic::AbstractWordEngine::languageReady);
+    engine.onLanguageChanged(m_a, QStringLiteral("aa"));
+    QVERIFY(not engine.isLanguageReady());
+
+    Model::Text text;
+    text.setPreedit(QStringLiteral("he"));
+    engine.computeCandidates(&text);
+    text.setPreedit(QStringLiteral("hel"));
+    engine.computeCandidates(&text);
+    engine.addToUserDictionary(QStringLiteral("maliit"));
+
+    QVERIFY(ready.wait(5000));
+    QCOMPARE(ready.count(), 1);
+    QCOMPARE(ready.first().first().toString(), QStringLiteral("aa"));
+    QVERIFY(engine.isLanguageReady());
+
+    // Replayed once, for the latest text, by the new plugin only.
+    QCOMPARE(a->property("language").toString(), QStringLiteral("aa"));
+    QCOMPARE(a->property("predictRequests").toInt(), 1);
+    QCOMPARE(a->property("lastPreedit").toString(), QStringLiteral("hel"));
+    QCOMPARE(a->property("userWords").toStringList(), QStringList() << QStringLiteral("maliit"));
+    QCOMPARE(probe(m_default)->property("predictRequests").toInt(), 0);
+  }
+
+  Q_SLOT void testNewerSwitchSupersedes() {
+    Logic::WordEngine engine;
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    QSignalSpy ready(&engine, &Logic::AbstractWordEngine::languageReady);
+    engine.onLanguageChanged(m_a, QStringLiteral("aa"));
+    engine.onLanguageChanged(m_b, QStringLiteral("bb"));
+
+    QVERIFY(ready.wait(5000));
+    // a is loaded meanwhile and ignored.
+    QTest::qWait(100);
+    QCOMPARE(ready.count(), 1);
+    QCOMPARE(ready.first().first().toString(), QStringLiteral("bb"));
+
+    Model::Text text;
+    text.setPreedit(QStringLiteral("he"));
+    engine.computeCandidates(&text);
+    QCOMPARE(probe(m_b)->property("predictRequests").toInt(), 1);
+    QCOMPARE(probe(m_a)->property("predictRequests").toInt(), 0);
+  }
+
+  Q_SLOT void testFallbackOnFailure() {
+    Logic::WordEngine engine;
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    QSignalSpy ready(&engine, &Logic::AbstractWordEngine::languageReady);
+    engine.onLanguageChanged(m_broken, QStringLiteral("xx"));
+    QVERIFY(ready.wait(5000));
+    QCOMPARE(ready.first().first().toString(), QStringLiteral("xx"));
+
+    // The default plugin takes over the language.
+    QObject *fallback = probe(m_default);
+    QCOMPARE(fallback->property("language").toString(), QStringLiteral("xx"));
+
+    Model::Text text;
+    text.setPreedit(QStringLiteral("he"));
+    engine.computeCandidates(&text);
+    QCOMPARE(fallback->property("predictRequests").toInt(), 1);
+  }
+
+  Q_SLOT void testLanguageTimeout() {
+    Logic::WordEngine engine;
+    engine.setLanguageTimeout(50);
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    // The plugin never reports its language as loaded.
+    probe(m_a)->setProperty("languageDelay", -1);
+
+    QSignalSpy ready(&engine, &Logic::AbstractWordEngine::languageReady);
+    engine.onLanguageChanged(m_a, QStringLiteral("aa"));
+    QVERIFY(ready.wait(5000));
+    QCOMPARE(ready.first().first().toString(), QStringLiteral("aa"));
+    QVERIFY(engine.isLanguageReady());
+  }
+
+  Q_SLOT void testPluginLoadTimeout() {
+    Logic::WordEngine engine;
+    engine.setLanguageTimeout(100);
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    // With every background slot of the executor taken, the plugin cannot
+    // load, and the switch falls back to the default plugin.
+    Logic::TaskExecutor *executor = Logic::TaskExecutor::instance();
+    const int slots = qMax(1, executor->threadCount() - 1);
+    QSemaphore started;
+    QSemaphore gate;
+    for (int i = 0; i < slots; ++i) {
+        executor->post(Logic::TaskExecutor::Background, [&started, &gate]() {
+            started.release();
+            gate.acquire();
+        });
+    }
+    started.acquire(slots);
+
+    QSignalSpy ready(&engine, &Logic::AbstractWordEngine::languageReady);
+    engine.onLanguageChanged(m_a, QStringLiteral("aa"));
+    const bool readyInTime = ready.wait(5000);
+    gate.release(slots);
+
+    QVERIFY(readyInTime);
+    QVERIFY(engine.isLanguageReady());
+    QCOMPARE(probe(m_default)->property("language").toString(), QStringLiteral("aa"));
+  }
+
+  Q_SLOT void testRequestedPluginKeptWhenDisabled() {
+    Logic::WordEngine engine;
+    engine.setLanguageTimeout(60000);
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    // The plugin being switched to is no longer enabled while it loads.
+    QSignalSpy ready(&engine, &Logic::AbstractWordEngine::languageReady);
+    engine.onLanguageChanged(m_a, QStringLiteral("aa"));
+    engine.setEnabledLanguagePlugins(QStringList() << m_b);
+
+    QVERIFY(ready.wait(5000));
+    QCOMPARE(probe(m_a)->property("language").toString(), QStringLiteral("aa"));
+  }
+
+  Q_SLOT void testRankedCandidatesOrder() {
+    Logic::WordEngine engine;
+    WordCandidateList candidates;
+    candidates.append(WordCandidate(WordCandidate::SourceUser, QStringLiteral("he")));
+
+    // A candidate of rank r scores the weight of its source / (r + 1), so
+    // the sources interleave and ties keep the order of arrival.
+    engine.appendRankedCandidates(&candidates,
+                                  QStringList() << "c0" << "c1" << "c2" << QString(),
+                                  QStringList() << "p0" << "p1" << "p2");
+
+    QStringList words;
+    for (const WordCandidate &candidate : candidates) {
+      words.append(candidate.word());
+    }
+    QCOMPARE(words, QStringList() << "he" << "c0" << "p0" << "c1" << "p1" << "c2" << "p2");
+    QCOMPARE(candidates.at(0).source(), WordCandidate::SourceUser);
+    QCOMPARE(candidates.at(1).source(), WordCandidate::SourceSpellChecking);
+    QCOMPARE(candidates.at(2).source(), WordCandidate::SourcePrediction);
+    for (int i = 2; i < candidates.size(); ++i) {
+      QVERIFY(candidates.at(i - 1).score() >= candidates.at(i).score());
+    }
+  }
+
+  Q_SLOT void testRankedCandidatesDuplicate() {
+    Logic::WordEngine engine;
+    WordCandidateList candidates;
+
+    // Offered by both sources, "help" keeps its better score only once.
+    engine.appendRankedCandidates(&candidates,
+                                  QStringList() << "hello" << "help",
+                                  QStringList() << "help" << "helm" << "hello");
+
+    QCOMPARE(candidates.size(), 3);
+    QCOMPARE(candidates.at(0).word(), QStringLiteral("hello"));
+    QCOMPARE(candidates.at(0).source(), WordCandidate::SourceSpellChecking);
+    QCOMPARE(candidates.at(1).word(), QStringLiteral("help"));
+    QCOMPARE(candidates.at(1).source(), WordCandidate::SourcePrediction);
+    QCOMPARE(candidates.at(2).word(), QStringLiteral("helm"));
+  }
+
+  Q_SLOT void testRankedCandidatesLimit() {
+    Logic::WordEngine engine;
+    WordCandidateList candidates;
+
+    QStringList predictions;
+    for (int i = 0; i < 150; ++i) {
+      predictions.append(QStringLiteral("word%1").arg(i));
+    }
+    engine.appendRankedCandidates(&candidates, QStringList() << "best", predictions);
+
+    // Only the best hundred are kept.
+    QCOMPARE(candidates.size(), 100);
+    QCOMPARE(candidates.first().word(), QStringLiteral("best"));
+    for (int i = 1; i < candidates.size(); ++i) {
+      QCOMPARE(candidates.at(i).word(), predictions.at(i - 1));
+    }
+  }
+
+  Q_SLOT void testMergeSingleEmission() {
+    Logic::WordEngine engine;
+    engine.setMergeDeadline(5000);
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    QObject *plugin = probe(m_default);
+    plugin->setProperty("predictions", QStringList() << "hello" << "help");
+    plugin->setProperty("predictionDelay", 10);
+    plugin->setProperty("corrections", QStringList() << "hex");
+    plugin->setProperty("correctionDelay", 50);
+
+    QSignalSpy candidates(&engine, &Logic::AbstractWordEngine::candidatesChanged);
+    Model::Text text;
+    text.setPreedit(QStringLiteral("he"));
+    engine.computeCandidates(&text);
+
+    // Both sources are merged into one list, published once.
+    QVERIFY(candidates.wait(5000));
+    QTest::qWait(100);
+    QCOMPARE(candidates.count(), 1);
+
+    const QStringList words = published(candidates, 0);
+    QCOMPARE(words.size(), 4);
+    QCOMPARE(words.first(), QStringLiteral("he"));
+    QVERIFY(words.contains(QStringLiteral("hello")));
+    QVERIFY(words.contains(QStringLiteral("help")));
+    QVERIFY(words.contains(QStringLiteral("hex")));
+  }
+
+  Q_SLOT void testMergeDeadline() {
+    Logic::WordEngine engine;
+    engine.setMergeDeadline(50);
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    // The spell checker never answers.
+    QObject *plugin = probe(m_default);
+    plugin->setProperty("predictions", QStringList() << "hello");
+    plugin->setProperty("corrections", QStringList() << "hex");
+    plugin->setProperty("correctionDelay", -1);
+
+    QSignalSpy candidates(&engine, &Logic::AbstractWordEngine::candidatesChanged);
+    QElapsedTimer elapsed;
+    elapsed.start();
+    Model::Text text;
+    text.setPreedit(QStringLiteral("he"));
+    engine.computeCandidates(&text);
+
+    // The predictions are published once the deadline expires.
+    QVERIFY(candidates.wait(5000));
+    QVERIFY(elapsed.elapsed() >= 45);
+    QCOMPARE(published(candidates, 0), QStringList() << "he" << "hello");
+
+    QTest::qWait(100);
+    QCOMPARE(candidates.count(), 1);
+  }
+
+  Q_SLOT void testMergeLateSource() {
+    Logic::WordEngine engine;
+    engine.setMergeDeadline(50);
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    QObject *plugin = probe(m_default);
+    plugin->setProperty("predictions", QStringList() << "hello");
+    plugin->setProperty("corrections", QStringList() << "hex");
+    plugin->setProperty("correctionDelay", 300);
+
+    QSignalSpy candidates(&engine, &Logic::AbstractWordEngine::candidatesChanged);
+    Model::Text text;
+    text.setPreedit(QStringLiteral("he"));
+    engine.computeCandidates(&text);
+
+    QVERIFY(candidates.wait(5000));
+    QCOMPARE(published(candidates, 0), QStringList() << "he" << "hello");
+
+    // The late corrections are merged into what was published.
+    QVERIFY(candidates.wait(5000));
+    QCOMPARE(candidates.count(), 2);
+    const QStringList words = published(candidates, 1);
+    QCOMPARE(words.size(), 3);
+    QCOMPARE(words.first(), QStringLiteral("he"));
+    QVERIFY(words.contains(QStringLiteral("hello")));
+    QVERIFY(words.contains(QStringLiteral("hex")));
+  }
+
+  Q_SLOT void testMergeLateSourcePrimary() {
+    Logic::WordEngine engine;
+    engine.setMergeDeadline(50);
+    enable(&engine);
+    engine.setAutoCorrectEnabled(true);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    QObject *plugin = probe(m_default);
+    plugin->setProperty("predictions", QStringList() << "hello");
+    plugin->setProperty("corrections", QStringList() << "hex");
+    plugin->setProperty("correctionDelay", 300);
+
+    QSignalSpy candidates(&engine, &Logic::AbstractWordEngine::candidatesChanged);
+    Model::Text text;
+    text.setPreedit(QStringLiteral("he"));
+    engine.computeCandidates(&text);
+    // Only count what the merged lists report.
+    QSignalSpy primary(&engine, &Logic::AbstractWordEngine::primaryCandidateChanged);
+
+    QVERIFY(candidates.wait(5000));
+    QCOMPARE(primary.count(), 1);
+    QCOMPARE(primary.last().first().toString(), QStringLiteral("hello"));
+
+    // The late correction outranks the prediction; the rebuilt list marks
+    // it primary and the editor is told.
+    QVERIFY(candidates.wait(5000));
+    QCOMPARE(primary.count(), 2);
+    QCOMPARE(primary.last().first().toString(), QStringLiteral("hex"));
+
+    const WordCandidateList late = candidates.at(1).first().value<WordCandidateList>();
+    QCOMPARE(late.size(), 3);
+    QCOMPARE(late.at(1).word(), QStringLiteral("hex"));
+    for (int i = 0; i < late.size(); ++i) {
+      QCOMPARE(late.at(i).primary(), i == 1);
+    }
+  }
+
+  Q_SLOT void testStaleResultsDropped() {
+    Logic::WordEngine engine;
+    enable(&engine);
+    engine.setSpellcheckerEnabled(false);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    // The results of the first keystroke arrive after those of the second.
+    QObject *plugin = probe(m_default);
+    plugin->setProperty("predictions", QStringList() << "stale");
+    plugin->setProperty("predictionDelay", 100);
+
+    QSignalSpy candidates(&engine, &Logic::AbstractWordEngine::candidatesChanged);
+    Model::Text text;
+    text.setPreedit(QStringLiteral("he"));
+    engine.computeCandidates(&text);
+    const quint64 stale = plugin->property("lastGeneration").toULongLong();
+
+    plugin->setProperty("predictions", QStringList() << "fresh");
+    plugin->setProperty("predictionDelay", 0);
+    text.setPreedit(QStringLiteral("hel"));
+    engine.computeCandidates(&text);
+    QVERIFY(plugin->property("lastGeneration").toULongLong() > stale);
+
+    QVERIFY(candidates.wait(5000));
+    QCOMPARE(published(candidates, 0), QStringList() << "hel" << "fresh");
+
+    QTest::qWait(200);
+    QCOMPARE(candidates.count(), 1);
+
+    // Nor is anything published for a generation the engine moved past.
+    engine.newPredictionSuggestions(stale, QStringLiteral("he"), QStringList() << "stale");
+    engine.newSpellingSuggestions(stale, QStringLiteral("he"), QStringList() << "stale");
+    QCOMPARE(candidates.count(), 1);
+  }
+
+  Q_SLOT void testNextWordCandidates_data() {
+    QTest::addColumn<bool>("capitalize");
+    QTest::addColumn<QStringList>("expected");
+
+    QTest::newRow("lowercase") << false << (QStringList() << "cat" << "dog");
+    QTest::newRow("auto-caps") << true << (QStringList() << "Cat" << "Dog");
+  }
+
+  Q_SLOT void testNextWordCandidates() {
+    QFETCH(bool, capitalize);
+    QFETCH(QStringList, expected);
+
+    Logic::WordEngine engine;
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    QObject *plugin = probe(m_default);
+    plugin->setProperty("predictions", QStringList() << "cat" << "dog");
+    plugin->setProperty("corrections", QStringList() << "cab");
+
+    Model::Text text;
+    text.setPreedit(QStringLiteral("the "));
+    text.commitPreedit();
+
+    QSignalSpy candidates(&engine, &Logic::AbstractWordEngine::candidatesChanged);
+    QSignalSpy primary(&engine, &Logic::AbstractWordEngine::primaryCandidateChanged);
+    engine.computeNextWordCandidates(&text, capitalize);
+    QVERIFY(candidates.wait(5000));
+
+    // Only predictions for an empty preedit are asked for.
+    QCOMPARE(plugin->property("predictRequests").toInt(), 1);
+    QCOMPARE(plugin->property("spellCheckRequests").toInt(), 0);
+    QCOMPARE(plugin->property("lastContext").toStringList(), QStringList() << "the");
+    QCOMPARE(plugin->property("lastPreedit").toString(), QString());
+
+    // Published as they are: no user candidate, and nothing becomes primary.
+    const WordCandidateList published = candidates.first().first().value<WordCandidateList>();
+    QCOMPARE(published.size(), expected.size());
+    for (int i = 0; i < published.size(); ++i) {
+      QCOMPARE(published.at(i).word(), expected.at(i));
+      QCOMPARE(published.at(i).source(), WordCandidate::SourcePrediction);
+    }
+    QVERIFY(primary.isEmpty());
+  }
+
+  Q_SLOT void testNextWordSkippedDuringSwitch() {
+    Logic::WordEngine engine;
+    enable(&engine);
+    QVERIFY(switchTo(&engine, m_default, QStringLiteral("en")));
+
+    probe(m_a)->setProperty("languageDelay", 20);
+    QSignalSpy ready(&engine, &Logic::AbstractWordEngine::languageReady);
+    engine.onLanguageChanged(m_a, QStringLiteral("aa"));
+
+    Model::Text text;
+    text.setPreedit(QStringLiteral("the "));
+    text.commitPreedit();
+    engine.computeNextWordCandidates(&text, false);
+
+    // Not replayed either once the new language is ready.
+    QVERIFY(ready.wait(5000));
+    QTest::qWait(50);
+    QCOMPARE(probe(m_default)->property("predictRequests").toInt(), 0);
+    QCOMPARE(probe(m_a)->property("predictRequests").toInt(), 0);
+  }
 
   Q_SLOT void wordRibbon() {
 
@@ -87,6 +571,21 @@ private:
     QVERIFY(arguments[1].toInt() == 3);
     QVERIFY(arguments[2].toInt() == 3);
 
+    // a new candidate list replaces the model in a single reset
+    WordCandidateList list;
+    list << WordCandidate(WordCandidate::SourceUser, "word_1")
+         << wc2 << wc3;
+
+    modelAboutToBeResetSpy.clear();
+    wr.onWordCandidatesChanged(list);
+
+    QCOMPARE( modelAboutToBeResetSpy.count(), 1 );
+    QCOMPARE( rowsInsertedSpy.count(), 0 );
+    QCOMPARE( wr.rowCount(), 3 );
+    QCOMPARE( wr.data( wr.index(0,0), WordRibbon::IsUserInputRole ), QVariant(true));
+    QCOMPARE( wr.candidates().at(0).label(), QString("Add 'word_1' to user dictionary"));
+    QCOMPARE( wr.candidates().at(1).label(), QString("word_2"));
+
     /*
       this API should be reviewed and refactored where appropriate:
 